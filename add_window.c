@@ -37,6 +37,7 @@
 #include "captive.h"
 #include "colormaps.h"
 #include "ctwm_atoms.h"
+#include "drawing.h"
 #include "functions.h"
 #include "events.h"
 #ifdef EWMH
@@ -59,6 +60,7 @@
 #include "vscreen.h"
 #include "windowbox.h"
 #include "win_decorations.h"
+#include "win_decorations_atlas.h"
 #include "win_ops.h"
 #include "win_regions.h"
 #include "win_resize.h"
@@ -184,7 +186,7 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 	 * other values in our ctwm TwmWindow tmp_win (window name, various
 	 * flags, etc) has to come later.
 	 */
-	XSelectInput(dpy, tmp_win->w, PropertyChangeMask);
+	select_input(tmp_win->w, PropertyChangeMask);
 	XGetWindowAttributes(dpy, tmp_win->w, &tmp_win->attr);
 	FetchWmProtocols(tmp_win);
 	FetchWmColormapWindows(tmp_win);
@@ -369,6 +371,16 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 		Scr->NumAutoLowers++;
 	}
 
+	/* How long to wait before doing either */
+	{
+		int *delay;
+
+		delay = LookInListWin(Scr->AutoRaiseDelay, tmp_win);
+		tmp_win->raise_delay = delay ? *delay : RaiseDelay;
+		delay = LookInListWin(Scr->AutoLowerDelay, tmp_win);
+		tmp_win->lower_delay = delay ? *delay : LowerDelay;
+	}
+
 	tmp_win->OpaqueMove = Scr->DoOpaqueMove;
 	if(CHKL(OpaqueMoveList)) {
 		tmp_win->OpaqueMove = true;
@@ -1010,14 +1022,14 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 				XRectangle ink_rect;
 				XRectangle logical_rect;
 
-				XmbTextExtents(Scr->SizeFont.font_set,
-				               tmp_win->name, namelen,
-				               &ink_rect, &logical_rect);
+				FontTextExtents(&Scr->SizeFont,
+				                tmp_win->name, namelen,
+				                &ink_rect, &logical_rect);
 				width = SIZE_HINDENT + ink_rect.width;
 				height = logical_rect.height + SIZE_VINDENT * 2;
 
-				XmbTextExtents(Scr->SizeFont.font_set,
-				               ": ", 2,  NULL, &logical_rect);
+				FontTextExtents(&Scr->SizeFont,
+				                ": ", 2,  NULL, &logical_rect);
 				Scr->SizeStringOffset = width + logical_rect.width;
 			}
 
@@ -1027,10 +1039,10 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 			XMapRaised(dpy, Scr->SizeWindow);
 			InstallRootColormap();
 			FB(Scr->DefaultC.fore, Scr->DefaultC.back);
-			XmbDrawImageString(dpy, Scr->SizeWindow, Scr->SizeFont.font_set,
-			                   Scr->NormalGC, SIZE_HINDENT,
-			                   SIZE_VINDENT + Scr->SizeFont.ascent,
-			                   tmp_win->name, namelen);
+			FontDrawImageString(Scr->SizeWindow, &Scr->SizeFont,
+			                    Scr->NormalGC, SIZE_HINDENT,
+			                    SIZE_VINDENT + Scr->SizeFont.ascent,
+			                    tmp_win->name, namelen);
 
 			if(winbox) {
 				ConstrainedToWinBox(tmp_win, AddingX, AddingY, &AddingX, &AddingY);
@@ -1042,9 +1054,9 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 			MoveOutline(vroot, AddingX, AddingY, AddingW, AddingH,
 			            tmp_win->frame_bw, tmp_win->title_height + tmp_win->frame_bw3D);
 
-			XmbDrawImageString(dpy, Scr->SizeWindow, Scr->SizeFont.font_set,
-			                   Scr->NormalGC, width,
-			                   SIZE_VINDENT + Scr->SizeFont.ascent, ": ", 2);
+			FontDrawImageString(Scr->SizeWindow, &Scr->SizeFont,
+			                    Scr->NormalGC, width,
+			                    SIZE_VINDENT + Scr->SizeFont.ascent, ": ", 2);
 			DisplayPosition(tmp_win, AddingX, AddingY);
 
 			/*
@@ -1130,17 +1142,17 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 					int lastx, lasty;
 					XRectangle logical_rect;
 
-					XmbTextExtents(Scr->SizeFont.font_set,
-					               ": ", 2,  NULL, &logical_rect);
+					FontTextExtents(&Scr->SizeFont,
+					                ": ", 2,  NULL, &logical_rect);
 					Scr->SizeStringOffset = width + logical_rect.width;
 
 					MoveResizeSizeWindow(event.xbutton.x_root, event.xbutton.y_root,
 					                     Scr->SizeStringOffset + Scr->SizeStringWidth + SIZE_HINDENT,
 					                     height);
 
-					XmbDrawImageString(dpy, Scr->SizeWindow, Scr->SizeFont.font_set,
-					                   Scr->NormalGC, width,
-					                   SIZE_VINDENT + Scr->SizeFont.ascent, ": ", 2);
+					FontDrawImageString(Scr->SizeWindow, &Scr->SizeFont,
+					                    Scr->NormalGC, width,
+					                    SIZE_VINDENT + Scr->SizeFont.ascent, ": ", 2);
 
 					if(0/*Scr->AutoRelativeResize*/) {
 						int dx = (tmp_win->attr.width / 4);
@@ -1311,8 +1323,8 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 	 */
 	{
 		XRectangle logical_rect;
-		XmbTextExtents(Scr->TitleBarFont.font_set, tmp_win->name, namelen,
-		               NULL, &logical_rect);
+		FontTextExtents(&Scr->TitleBarFont, tmp_win->name, namelen,
+		                NULL, &logical_rect);
 		tmp_win->name_width = logical_rect.width;
 	}
 
@@ -1409,6 +1421,7 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 	}
 	tmp_win->prev = NULL;
 	Scr->FirstWindow = tmp_win;
+	InvalidateWindowListMenus();
 
 
 
@@ -1575,10 +1588,8 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 
 	/*
 	 * If we're highlighting borders on focus, we need the pixmap to do
-	 * it.
-	 *
-	 * XXX I'm not at all sure this can't just be global and shared, so
-	 * we don't have to create one per window...
+	 * it.  It's shared with all other windows with the same colors via
+	 * the decoration atlas.
 	 */
 	if(tmp_win->highlight) {
 		char *which;
@@ -1589,7 +1600,7 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 		else {
 			which = "gray";
 		}
-		tmp_win->gray = mk_blackgray_pixmap(which, vroot,
+		tmp_win->gray = DecorAtlasBlackGray(which,
 		                                    tmp_win->border_tile.fore,
 		                                    tmp_win->border_tile.back);
 
@@ -1640,6 +1651,7 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 		attributes.do_not_propagate_mask = ButtonPressMask | ButtonReleaseMask
 		                                   | PointerMotionMask;
 		XChangeWindowAttributes(dpy, tmp_win->w, valuemask, &attributes);
+		note_event_mask(tmp_win->w, attributes.event_mask);
 	}
 
 
@@ -1848,6 +1860,181 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
  * stay here and be staticized in the end.
  */
 
+/*
+ * The key and button grabs a window needs only depend on the bindings
+ * and a few config vars, not on the window, so we work them out once
+ * (on first use after the bindings change) into flat lists of
+ * (keycode/button, modifiers) per sort of target window, and then just
+ * run down those for each window.
+ */
+typedef struct WindowGrab {
+	unsigned int code;          ///< Keycode or button number
+	unsigned int mods;
+} WindowGrab;
+
+typedef struct WindowGrabList {
+	WindowGrab *grabs;
+	int len, cap;
+} WindowGrabList;
+
+struct WindowGrabs {
+	unsigned int ignoremod;     ///< Scr->IgnoreModifier when built
+	WindowGrabList frame_buttons;   ///< Buttons on the frame
+	WindowGrabList win_keys;        ///< Keys on the client window
+	WindowGrabList icon_keys;       ///< Keys on the icon window
+	WindowGrabList title_keys;      ///< Keys on the titlebar
+#ifdef EWMH_DESKTOP_ROOT
+	WindowGrabList desktop_keys;    ///< Keys on wt_Desktop windows
+#endif
+	WindowGrabList iconmgr_keys;    ///< Keys to ungrab on icon managers
+};
+
+static const unsigned int ModifierMask[8] = {
+	ShiftMask, ControlMask, LockMask,
+	Mod1Mask, Mod2Mask, Mod3Mask, Mod4Mask, Mod5Mask
+};
+
+
+/*
+ * Add a grab, plus its variants with each IgnoreModifier'd modifier,
+ * skipping any we already have.
+ */
+static void
+addGrab(WindowGrabList *gl, unsigned int code, unsigned int mods,
+        unsigned int ignoremod)
+{
+	int i, j;
+
+	for(i = -1 ; i < 8 ; i++) {
+		unsigned int m = mods;
+
+		if(i >= 0) {
+			if(!(ignoremod & ModifierMask[i]) || (mods & ModifierMask[i])) {
+				continue;
+			}
+			m |= ModifierMask[i];
+		}
+
+		for(j = 0 ; j < gl->len ; j++) {
+			if(gl->grabs[j].code == code && gl->grabs[j].mods == m) {
+				break;
+			}
+		}
+		if(j < gl->len) {
+			continue;
+		}
+
+		if(gl->len == gl->cap) {
+			int ncap = gl->cap ? gl->cap * 2 : 16;
+			WindowGrab *n = realloc(gl->grabs, ncap * sizeof(WindowGrab));
+			if(n == NULL) {
+				return;
+			}
+			gl->grabs = n;
+			gl->cap = ncap;
+		}
+		gl->grabs[gl->len].code = code;
+		gl->grabs[gl->len].mods = m;
+		gl->len++;
+	}
+}
+
+
+/*
+ * Throw out the current grab lists; they'll be rebuilt when next needed.
+ * Called when bindings get added.
+ */
+void
+InvalidateWindowGrabs(void)
+{
+	struct WindowGrabs *wg = Scr->WindowGrabs;
+
+	if(wg == NULL) {
+		return;
+	}
+	free(wg->frame_buttons.grabs);
+	free(wg->win_keys.grabs);
+	free(wg->icon_keys.grabs);
+	free(wg->title_keys.grabs);
+#ifdef EWMH_DESKTOP_ROOT
+	free(wg->desktop_keys.grabs);
+#endif
+	free(wg->iconmgr_keys.grabs);
+	free(wg);
+	Scr->WindowGrabs = NULL;
+}
+
+
+/*
+ * Get the grab lists for the current screen, building them if needed.
+ */
+static struct WindowGrabs *
+GetWindowGrabs(void)
+{
+	struct WindowGrabs *wg = Scr->WindowGrabs;
+	const unsigned int im = Scr->IgnoreModifier;
+
+	if(wg != NULL && wg->ignoremod == im) {
+		return wg;
+	}
+	InvalidateWindowGrabs();
+
+	wg = calloc(1, sizeof(*wg));
+	if(wg == NULL) {
+		return NULL;
+	}
+	wg->ignoremod = im;
+
+	for(FuncButton *fb = Scr->FuncButtonRoot.next; fb != NULL; fb = fb->next) {
+		if((fb->cont != C_WINDOW) || (fb->func == 0)) {
+			continue;
+		}
+		addGrab(&wg->frame_buttons, fb->num, fb->mods, im);
+	}
+
+	for(FuncKey *fk = Scr->FuncKeyRoot.next; fk != NULL; fk = fk->next) {
+		switch(fk->cont) {
+			case C_WINDOW:
+				/* case C_WORKSPACE: */
+#define AltMask (Alt1Mask | Alt2Mask | Alt3Mask | Alt4Mask | Alt5Mask)
+				if(fk->mods & AltMask) {
+					break;
+				}
+#undef AltMask
+				addGrab(&wg->win_keys, fk->keycode, fk->mods, im);
+				break;
+
+			case C_ICON:
+				addGrab(&wg->icon_keys, fk->keycode, fk->mods, im);
+				break;
+
+			case C_TITLE:
+				addGrab(&wg->title_keys, fk->keycode, fk->mods, im);
+				break;
+
+			case C_NAME:
+				addGrab(&wg->win_keys, fk->keycode, fk->mods, im);
+				addGrab(&wg->icon_keys, fk->keycode, fk->mods, im);
+				addGrab(&wg->title_keys, fk->keycode, fk->mods, im);
+				break;
+
+#ifdef EWMH_DESKTOP_ROOT
+			case C_ROOT:
+				addGrab(&wg->desktop_keys, fk->keycode, fk->mods, im);
+				break;
+#endif /* EWMH */
+
+			case C_ICONMGR:
+				addGrab(&wg->iconmgr_keys, fk->keycode, fk->mods, im);
+				break;
+		}
+	}
+
+	Scr->WindowGrabs = wg;
+	return wg;
+}
+
+
 /***********************************************************************
  *
  *  Procedure:
@@ -1867,25 +2054,17 @@ AddWindow(Window w, AWType wtype, IconMgr *iconp, VirtualScreen *vs)
 
 void GrabButtons(TwmWindow *tmp_win)
 {
-	FuncButton *tmp;
+	struct WindowGrabs *wg = GetWindowGrabs();
 	int i;
-	unsigned int ModifierMask[8] = { ShiftMask, ControlMask, LockMask,
-	                                 Mod1Mask, Mod2Mask, Mod3Mask, Mod4Mask,
-	                                 Mod5Mask
-	                               };
 
-	for(tmp = Scr->FuncButtonRoot.next; tmp != NULL; tmp = tmp->next) {
-		if((tmp->cont != C_WINDOW) || (tmp->func == 0)) {
-			continue;
-		}
-		grabbutton(tmp->num, tmp->mods, tmp_win->frame, GrabModeAsync);
-
-		for(i = 0 ; i < 8 ; i++) {
-			if((Scr->IgnoreModifier & ModifierMask [i]) && !(tmp->mods & ModifierMask [i]))
-				grabbutton(tmp->num, tmp->mods | ModifierMask [i],
-				           tmp_win->frame, GrabModeAsync);
+	if(wg != NULL) {
+		const WindowGrabList *gl = &wg->frame_buttons;
+		for(i = 0 ; i < gl->len ; i++) {
+			grabbutton(gl->grabs[i].code, gl->grabs[i].mods,
+			           tmp_win->frame, GrabModeAsync);
 		}
 	}
+
 	if(Scr->ClickToFocus) {
 		grabbutton(AnyButton, None, tmp_win->w, GrabModeSync);
 		for(i = 0 ; i < 8 ; i++) {
@@ -1913,144 +2092,53 @@ void GrabButtons(TwmWindow *tmp_win)
  ***********************************************************************
  */
 
-#define grabkey(funckey, modifier, window) \
-        XGrabKey(dpy, funckey->keycode, funckey->mods | modifier, window, True, \
-                GrabModeAsync, GrabModeAsync);
-#define ungrabkey(funckey, modifier, window) \
-        XUngrabKey (dpy, funckey->keycode, funckey->mods | modifier, window);
+static void
+grabKeyList(const WindowGrabList *gl, Window window)
+{
+	for(int i = 0 ; i < gl->len ; i++) {
+		XGrabKey(dpy, gl->grabs[i].code, gl->grabs[i].mods, window, True,
+		         GrabModeAsync, GrabModeAsync);
+	}
+}
 
 void GrabKeys(TwmWindow *tmp_win)
 {
-	FuncKey *tmp;
-	IconMgr *p;
-	int i;
-	unsigned int ModifierMask[8] = { ShiftMask, ControlMask, LockMask,
-	                                 Mod1Mask, Mod2Mask, Mod3Mask, Mod4Mask,
-	                                 Mod5Mask
-	                               };
-
-	for(tmp = Scr->FuncKeyRoot.next; tmp != NULL; tmp = tmp->next) {
-		switch(tmp->cont) {
-			case C_WINDOW:
-				/* case C_WORKSPACE: */
-#define AltMask (Alt1Mask | Alt2Mask | Alt3Mask | Alt4Mask | Alt5Mask)
-				if(tmp->mods & AltMask) {
-					break;
-				}
-#undef AltMask
-
-				grabkey(tmp, 0, tmp_win->w);
-
-				for(i = 0 ; i < 8 ; i++) {
-					if((Scr->IgnoreModifier & ModifierMask [i]) &&
-					                !(tmp->mods & ModifierMask [i])) {
-						grabkey(tmp, ModifierMask [i], tmp_win->w);
-					}
-				}
-				break;
-
-			case C_ICON:
-				if(!tmp_win->icon || tmp_win->icon->w) {
-					break;
-				}
-
-				grabkey(tmp, 0, tmp_win->icon->w);
-
-				for(i = 0 ; i < 8 ; i++) {
-					if((Scr->IgnoreModifier & ModifierMask [i]) &&
-					                !(tmp->mods & ModifierMask [i])) {
-						grabkey(tmp, ModifierMask [i], tmp_win->icon->w);
-					}
-				}
-				break;
+	struct WindowGrabs *wg = GetWindowGrabs();
 
-			case C_TITLE:
-				if(!tmp_win->title_w) {
-					break;
-				}
-
-				grabkey(tmp, 0, tmp_win->title_w);
-
-				for(i = 0 ; i < 8 ; i++) {
-					if((Scr->IgnoreModifier & ModifierMask [i]) &&
-					                !(tmp->mods & ModifierMask [i])) {
-						grabkey(tmp, ModifierMask [i], tmp_win->title_w);
-					}
-				}
-				break;
-
-			case C_NAME:
-				grabkey(tmp, 0, tmp_win->w);
-				for(i = 0 ; i < 8 ; i++) {
-					if((Scr->IgnoreModifier & ModifierMask [i]) &&
-					                !(tmp->mods & ModifierMask [i])) {
-						grabkey(tmp, ModifierMask [i], tmp_win->w);
-					}
-				}
-				if(tmp_win->icon && tmp_win->icon->w) {
-					grabkey(tmp, 0, tmp_win->icon->w);
-
-					for(i = 0 ; i < 8 ; i++) {
-						if((Scr->IgnoreModifier & ModifierMask [i]) &&
-						                !(tmp->mods & ModifierMask [i])) {
-							grabkey(tmp, ModifierMask [i], tmp_win->icon->w);
-						}
-					}
-				}
-				if(tmp_win->title_w) {
-					grabkey(tmp, 0, tmp_win->title_w);
-
-					for(i = 0 ; i < 8 ; i++) {
-						if((Scr->IgnoreModifier & ModifierMask [i]) &&
-						                !(tmp->mods & ModifierMask [i])) {
-							grabkey(tmp, ModifierMask [i], tmp_win->title_w);
-						}
-					}
-				}
-				break;
+	if(wg == NULL) {
+		return;
+	}
 
+	grabKeyList(&wg->win_keys, tmp_win->w);
+	if(tmp_win->icon && tmp_win->icon->w) {
+		grabKeyList(&wg->icon_keys, tmp_win->icon->w);
+	}
+	if(tmp_win->title_w) {
+		grabKeyList(&wg->title_keys, tmp_win->title_w);
+	}
 #ifdef EWMH_DESKTOP_ROOT
-			case C_ROOT:
-				if(tmp_win->ewmhWindowType != wt_Desktop) {
-					break;
-				}
-
-				grabkey(tmp, 0, tmp_win->w);
-
-				for(i = 0 ; i < 8 ; i++) {
-					if((Scr->IgnoreModifier & ModifierMask [i]) &&
-					                !(tmp->mods & ModifierMask [i])) {
-						grabkey(tmp, ModifierMask [i], tmp_win->w);
-					}
-				}
-				break;
-#endif /* EWMH */
-
-				/*
-				case C_ROOT:
-				    XGrabKey(dpy, tmp->keycode, tmp->mods, Scr->Root, True,
-				        GrabModeAsync, GrabModeAsync);
-				    break;
-				*/
-		}
+	if(tmp_win->ewmhWindowType == wt_Desktop) {
+		grabKeyList(&wg->desktop_keys, tmp_win->w);
 	}
-	for(tmp = Scr->FuncKeyRoot.next; tmp != NULL; tmp = tmp->next) {
-		if(tmp->cont == C_ICONMGR && !Scr->NoIconManagers) {
-			for(p = Scr->iconmgr; p != NULL; p = p->next) {
-				ungrabkey(tmp, 0, p->twm_win->w);
+#endif
 
-				for(i = 0 ; i < 8 ; i++) {
-					if((Scr->IgnoreModifier & ModifierMask [i]) &&
-					                !(tmp->mods & ModifierMask [i])) {
-						ungrabkey(tmp, ModifierMask [i], p->twm_win->w);
-					}
-				}
+	/*
+	case C_ROOT:
+	    XGrabKey(dpy, tmp->keycode, tmp->mods, Scr->Root, True,
+	        GrabModeAsync, GrabModeAsync);
+	    break;
+	*/
+
+	if(wg->iconmgr_keys.len > 0 && !Scr->NoIconManagers) {
+		for(IconMgr *p = Scr->iconmgr; p != NULL; p = p->next) {
+			const WindowGrabList *gl = &wg->iconmgr_keys;
+			for(int i = 0 ; i < gl->len ; i++) {
+				XUngrabKey(dpy, gl->grabs[i].code, gl->grabs[i].mods,
+				           p->twm_win->w);
 			}
 		}
 	}
 }
-#undef grabkey
-#undef ungrabkey
 
 
 /*
@@ -32,6 +32,7 @@ TwmWindow *AddWindow(Window w, AWType wtype, IconMgr *iconp,
                      VirtualScreen *vs);
 void GrabButtons(TwmWindow *tmp_win);
 void GrabKeys(TwmWindow *tmp_win);
+void InvalidateWindowGrabs(void);
 
 extern int AddingX;
 extern int AddingY;
@@ -5,17 +5,17 @@
 
 #include "ctwm.h"
 
-#include <sys/time.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <X11/extensions/shape.h>
 
-#include "ctwm_atoms.h"
 #include "events.h"
 #include "icons.h"
 #include "image.h"
 #include "screen.h"
+#include "timers.h"
 #include "util.h"
 #include "vscreen.h"
 #include "win_utils.h"
@@ -26,63 +26,239 @@
 #define MAXANIMATIONSPEED 20
 
 
-int  Animating        = 0;
 int  AnimationSpeed   = 0;
 bool AnimationActive  = false;
-bool MaybeAnimate     = true;
-struct timeval AnimateTimeout;
 
 
-static void Animate(void);
+/*
+ * Everything that's currently animating.  Rather than look through
+ * every window on every frame to find the few animated images, bits get
+ * added here when they come into view (window mapped, icon up, focus
+ * highlighted, workspace changed...), and each frame only touches
+ * what's on the list.  Things that have stopped being shown are noticed
+ * and dropped when their next frame comes around.
+ */
+typedef enum {
+	AN_ICON,         ///< Window's icon image
+	AN_BUTTON,       ///< One of a window's title buttons
+	AN_HIGHLIGHT,    ///< Focused window's title highlight
+	AN_ROOT,         ///< Current workspace's root background
+	AN_WSMAP,        ///< A workspace's background in the WSM map
+} AnimKind;
+
+typedef struct Animation {
+	struct Animation *next;
+	AnimKind kind;
+	ScreenInfo *scr;
+	TwmWindow *win;       ///< For ICON, BUTTON, HIGHLIGHT
+	int button;           ///< Index into win->titlebuttons
+	VirtualScreen *vs;    ///< For ROOT, WSMAP
+	WorkSpace *ws;        ///< For WSMAP
+} Animation;
+
+static Animation *animations;
+static Timer frameTimer;
+static bool frameTimerInit = false;
+
+
+static void AnimateFrame(void *arg);
 static void AnimateButton(TBWindow *tbw);
 static void AnimateHighlight(TwmWindow *t);
 static void AnimateIcons(ScreenInfo *scr, Icon *icon);
-static bool AnimateRoot(void);
+static void AnimateRoot(ScreenInfo *scr, VirtualScreen *vs);
+static void AnimateWSMap(VirtualScreen *vs, WorkSpace *ws);
 
 
 /*
- * XXX We're directly looking at this for hopefully hysterical raisins.
- * Rexamine the whole tracefile subsystem at some point when we look at
- * debugging.
- *
- * Currently get it via pollution from events.h anyway.
- *
- * extern FILE *tracefile;
+ * How long between frames, in ms.
  */
+static unsigned int
+framePeriod(void)
+{
+	if(AnimationSpeed <= 1) {
+		return 1000;
+	}
+	return 1000 / AnimationSpeed;
+}
 
-void
-TryToAnimate(void)
+
+/*
+ * Make sure the next frame is coming, if there's anything to show.
+ */
+static void
+scheduleFrame(void)
+{
+	if(!frameTimerInit) {
+		TimerInit(&frameTimer, AnimateFrame, NULL);
+		frameTimerInit = true;
+	}
+	if(!AnimationActive || AnimationSpeed <= 0 || animations == NULL) {
+		TimerCancel(&frameTimer);
+		return;
+	}
+	if(!TimerPending(&frameTimer)) {
+		TimerSet(&frameTimer, framePeriod());
+	}
+}
+
+
+/*
+ * Is the thing an entry describes still there to be animated?  These
+ * are the same tests the old full scan used to pick things out.
+ */
+static bool
+stillAnimating(const Animation *a)
+{
+	const TwmWindow *t = a->win;
+
+	switch(a->kind) {
+		case AN_ICON:
+			return visible(t) && t->icon_on && t->icon && t->icon->bm_w
+			       && t->icon->image && t->icon->image->next;
+
+		case AN_BUTTON: {
+			const TBWindow *tbw;
+
+			if(!visible(t) || !t->mapped || !t->titlebuttons
+			                || a->button >= a->scr->TBInfo.nleft
+			                + a->scr->TBInfo.nright) {
+				return false;
+			}
+			tbw = &t->titlebuttons[a->button];
+			return tbw->image && tbw->image->next;
+		}
+
+		case AN_HIGHLIGHT:
+			return t->hasfocusvisible && t->mapped && t->titlehighlight
+			       && t->title_height && t->HiliteImage && t->HiliteImage->next;
+
+		case AN_ROOT: {
+			const Image *image;
+
+			if(!a->scr->workSpaceManagerActive || a->scr->DontPaintRootWindow
+			                || !a->vs->wsw->currentwspc) {
+				return false;
+			}
+			image = a->vs->wsw->currentwspc->image;
+			return image && image->next;
+		}
+
+		case AN_WSMAP:
+			return a->vs->wsw->state != WMS_buttons
+			       && a->ws != a->vs->wsw->currentwspc
+			       && a->ws->image && a->ws->image->next;
+	}
+	return false;
+}
+
+
+/*
+ * Add an entry, unless it's already there.
+ */
+static void
+addAnimation(AnimKind kind, ScreenInfo *scr, TwmWindow *win, int button,
+             VirtualScreen *vs, WorkSpace *ws)
 {
-	struct timeval  tp;
-	static unsigned long lastsec;
-	static long lastusec;
-	unsigned long gap;
+	Animation *a;
 
-	if(Animating > 1) {
-		return;        /* rate limiting */
+	for(a = animations; a != NULL; a = a->next) {
+		if(a->kind == kind && a->scr == scr && a->win == win
+		                && a->button == button && a->vs == vs && a->ws == ws) {
+			return;
+		}
 	}
 
-	gettimeofday(&tp, NULL);
-	gap = ((tp.tv_sec - lastsec) * 1000000) + (tp.tv_usec - lastusec);
-	if(tracefile) {
-		fprintf(tracefile, "Time = %lu, %ld, %ld, %ld, %lu\n", lastsec,
-		        lastusec, (long)tp.tv_sec, (long)tp.tv_usec, gap);
-		fflush(tracefile);
+	a = calloc(1, sizeof(*a));
+	if(a == NULL) {
+		return;
 	}
-	gap *= AnimationSpeed;
-	if(gap < 1000000) {
+	a->kind = kind;
+	a->scr = scr;
+	a->win = win;
+	a->button = button;
+	a->vs = vs;
+	a->ws = ws;
+	if(!stillAnimating(a)) {
+		free(a);
 		return;
 	}
-	if(tracefile) {
-		fprintf(tracefile, "Animate\n");
-		fflush(tracefile);
+
+	a->next = animations;
+	animations = a;
+	scheduleFrame();
+}
+
+
+/**
+ * Look over a window (on the current screen) that's just come into view
+ * or changed, and start animating any of its bits that should be.
+ */
+void
+AnimationAddWindow(TwmWindow *t)
+{
+	ScreenInfo *scr = Scr;
+	int nb;
+
+	if(t == NULL) {
+		return;
+	}
+
+	if(t->icon_on && t->icon && t->icon->image && t->icon->image->next) {
+		addAnimation(AN_ICON, scr, t, 0, NULL, NULL);
+	}
+	else if(t->mapped && t->titlebuttons) {
+		nb = scr->TBInfo.nleft + scr->TBInfo.nright;
+		for(int i = 0; i < nb; i++) {
+			if(t->titlebuttons[i].image && t->titlebuttons[i].image->next) {
+				addAnimation(AN_BUTTON, scr, t, i, NULL, NULL);
+			}
+		}
+	}
+	if(t->hasfocusvisible && t->HiliteImage && t->HiliteImage->next) {
+		addAnimation(AN_HIGHLIGHT, scr, t, 0, NULL, NULL);
+	}
+}
+
+
+/**
+ * A window's going away; stop referring to it.
+ */
+void
+AnimationForgetWindow(TwmWindow *t)
+{
+	Animation **pp = &animations;
+
+	while(*pp != NULL) {
+		Animation *a = *pp;
+		if(a->win == t) {
+			*pp = a->next;
+			free(a);
+			continue;
+		}
+		pp = &a->next;
 	}
-	Animate();
-	lastsec  = tp.tv_sec;
-	lastusec = tp.tv_usec;
 }
 
 
+/**
+ * Look for animated workspace backgrounds on a screen, after switching
+ * workspaces or changing the WSM's state.
+ */
+void
+AnimationAddRoot(ScreenInfo *scr)
+{
+	for(VirtualScreen *vs = scr->vScreenList; vs != NULL; vs = vs->next) {
+		if(vs->wsw == NULL) {
+			continue;
+		}
+		addAnimation(AN_ROOT, scr, NULL, 0, vs, NULL);
+		for(WorkSpace *ws = scr->workSpaceMgr.workSpaceList; ws != NULL;
+		                ws = ws->next) {
+			addAnimation(AN_WSMAP, scr, NULL, 0, vs, ws);
+		}
+	}
+}
+
 
 void
 StartAnimation(void)
@@ -97,18 +273,11 @@ StartAnimation(void)
 	if(AnimationActive) {
 		return;
 	}
-	switch(AnimationSpeed) {
-		case 0 :
-			return;
-		case 1 :
-			AnimateTimeout.tv_sec  = 1;
-			AnimateTimeout.tv_usec = 0;
-			break;
-		default :
-			AnimateTimeout.tv_sec  = 0;
-			AnimateTimeout.tv_usec = 1000000 / AnimationSpeed;
+	if(AnimationSpeed == 0) {
+		return;
 	}
 	AnimationActive = true;
+	scheduleFrame();
 }
 
 
@@ -116,6 +285,7 @@ void
 StopAnimation(void)
 {
 	AnimationActive = false;
+	scheduleFrame();
 }
 
 
@@ -147,87 +317,57 @@ ModifyAnimationSpeed(int incr)
 		AnimationSpeed = MAXANIMATIONSPEED;
 	}
 
-	if(AnimationSpeed == 1) {
-		AnimateTimeout.tv_sec  = 1;
-		AnimateTimeout.tv_usec = 0;
-	}
-	else {
-		AnimateTimeout.tv_sec  = 0;
-		AnimateTimeout.tv_usec = 1000000 / AnimationSpeed;
-	}
 	AnimationActive = true;
+	TimerCancel(&frameTimer);
+	scheduleFrame();
 }
 
 
 
 /*
- * Only called from TryToAnimate
+ * Frame timer callback: step everything on the list along.
  */
 static void
-Animate(void)
+AnimateFrame(void *arg)
 {
-	TwmWindow   *t;
-	int         scrnum;
-	ScreenInfo  *scr;
-	int         i;
-	TBWindow    *tbw;
-	int         nb;
+	Animation **pp = &animations;
 
-	if(AnimationSpeed == 0) {
-		return;
-	}
-	if(Animating > 1) {
-		return;        /* rate limiting */
+	if(tracefile) {
+		fprintf(tracefile, "Animate\n");
+		fflush(tracefile);
 	}
 
-	/* Impossible? */
-	if(NumScreens < 1) {
-		return;
-	}
+	while(*pp != NULL) {
+		Animation *a = *pp;
 
-	MaybeAnimate = false;
-	scr = NULL;
-	for(scrnum = 0; scrnum < NumScreens; scrnum++) {
-		if((scr = ScreenList [scrnum]) == NULL) {
+		if(!stillAnimating(a)) {
+			*pp = a->next;
+			free(a);
 			continue;
 		}
 
-		for(t = scr->FirstWindow; t != NULL; t = t->next) {
-			if(! visible(t)) {
-				continue;
-			}
-			if(t->icon_on && t->icon && t->icon->bm_w && t->icon->image &&
-			                t->icon->image->next) {
-				AnimateIcons(scr, t->icon);
-				MaybeAnimate = true;
-			}
-			else if(t->mapped && t->titlebuttons) {
-				nb = scr->TBInfo.nleft + scr->TBInfo.nright;
-				for(i = 0, tbw = t->titlebuttons; i < nb; i++, tbw++) {
-					if(tbw->image && tbw->image->next) {
-						AnimateButton(tbw);
-						MaybeAnimate = true;
-					}
-				}
-			}
-		}
-		if(scr->Focus) {
-			t = scr->Focus;
-			if(t->mapped && t->titlehighlight && t->title_height &&
-			                t->HiliteImage && t->HiliteImage->next) {
-				AnimateHighlight(t);
-				MaybeAnimate = true;
-			}
+		switch(a->kind) {
+			case AN_ICON:
+				AnimateIcons(a->scr, a->win->icon);
+				break;
+			case AN_BUTTON:
+				AnimateButton(&a->win->titlebuttons[a->button]);
+				break;
+			case AN_HIGHLIGHT:
+				AnimateHighlight(a->win);
+				break;
+			case AN_ROOT:
+				AnimateRoot(a->scr, a->vs);
+				break;
+			case AN_WSMAP:
+				AnimateWSMap(a->vs, a->ws);
+				break;
 		}
+		pp = &a->next;
 	}
-	MaybeAnimate |= AnimateRoot();
-	if(MaybeAnimate) {
-		Animating++;
-		send_clientmessage(scr->currentvs->wsw->w, XA_WM_END_OF_ANIMATION,
-		                   EventTime);
-	}
+
 	XFlush(dpy);
-	return;
+	scheduleFrame();
 }
 
 
@@ -306,67 +446,22 @@ AnimateIcons(ScreenInfo *scr, Icon *icon)
 
 
 /* Original in workmgr.c */
-static bool
-AnimateRoot(void)
+static void
+AnimateRoot(ScreenInfo *scr, VirtualScreen *vs)
 {
-	VirtualScreen *vs;
-	ScreenInfo *scr;
-	int        scrnum;
-	Image      *image;
-	WorkSpace  *ws;
-	bool       maybeanimate;
-
-	maybeanimate = false;
-	for(scrnum = 0; scrnum < NumScreens; scrnum++) {
-		if((scr = ScreenList [scrnum]) == NULL) {
-			continue;
-		}
-		if(! scr->workSpaceManagerActive) {
-			continue;
-		}
+	Image *image = vs->wsw->currentwspc->image;
 
-		for(vs = scr->vScreenList; vs != NULL; vs = vs->next) {
-			if(! vs->wsw->currentwspc) {
-				continue;
-			}
-			image = vs->wsw->currentwspc->image;
-			if((image == NULL) || (image->next == NULL)) {
-				continue;
-			}
-			if(scr->DontPaintRootWindow) {
-				continue;
-			}
+	XSetWindowBackgroundPixmap(dpy, vs->window, image->pixmap);
+	XClearWindow(dpy, scr->Root);
+	vs->wsw->currentwspc->image = image->next;
+}
 
-			XSetWindowBackgroundPixmap(dpy, vs->window, image->pixmap);
-			XClearWindow(dpy, scr->Root);
-			vs->wsw->currentwspc->image = image->next;
-			maybeanimate = true;
-		}
-	}
-	for(scrnum = 0; scrnum < NumScreens; scrnum++) {
-		if((scr = ScreenList [scrnum]) == NULL) {
-			continue;
-		}
+static void
+AnimateWSMap(VirtualScreen *vs, WorkSpace *ws)
+{
+	Image *image = ws->image;
 
-		for(vs = scr->vScreenList; vs != NULL; vs = vs->next) {
-			if(vs->wsw->state == WMS_buttons) {
-				continue;
-			}
-			for(ws = scr->workSpaceMgr.workSpaceList; ws != NULL; ws = ws->next) {
-				image = ws->image;
-
-				if((image == NULL) || (image->next == NULL)) {
-					continue;
-				}
-				if(ws == vs->wsw->currentwspc) {
-					continue;
-				}
-				XSetWindowBackgroundPixmap(dpy, vs->wsw->mswl [ws->number]->w, image->pixmap);
-				XClearWindow(dpy, vs->wsw->mswl [ws->number]->w);
-				ws->image = image->next;
-				maybeanimate = true;
-			}
-		}
-	}
-	return maybeanimate;
+	XSetWindowBackgroundPixmap(dpy, vs->wsw->mswl [ws->number]->w, image->pixmap);
+	XClearWindow(dpy, vs->wsw->mswl [ws->number]->w);
+	ws->image = image->next;
 }
@@ -6,17 +6,16 @@
 #define _CTWM_ANIMATE_H
 
 /* Current code requires these to be leaked */
-extern int Animating;
 extern bool AnimationActive;
-extern bool MaybeAnimate;
 extern int AnimationSpeed;
-extern struct timeval AnimateTimeout;
 
 
 void StartAnimation(void);
 void StopAnimation(void);
 void SetAnimationSpeed(int speed);
 void ModifyAnimationSpeed(int incr);
-void TryToAnimate(void);
+void AnimationAddWindow(TwmWindow *t);
+void AnimationForgetWindow(TwmWindow *t);
+void AnimationAddRoot(ScreenInfo *scr);
 
 #endif /* _CTWM_ANIMATE_H */
@@ -47,6 +47,53 @@ static bool DontRedirect(Window window);
 
 static Atom XA_WM_CTWM_ROOT_our_name;
 
+
+/*
+ * What a client's WM_COMMAND asks for, by way of -xrm ctwm.redirect and
+ * ctwm.rootWindow.  That only depends on the command, so we remember
+ * the last few; a client opening a pile of windows only gets parsed
+ * once.
+ */
+typedef struct RedirectRequest {
+	char   *cmd;        ///< WM_COMMAND, \0-separated
+	size_t len;
+	char   *name;       ///< ctwm.redirect, or NULL
+	Window rootw;       ///< ctwm.rootWindow, or None
+} RedirectRequest;
+
+#define REDIRECT_CACHE_SIZE 16
+static RedirectRequest requests[REDIRECT_CACHE_SIZE];
+static int nextRequest;
+
+
+/*
+ * Client leaders whose windows we've found don't ask to be redirected.
+ * A client's windows all share its leader, and its command line, so
+ * after the first one we can skip the rest on the strength of their
+ * WM_CLIENT_LEADER alone.  Leaders get dropped when they go away, since
+ * the XID can be reused; see CaptiveLeaderGone().
+ */
+#define NOREDIRECT_CACHE_SIZE 16
+static Window noRedirectLeaders[NOREDIRECT_CACHE_SIZE];
+static int nextNoRedirect;
+
+
+/*
+ * What WM_CTWM_ROOT_<name> on the root says for captives we've looked
+ * up.  Thrown away when it, or WM_CTWMSLIST, changes; see
+ * CaptiveRootPropertyChange().  And when it turns out not to work, in
+ * case we missed that.
+ */
+typedef struct CaptiveRoot {
+	struct CaptiveRoot *next;
+	int    scrnum;
+	char   *name;
+	Atom   atom;        ///< WM_CTWM_ROOT_<name>
+	Window root;        ///< What it holds, or None if nothing useful
+} CaptiveRoot;
+
+static CaptiveRoot *captiveRoots;
+
 /* XXX Share with occupation.c? */
 static XrmOptionDescRec table [] = {
 	{"-xrm",            NULL,           XrmoptionResArg, (XPointer) NULL},
@@ -54,137 +101,338 @@ static XrmOptionDescRec table [] = {
 
 
 /*
- * Reparent a window over to a captive ctwm, if we should.
+ * Find a window's WM_CLIENT_LEADER, or None if it hasn't one.
  */
-bool
-RedirectToCaptive(Window window)
+static Window
+GetClientLeader(Window window)
 {
-	unsigned long       nitems, bytesafter;
-	Atom                actual_type;
-	int                 actual_format;
-	Bool                status;
-	char                *str_type;
-	XrmValue            value;
-	bool                ret;
-	char                *atomname;
-	XrmDatabase         db = NULL;
-
-	/* NOREDIRECT property set?  Leave it alone. */
-	if(DontRedirect(window)) {
-		return false;
+	Window *prop = NULL;
+	Window leader = None;
+	unsigned long nitems, bytesafter;
+	Atom actual_type;
+	int actual_format;
+
+	if(XGetWindowProperty(dpy, window, XA_WM_CLIENT_LEADER,
+	                      0L, 1L, False, AnyPropertyType,
+	                      &actual_type, &actual_format,
+	                      &nitems, &bytesafter,
+	                      (unsigned char **)&prop) == Success
+	                && actual_type == XA_WINDOW && actual_format == 32
+	                && nitems == 1) {
+		leader = *prop;
+	}
+	if(prop != NULL) {
+		XFree(prop);
 	}
+	return leader;
+}
 
-	/* Figure out what sort of -xrm stuff it might have */
-	{
-		char **cliargv = NULL;
-		int  cliargc;
 
-		/* Get its command-line */
-		if(!XGetCommand(dpy, window, &cliargv, &cliargc)) {
-			/* Can't tell, bail */
-			return false;
+/**
+ * Note that a window has gone away, in case it was a client leader we
+ * were remembering.
+ */
+void
+CaptiveLeaderGone(Window window)
+{
+	for(int i = 0; i < NOREDIRECT_CACHE_SIZE; i++) {
+		if(noRedirectLeaders[i] == window) {
+			noRedirectLeaders[i] = None;
 		}
+	}
+}
+
 
-		XrmParseCommand(&db, table, 1, "ctwm", &cliargc, cliargv);
-		if(cliargv) {
+/*
+ * Find (or work out) what a window's command line asks for.  NULL if it
+ * doesn't have one.
+ */
+static const RedirectRequest *
+GetRedirectRequest(Window window)
+{
+	char **cliargv = NULL;
+	int  cliargc;
+	char *cmd, *p;
+	size_t len;
+	RedirectRequest *req;
+	XrmDatabase db = NULL;
+	char *str_type;
+	XrmValue value;
+
+	/* Get its command-line */
+	if(!XGetCommand(dpy, window, &cliargv, &cliargc)) {
+		/* Can't tell, bail */
+		return NULL;
+	}
+
+	/* Seen it before? */
+	len = 0;
+	for(int i = 0; i < cliargc; i++) {
+		len += strlen(cliargv[i]) + 1;
+	}
+	cmd = malloc(len + 1);
+	if(cmd == NULL) {
+		XFreeStringList(cliargv);
+		return NULL;
+	}
+	p = cmd;
+	for(int i = 0; i < cliargc; i++) {
+		strcpy(p, cliargv[i]);
+		p += strlen(cliargv[i]) + 1;
+	}
+	for(int i = 0; i < REDIRECT_CACHE_SIZE; i++) {
+		if(requests[i].cmd && requests[i].len == len
+		                && memcmp(requests[i].cmd, cmd, len) == 0) {
+			free(cmd);
 			XFreeStringList(cliargv);
+			return &requests[i];
 		}
 	}
 
-	/* Bail if we didn't get any info */
+	/* No; figure out what sort of -xrm stuff it might have */
+	req = &requests[nextRequest];
+	nextRequest = (nextRequest + 1) % REDIRECT_CACHE_SIZE;
+	free(req->cmd);
+	free(req->name);
+	req->cmd = cmd;
+	req->len = len;
+	req->name = NULL;
+	req->rootw = None;
+
+	XrmParseCommand(&db, table, 1, "ctwm", &cliargc, cliargv);
+	XFreeStringList(cliargv);
 	if(db == NULL) {
-		return false;
+		return req;
 	}
 
-	ret = false;
+	/*
+	 * "-xrm ctwm.redirect" should contain a captive name.  e.g., what
+	 * ctwm was started with via --name, or an autogen'd name if no
+	 * --name was given.
+	 */
+	if(XrmGetResource(db, "ctwm.redirect", "Ctwm.Redirect", &str_type,
+	                  &value) == True && value.size != 0) {
+		req->name = strdup(value.addr);
+	}
 
 	/*
-	 * Check "-xrm ctwm.redirect" to see if that says what to do.  It
-	 * should contain a captive name.  e.g., what ctwm was started with
-	 * via --name, or an autogen'd name if no --name was given.
-	 * */
-	status = XrmGetResource(db, "ctwm.redirect", "Ctwm.Redirect", &str_type,
-	                        &value);
-	if((status == True) && (value.size != 0)) {
-		/* Yep, we're asked for one.  Find it. */
-		Window  *prop;
-		Atom    XA_WM_CTWM_ROOT_name;
-		int     gpret;
-
-		asprintf(&atomname, "WM_CTWM_ROOT_%s", value.addr);
-		/*
-		 * Set only_if_exists to True: the atom for the requested
-		 * captive ctwm won't exist if the captive ctwm itself does not exist.
-		 * There is no reason to go and create random atoms just to
-		 * check.
-		 */
-		XA_WM_CTWM_ROOT_name = XInternAtom(dpy, atomname, True);
-		free(atomname);
+	 * ctwm.rootWindow may contain a (hex) X window identifier, which we
+	 * should parent into.
+	 */
+	if(XrmGetResource(db, "ctwm.rootWindow", "Ctwm.RootWindow", &str_type,
+	                  &value) == True && value.size != 0) {
+		char rootw [32];
+		unsigned long int scanned;
 
-		/*
-		 * Got the atom?  Lookup the property it keys for, which holds a
-		 * Window identifier.
-		 * */
-		gpret = !Success;
-		prop = NULL;
-		if(XA_WM_CTWM_ROOT_name != None) {
-			gpret = XGetWindowProperty(dpy, Scr->Root, XA_WM_CTWM_ROOT_name,
-			                           0L, 1L, False, AnyPropertyType,
-			                           &actual_type, &actual_format,
-			                           &nitems, &bytesafter,
-			                           (unsigned char **)&prop);
+		safe_strncpy(rootw, value.addr, sizeof(rootw));
+		if(sscanf(rootw, "%lx", &scanned) == 1) {
+			req->rootw = scanned;
 		}
+	}
 
-		/*
-		 * Got the property?  Make sure it's the right type.  If so, make
-		 * sure the window it points at exists.
-		 */
-		if(gpret == Success
-		                && actual_type == XA_WINDOW && actual_format == 32 &&
-		                nitems == 1 /*&& bytesafter == 0*/) {
-			Window newroot = *prop;
-			XWindowAttributes dummy_wa;
-
-			if(XGetWindowAttributes(dpy, newroot, &dummy_wa)) {
-				/* Well, it must be where we should redirect to, so do it */
-				XReparentWindow(dpy, window, newroot, 0, 0);
-				XMapWindow(dpy, window);
-				ret = true;
-			}
+	/* Cleanup xrm bits */
+	XrmDestroyDatabase(db);
+
+	return req;
+}
+
+
+/*
+ * Find the root window of a captive ctwm by name, via the
+ * WM_CTWM_ROOT_<name> property it sets on our root.  *cached says
+ * whether it's what we found some earlier time.
+ */
+static Window
+CaptiveRootByName(const char *name, bool *cached)
+{
+	const int scrnum = Scr->screen;
+	CaptiveRoot *cr;
+	char *atomname;
+	Atom atom;
+	Window *prop = NULL;
+	Window croot = None;
+	unsigned long nitems, bytesafter;
+	Atom actual_type;
+	int actual_format;
+
+	for(cr = captiveRoots; cr != NULL; cr = cr->next) {
+		if(cr->scrnum == scrnum && strcmp(cr->name, name) == 0) {
+			*cached = true;
+			return cr->root;
+		}
+	}
+	*cached = false;
+
+	/*
+	 * Set only_if_exists to True: the atom for the requested captive
+	 * ctwm won't exist if the captive ctwm itself does not exist.  There
+	 * is no reason to go and create random atoms just to check.  Nor to
+	 * remember it, since we'd have nothing to tell us when it does turn
+	 * up.
+	 */
+	asprintf(&atomname, "WM_CTWM_ROOT_%s", name);
+	atom = XInternAtom(dpy, atomname, True);
+	free(atomname);
+	if(atom == None) {
+		return None;
+	}
+
+	/*
+	 * Got the atom?  Lookup the property it keys for, which holds a
+	 * Window identifier.  Make sure it's the right type.
+	 */
+	if(XGetWindowProperty(dpy, RootWindow(dpy, scrnum), atom,
+	                      0L, 1L, False, AnyPropertyType,
+	                      &actual_type, &actual_format,
+	                      &nitems, &bytesafter,
+	                      (unsigned char **)&prop) == Success
+	                && actual_type == XA_WINDOW && actual_format == 32 &&
+	                nitems == 1 /*&& bytesafter == 0*/) {
+		croot = *prop;
+	}
+	if(prop != NULL) {
+		XFree(prop);
+	}
+
+	cr = malloc(sizeof(CaptiveRoot));
+	if(cr != NULL) {
+		cr->scrnum = scrnum;
+		cr->name = strdup(name);
+		cr->atom = atom;
+		cr->root = croot;
+		cr->next = captiveRoots;
+		captiveRoots = cr;
+	}
+
+	return croot;
+}
+
+
+/*
+ * Throw away what we had for a captive; it's turned out to be wrong.
+ */
+static void
+CaptiveRootForget(const char *name)
+{
+	CaptiveRoot **crp = &captiveRoots;
+
+	while(*crp != NULL) {
+		CaptiveRoot *cr = *crp;
+
+		if(cr->scrnum == Scr->screen && strcmp(cr->name, name) == 0) {
+			*crp = cr->next;
+			free(cr->name);
+			free(cr);
+			return;
 		}
-		if(prop != NULL) {
-			XFree(prop);
+		crp = &cr->next;
+	}
+}
+
+
+/**
+ * Note a property change on a root window, in case it's about the
+ * captives inside us.
+ */
+void
+CaptiveRootPropertyChange(int scrnum, Atom atom)
+{
+	CaptiveRoot **crp = &captiveRoots;
+
+	while(*crp != NULL) {
+		CaptiveRoot *cr = *crp;
+
+		if(cr->scrnum == scrnum
+		                && (atom == XA_WM_CTWMSLIST || atom == cr->atom)) {
+			*crp = cr->next;
+			free(cr->name);
+			free(cr);
+			continue;
 		}
+		crp = &cr->next;
+	}
+}
 
-		/* XXX Should we return here if we did the Reparent? */
+
+/*
+ * Move a window over into another root, if that's really a window.
+ */
+static bool
+ReparentToRoot(Window window, Window newroot)
+{
+	XWindowAttributes dummy_wa;
+
+	if(!XGetWindowAttributes(dpy, newroot, &dummy_wa)) {
+		return false;
+	}
+	XReparentWindow(dpy, window, newroot, 0, 0);
+	XMapWindow(dpy, window);
+	return true;
+}
+
+
+/*
+ * Reparent a window over to a captive ctwm, if we should.
+ */
+bool
+RedirectToCaptive(Window window)
+{
+	const RedirectRequest *req;
+	const Window leader = GetClientLeader(window);
+	bool ret = false;
+
+	/* Already know this client doesn't want anything? */
+	if(leader != None) {
+		for(int i = 0; i < NOREDIRECT_CACHE_SIZE; i++) {
+			if(noRedirectLeaders[i] == leader) {
+				return false;
+			}
+		}
 	}
 
+	/* NOREDIRECT property set?  Leave it alone. */
+	if(DontRedirect(window)) {
+		return false;
+	}
 
-	/*
-	 * Check ctwm.rootWindow; it may contain a (hex) X window identifier,
-	 * which we should parent into.
-	 * */
-	status = XrmGetResource(db, "ctwm.rootWindow", "Ctwm.RootWindow", &str_type,
-	                        &value);
-	if((status == True) && (value.size != 0)) {
-		char rootw [32];
-		unsigned long int scanned;
+	/* Bail if we didn't get any info, remembering that for next time */
+	req = GetRedirectRequest(window);
+	if(req == NULL || (req->name == NULL && req->rootw == None)) {
+		if(leader != None) {
+			noRedirectLeaders[nextNoRedirect] = leader;
+			nextNoRedirect = (nextNoRedirect + 1) % NOREDIRECT_CACHE_SIZE;
+		}
+		return false;
+	}
 
-		safe_strncpy(rootw, value.addr, sizeof(rootw));
-		if(sscanf(rootw, "%lx", &scanned) == 1) {
-			Window newroot = scanned;
-			XWindowAttributes dummy_wa;
+	/* Asked for a captive by name?  Find it. */
+	if(req->name != NULL) {
+		bool cached;
+		Window newroot = CaptiveRootByName(req->name, &cached);
 
-			if(XGetWindowAttributes(dpy, newroot, &dummy_wa)) {
-				XReparentWindow(dpy, window, newroot, 0, 0);
-				XMapWindow(dpy, window);
+		if(newroot != None && ReparentToRoot(window, newroot)) {
+			ret = true;
+		}
+		else if(cached) {
+			/*
+			 * What we remembered is gone, or it wasn't there yet when
+			 * we looked; either way we may have missed hearing about
+			 * it, so go look again.
+			 */
+			CaptiveRootForget(req->name);
+			newroot = CaptiveRootByName(req->name, &cached);
+			if(newroot != None && ReparentToRoot(window, newroot)) {
 				ret = true;
 			}
 		}
+
+		/* XXX Should we return here if we did the Reparent? */
 	}
 
-	/* Cleanup xrm bits */
-	XrmDestroyDatabase(db);
+	/* Or a window to go into */
+	if(req->rootw != None && ReparentToRoot(window, req->rootw)) {
+		ret = true;
+	}
 
 	/* Whatever we found */
 	return ret;
@@ -307,8 +555,8 @@ SetCaptivesList(int scrnum, char **clist)
 char *
 AddToCaptiveList(const char *cptname)
 {
-	int         i, count;
-	char        **clist, **cl, **newclist;
+	int         i;
+	char        **clist, **cl;
 	int         busy [32];
 	char        *atomname;
 	int         scrnum = Scr->screen;
@@ -325,10 +573,7 @@ AddToCaptiveList(const char *cptname)
 	 */
 	clist = GetCaptivesList(scrnum);
 	cl = clist;
-	count = 0;
 	while(cl && *cl) {
-		count++;
-
 		/*
 		 * If we're not given a cptname, we use this loop to mark up
 		 * which auto-gen'd names have been used.
@@ -390,16 +635,7 @@ AddToCaptiveList(const char *cptname)
 	}
 
 
-	/* Put together new list of captives */
-	newclist = calloc(count + 2, sizeof(char *));
-	for(i = 0; i < count; i++) {
-		newclist[i] = strdup(clist[i]);
-	}
-	newclist[count] = strdup(rcname);
-	newclist[count + 1] = NULL;
-	SetCaptivesList(scrnum, newclist);
 	freeCaptivesList(clist);
-	freeCaptivesList(newclist);
 
 	/* Stash property/atom of our captivename */
 	root = RootWindow(dpy, scrnum);
@@ -409,6 +645,16 @@ AddToCaptiveList(const char *cptname)
 	XChangeProperty(dpy, root, XA_WM_CTWM_ROOT_our_name, XA_WINDOW, 32,
 	                PropModeReplace, (unsigned char *) &croot, 1);
 
+	/*
+	 * And add ourselves to the list of captives.  That's done last, so
+	 * anyone who sees us there can find our root, and by appending,
+	 * rather than rewriting the list, so we can't lose anyone else who
+	 * came along in the meantime.
+	 */
+	XChangeProperty(dpy, root, XA_WM_CTWMSLIST, XA_STRING, 8,
+	                PropModeAppend, (unsigned char *) rcname,
+	                strlen(rcname) + 1);
+
 	/*
 	 * Tell our caller the name we wound up with, in case they didn't
 	 * give us one we could use.
@@ -433,7 +679,12 @@ RemoveFromCaptiveList(const char *cptname)
 		return;
 	}
 
-	/* Take us out of the captives list in WM_CTWMSLIST */
+	/*
+	 * Take us out of the captives list in WM_CTWMSLIST.  That means
+	 * rewriting the whole thing, so hold the server while we do, or we
+	 * could lose somebody's AddToCaptiveList() append in between.
+	 */
+	XGrabServer(dpy);
 	clist = GetCaptivesList(scrnum);
 	if(clist && *clist) {
 		char **cl = clist;
@@ -454,6 +705,7 @@ RemoveFromCaptiveList(const char *cptname)
 
 		/* If we weren't there, there's nothing to do */
 		if(!found) {
+			XUngrabServer(dpy);
 			freeCaptivesList(clist);
 			return;
 		}
@@ -485,6 +737,7 @@ RemoveFromCaptiveList(const char *cptname)
 		SetCaptivesList(scrnum, newclist);
 		free(newclist);
 	}
+	XUngrabServer(dpy);
 	freeCaptivesList(clist);
 
 	/* And delete our CTWM_ROOT_x property */
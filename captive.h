@@ -13,6 +13,8 @@ typedef struct CaptiveCTWM {
 
 
 bool RedirectToCaptive(Window window);
+void CaptiveRootPropertyChange(int scrnum, Atom atom);
+void CaptiveLeaderGone(Window window);
 char *AddToCaptiveList(const char *cptname);
 void RemoveFromCaptiveList(const char *cptname);
 void SetPropsIfCaptiveCtwm(TwmWindow *win);
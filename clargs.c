@@ -28,6 +28,7 @@ ctwm_cl_args CLarg = {
 	.MultiScreen     = true,
 	.Monochrome      = false,
 	.cfgchk          = false,
+	.ProfileStartup  = false,
 	.InitFile        = NULL,
 	.display_name    = NULL,
 	.PrintErrorMessages = false,
@@ -43,6 +44,7 @@ ctwm_cl_args CLarg = {
 	.KeepTmpFile     = false,
 	.keepM4_filename = NULL,
 	.GoThroughM4     = true,
+	.UseM4Cache      = true,
 #endif
 #ifdef EWMH
 	.ewmh_replace    = false,
@@ -75,6 +77,7 @@ clargs_parse(int argc, char *argv[])
 		/* Config/file related */
 		{ "file",      required_argument, NULL, 'f' },
 		{ "cfgchk",    no_argument,       NULL, 0 },
+		{ "profile-startup", no_argument, NULL, 0 },
 
 		/* Show something and exit right away */
 		{ "help",      no_argument,       NULL, 'h' },
@@ -97,6 +100,7 @@ clargs_parse(int argc, char *argv[])
 		{ "keep-defs", no_argument,       NULL, 'k' },
 		{ "keep",      required_argument, NULL, 'K' },
 		{ "nom4",      no_argument,       NULL, 'n' },
+		{ "nom4cache", no_argument,       NULL, 0 },
 #endif
 
 		/* Random session-related bits */
@@ -222,6 +226,16 @@ clargs_parse(int argc, char *argv[])
 					CLarg.cfgchk = true;
 					break;
 				}
+				IFIS("profile-startup") {
+					CLarg.ProfileStartup = true;
+					break;
+				}
+#ifdef USEM4
+				IFIS("nom4cache") {
+					CLarg.UseM4Cache = false;
+					break;
+				}
+#endif
 #ifdef EWMH
 				IFIS("replace") {
 					CLarg.ewmh_replace = true;
@@ -364,12 +378,14 @@ usage(void)
 
 #ifdef USEM4
 	fprintf(stderr, "%*s[--nom4 | -n]  [--keep-defs | -k]  "
-	        "[(--keep | -K) m4file]\n", llen, "");
+	        "[(--keep | -K) m4file]  [--nom4cache]\n", llen, "");
 #endif
 
 	fprintf(stderr, "%*s[--verbose | -v]  [--quiet | -q]  [--mono]  "
 	        "[--xrm resource]\n", llen, "");
 
+	fprintf(stderr, "%*s[--profile-startup]\n", llen, "");
+
 	fprintf(stderr, "%*s[--version]  [--info]  [--nowelcome | -W]\n",
 	        llen, "");
 
@@ -20,6 +20,7 @@ set(CTWMSRC
 	captive.c
 	clargs.c
 	clicktofocus.c
+	color_cache.c
 	colormaps.c
 	ctopts.c
 	ctwm_main.c
@@ -31,6 +32,7 @@ set(CTWMSRC
 	event_handlers.c
 	event_names.c
 	event_utils.c
+	font_cache.c
 	functions.c
 	functions_captive.c
 	functions_icmgr_wsmgr.c
@@ -47,7 +49,9 @@ set(CTWMSRC
 	image.c
 	image_bitmap.c
 	image_bitmap_builtin.c
+	image_upload.c
 	image_xwd.c
+	launcher.c
 	list.c
 	mask_screen.c
 	menus.c
@@ -57,14 +61,19 @@ set(CTWMSRC
 	parse.c
 	parse_be.c
 	parse_yacc.c
+	profile.c
+	prop_writer.c
 	r_area.c
 	r_area_list.c
 	r_layout.c
+	reactor.c
 	session.c
 	signals.c
+	timers.c
 	util.c
 	vscreen.c
 	win_decorations.c
+	win_decorations_atlas.c
 	win_decorations_init.c
 	win_iconify.c
 	win_ops.c
@@ -14,6 +14,8 @@ option(USE_RPLAY  "Enable librplay sound support"      OFF)
 option(USE_SREGEX "Use regex from libc"                ON )
 option(USE_EWMH   "Support some Extended Window Manager Hints"  ON )
 option(USE_XRANDR "Enable Xrandr support"              ON )
+option(USE_XFT    "Enable Xft antialiased text support" OFF)
+option(USE_XSHM   "Enable MIT-SHM image uploads"        ON )
 
 
 
@@ -150,3 +152,41 @@ if(USE_XRANDR)
 else()
 	message(STATUS "Disabling Xrandr support.")
 endif(USE_XRANDR)
+
+
+# Xft text rendering is optional
+if(USE_XFT)
+	if(NOT X11_Xft_FOUND)
+		message(FATAL_ERROR "Couldn't find Xft libs")
+	endif(NOT X11_Xft_FOUND)
+
+	# Xft.h pulls in freetype's headers
+	find_package(Freetype)
+	if(NOT FREETYPE_FOUND)
+		message(FATAL_ERROR "Couldn't find freetype headers for Xft")
+	endif(NOT FREETYPE_FOUND)
+
+	include_directories(${X11_Xft_INCLUDE_PATH} ${FREETYPE_INCLUDE_DIRS})
+	list(APPEND CTWMLIBS ${X11_Xft_LIB})
+	message(STATUS "Enabling Xft text support: ${X11_Xft_LIB}")
+else()
+	message(STATUS "Disabling Xft text support.")
+endif(USE_XFT)
+
+
+# Shared memory for sending images to a local server
+if(USE_XSHM)
+	if(NOT X11_XShm_INCLUDE_PATH OR NOT X11_Xext_LIB)
+		message(FATAL_ERROR "Couldn't find MIT-SHM (libXext) headers and libs")
+	endif()
+	check_include_files(sys/shm.h HAS_SYS_SHM_H)
+	if(NOT HAS_SYS_SHM_H)
+		message(FATAL_ERROR "Couldn't find sys/shm.h for MIT-SHM")
+	endif(NOT HAS_SYS_SHM_H)
+
+	include_directories(${X11_XShm_INCLUDE_PATH})
+	list(APPEND CTWMLIBS ${X11_Xext_LIB})
+	message(STATUS "Enabling MIT-SHM image uploads: ${X11_Xext_LIB}")
+else()
+	message(STATUS "Disabling MIT-SHM image uploads.")
+endif(USE_XSHM)
@@ -39,3 +39,8 @@ check_function_exists(asprintf HAS_ASPRINTF)
 if(NOT HAS_ASPRINTF)
 	message(FATAL_ERROR "You don't seem to have asprintf(3).")
 endif(NOT HAS_ASPRINTF)
+
+
+
+# epoll(7) is Linux-only; the main loop falls back to poll(2) without it.
+check_include_files(sys/epoll.h HAS_EPOLL)
@@ -0,0 +1,254 @@
+/*
+ * Color name -> Pixel cache
+ *
+ * Every color in the config goes through GetColor(), which used to cost
+ * an XParseColor() and an XAllocColor() round trip each.  A typical
+ * config names the same handful of colors over and over (per-workspace
+ * colors, titles, borders, icon managers, menus, ...), and then
+ * GetShadeColors() does an XQueryColor() for each ColorPair on top.
+ *
+ * So we remember what every name resolved to, per colormap, for the
+ * whole run; ctwm never frees the colors it allocates, so the answers
+ * stay good.  The pixel side is indexed too, so the shading code can
+ * get a pixel's RGB back without asking the server.
+ *
+ * On TrueColor visuals there's nothing to allocate at all: the pixel
+ * value is just the RGB components packed into the visual's masks, so
+ * ColorTrueColorPixel() works it out the same way the server would.
+ */
+
+#include "ctwm.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "color_cache.h"
+
+
+/* Hash table sizes; must be powers of 2 */
+#define CC_NAME_BUCKETS  256
+#define CC_PIXEL_BUCKETS 256
+
+typedef struct ColorCacheEntry {
+	struct ColorCacheEntry *nnext;   ///< Next in name hash chain
+	struct ColorCacheEntry *pnext;   ///< Next in pixel hash chain
+	Colormap cmap;
+	unsigned int hash;
+	XColor col;
+	char name[];                     ///< Lowercased
+} ColorCacheEntry;
+
+static ColorCacheEntry *nameTable[CC_NAME_BUCKETS];
+static ColorCacheEntry *pixelTable[CC_PIXEL_BUCKETS];
+static ColorCacheStats stats;
+
+
+/*
+ * X color names are case-insensitive, so we hash and compare them
+ * lowercased.
+ */
+static unsigned int
+hashName(Colormap cmap, const char *name)
+{
+	unsigned int h = 2166136261u;
+
+	h = (h ^ (unsigned int)cmap) * 16777619u;
+	for(; *name; name++) {
+		h = (h ^ (unsigned char)tolower((unsigned char)*name)) * 16777619u;
+	}
+	return h;
+}
+
+#define PIXEL_BUCKET(cmap, pix) \
+	(((pix) ^ ((pix) >> 8) ^ (cmap)) & (CC_PIXEL_BUCKETS - 1))
+
+
+/**
+ * Look up a color name.  On a hit, fills in col (pixel and the RGB it
+ * actually got) and returns true.
+ */
+bool
+ColorCacheLookup(Colormap cmap, const char *name, XColor *col)
+{
+	ColorCacheEntry *e;
+	unsigned int hash = hashName(cmap, name);
+
+	for(e = nameTable[hash & (CC_NAME_BUCKETS - 1)]; e != NULL; e = e->nnext) {
+		if(e->hash == hash && e->cmap == cmap
+		                && strcasecmp(e->name, name) == 0) {
+			*col = e->col;
+			stats.hits++;
+			return true;
+		}
+	}
+
+	stats.misses++;
+	return false;
+}
+
+
+/**
+ * Remember what a color name resolved to.  col should have the pixel
+ * and its actual RGB values, as XAllocColor() leaves them.
+ */
+void
+ColorCacheAdd(Colormap cmap, const char *name, const XColor *col)
+{
+	ColorCacheEntry *e;
+	size_t len = strlen(name);
+	unsigned int hash = hashName(cmap, name);
+	unsigned int pb;
+
+	e = malloc(sizeof(*e) + len + 1);
+	if(e == NULL) {
+		return;
+	}
+	for(size_t i = 0; i <= len; i++) {
+		e->name[i] = tolower((unsigned char)name[i]);
+	}
+	e->cmap = cmap;
+	e->hash = hash;
+	e->col = *col;
+
+	e->nnext = nameTable[hash & (CC_NAME_BUCKETS - 1)];
+	nameTable[hash & (CC_NAME_BUCKETS - 1)] = e;
+	pb = PIXEL_BUCKET(cmap, col->pixel);
+	e->pnext = pixelTable[pb];
+	pixelTable[pb] = e;
+	stats.entries++;
+}
+
+
+/*
+ * Where a mask's bits sit, and how many there are.
+ */
+static void
+maskShape(unsigned long mask, int *shift, int *bits)
+{
+	*shift = *bits = 0;
+	if(mask == 0) {
+		return;
+	}
+	while(!(mask & 1)) {
+		mask >>= 1;
+		(*shift)++;
+	}
+	while(mask & 1) {
+		mask >>= 1;
+		(*bits)++;
+	}
+}
+
+static unsigned long
+packComponent(unsigned short val, unsigned long mask)
+{
+	int shift, bits;
+	unsigned long max;
+
+	maskShape(mask, &shift, &bits);
+	if(bits == 0) {
+		return 0;
+	}
+	max = (1UL << bits) - 1;
+
+	// Same rounding as the server's AllocColor() for TrueColor
+	return ((val * max + 0x8000) >> 16) << shift;
+}
+
+static unsigned short
+unpackComponent(unsigned long pixel, unsigned long mask)
+{
+	int shift, bits;
+	unsigned long max;
+
+	maskShape(mask, &shift, &bits);
+	if(bits == 0) {
+		return 0;
+	}
+	max = (1UL << bits) - 1;
+
+	return (((pixel & mask) >> shift) * 65535 + max / 2) / max;
+}
+
+
+/**
+ * Work out the pixel value for col's RGB on a TrueColor visual, without
+ * bothering the server.  The RGB values are adjusted to what that pixel
+ * actually shows, like XAllocColor() would.  Returns false (and leaves
+ * col alone) for any other sort of visual.
+ */
+bool
+ColorTrueColorPixel(const Visual *vis, XColor *col)
+{
+	if(vis == NULL || vis->class != TrueColor) {
+		return false;
+	}
+
+	col->pixel = packComponent(col->red,   vis->red_mask)
+	             | packComponent(col->green, vis->green_mask)
+	             | packComponent(col->blue,  vis->blue_mask);
+	col->red   = unpackComponent(col->pixel, vis->red_mask);
+	col->green = unpackComponent(col->pixel, vis->green_mask);
+	col->blue  = unpackComponent(col->pixel, vis->blue_mask);
+	stats.computed++;
+
+	return true;
+}
+
+
+/**
+ * Local equivalent of XQueryColor(): find the RGB for col->pixel.  vis
+ * is the visual of cmap if it's one whose pixels can be decoded
+ * directly, NULL otherwise.  Returns false if we don't know, and the
+ * caller needs to go ask.
+ */
+bool
+ColorCacheQuery(Colormap cmap, const Visual *vis, XColor *col)
+{
+	ColorCacheEntry *e;
+
+	if(vis != NULL && vis->class == TrueColor) {
+		col->red   = unpackComponent(col->pixel, vis->red_mask);
+		col->green = unpackComponent(col->pixel, vis->green_mask);
+		col->blue  = unpackComponent(col->pixel, vis->blue_mask);
+		stats.queried++;
+		return true;
+	}
+
+	for(e = pixelTable[PIXEL_BUCKET(cmap, col->pixel)]; e != NULL;
+	                e = e->pnext) {
+		if(e->cmap == cmap && e->col.pixel == col->pixel) {
+			col->red   = e->col.red;
+			col->green = e->col.green;
+			col->blue  = e->col.blue;
+			stats.queried++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * Current cache counters.
+ */
+const ColorCacheStats *
+ColorCacheGetStats(void)
+{
+	return &stats;
+}
+
+
+/**
+ * Say how many color lookups we saved the server.
+ */
+void
+ColorCacheReport(FILE *out)
+{
+	fprintf(out, "Color cache: %lu hits, %lu misses (%lu computed locally), "
+	        "%lu pixel queries; %u names\n", stats.hits, stats.misses,
+	        stats.computed, stats.queried, stats.entries);
+}
@@ -0,0 +1,28 @@
+/*
+ * Color name -> Pixel cache
+ */
+
+#ifndef _CTWM_COLOR_CACHE_H
+#define _CTWM_COLOR_CACHE_H
+
+#include <stdio.h>  // For FILE
+
+
+/// Counts of color lookups, for diagnostics
+typedef struct ColorCacheStats {
+	unsigned long hits;       ///< Names answered from the cache
+	unsigned long misses;     ///< Names we had to go resolve
+	unsigned long computed;   ///< ... of which needed no XAllocColor()
+	unsigned long queried;    ///< Pixel -> RGB lookups answered locally
+	unsigned int entries;     ///< Names currently cached
+} ColorCacheStats;
+
+bool ColorCacheLookup(Colormap cmap, const char *name, XColor *col);
+void ColorCacheAdd(Colormap cmap, const char *name, const XColor *col);
+bool ColorCacheQuery(Colormap cmap, const Visual *vis, XColor *col);
+bool ColorTrueColorPixel(const Visual *vis, XColor *col);
+const ColorCacheStats *ColorCacheGetStats(void);
+void ColorCacheReport(FILE *out);
+
+
+#endif /* _CTWM_COLOR_CACHE_H */
@@ -9,6 +9,7 @@
 
 #include "colormaps.h"
 #include "screen.h"
+#include "win_utils.h"
 
 
 /*
@@ -20,6 +21,18 @@ extern bool ColortableThrashing;
 static Bool UninstallRootColormapQScanner(Display *display, XEvent *ev,
                 char *args);
 
+/*
+ * Bumped whenever something changes that could change what
+ * InstallColormaps() would pick: the colormap window lists or their
+ * order, the colormaps on those windows, which of them are fully
+ * obscured, or the conflicts we've learned.  If none of that has moved
+ * since the last pass, and everything it picked is still installed,
+ * there's nothing to do.
+ */
+static unsigned long generation = 1;
+
+static ColormapStats stats;
+
 
 /***********************************************************************
  *
@@ -47,6 +60,29 @@ InstallWindowColormaps(int type, TwmWindow *tmp)
 }
 
 
+/*
+ * If everything the last pass over a list picked is still installed,
+ * how many that was; else -1.
+ */
+static int
+PickedInstalled(Colormaps *cmaps)
+{
+	int i, n = 0;
+
+	for(i = 0; i < cmaps->number_cwins; i++) {
+		TwmColormap *cmap = cmaps->cwins[i]->colormap;
+
+		if(cmap->state & CM_WANTED) {
+			if(!(cmap->state & CM_INSTALLED)) {
+				return -1;
+			}
+			n++;
+		}
+	}
+	return n;
+}
+
+
 bool
 InstallColormaps(int type, Colormaps *cmaps)
 {
@@ -70,17 +106,21 @@ InstallColormaps(int type, Colormaps *cmaps)
 			if(Scr->cmapInfo.root_pushes) {
 				return false;
 			}
-			/* Don't reload the current window colormap list.
-			if (Scr->cmapInfo.cmaps == cmaps)
-			    return false;
+			/*
+			 * Reloading the current list only needs doing if something's
+			 * changed; the check below sorts that out.
 			 */
+			if(Scr->cmapInfo.cmaps == cmaps) {
+				break;
+			}
 			if(Scr->cmapInfo.cmaps) {
 				for(i = Scr->cmapInfo.cmaps->number_cwins,
 				                cwins = Scr->cmapInfo.cmaps->cwins; i-- > 0; cwins++) {
-					(*cwins)->colormap->state &= ~CM_INSTALLABLE;
+					(*cwins)->colormap->state &= ~(CM_INSTALLABLE | CM_WANTED);
 				}
 			}
 			Scr->cmapInfo.cmaps = cmaps;
+			Scr->cmapInfo.picked_gen = 0;
 			break;
 
 		case PropertyNotify:
@@ -89,16 +129,26 @@ InstallColormaps(int type, Colormaps *cmaps)
 			break;
 	}
 
+	/* Same as last time, and still all in? */
+	if(Scr->cmapInfo.picked_gen == generation
+	                && (n = PickedInstalled(Scr->cmapInfo.cmaps)) >= 0) {
+		ColortableThrashing = false;
+		stats.cached++;
+		stats.avoided += n;
+		return true;
+	}
+
 	number_cwins = Scr->cmapInfo.cmaps->number_cwins;
 	cwins = Scr->cmapInfo.cmaps->cwins;
 	scoreboard = Scr->cmapInfo.cmaps->scoreboard;
 
 	ColortableThrashing = false; /* in case installation aborted */
+	stats.passes++;
 
 	state = CM_INSTALLED;
 
 	for(i = n = 0; i < number_cwins; i++) {
-		cwins[i]->colormap->state &= ~CM_INSTALL;
+		cwins[i]->colormap->state &= ~(CM_INSTALL | CM_WANTED);
 	}
 	for(i = n = 0; i < number_cwins && n < Scr->cmapInfo.maxCmaps; i++) {
 		cwin = cwins[i];
@@ -120,9 +170,10 @@ InstallColormaps(int type, Colormaps *cmaps)
 			n++;
 			maxcwin = &cwins[i];
 			state &= (cmap->state & CM_INSTALLED);
-			cmap->state |= CM_INSTALL;
+			cmap->state |= CM_INSTALL | CM_WANTED;
 		}
 	}
+	Scr->cmapInfo.picked_gen = generation;
 
 	// Hack: special-case startup
 	if(!dpy) {
@@ -139,6 +190,10 @@ InstallColormaps(int type, Colormaps *cmaps)
 				cmap->install_req = NextRequest(dpy);
 				/* printf ("XInstallColormap : %x, %x\n", cmap, cmap->c); */
 				XInstallColormap(dpy, cmap->c);
+				stats.installs++;
+			}
+			else {
+				stats.avoided++;
 			}
 			cmap->state |= CM_INSTALLED;
 			n--;
@@ -148,6 +203,39 @@ InstallColormaps(int type, Colormaps *cmaps)
 }
 
 
+/**
+ * Note that something InstallColormaps() bases its choices on has
+ * changed, so the next call has to work them out afresh.
+ */
+void
+ColormapsChanged(void)
+{
+	generation++;
+}
+
+
+/**
+ * Current counters.
+ */
+const ColormapStats *
+ColormapGetStats(void)
+{
+	return &stats;
+}
+
+
+/**
+ * Say how much colormap juggling we've done.
+ */
+void
+ColormapReport(FILE *out)
+{
+	fprintf(out, "Colormaps: %lu passes, %lu unchanged, %lu installs, "
+	        "%lu skipped, %lu conflicts kept\n", stats.passes, stats.cached,
+	        stats.installs, stats.avoided, stats.kept);
+}
+
+
 
 /***********************************************************************
  *
@@ -331,7 +419,7 @@ CreateColormapWindow(Window w, bool creating_parent, bool property_window)
 	                (attributes.your_event_mask &
 	                 (ColormapChangeMask | VisibilityChangeMask)) !=
 	                (ColormapChangeMask | VisibilityChangeMask)) {
-		XSelectInput(dpy, w, attributes.your_event_mask |
+		select_input(w, attributes.your_event_mask |
 		             (ColormapChangeMask | VisibilityChangeMask));
 	}
 
@@ -339,6 +427,58 @@ CreateColormapWindow(Window w, bool creating_parent, bool property_window)
 }
 
 
+/*
+ * Carry what's been learned about which of a window's colormaps knock
+ * each other out over to a new list of (some of) the same windows, so
+ * we don't have to thrash around finding out all over again.
+ */
+static void
+CarryScoreboard(Colormaps *from, ColormapWindow **cwins, int number_cwins,
+                char *scoreboard)
+{
+	int i, j, k, oi, oj;
+	int *map;
+
+	if(from->number_cwins < 2 || number_cwins < 2
+	                || !from->scoreboard || !scoreboard) {
+		return;
+	}
+	map = malloc(number_cwins * sizeof(int));
+	if(!map) {
+		return;
+	}
+
+	/* Where each window was in the old list */
+	for(i = 0; i < number_cwins; i++) {
+		map[i] = -1;
+		for(k = 0; k < from->number_cwins; k++) {
+			if(from->cwins[k] == cwins[i]) {
+				map[i] = k;
+				break;
+			}
+		}
+	}
+
+	for(i = 1; i < number_cwins; i++) {
+		if((oi = map[i]) < 0) {
+			continue;
+		}
+		for(j = 0; j < i; j++) {
+			if((oj = map[j]) < 0 || oj == oi) {
+				continue;
+			}
+			/* lower diagonal index calculation */
+			k = oi > oj ? oi * (oi - 1) / 2 + oj : oj * (oj - 1) / 2 + oi;
+			if(from->scoreboard[k]) {
+				scoreboard[i * (i - 1) / 2 + j] = 1;
+				stats.kept++;
+			}
+		}
+	}
+	free(map);
+}
+
+
 /*
  * Do something with looking up stuff from WM_COLORMAPS_WINDOWS (relating
  * to windows with their own colormap) and finding or putting this window
@@ -356,6 +496,7 @@ FetchWmColormapWindows(TwmWindow *tmp)
 	bool can_free_cmap_windows = false;
 	int number_cmap_windows = 0;
 	ColormapWindow **cwins = NULL;
+	char *scoreboard = NULL;
 	bool previnst;
 
 	number_cmap_windows = 0;
@@ -458,15 +599,20 @@ FetchWmColormapWindows(TwmWindow *tmp)
 		}
 	}
 
+	if(number_cmap_windows > 1) {
+		scoreboard = calloc(1,
+		                    number_cmap_windows * (number_cmap_windows - 1) / 2);
+		CarryScoreboard(&tmp->cmaps, cwins, number_cmap_windows, scoreboard);
+	}
+
 	if(tmp->cmaps.number_cwins) {
 		free_cwins(tmp);
 	}
 
 	tmp->cmaps.cwins = cwins;
 	tmp->cmaps.number_cwins = number_cmap_windows;
-	if(number_cmap_windows > 1)
-		tmp->cmaps.scoreboard =
-		        calloc(1, ColormapsScoreboardLength(&tmp->cmaps));
+	tmp->cmaps.scoreboard = scoreboard;
+	ColormapsChanged();
 
 	if(previnst) {
 		InstallColormaps(PropertyNotify, NULL);
@@ -523,13 +669,27 @@ BumpWindowColormap(TwmWindow *tmp, int inc)
 				cwins[j] = tmp->cmaps.cwins[i];
 			}
 
+			/* Same windows, so the same conflicts, just shuffled */
+			if(tmp->cmaps.number_cwins > 1) {
+				char *scoreboard = calloc(1,
+				                          ColormapsScoreboardLength(&tmp->cmaps));
+
+				if(scoreboard) {
+					CarryScoreboard(&tmp->cmaps, cwins, tmp->cmaps.number_cwins,
+					                scoreboard);
+					free(tmp->cmaps.scoreboard);
+					tmp->cmaps.scoreboard = scoreboard;
+				}
+				else {
+					memset(tmp->cmaps.scoreboard, 0,
+					       ColormapsScoreboardLength(&tmp->cmaps));
+				}
+			}
+
 			free(tmp->cmaps.cwins);
 
 			tmp->cmaps.cwins = cwins;
-
-			if(tmp->cmaps.number_cwins > 1)
-				memset(tmp->cmaps.scoreboard, 0,
-				       ColormapsScoreboardLength(&tmp->cmaps));
+			ColormapsChanged();
 
 			if(previously_installed) {
 				InstallColormaps(PropertyNotify, NULL);
@@ -685,6 +845,12 @@ free_cwins(TwmWindow *tmp)
 					free(cmap);
 				}
 				XDeleteContext(dpy, tmp->cmaps.cwins[i]->w, ColormapContext);
+				// We may have been tracking a subwindow's mask since
+				// CreateColormapWindow(); the client's own is dealt
+				// with when it goes away.
+				if(tmp->cmaps.cwins[i]->w != tmp->w) {
+					forget_event_mask(tmp->cmaps.cwins[i]->w);
+				}
 				free(tmp->cmaps.cwins[i]);
 			}
 		}
@@ -694,5 +860,6 @@ free_cwins(TwmWindow *tmp)
 			tmp->cmaps.scoreboard = NULL;
 		}
 		tmp->cmaps.number_cwins = 0;
+		ColormapsChanged();
 	}
 }
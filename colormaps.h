@@ -4,6 +4,17 @@
 #ifndef _CTWM_COLORMAPS_H
 #define _CTWM_COLORMAPS_H
 
+#include <stdio.h>  // For FILE
+
+
+/// Counts of how InstallColormaps() has been getting on, for diagnostics
+typedef struct ColormapStats {
+	unsigned long passes;     ///< Times we worked out what to install
+	unsigned long cached;     ///< Times the last pass still held
+	unsigned long installs;   ///< XInstallColormap() calls made
+	unsigned long avoided;    ///< ... and skipped, as already installed
+	unsigned long kept;       ///< Conflicts carried over list changes
+} ColormapStats;
 
 bool InstallWindowColormaps(int type, TwmWindow *tmp);
 bool InstallColormaps(int type, Colormaps *cmaps);
@@ -24,4 +35,8 @@ void LocateStandardColormaps(void);
 
 void free_cwins(TwmWindow *tmp);
 
+void ColormapsChanged(void);
+const ColormapStats *ColormapGetStats(void);
+void ColormapReport(FILE *out);
+
 #endif /* _CTWM_COLORMAPS_H */
@@ -34,6 +34,12 @@ static char *ctopts[] = {
 #ifdef XRANDR
 	"XRANDR",
 #endif
+#ifdef XFT
+	"XFT",
+#endif
+#ifdef XSHM
+	"XSHM",
+#endif
 #ifdef DEBUG
 	"DEBUG",
 #endif
@@ -127,6 +127,7 @@
 struct MyFont {
 	char       *basename;       /* name of the font */
 	XFontSet    font_set;
+	struct _XftFont *xft;       /* Xft font, if it's an "xft:" one */
 	int         ascent;
 	int         descent;
 	int         height;         /* height of the font */
@@ -266,6 +267,7 @@ struct TwmColormap {
 #define CM_INSTALLABLE          1
 #define CM_INSTALLED            2
 #define CM_INSTALL              4
+#define CM_WANTED               8   /* picked in the last install pass */
 
 
 struct ColormapWindow {
@@ -374,6 +376,7 @@ typedef struct _ctwm_cl_args {
 	bool   MultiScreen;        // ! --single, grab multiple screens
 	bool   Monochrome;         // --mono, force monochrome
 	bool   cfgchk;             // --cfgchk, check config and exit
+	bool   ProfileStartup;     // --profile-startup, time startup phases
 	char  *InitFile;           // --file, config filename
 	char  *display_name;       // --display, X server display
 
@@ -388,6 +391,7 @@ typedef struct _ctwm_cl_args {
 	bool   KeepTmpFile;        // --keep-defs, keep generated m4 defs
 	char  *keepM4_filename;    // --keep, keep m4 post-processed output
 	bool   GoThroughM4;        // ! --nom4, do m4 processing
+	bool   UseM4Cache;         // ! --nom4cache, reuse saved m4 output
 #endif
 
 #ifdef EWMH
@@ -40,8 +40,10 @@
 #include "parse.h"
 #include "version.h"
 #include "colormaps.h"
+#include "drawing.h"
 #include "events.h"
 #include "util.h"
+#include "font_cache.h"
 #include "mask_screen.h"
 #include "animate.h"
 #include "screen.h"
@@ -51,6 +53,7 @@
 #include "session.h"
 #include "occupation.h"
 #include "otp.h"
+#include "profile.h"
 #include "cursor.h"
 #include "windowbox.h"
 #include "captive.h"
@@ -188,6 +191,9 @@ ctwm_main(int argc, char *argv[])
 	clargs_check();
 	/* If we get this far, it was all good */
 
+	/* Start timing things if we were asked to */
+	ProfileStart();
+
 	/* Some clargs mean we're not actually trying to take over the screen */
 	if(CLarg.cfgchk || CLarg.is_captive) {
 		takeover = false;
@@ -228,6 +234,7 @@ ctwm_main(int argc, char *argv[])
 	/*
 	 * Initialize our X connection and state bits.
 	 */
+	ProfilePhase("open display");
 	{
 		int zero = 0; // Fakey
 
@@ -266,6 +273,7 @@ ctwm_main(int argc, char *argv[])
 
 
 	// Load session stuff
+	ProfilePhase("X setup");
 	if(CLarg.restore_filename) {
 		ReadWinConfigFile(CLarg.restore_filename);
 	}
@@ -358,6 +366,7 @@ ctwm_main(int argc, char *argv[])
 		/*
 		 * First, setup the root window for the screen.
 		 */
+		ProfilePhase("screen init");
 		if(CLarg.is_captive) {
 			// Captive ctwm.  We make a fake root.
 			XWindowAttributes wa;
@@ -579,12 +588,15 @@ ctwm_main(int argc, char *argv[])
 		/*
 		 * Load up config file
 		 */
+		ProfilePhase("config");
 		{
 			bool ok = LoadTwmrc(CLarg.InitFile);
 
 			// cfgchk just displays whether there are errors, then moves
 			// on.
 			if(CLarg.cfgchk) {
+				const TwmrcLoadInfo *li = LoadTwmrcInfo();
+
 				if(ok) {
 					fprintf(stderr, "%d: No errors found\n", scrnum);
 				}
@@ -592,6 +604,11 @@ ctwm_main(int argc, char *argv[])
 					fprintf(stderr, "%d: Errors found\n", scrnum);
 					cfgerrs = true;
 				}
+				fprintf(stderr, "%d: Loaded in %.1f ms", scrnum, li->ms);
+				if(li->m4cache) {
+					fprintf(stderr, " (m4 cache: %s)", li->m4cache);
+				}
+				fprintf(stderr, "\n");
 				continue;
 			}
 
@@ -616,6 +633,7 @@ ctwm_main(int argc, char *argv[])
 		 * Since we've loaded the config, go ahead and take over the
 		 * screen.
 		 */
+		ProfilePhase("takeover");
 		if(takeover) {
 			if(takeover_screen(Scr) != true) {
 				// Well, move on to the next one, maybe we'll get it...
@@ -640,6 +658,7 @@ ctwm_main(int argc, char *argv[])
 		/*
 		 * Do various setup based on the results from the config file.
 		 */
+		ProfilePhase("screen setup");
 
 		// Few simple var defaults
 		if(Scr->ClickToFocus) {
@@ -729,6 +748,7 @@ ctwm_main(int argc, char *argv[])
 		}
 
 		// Setup colors stuff
+		ProfilePhase("colors");
 		if(!Scr->BeNiceToColormap) {
 			// Default pair
 			GetShadeColors(&Scr->DefaultC);
@@ -765,6 +785,7 @@ ctwm_main(int argc, char *argv[])
 		assign_var_savecolor();
 
 		// Setup cursor values that weren't give in the config
+		ProfilePhase("cursors");
 #define DEFCURSOR(name, val) if(!Scr->name) NewFontCursor(&Scr->name, val)
 		DEFCURSOR(FrameCursor,   "top_left_arrow");
 		DEFCURSOR(TitleCursor,   "top_left_arrow");
@@ -780,6 +801,7 @@ ctwm_main(int argc, char *argv[])
 		DEFCURSOR(AlterCursor,   "question_arrow");
 #undef DEFCURSOR
 
+		ProfilePhase("fonts");
 		// Load up fonts for the screen.
 		//
 		// XXX HaveFonts is kinda stupid, however it gets useful in one
@@ -812,9 +834,14 @@ ctwm_main(int argc, char *argv[])
 		 * Now we can start making various things.
 		 */
 
+		ProfilePhase("menus");
 		// Stash up a ref to our Scr on the root, so we can find the
 		// right Scr for events etc.
 		XSaveContext(dpy, Scr->Root, ScreenContext, (XPointer) Scr);
+		if(Scr->RealRoot != Scr->Root) {
+			// Captive; we watch the real root for other captives
+			XSaveContext(dpy, Scr->RealRoot, ScreenContext, (XPointer) Scr);
+		}
 
 		// Setup GC's for drawing, so we can start making stuff we have
 		// to actually draw.  Could move earlier, has to preceed a lot of
@@ -834,6 +861,7 @@ ctwm_main(int argc, char *argv[])
 		// Copy the icon managers over to workspaces past the first as
 		// necessary.  AllocateIconManager() and the config parsing
 		// already made them on the first WS.
+		ProfilePhase("icon managers");
 		AllocateOtherIconManagers();
 
 		// Create the windows for our icon managers now that all our
@@ -842,8 +870,13 @@ ctwm_main(int argc, char *argv[])
 
 		// Create the WSM window (per-vscreen) and stash info on the root
 		// about our WS's.
+		ProfilePhase("workspace manager");
 		CreateWorkSpaceManager();
 
+		// Animated backgrounds on the workspaces we're starting out on
+		// otherwise wouldn't get going until the first switch.
+		AnimationAddRoot(Scr);
+
 		// Create the f.occupy window
 		CreateOccupyWindow();
 
@@ -861,6 +894,7 @@ ctwm_main(int argc, char *argv[])
 #ifdef EWMH
 		// Set EWMH-related properties on various root-ish windows, for
 		// other programs to read to find out how we view the world.
+		ProfilePhase("EWMH");
 		EwmhInitScreenLate(Scr);
 #endif /* EWMH */
 
@@ -868,6 +902,7 @@ ctwm_main(int argc, char *argv[])
 		/*
 		 * Look up and handle all the windows on the screen.
 		 */
+		ProfilePhase("adopt windows");
 		{
 			Window parent, *children;
 			unsigned int nchildren;
@@ -901,8 +936,10 @@ ctwm_main(int argc, char *argv[])
 			 */
 			for(int i = 0; i < nchildren; i++) {
 				if(children[i] && MappedNotOverride(children[i])) {
+					ProfileWindowStart();
 					XUnmapWindow(dpy, children[i]);
 					SimulateMapRequest(children[i]);
+					ProfileWindowEnd(children[i]);
 				}
 			}
 
@@ -919,6 +956,7 @@ ctwm_main(int argc, char *argv[])
 
 
 		// Show the WSM window if we should
+		ProfilePhase("map WSM");
 		if(Scr->ShowWorkspaceManager && Scr->workSpaceManagerActive) {
 			VirtualScreen *vs;
 			if(Scr->WindowMask) {
@@ -941,6 +979,7 @@ ctwm_main(int argc, char *argv[])
 		/*
 		 * Setup the Info window, used for f.identify and f.version.
 		 */
+		ProfilePhase("misc windows");
 		{
 			unsigned long valuemask;
 			XSetWindowAttributes attributes;
@@ -980,9 +1019,9 @@ ctwm_main(int argc, char *argv[])
 			unsigned long valuemask;
 			XSetWindowAttributes attributes;
 
-			XmbTextExtents(Scr->SizeFont.font_set,
-			               " 8888 x 8888 ", 13,
-			               &ink_rect, &logical_rect);
+			FontTextExtents(&Scr->SizeFont,
+			                " 8888 x 8888 ", 13,
+			                &ink_rect, &logical_rect);
 			Scr->SizeStringWidth = logical_rect.width;
 			valuemask = (CWBorderPixel | CWBackPixel | CWBitGravity);
 			attributes.bit_gravity = NorthWestGravity;
@@ -1017,6 +1056,7 @@ ctwm_main(int argc, char *argv[])
 		// element is worth anything...
 		Scr->FirstTime = false;
 	} // for each screen on display
+	ProfilePhase("finish");
 
 
 	// If we're just checking the config, there's nothing more to do.
@@ -1034,6 +1074,15 @@ ctwm_main(int argc, char *argv[])
 		exit(1);
 	}
 
+	// Font sets are one of the slower parts of startup
+	if(CLarg.PrintErrorMessages) {
+		const FontCacheStats *fst = FontCacheGetStats();
+
+		fprintf(stderr, "%s: font setup took %.1f ms (%lu font sets created, "
+		        "%lu shared)\n", ProgramName, fst->total_ms, fst->misses,
+		        fst->hits);
+	}
+
 	// Hook up session
 	ConnectToSessionManager(CLarg.client_id);
 
@@ -1050,6 +1099,9 @@ ctwm_main(int argc, char *argv[])
 	// Set vars to enable animation bits
 	StartAnimation();
 
+	// Startup's done
+	ProfileStop();
+
 	// Main loop.
 	HandlingEvents = true;
 	HandleEvents();
@@ -1253,6 +1305,8 @@ InitScreenInfo(int scrnum, Window croot, int crootx, int crooty,
 	scr->NoWarpToMenuTitle = false;
 	scr->DontToggleWorkspaceManagerState = false;
 	scr->NameDecorations = true;
+	scr->DirectExec = false;
+	scr->CheckStackingOrder = false;
 	scr->ForceFocus = false;
 	scr->BorderTop    = 0;
 	scr->BorderBottom = 0;
@@ -1262,6 +1316,7 @@ InitScreenInfo(int scrnum, Window croot, int crootx, int crooty,
 #ifdef EWMH
 	scr->PreferredIconWidth = 48;
 	scr->PreferredIconHeight = 48;
+	scr->ScaleEWMHIcons = false;
 
 	scr->ewmh_CLIENT_LIST_used = 0;
 	scr->ewmh_CLIENT_LIST_size = 16;
@@ -10,20 +10,29 @@
 
 #include "animate.h"
 #include "captive.h"
+#include "color_cache.h"
 #include "colormaps.h"
 #include "ctwm_atoms.h"
 #include "ctwm_shutdown.h"
+#include "image_upload.h"
+#include "launcher.h"
 #include "screen.h"
 #include "session.h"
 #ifdef SOUNDS
 # include "sound.h"
 #endif
 #include "otp.h"
+#include "prop_writer.h"
+#include "r_area_list.h"
+#include "reactor.h"
+#include "timers.h"
+#include "win_decorations_atlas.h"
 #include "win_ops.h"
 #include "win_utils.h"
 
 
 static void RestoreForShutdown(Time mytime);
+static void PrintStats(void);
 
 
 /**
@@ -202,6 +211,30 @@ RestoreForShutdown(Time mytime)
 }
 
 
+/**
+ * With -v, say how much work various bits did while we were running.
+ */
+static void
+PrintStats(void)
+{
+	if(!CLarg.PrintErrorMessages) {
+		return;
+	}
+
+	ReactorReport(stderr);
+	TimerReport(stderr);
+	LauncherReport(stderr);
+	ColormapReport(stderr);
+	ColorCacheReport(stderr);
+	EventMaskReport(stderr);
+	ImageUploadReport(stderr);
+	PropReport(stderr);
+	OtpReport(stderr);
+	RAreaListReport(stderr);
+	DecorAtlasReport(stderr);
+}
+
+
 /**
  * Cleanup and exit ctwm
  */
@@ -216,6 +249,7 @@ DoShutdown(void)
 
 	// Restore windows/colormaps for our absence.
 	RestoreForShutdown(CurrentTime);
+	PropFlush();
 
 #ifdef EWMH
 	// Clean up EWMH properties
@@ -230,6 +264,9 @@ DoShutdown(void)
 		RemoveFromCaptiveList(Scr->captivename);
 	}
 
+	// How busy were we?
+	PrintStats();
+
 	// Close up shop
 	XCloseDisplay(dpy);
 	exit(0);
@@ -249,6 +286,7 @@ DoRestart(Time t)
 	// Replace all the windows/colormaps as if we were going away.  'cuz
 	// we are.
 	RestoreForShutdown(t);
+	PropFlush();
 	XSync(dpy, 0);
 
 	// Shut down session management connection cleanly.
@@ -257,6 +295,7 @@ DoRestart(Time t)
 	}
 
 	// Re-run ourself
+	PrintStats();
 	fprintf(stderr, "%s:  restarting:  %s\n", ProgramName, *Argv);
 	execvp(*Argv, Argv);
 
@@ -10,6 +10,7 @@
 
 #include "ctwm_takeover.h"
 #include "screen.h"
+#include "win_utils.h"
 
 
 /// Flag for "we got an error trying to take over".  Set in temporary
@@ -62,7 +63,13 @@ takeover_screen(ScreenInfo *scr)
 	if(CLarg.is_captive) {
 		attrmask |= StructureNotifyMask;
 	}
-	XSelectInput(dpy, scr->Root, attrmask);
+	select_input(scr->Root, attrmask);
+
+	// Captives inside us announce themselves on the real root, not on
+	// ours, so we have to watch there to notice them coming and going.
+	if(CLarg.is_captive) {
+		select_input(scr->RealRoot, PropertyChangeMask);
+	}
 
 	// Make sure we flush out any errors that may have caused.  This
 	// ensures our RedirectError flag will be set if the server sent us
@@ -27,6 +27,7 @@
 
 #include "screen.h"
 #include "cursor.h"
+#include "drawing.h"
 #include "image_bitmap.h"
 
 static struct _CursorName {
@@ -193,13 +194,19 @@ Cursor MakeStringCursor(char *string)
 	XRectangle inc_rect;
 	XRectangle logical_rect;
 
+	// Our Xft drawing goes through the screen's visual, which a depth-1
+	// bitmap doesn't have; use the core fallback font for this.
+	if(myfont.xft != NULL) {
+		myfont = Scr->DefaultFont;
+	}
+
 	black.pixel = Scr->Black;
 	XQueryColor(dpy, cmap, &black);
 	white.pixel = Scr->White;
 	XQueryColor(dpy, cmap, &white);
 
-	XmbTextExtents(myfont.font_set, string, strlen(string),
-	               &inc_rect, &logical_rect);
+	FontTextExtents(&myfont, string, strlen(string),
+	                &inc_rect, &logical_rect);
 	width  = logical_rect.width  + 4;
 	height = logical_rect.height + 2;
 	middle = myfont.ascent;
@@ -213,8 +220,8 @@ Cursor MakeStringCursor(char *string)
 	XSetForeground(dpy, gc, 1L);
 	XDrawRectangle(dpy, bitmap, gc, 0, 0, width - 1, height - 1);
 
-	XmbDrawString(dpy, bitmap, myfont.font_set,
-	              gc, 2, middle, string, strlen(string));
+	FontDrawString(bitmap, &myfont,
+	               gc, 2, middle, string, strlen(string));
 
 	cursor = XCreatePixmapCursor(dpy, bitmap, None, &black, &white, 0, 0);
 	XFreePixmap(dpy, bitmap);
@@ -11,7 +11,15 @@
 
 #include "ctwm.h"
 
+#include <stdlib.h>
+#include <string.h>
+#ifdef XFT
+#include <langinfo.h>
+#include <wchar.h>
+#include <X11/Xft/Xft.h>
+#endif
 
+#include "color_cache.h"
 #include "screen.h"
 #include "gram.tab.h"
 #include "occupation.h"
@@ -183,8 +191,8 @@ PaintWsButton(PWBType which, VirtualScreen *vs, Window w,
 		XRectangle inc_rect;
 		XRectangle logical_rect;
 
-		XmbTextExtents(font.font_set, label, strlen(label), &inc_rect,
-		               &logical_rect);
+		FontTextExtents(&font, label, strlen(label), &inc_rect,
+		                &logical_rect);
 		strHei = logical_rect.height;
 		vspace = ((bheight + strHei - font.descent) / 2);
 		strWid = logical_rect.width;
@@ -232,21 +240,251 @@ PaintWsButton(PWBType which, VirtualScreen *vs, Window w,
 				break;
 		}
 		FB(cp.fore, cp.back);
-		XmbDrawString(dpy, w, font.font_set, Scr->NormalGC, hspace, vspace,
-		              label, strlen(label));
+		FontDrawString(w, &font, Scr->NormalGC, hspace, vspace,
+		               label, strlen(label));
 	}
 	else {
 		Draw3DBorder(w, 0, 0, bwidth, bheight, Scr->WMgrButtonShadowDepth,
 		             cp, state, true, false);
 		if(state == on) {
 			FB(cp.fore, cp.back);
-			XmbDrawImageString(dpy, w, font.font_set, Scr->NormalGC, hspace, vspace,
-			                   label, strlen(label));
+			FontDrawImageString(w, &font, Scr->NormalGC, hspace, vspace,
+			                    label, strlen(label));
 		}
 		else {
 			FB(cp.back, cp.fore);
-			XmbDrawImageString(dpy, w, font.font_set, Scr->NormalGC, hspace, vspace,
-			                   label, strlen(label));
+			FontDrawImageString(w, &font, Scr->NormalGC, hspace, vspace,
+			                    label, strlen(label));
 		}
 	}
 }
+
+
+
+/*
+ * Text drawing.  A MyFont is either a core font set or, when we're built
+ * with Xft, an Xft font; these hide which from callers.  Strings are in
+ * the locale's multibyte encoding either way, like the Xmb*() funcs
+ * take.
+ *
+ * Xft keeps its glyphs client-side and uploads each one to the server
+ * once, into a glyphset it then draws from with XRenderCompositeText();
+ * so after the first time a glyph is seen, drawing text is just a
+ * request with the glyph indices.
+ */
+#ifdef XFT
+/*
+ * Xft takes UTF-8 or UCS-4.  If the locale is UTF-8 strings can go
+ * straight through; otherwise we convert.
+ */
+static bool
+utf8Locale(void)
+{
+	static int utf8 = -1;
+
+	if(utf8 == -1) {
+		const char *cs = nl_langinfo(CODESET);
+		utf8 = (cs != NULL && strcmp(cs, "UTF-8") == 0);
+	}
+	return utf8;
+}
+
+/*
+ * Convert to UCS-4, using buf if it's big enough.  Unconvertable bytes
+ * become '?'.  Returns NULL if we run out of memory.
+ */
+static FcChar32 *
+toUcs4(const char *str, int len, FcChar32 *buf, int bufsize, int *outlen)
+{
+	FcChar32 *out = buf;
+	mbstate_t st;
+	int n = 0;
+
+	// Never more chars than bytes
+	if(len > bufsize) {
+		out = malloc(len * sizeof(FcChar32));
+		if(out == NULL) {
+			return NULL;
+		}
+	}
+
+	memset(&st, 0, sizeof(st));
+	while(len > 0) {
+		wchar_t wc;
+		size_t r = mbrtowc(&wc, str, len, &st);
+
+		if(r == (size_t) -1 || r == (size_t) -2) {
+			wc = '?';
+			r = 1;
+			memset(&st, 0, sizeof(st));
+		}
+		else if(r == 0) {
+			r = 1;
+		}
+		out[n++] = wc;
+		str += r;
+		len -= r;
+	}
+
+	*outlen = n;
+	return out;
+}
+
+static void
+xftExtents(const MyFont *font, const char *str, int len, XGlyphInfo *gi)
+{
+	FcChar32 buf[256], *u;
+	int n;
+
+	if(utf8Locale()) {
+		XftTextExtentsUtf8(dpy, font->xft, (const FcChar8 *)str, len, gi);
+		return;
+	}
+
+	u = toUcs4(str, len, buf, 256, &n);
+	if(u == NULL) {
+		memset(gi, 0, sizeof(*gi));
+		return;
+	}
+	XftTextExtents32(dpy, font->xft, u, n, gi);
+	if(u != buf) {
+		free(u);
+	}
+}
+
+/*
+ * XftColor for a pixel, which is what our GCs have.  Usually we can
+ * find out its RGB without asking the server.
+ */
+static void
+xftColor(Colormap cmap, Pixel pix, XftColor *col)
+{
+	XColor xc;
+
+	xc.pixel = pix;
+	if(!ColorCacheQuery(cmap, cmap == DefaultColormap(dpy, Scr->screen)
+	                    ? Scr->d_visual : NULL, &xc)) {
+		XQueryColor(dpy, cmap, &xc);
+	}
+	col->pixel = pix;
+	col->color.red   = xc.red;
+	col->color.green = xc.green;
+	col->color.blue  = xc.blue;
+	col->color.alpha = 0xffff;
+}
+
+static void
+xftDrawText(Drawable d, const MyFont *font, GC gc, int x, int y,
+            const char *str, int len, bool image)
+{
+	Colormap cmap = Scr->RootColormaps.cwins[0]->colormap->c;
+	XGCValues gcv;
+	XftDraw *draw;
+	XftColor fg;
+
+	// An XftDraw is just client-side state, plus a Picture made when we
+	// first draw.  Keeping one around would leave it referencing
+	// drawables after they're gone, so make one each time.
+	draw = XftDrawCreate(dpy, d, Scr->d_visual, cmap);
+	if(draw == NULL) {
+		return;
+	}
+	XGetGCValues(dpy, gc, GCForeground | GCBackground, &gcv);
+
+	if(image) {
+		XGlyphInfo gi;
+		XftColor bg;
+
+		xftExtents(font, str, len, &gi);
+		xftColor(cmap, gcv.background, &bg);
+		XftDrawRect(draw, &bg, x, y - font->ascent, gi.xOff,
+		            font->ascent + font->descent);
+	}
+
+	xftColor(cmap, gcv.foreground, &fg);
+	if(utf8Locale()) {
+		XftDrawStringUtf8(draw, &fg, font->xft, x, y,
+		                  (const FcChar8 *)str, len);
+	}
+	else {
+		FcChar32 buf[256], *u;
+		int n;
+
+		u = toUcs4(str, len, buf, 256, &n);
+		if(u != NULL) {
+			XftDrawString32(draw, &fg, font->xft, x, y, u, n);
+			if(u != buf) {
+				free(u);
+			}
+		}
+	}
+
+	XftDrawDestroy(draw);
+}
+#endif /* XFT */
+
+
+/**
+ * Equivalent of XmbTextExtents() for a MyFont.
+ */
+void
+FontTextExtents(const MyFont *font, const char *str, int len,
+                XRectangle *ink, XRectangle *logical)
+{
+#ifdef XFT
+	if(font->xft != NULL) {
+		XGlyphInfo gi;
+
+		xftExtents(font, str, len, &gi);
+		ink->x = -gi.x;
+		ink->y = -gi.y;
+		ink->width = gi.width;
+		ink->height = gi.height;
+		logical->x = 0;
+		logical->y = -font->ascent;
+		logical->width = gi.xOff;
+		logical->height = font->ascent + font->descent;
+		return;
+	}
+#endif
+
+	XmbTextExtents(font->font_set, str, len, ink, logical);
+}
+
+
+/**
+ * Equivalent of XmbDrawString() for a MyFont: draw the text in gc's
+ * foreground.
+ */
+void
+FontDrawString(Drawable d, const MyFont *font, GC gc, int x, int y,
+               const char *str, int len)
+{
+#ifdef XFT
+	if(font->xft != NULL) {
+		xftDrawText(d, font, gc, x, y, str, len, false);
+		return;
+	}
+#endif
+
+	XmbDrawString(dpy, d, font->font_set, gc, x, y, str, len);
+}
+
+
+/**
+ * Equivalent of XmbDrawImageString() for a MyFont: draw the text in gc's
+ * foreground on a box of its background.
+ */
+void
+FontDrawImageString(Drawable d, const MyFont *font, GC gc,
+                    int x, int y, const char *str, int len)
+{
+#ifdef XFT
+	if(font->xft != NULL) {
+		xftDrawText(d, font, gc, x, y, str, len, true);
+		return;
+	}
+#endif
+
+	XmbDrawImageString(dpy, d, font->font_set, gc, x, y, str, len);
+}
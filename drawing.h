@@ -22,4 +22,12 @@ void PaintWsButton(PWBType which, VirtualScreen *vs, Window w,
                    char *label, ColorPair cp, ButtonState state);
 
 
+void FontTextExtents(const MyFont *font, const char *str, int len,
+                     XRectangle *ink, XRectangle *logical);
+void FontDrawString(Drawable d, const MyFont *font, GC gc, int x, int y,
+                    const char *str, int len);
+void FontDrawImageString(Drawable d, const MyFont *font, GC gc,
+                         int x, int y, const char *str, int len);
+
+
 #endif // _CTWM_DRAWING_H
@@ -29,12 +29,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <errno.h>
-#include <sys/time.h>
 
 #include <X11/extensions/shape.h>
 
-#include "animate.h"
 #include "captive.h"
 #include "colormaps.h"
 #include "events.h"
@@ -44,8 +41,13 @@
 #include "functions.h"
 #include "iconmgr.h"
 #include "image.h"
+#include "launcher.h"
+#include "otp.h"
+#include "prop_writer.h"
+#include "reactor.h"
 #include "screen.h"
 #include "signals.h"
+#include "timers.h"
 #include "util.h"
 #include "version.h"
 #include "win_utils.h"
@@ -55,6 +57,11 @@
 
 
 static void CtwmNextEvent(Display *display, XEvent  *event);
+static void XInput(int fd, void *arg);
+static void LauncherInput(int fd, void *arg);
+
+/* Set when the reactor sees the X connection readable */
+static bool x_readable;
 static bool StashEventTime(XEvent *ev);
 static void dumpevent(const XEvent *e);
 
@@ -156,6 +163,18 @@ InitEvents(void)
 
 #undef STDH
 
+	/*
+	 * CtwmNextEvent() sleeps in the reactor, so everything it should
+	 * wake up for gets registered there: the X connection, and the
+	 * launcher's pipe that exited children poke.
+	 */
+	if(dpy) {
+		ReactorAddFd(ConnectionNumber(dpy), "X", XInput, NULL);
+	}
+	if(LauncherFd() >= 0) {
+		ReactorAddFd(LauncherFd(), "launcher", LauncherInput, NULL);
+	}
+
 	/* And done */
 	return;
 }
@@ -192,6 +211,9 @@ HandleEvents(void)
 		if(ColortableThrashing && !QLength(dpy) && Scr) {
 			InstallColormaps(ColormapNotify, NULL);
 		}
+		if(!QLength(dpy)) {
+			OtpIdleCheck();
+		}
 		WindowMoved = false;
 
 		CtwmNextEvent(dpy, &Event);
@@ -210,75 +232,67 @@ HandleEvents(void)
 }
 
 
+/*
+ * Reactor callbacks
+ */
+static void
+XInput(int fd, void *arg)
+{
+	x_readable = true;
+}
+
+static void
+LauncherInput(int fd, void *arg)
+{
+	LauncherReap();
+}
+
+
 /*
  * Grab the next event in the queue to process.
+ *
+ * Xt only gets asked for an event once we know there's one queued, so
+ * it never blocks; all the waiting happens in the reactor, which wakes
+ * up for X input, timers coming due, exiting children, the session
+ * manager, and signals.  Property changes held back since the last
+ * event (see prop_writer.c) are sent before each look at the queue.
  */
 static void
 CtwmNextEvent(Display *display, XEvent *event)
 {
-	int         fd;
-	struct timeval timeout, *tout = NULL;
-	const bool animate = (AnimationActive && MaybeAnimate);
-
 #define NEXTEVENT XtAppNextEvent(appContext, event)
 
-	if(SignalFlag) {
-		handle_signal_flag(CurrentTime);
-	}
-	if(XEventsQueued(display, QueuedAfterFlush) != 0) {
-		NEXTEVENT;
-		return;
-	}
-	fd = ConnectionNumber(display);
-
-	if(animate) {
-		TryToAnimate();
-	}
-	if(SignalFlag) {
-		handle_signal_flag(CurrentTime);
-	}
-	if(! MaybeAnimate) {
-		NEXTEVENT;
-		return;
-	}
-	if(animate) {
-		tout = (AnimationSpeed > 0) ? &timeout : NULL;
-	}
 	while(1) {
-		fd_set mask;
-		int found;
-
-		FD_ZERO(&mask);
-		FD_SET(fd, &mask);
-		if(animate) {
-			timeout = AnimateTimeout;
-		}
-		found = select(fd + 1, &mask, NULL, NULL, tout);
 		if(SignalFlag) {
 			handle_signal_flag(CurrentTime);
 		}
-		if(found < 0) {
-			if(errno != EINTR) {
-				perror("select");
-			}
-			continue;
+		PropFlush();
+		if(XEventsQueued(display, QueuedAfterFlush) != 0) {
+			NEXTEVENT;
+			return;
+		}
+
+		TimerRun();
+		if(SignalFlag) {
+			handle_signal_flag(CurrentTime);
 		}
-		if(FD_ISSET(fd, &mask)) {
+		PropFlush();
+		if(XEventsQueued(display, QueuedAfterFlush) != 0) {
 			NEXTEVENT;
 			return;
 		}
-		if(found == 0) {
-			if(animate) {
-				TryToAnimate();
-			}
-			if(SignalFlag) {
-				handle_signal_flag(CurrentTime);
-			}
-			if(! MaybeAnimate) {
-				NEXTEVENT;
-				return;
-			}
-			continue;
+
+		x_readable = false;
+		ReactorWait(TimerTimeout());
+
+		/*
+		 * Readable might just mean replies or errors, which reading
+		 * handles; or the connection's gone, in which case Xlib's IO
+		 * error handler takes us away.
+		 */
+		if(x_readable && XEventsQueued(display, QueuedAfterReading) != 0) {
+			NEXTEVENT;
+			return;
 		}
 	}
 
@@ -369,6 +383,12 @@ DispatchEvent2(void)
 		}
 	}
 
+	/*
+	 * The loops calling us don't come back through CtwmNextEvent()
+	 * until they're done, so send any property changes now.
+	 */
+	PropFlush();
+
 	return true;
 }
 
@@ -34,6 +34,7 @@
 
 #include "add_window.h"
 #include "animate.h"
+#include "captive.h"
 #include "clicktofocus.h"
 #include "colormaps.h"
 #include "ctwm_atoms.h"
@@ -52,10 +53,12 @@
 #include "occupation.h"
 #include "otp.h"
 #include "parse.h"
+#include "prop_writer.h"
 #include "screen.h"
 #include "util.h"
 #include "vscreen.h"
 #include "win_decorations.h"
+#include "win_decorations_atlas.h"
 #include "win_iconify.h"
 #include "win_ops.h"
 #include "win_regions.h"
@@ -125,6 +128,7 @@ void HandleColormapNotify(void)
 		else {
 			cwin->colormap->refcnt++;
 		}
+		ColormapsChanged();
 
 		cmap->refcnt--;
 
@@ -221,6 +225,7 @@ void HandleColormapNotify(void)
 						n = won * (won - 1) / 2 + lost;
 					}
 					Scr->cmapInfo.cmaps->scoreboard[n] = 1;
+					ColormapsChanged();
 				}
 				else {
 					/*
@@ -499,14 +504,19 @@ void HandleVisibilityNotify(void)
 	 * when Saber complains about retreiving an <int> from an <unsigned int>
 	 * just type "touch vevent->state" and "cont"
 	 */
+	/*
+	 * Only going into or coming out of being fully obscured makes any
+	 * difference to what gets installed.
+	 */
 	cmap = cwin->colormap;
-	if((cmap->state & CM_INSTALLABLE) &&
-	                vevent->state != cwin->visibility &&
+	if(vevent->state != cwin->visibility &&
 	                (vevent->state == VisibilityFullyObscured ||
-	                 cwin->visibility == VisibilityFullyObscured) &&
-	                cmap->w == cwin->w) {
+	                 cwin->visibility == VisibilityFullyObscured)) {
 		cwin->visibility = vevent->state;
-		InstallWindowColormaps(VisibilityNotify, NULL);
+		ColormapsChanged();
+		if((cmap->state & CM_INSTALLABLE) && cmap->w == cwin->w) {
+			InstallWindowColormaps(VisibilityNotify, NULL);
+		}
 	}
 	else {
 		cwin->visibility = vevent->state;
@@ -950,10 +960,12 @@ void HandleKeyPress(void)
 
 
 	/*
-	 * Loop over our key bindings and do its thing if we find a matching
-	 * one.
+	 * Loop over the key bindings for this key and do its thing if we
+	 * find a matching one.  Other keys hash elsewhere, so there are
+	 * usually only a handful to look at.
 	 */
-	for(FuncKey *key = Scr->FuncKeyRoot.next; key != NULL; key = key->next) {
+	for(FuncKey *key = Scr->FuncKeyHash[FUNCKEY_HASH(Event.xkey.keycode, modifier)];
+	                key != NULL; key = key->hnext) {
 		/*
 		 * Is this what we're trying to invoke?  Gotta be the right key,
 		 * and right modifier; those are easy.
@@ -1132,11 +1144,19 @@ void HandlePropertyNotify(void)
 	Icon *icon;
 
 
+	/* Captive ctwms inside us coming and going */
+	if(Event.xproperty.window == Scr->RealRoot) {
+		CaptiveRootPropertyChange(Scr->screen, Event.xproperty.atom);
+	}
+
 	/* watch for standard colormap changes */
 	if(Event.xproperty.window == Scr->Root) {
 
 		if(Event.xproperty.atom == XA_WM_CURRENTWORKSPACE) {
 			unsigned char *prop;
+
+			/* Somebody else set it (we don't listen while we do) */
+			PropInvalidate(Scr->Root, XA_WM_CURRENTWORKSPACE);
 			switch(Event.xproperty.state) {
 				case PropertyNewValue:
 					if(XGetWindowProperty(dpy, Scr->Root, XA_WM_CURRENTWORKSPACE,
@@ -1564,16 +1584,6 @@ void HandleClientMessage(void)
 		return;
 	}
 #endif
-
-	else if((Event.xclient.message_type == XA_WM_PROTOCOLS) &&
-	                (Event.xclient.data.l[0] == XA_WM_END_OF_ANIMATION)) {
-		if(Animating > 0) {
-			Animating--;
-		}
-		else {
-			fprintf(stderr, "!! end of unknown animation !!\n");
-		}
-	}
 }
 
 
@@ -1705,6 +1715,8 @@ static void remove_window_from_ring(TwmWindow *tmp)
 	if(lower_win == Tmp_win) {
 		lower_win = NULL;
 	}
+	AutoRaiseCancel(tmp);
+	AutoLowerCancel(tmp);
 
 	/*
 	 * 1. Unlink window
@@ -1743,6 +1755,11 @@ void HandleDestroyNotify(void)
 	 * into a DestroyNotify.
 	 */
 
+	// Could be a client leader we've been keeping track of
+	if(Event.type == DestroyNotify) {
+		CaptiveLeaderGone(Event.xdestroywindow.window);
+	}
+
 	if(Tmp_win == NULL) {
 		return;
 	}
@@ -1773,6 +1790,8 @@ void HandleDestroyNotify(void)
 	}
 	XDeleteContext(dpy, Tmp_win->w, TwmContext);
 	XDeleteContext(dpy, Tmp_win->w, ScreenContext);
+	forget_event_mask(Tmp_win->w);
+	PropForget(Tmp_win->w);
 	XDeleteContext(dpy, Tmp_win->frame, TwmContext);
 	XDeleteContext(dpy, Tmp_win->frame, ScreenContext);
 	if(Tmp_win->icon && Tmp_win->icon->w) {
@@ -1840,7 +1859,7 @@ void HandleDestroyNotify(void)
 	 */
 	WMapRemoveWindow(Tmp_win);
 	if(Tmp_win->gray) {
-		XFreePixmap(dpy, Tmp_win->gray);
+		DecorAtlasRelease(Tmp_win->gray);
 	}
 
 	/*
@@ -1870,6 +1889,7 @@ void HandleDestroyNotify(void)
 	if(Tmp_win->next != NULL) {
 		Tmp_win->next->prev = Tmp_win->prev;
 	}
+	InvalidateWindowListMenus();
 	if(Tmp_win->auto_raise) {
 		Scr->NumAutoRaises--;
 	}
@@ -1906,6 +1926,7 @@ void HandleDestroyNotify(void)
 	}
 	DeleteHighlightWindows(Tmp_win);                            /* 13 */
 
+	AnimationForgetWindow(Tmp_win);
 	free(Tmp_win);
 	Tmp_win = NULL;
 
@@ -2071,7 +2092,7 @@ void HandleMapRequest(void)
 	if(Tmp_win->mapped) {
 		WMapMapWindow(Tmp_win);
 	}
-	MaybeAnimate = true;
+	AnimationAddWindow(Tmp_win);
 }
 
 
@@ -2135,6 +2156,7 @@ void HandleMapNotify(void)
 	Tmp_win->mapped = true;
 	Tmp_win->isicon = false;
 	Tmp_win->icon_on = false;
+	InvalidateWindowListMenus();
 }
 
 
@@ -2215,6 +2237,9 @@ void HandleUnmapNotify(void)
 		}
 		XRemoveFromSaveSet(dpy, Event.xunmap.window);
 		XSelectInput(dpy, Event.xunmap.window, NoEventMask);
+
+		/* It's still there, so the withdrawn state has to get to it */
+		PropFlush();
 		HandleDestroyNotify();          /* do not need to mash event before */
 	} /* else window no longer exists and we'll get a destroy notify */
 	XUngrabServer(dpy);
@@ -3139,83 +3164,6 @@ void HandleEnterNotify(void)
 			}
 		}
 
-		/* Handle RaiseDelay, if any.....
-		 */
-		if(RaiseDelay > 0) {
-			if(Tmp_win && Tmp_win->auto_raise &&
-			                (!Tmp_win->iconmanagerlist ||
-			                 Tmp_win->iconmanagerlist->w != ewp->window)) {
-				ColormapWindow *cwin;
-				static struct timeval tout, timeout = {0, 12500};
-
-				if(XFindContext(dpy, Tmp_win->w, ColormapContext,
-				                (XPointer *)&cwin) == XCNOENT) {
-					cwin = NULL;
-				}
-
-				if((ewp->detail != NotifyInferior
-				                || Tmp_win->frame == ewp->window)
-				                && (!cwin || cwin->visibility != VisibilityUnobscured)) {
-					int x, y, px, py, d, i;
-					Window w;
-
-					XQueryPointer(dpy, Scr->Root, &w, &w, &px, &py,
-					              &d, &d, (unsigned int *)&d);
-
-					/* The granularity of RaiseDelay is about 25 ms.
-					 * The timeout variable is set to 12.5 ms since we
-					 * pass this way twice each time a twm window is
-					 * entered.
-					 */
-					for(i = 25; i < RaiseDelay; i += 25) {
-						tout = timeout;
-						select(0, NULL, NULL, NULL, &tout);
-						/* Did we leave this window already? */
-						scanArgs.w = ewp->window;
-						scanArgs.leaves = scanArgs.enters = False;
-						XCheckIfEvent(dpy, &dummy, HENQueueScanner,
-						              (void *) &scanArgs);
-						if(scanArgs.leaves && !scanArgs.inferior) {
-							return;
-						}
-
-						XQueryPointer(dpy, Scr->Root, &w, &w, &x, &y,
-						              &d, &d, (unsigned int *)&d);
-
-						/* Has the pointer moved?  If so reset the loop cnt.
-						 * We want the pointer to be still for RaiseDelay
-						 * milliseconds before terminating the loop
-						 */
-						if(x != px || y != py) {
-							i = 0;
-							px = x;
-							py = y;
-						}
-					}
-				}
-			}
-
-			/*
-			 * Scan for Leave and Enter Notify events to see if we can avoid some
-			 * unnecessary processing.
-			 */
-			scanArgs.w = ewp->window;
-			scanArgs.leaves = scanArgs.enters = False;
-			XCheckIfEvent(dpy, &dummy, HENQueueScanner, (void *) &scanArgs);
-
-			/*
-			 * if entering root window, restore twm default colormap so that
-			 * titlebars are legible
-			 */
-			if(ewp->window == Scr->Root) {
-				if(!scanArgs.leaves && !scanArgs.enters) {
-					InstallColormaps(EnterNotify, &Scr->RootColormaps);
-				}
-				return;
-			}
-		}
-		/* End of RaiseDelay modification. */
-
 		/*
 		 * if we have an event for a specific one of our windows
 		 */
@@ -3362,9 +3310,18 @@ void HandleEnterNotify(void)
 				SetBorderCursor(Tmp_win, -1000, -1000);
 			}
 			/*
-			 * If this window is to be autoraised, mark it so
+			 * If this window is to be autoraised, mark it so.  With a
+			 * RaiseDelay, that waits to see if the pointer stays in
+			 * its frame, rather than just passing through.
 			 */
-			if(Tmp_win->auto_raise) {
+			AutoLowerCancel(Tmp_win);
+			if(Tmp_win->auto_raise && Tmp_win->raise_delay > 0
+			                && Tmp_win->mapped
+			                && (!Tmp_win->iconmanagerlist
+			                    || Tmp_win->iconmanagerlist->w != ewp->window)) {
+				AutoRaiseSchedule(Tmp_win);
+			}
+			else if(Tmp_win->auto_raise) {
 				enter_win = Tmp_win;
 				if(enter_flag == false) {
 					AutoRaiseWindow(Tmp_win);
@@ -3652,8 +3609,24 @@ void HandleLeaveNotify(void)
 		}
 	}
 
-	/* Autolower modification. */
-	if(Tmp_win->auto_lower) {
+	/* Out of the frame altogether?  Then any pending raise is off. */
+	if(Event.xcrossing.window == Tmp_win->frame
+	                && Event.xcrossing.detail != NotifyInferior) {
+		AutoRaiseCancel(Tmp_win);
+	}
+
+	/*
+	 * Autolower modification.  With a LowerDelay, we wait to see if the
+	 * pointer comes back before lowering.
+	 */
+	if(Tmp_win->auto_lower && Tmp_win->lower_delay > 0
+	                && Tmp_win->mapped && !inicon) {
+		if(Event.xcrossing.window == Tmp_win->frame
+		                && Event.xcrossing.detail != NotifyInferior) {
+			AutoLowerSchedule(Tmp_win);
+		}
+	}
+	else if(Tmp_win->auto_lower) {
 		leave_win = Tmp_win;
 		if(leave_flag == false) {
 			AutoLowerWindow(Tmp_win);
@@ -10,6 +10,10 @@
 void SetRaiseWindow(TwmWindow *tmp);
 void AutoPopupMaybe(TwmWindow *tmp);
 void AutoLowerWindow(TwmWindow *tmp);
+void AutoRaiseSchedule(TwmWindow *tmp);
+void AutoRaiseCancel(TwmWindow *tmp);
+void AutoLowerSchedule(TwmWindow *tmp);
+void AutoLowerCancel(TwmWindow *tmp);
 Window WindowOfEvent(XEvent *e);
 ScreenInfo *GetTwmScreen(XEvent *event);
 void SynthesiseFocusOut(Window w);
@@ -15,6 +15,7 @@
 #include "list.h"
 #include "otp.h"
 #include "screen.h"
+#include "timers.h"
 #include "vscreen.h"
 #include "win_iconify.h"
 #include "workspace_manager.h"
@@ -23,6 +24,26 @@
 static ScreenInfo *FindScreenInfo(Window w);
 
 
+/*
+ * Delayed auto-raise/lower.  With a RaiseDelay, entering an AutoRaise
+ * window doesn't raise it, it starts a timer; leaving the frame again
+ * calls it off, and when it goes off we only raise if the pointer's
+ * still in there.  So sweeping the pointer across a pile of windows
+ * doesn't restack every one it passes over.  LowerDelay is the same the
+ * other way around: coming back in before it's up cancels the lower.
+ *
+ * The pointer can only be in one place, so there's only ever one of
+ * each pending.
+ */
+typedef struct DelayedRestack {
+	Timer timer;
+	TwmWindow *win;
+	ScreenInfo *scr;
+} DelayedRestack;
+
+static DelayedRestack pendingRaise, pendingLower;
+
+
 void
 AutoRaiseWindow(TwmWindow *tmp)
 {
@@ -86,6 +107,122 @@ AutoLowerWindow(TwmWindow *tmp)
 }
 
 
+
+/*
+ * Is the pointer (still) somewhere in the window's frame?
+ */
+static bool
+PointerInFrame(TwmWindow *tmp)
+{
+	Window root, child;
+	int rx, ry, x, y;
+	unsigned int mask;
+	const int bw = tmp->frame_bw;
+
+	if(!tmp->mapped) {
+		return false;
+	}
+	if(!XQueryPointer(dpy, tmp->frame, &root, &child, &rx, &ry, &x, &y,
+	                  &mask)) {
+		return false;   // Not even on the same screen
+	}
+	return x >= -bw && y >= -bw
+	       && x < tmp->frame_width + bw && y < tmp->frame_height + bw;
+}
+
+static void
+DelayedRaise(void *arg)
+{
+	DelayedRestack *dr = arg;
+	TwmWindow *tmp = dr->win;
+
+	dr->win = NULL;
+	Scr = dr->scr;
+	if(PointerInFrame(tmp)) {
+		AutoRaiseWindow(tmp);
+	}
+}
+
+static void
+DelayedLower(void *arg)
+{
+	DelayedRestack *dr = arg;
+	TwmWindow *tmp = dr->win;
+
+	dr->win = NULL;
+	Scr = dr->scr;
+	if(tmp->mapped) {
+		AutoLowerWindow(tmp);
+	}
+}
+
+static void
+DelaySchedule(DelayedRestack *dr, TimerFunc func, TwmWindow *tmp,
+              int delay)
+{
+	// Already counting down for it?  Wandering around inside the frame
+	// doesn't restart the clock.
+	if(dr->win == tmp && TimerPending(&dr->timer)) {
+		return;
+	}
+	if(dr->win != NULL) {
+		TimerCancel(&dr->timer);
+	}
+	TimerInit(&dr->timer, func, dr);
+	dr->win = tmp;
+	dr->scr = Scr;
+	TimerSet(&dr->timer, delay);
+}
+
+static void
+DelayCancel(DelayedRestack *dr, TwmWindow *tmp)
+{
+	if(dr->win == tmp) {
+		TimerCancel(&dr->timer);
+		dr->win = NULL;
+	}
+}
+
+
+/**
+ * Raise an AutoRaise window after its RaiseDelay, if the pointer stays
+ * in it that long.
+ */
+void
+AutoRaiseSchedule(TwmWindow *tmp)
+{
+	DelaySchedule(&pendingRaise, DelayedRaise, tmp, tmp->raise_delay);
+}
+
+/**
+ * Call off any pending raise for a window.
+ */
+void
+AutoRaiseCancel(TwmWindow *tmp)
+{
+	DelayCancel(&pendingRaise, tmp);
+}
+
+/**
+ * Lower an AutoLower window after its LowerDelay, unless the pointer
+ * comes back first.
+ */
+void
+AutoLowerSchedule(TwmWindow *tmp)
+{
+	DelaySchedule(&pendingLower, DelayedLower, tmp, tmp->lower_delay);
+}
+
+/**
+ * Call off any pending lower for a window.
+ */
+void
+AutoLowerCancel(TwmWindow *tmp)
+{
+	DelayCancel(&pendingLower, tmp);
+}
+
+
 /*
  * WindowOfEvent - return the window about which this event is concerned; this
  * window may not be the same as XEvent.xany.window (the first window listed
@@ -27,8 +27,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <time.h>
 #include <stdint.h>
+#include <string.h>
 #include <assert.h>
 
 #include <X11/Xatom.h>
@@ -44,9 +46,13 @@
 #include "icons.h"
 #include "otp.h"
 #include "image.h"
+#include "image_upload.h"
 #include "list.h"
 #include "functions.h"
 #include "occupation.h"
+#include "prop_writer.h"
+#include "r_area.h"
+#include "r_area_list.h"
 #include "r_layout.h"
 #include "util.h"
 #include "vscreen.h"
@@ -77,7 +83,7 @@ Atom XEWMHAtom[NUM_EWMH_XATOMS];
 #define _NET_WM_MOVERESIZE_MOVE_KEYBOARD    10   /* move via keyboard */
 #define _NET_WM_MOVERESIZE_CANCEL           11   /* cancel operation */
 
-static Image *ExtractIcon(ScreenInfo *scr, unsigned long *prop, int width,
+static Image *ExtractIcon(ScreenInfo *scr, const unsigned long *prop, int width,
                           int height);
 static void EwmhClientMessage_NET_WM_DESKTOP(XClientMessageEvent *msg);
 static void EwmhClientMessage_NET_WM_STATE(XClientMessageEvent *msg);
@@ -87,6 +93,9 @@ static XEvent synth_btnevent_for_moveresize(TwmWindow *twm_win);
 static unsigned long EwmhGetWindowProperty(Window w, Atom name, Atom type);
 static void EwmhGetStrut(TwmWindow *twm_win, bool update);
 static void EwmhRemoveStrut(TwmWindow *twm_win);
+static void EwmhStrutSetFullEdges(EwmhStrut *strut);
+static void EwmhStrutChanged(const EwmhStrut *old, const EwmhStrut *new);
+static void EwmhRecalculateWorkArea(void);
 static void EwmhSet_NET_WORKAREA(ScreenInfo *scr);
 static int EwmhGet_NET_WM_STATE(TwmWindow *twm_win);
 static void EwmhClientMessage_NET_WM_STATEchange(TwmWindow *twm_win, int change,
@@ -410,10 +419,8 @@ void EwmhInitScreenLate(ScreenInfo *scr)
 	else {
 		data[0] = 0;
 	}
-	XChangeProperty(dpy, scr->XineramaRoot,
-	                XA__NET_CURRENT_DESKTOP, XA_CARDINAL,
-	                32, PropModeReplace,
-	                (unsigned char *)data, 1);
+	PropSet(scr->XineramaRoot, XA__NET_CURRENT_DESKTOP, XA_CARDINAL, 32,
+	        data, 1);
 
 	EwmhSet_NET_SHOWING_DESKTOP(0);
 
@@ -603,6 +610,214 @@ bool EwmhClientMessage(XClientMessageEvent *msg)
 	return false;
 }
 
+/*
+ * Icons extracted from _NET_WM_ICON are kept in a small cache, keyed on
+ * a hash of the chosen ARGB pixels (plus their size and the screen).
+ * We keep a copy of the pixels too, so a hash collision can't give one
+ * window another's icon.
+ * Windows showing the same icon (typically all windows of one class)
+ * share a single Image, and a client rewriting the property with data
+ * we've already seen, such as a chat client flipping a notification
+ * badge on and off, doesn't cost us a new Pixmap each time.
+ *
+ * Entries nobody uses any more are kept around on an LRU basis, up to
+ * EWMH_ICON_CACHE_IDLE of them, before their Image is freed.
+ */
+typedef struct EwmhIconCacheEntry {
+	struct EwmhIconCacheEntry *next;
+	ScreenInfo *scr;
+	uint64_t hash;
+	int src_width, src_height;  ///< Size of the chosen icon, pre-scaling
+	unsigned long *pixels;      ///< ... and its pixels, as we got them
+	Image *image;
+	int refcount;
+	unsigned long lastuse;      ///< For picking the LRU idle entry
+} EwmhIconCacheEntry;
+
+#define EWMH_ICON_CACHE_IDLE    8
+
+/* Sanity limit on icon dimensions; beyond it we assume garbage */
+#define EWMH_ICON_MAX_DIM       4096
+
+/* How much of the property to read up front */
+#define EWMH_ICON_FIRST_FETCH   1024
+
+static EwmhIconCacheEntry *iconCache;
+static int iconCacheIdle;
+static unsigned long iconCacheClock;
+
+
+/*
+ * 64-bit FNV-1a over the icon size and pixels.  Only the low 32 bits of
+ * each CARDINAL carry data, whatever sizeof(long) is.
+ */
+static uint64_t EwmhIconHash(const unsigned long *pixels, int width,
+                             int height)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	const uint64_t prime = 0x100000001b3ULL;
+	int i, n = width * height;
+
+#define FNV_WORD(v) do { \
+		uint32_t _v = (v); \
+		h = (h ^ (_v & 0xFF)) * prime; \
+		h = (h ^ ((_v >> 8) & 0xFF)) * prime; \
+		h = (h ^ ((_v >> 16) & 0xFF)) * prime; \
+		h = (h ^ (_v >> 24)) * prime; \
+	} while(0)
+
+	FNV_WORD(width);
+	FNV_WORD(height);
+	for(i = 0; i < n; i++) {
+		FNV_WORD(pixels[i]);
+	}
+#undef FNV_WORD
+
+	return h;
+}
+
+
+/*
+ * Shrink an ARGB icon with a box filter, so that it fits in
+ * (max_w x max_h) keeping its aspect ratio.  Colour channels are
+ * weighted by alpha so transparent pixels don't bleed into the edges.
+ * Returns a malloc'd buffer, and the new size in *dw and *dh.
+ */
+static unsigned long *EwmhScaleIcon(const unsigned long *src, int sw, int sh,
+                                    int max_w, int max_h, int *dw, int *dh)
+{
+	unsigned long *dst;
+	int w, h, x, y;
+
+	if((long)sw * max_h > (long)sh * max_w) {
+		w = max_w;
+		h = max(1, (int)((long)sh * max_w / sw));
+	}
+	else {
+		h = max_h;
+		w = max(1, (int)((long)sw * max_h / sh));
+	}
+
+	dst = malloc(w * h * sizeof(dst[0]));
+	if(dst == NULL) {
+		return NULL;
+	}
+
+	for(y = 0; y < h; y++) {
+		int y0 = (long)y * sh / h;
+		int y1 = max(y0 + 1, (int)((long)(y + 1) * sh / h));
+
+		for(x = 0; x < w; x++) {
+			int x0 = (long)x * sw / w;
+			int x1 = max(x0 + 1, (int)((long)(x + 1) * sw / w));
+			unsigned long sa = 0, sr = 0, sg = 0, sb = 0, n = 0;
+			int sx, sy;
+
+			for(sy = y0; sy < y1; sy++) {
+				const unsigned long *row = &src[sy * sw];
+				for(sx = x0; sx < x1; sx++) {
+					unsigned long argb = row[sx];
+					unsigned long a = (argb >> 24) & 0xFF;
+					sa += a;
+					sr += a * ((argb >> 16) & 0xFF);
+					sg += a * ((argb >>  8) & 0xFF);
+					sb += a * ((argb >>  0) & 0xFF);
+					n++;
+				}
+			}
+
+			if(sa == 0) {
+				dst[y * w + x] = 0;
+			}
+			else {
+				dst[y * w + x] = ((sa / n) << 24) | ((sr / sa) << 16)
+				                 | ((sg / sa) << 8) | (sb / sa);
+			}
+		}
+	}
+
+	*dw = w;
+	*dh = h;
+	return dst;
+}
+
+
+/*
+ * Drop a reference to an Image returned by EwmhGetIcon().
+ */
+void EwmhReleaseIcon(Image *image)
+{
+	EwmhIconCacheEntry *ce, **pce, **lru;
+
+	if(image == NULL) {
+		return;
+	}
+
+	for(ce = iconCache; ce != NULL; ce = ce->next) {
+		if(ce->image == image) {
+			break;
+		}
+	}
+	if(ce == NULL) {
+		/* Not one of ours; shouldn't happen */
+		FreeImage(image);
+		return;
+	}
+
+	assert(ce->refcount > 0);
+	if(--ce->refcount > 0) {
+		return;
+	}
+	ce->lastuse = ++iconCacheClock;
+	if(++iconCacheIdle <= EWMH_ICON_CACHE_IDLE) {
+		return;
+	}
+
+	/* Too many idle entries; get rid of the least recently used one */
+	lru = NULL;
+	for(pce = &iconCache; *pce != NULL; pce = &(*pce)->next) {
+		if((*pce)->refcount == 0 &&
+		                (lru == NULL || (*pce)->lastuse < (*lru)->lastuse)) {
+			lru = pce;
+		}
+	}
+	ce = *lru;
+	*lru = ce->next;
+	iconCacheIdle--;
+	FreeImage(ce->image);
+	free(ce->pixels);
+	free(ce);
+}
+
+
+/*
+ * Read a piece of _NET_WM_ICON.  Returns NULL on failure or if there's
+ * nothing there.
+ */
+static unsigned long *EwmhFetchIcon(Window w, long offset, long length,
+                                    unsigned long *nitems, unsigned long *bytes_after)
+{
+	Atom actual_type;
+	int actual_format;
+	unsigned long *prop;
+
+	if(XGetWindowProperty(dpy, w, XA__NET_WM_ICON,
+	                      offset, length, False, XA_CARDINAL,
+	                      &actual_type, &actual_format, nitems,
+	                      bytes_after, (unsigned char **)&prop) != Success) {
+		return NULL;
+	}
+	if(prop == NULL) {
+		return NULL;
+	}
+	if(actual_format != 32 || *nitems == 0) {
+		XFree(prop);
+		return NULL;
+	}
+	return prop;
+}
+
+
 /*
  * The format of the _NET_WM_ICON property is
  *
@@ -615,46 +830,41 @@ bool EwmhClientMessage(XClientMessageEvent *msg)
  * repeat for next size.
  *
  * Some icons can be 256x256 CARDINALs which is 65536 CARDINALS!
- * Therefore we fetch in pieces and skip the pixels of large icons
- * until needed.
+ * So we read a modest first piece of the property, which usually holds
+ * the headers of the smaller sizes, and walk the rest of the size
+ * headers with 2-CARDINAL reads, skipping over the pixels.  Only the
+ * pixels of the one size we choose are ever transferred.
  *
  * First scan all sizes. Keep a record of the closest smaller and larger
  * size. At the end, choose from one of those.
- * Finally, go and fetch the pixel data.
+ * Finally, go and fetch the pixel data, and look it up in the cache.
+ *
+ * The returned Image is shared; release it with EwmhReleaseIcon().
  */
-
 Image *EwmhGetIcon(ScreenInfo *scr, TwmWindow *twm_win)
 {
-	int fetch_offset;
-	Atom actual_type;
-	int actual_format;
-	unsigned long nitems, bytes_after;
-	unsigned long *prop;
-
-	int wanted_area;
-	int smaller, larger;
-	int offset;
-	int smaller_offset, larger_offset;
-	int i;
-
-	int area, width, height;
-
-	fetch_offset = 0;
-	if(XGetWindowProperty(dpy, twm_win->w, XA__NET_WM_ICON,
-	                      fetch_offset, 8 * 1024, False, XA_CARDINAL,
-	                      &actual_type, &actual_format, &nitems,
-	                      &bytes_after, (unsigned char **)&prop) != Success || nitems == 0) {
-		return NULL;
-	}
-
-	if(actual_format != 32) {
-		XFree(prop);
+	unsigned long *first, *prop, *pixels;
+	unsigned long first_len, nitems, bytes_after;
+
+	long total;
+	long wanted_area;
+	long smaller, larger;
+	long offset, area;
+	long smaller_offset, larger_offset;
+	int width, height;
+
+	first = EwmhFetchIcon(twm_win->w, 0, EWMH_ICON_FIRST_FETCH,
+	                      &first_len, &bytes_after);
+	if(first == NULL) {
 		return NULL;
 	}
 
 #ifdef DEBUG_EWMH
 	fprintf(stderr, "_NET_WM_ICON data fetched\n");
 #endif
+	/* How long the whole thing is, in CARDINALs */
+	total = first_len + bytes_after / 4;
+
 	/*
 	 * Usually the icons are square, but that is not a rule.
 	 * So we measure the area instead.
@@ -662,114 +872,90 @@ Image *EwmhGetIcon(ScreenInfo *scr, TwmWindow *twm_win)
 	 * Approach wanted size from both directions and at the end,
 	 * choose the "nearest".
 	 */
-	wanted_area = Scr->PreferredIconWidth * Scr->PreferredIconHeight;
+	wanted_area = scr->PreferredIconWidth * scr->PreferredIconHeight;
 	smaller = 0;
-	larger = 999999;
-	offset = 0;
+	larger = LONG_MAX;
 	smaller_offset = -1;
 	larger_offset = -1;
-	i = 0;
 
-	for(;;) {
-		offset = i;
+	for(offset = 0; offset + 2 <= total; offset += 2 + area) {
+		long w, h;
 
-		int w = prop[i++];
-		int h = prop[i++];
-		int size = w * h;
+		if(offset + 2 <= first_len) {
+			w = first[offset];
+			h = first[offset + 1];
+		}
+		else {
+			unsigned long *hdr = EwmhFetchIcon(twm_win->w, offset, 2,
+			                                   &nitems, &bytes_after);
+			if(hdr == NULL) {
+				break;
+			}
+			if(nitems < 2) {
+				XFree(hdr);
+				break;
+			}
+			w = hdr[0];
+			h = hdr[1];
+			XFree(hdr);
+		}
 
+		if(w <= 0 || h <= 0 || w > EWMH_ICON_MAX_DIM || h > EWMH_ICON_MAX_DIM) {
+#ifdef DEBUG_EWMH
+			fprintf(stderr, "[%ld] bogus size w=%ld h=%ld\n", offset, w, h);
+#endif
+			break;
+		}
 		area = w * h;
-
+		if(offset + 2 + area > total) {
 #ifdef DEBUG_EWMH
-		fprintf(stderr, "[%d+%d] w=%d h=%d\n", fetch_offset, offset, w, h);
+			fprintf(stderr, "[%ld] w=%ld h=%ld runs off the end\n", offset, w, h);
 #endif
+			break;
+		}
 
+#ifdef DEBUG_EWMH
+		fprintf(stderr, "[%ld] w=%ld h=%ld\n", offset, w, h);
+#endif
 
 		if(area == wanted_area) {
 #ifdef DEBUG_EWMH
-			fprintf(stderr, "exact match [%d+%d=%d] w=%d h=%d\n", fetch_offset, offset,
-			        fetch_offset + offset, w, h);
+			fprintf(stderr, "exact match [%ld] w=%ld h=%ld\n", offset, w, h);
 #endif /* DEBUG_EWMH */
-			smaller_offset = fetch_offset + offset;
+			smaller_offset = offset;
 			smaller = area;
 			larger_offset = -1;
 			break;
 		}
 		else if(area < wanted_area) {
 			if(area > smaller) {
-#ifdef DEBUG_EWMH
-				fprintf(stderr, "increase smaller, was [%d]\n", smaller_offset);
-#endif /* DEBUG_EWMH */
 				smaller = area;
-				smaller_offset = fetch_offset + offset;
+				smaller_offset = offset;
 			}
 		}
 		else {   /* area > wanted_area */
 			if(area < larger) {
-#ifdef DEBUG_EWMH
-				fprintf(stderr, "decrease larger, was [%d]\n", larger_offset);
-#endif /* DEBUG_EWMH */
 				larger = area;
-				larger_offset = fetch_offset + offset;
-			}
-		}
-
-		if(i + size + 2 > nitems) {
-#ifdef DEBUG_EWMH
-			fprintf(stderr, "not enough data: %d + %d > %ld \n", i, size, nitems);
-#endif /* DEBUG_EWMH */
-
-			if(i + size + 2 <= nitems + bytes_after / 4) {
-				/* we can fetch some more... */
-				XFree(prop);
-				fetch_offset += i + size;
-				if(XGetWindowProperty(dpy, twm_win->w, XA__NET_WM_ICON,
-				                      fetch_offset, 8 * 1024, False, XA_CARDINAL,
-				                      &actual_type, &actual_format, &nitems,
-				                      &bytes_after, (unsigned char **)&prop) != Success) {
-					continue;
-				}
-				i = 0;
-				continue;
+				larger_offset = offset;
 			}
-			break;
 		}
-		i += size;
 	}
 
 	/*
 	 * Choose which icon approximates our desired size best.
 	 */
-	area = 0;
-
 	if(smaller_offset >= 0) {
-		if(larger_offset >= 0) {
-			/* choose the nearest */
-#ifdef DEBUG_EWMH
-			fprintf(stderr, "choose nearest %d %d\n", smaller, larger);
-#endif /* DEBUG_EWMH */
-			if((double)larger / wanted_area > (double)wanted_area / smaller) {
-				offset = smaller_offset;
-				area = smaller;
-			}
-			else {
-				offset = larger_offset;
-				area = larger;
-			}
+		if(larger_offset >= 0 &&
+		                (double)larger / wanted_area <= (double)wanted_area / smaller) {
+			offset = larger_offset;
+			area = larger;
 		}
 		else {
-			/* choose smaller */
-#ifdef DEBUG_EWMH
-			fprintf(stderr, "choose smaller (only) %d\n", smaller);
-#endif /* DEBUG_EWMH */
 			offset = smaller_offset;
 			area = smaller;
 		}
 	}
 	else if(larger_offset >= 0) {
-		/* choose larger */
-#ifdef DEBUG_EWMH
-		fprintf(stderr, "choose larger (only) %d\n", larger);
-#endif /* DEBUG_EWMH */
 		offset = larger_offset;
 		area = larger;
 	}
@@ -778,45 +964,113 @@ Image *EwmhGetIcon(ScreenInfo *scr, TwmWindow *twm_win)
 #ifdef DEBUG_EWMH
 		fprintf(stderr, "nothing to choose from\n");
 #endif /* DEBUG_EWMH */
-		XFree(prop);
+		XFree(first);
 		return NULL;
 	}
 
 	/*
-	 * Now fetch the pixels.
+	 * Now get the pixels: either they were in the first piece already,
+	 * or we fetch exactly that one size.
 	 */
-
+	if(offset + 2 + area <= first_len) {
+		prop = first;
+		pixels = &first[offset];
+	}
+	else {
+		XFree(first);
+		first = NULL;
+		prop = EwmhFetchIcon(twm_win->w, offset, 2 + area, &nitems, &bytes_after);
+		if(prop == NULL) {
+			return NULL;
+		}
+		if(nitems < 2 + area) {
+			XFree(prop);
+			return NULL;
+		}
+		pixels = prop;
+	}
+	width = pixels[0];
+	height = pixels[1];
+	pixels += 2;
 #ifdef DEBUG_EWMH
-	fprintf(stderr, "offset = %d fetch_offset = %d\n", offset, fetch_offset);
-	fprintf(stderr, "offset + 2 + area = %d fetch_offset + nitems = %ld\n",
-	        offset + 2 + area, fetch_offset + nitems);
+	fprintf(stderr, "Chosen [%ld] w=%d h=%d area=%ld\n", offset, width, height,
+	        area);
 #endif /* DEBUG_EWMH */
-	if(offset < fetch_offset ||
-	                offset + 2 + area > fetch_offset + nitems) {
-		XFree(prop);
-		fetch_offset = offset;
+	assert(width * height == area);
+
+	/*
+	 * Have we got these pixels already?
+	 */
+	uint64_t hash = EwmhIconHash(pixels, width, height);
+	const size_t pixbytes = area * sizeof(unsigned long);
+	EwmhIconCacheEntry *ce;
+
+	for(ce = iconCache; ce != NULL; ce = ce->next) {
+		if(ce->scr == scr && ce->hash == hash &&
+		                ce->src_width == width && ce->src_height == height &&
+		                memcmp(ce->pixels, pixels, pixbytes) == 0) {
+			XFree(prop);
+			if(ce->refcount++ == 0) {
+				iconCacheIdle--;
+			}
 #ifdef DEBUG_EWMH
-		fprintf(stderr, "refetching from %d\n", fetch_offset);
+			fprintf(stderr, "icon cache hit\n");
 #endif /* DEBUG_EWMH */
-		if(XGetWindowProperty(dpy, twm_win->w, XA__NET_WM_ICON,
-		                      fetch_offset, 2 + area, False, XA_CARDINAL,
-		                      &actual_type, &actual_format, &nitems,
-		                      &bytes_after, (unsigned char **)&prop) != Success) {
-			return NULL;
+			return ce->image;
 		}
 	}
 
-	i = offset - fetch_offset;
-	width = prop[i++];
-	height = prop[i++];
-#ifdef DEBUG_EWMH
-	fprintf(stderr, "Chosen [%d] w=%d h=%d area=%d\n", offset, width, height, area);
-#endif /* DEBUG_EWMH */
-	assert(width * height == area);
+	/*
+	 * No; build it, shrinking it first if it's too big and we're asked
+	 * to.  Hang onto the pixels for checking later hits against.
+	 */
+	Image *image;
+	unsigned long *srcpixels = malloc(pixbytes);
 
-	Image *image = ExtractIcon(scr, &prop[i], width, height);
+	if(srcpixels != NULL) {
+		memcpy(srcpixels, pixels, pixbytes);
+	}
+	if(scr->ScaleEWMHIcons && (width > scr->PreferredIconWidth ||
+	                           height > scr->PreferredIconHeight)) {
+		unsigned long *scaled;
+		int sw, sh;
 
-	XFree(prop);
+		scaled = EwmhScaleIcon(pixels, width, height,
+		                       scr->PreferredIconWidth, scr->PreferredIconHeight,
+		                       &sw, &sh);
+		XFree(prop);
+		if(scaled == NULL) {
+			free(srcpixels);
+			return NULL;
+		}
+		image = ExtractIcon(scr, scaled, sw, sh);
+		free(scaled);
+	}
+	else {
+		image = ExtractIcon(scr, pixels, width, height);
+		XFree(prop);
+	}
+	if(image == NULL) {
+		free(srcpixels);
+		return NULL;
+	}
+
+	ce = srcpixels != NULL ? malloc(sizeof(*ce)) : NULL;
+	if(ce == NULL) {
+		/* Can't cache it; EwmhReleaseIcon() will just free it */
+		free(srcpixels);
+		return image;
+	}
+	ce->scr = scr;
+	ce->hash = hash;
+	ce->src_width = width;
+	ce->src_height = height;
+	ce->pixels = srcpixels;
+	ce->image = image;
+	ce->refcount = 1;
+	ce->lastuse = 0;
+	ce->next = iconCache;
+	iconCache = ce;
 
 	return image;
 }
@@ -837,12 +1091,13 @@ static void convert_for_32(int w, int x, int y, int argb)
 	buffer_32bpp [y * w + x] = argb & 0x00FFFFFF;
 }
 
-static Image *ExtractIcon(ScreenInfo *scr, unsigned long *prop, int width,
+static Image *ExtractIcon(ScreenInfo *scr, const unsigned long *prop, int width,
                           int height)
 {
 	XImage *ximage;
 	void (*store_data)(int w, int x, int y, int argb);
 	int x, y, transparency;
+	int stride;
 	int rowbytes;
 	unsigned char *maskbits;
 
@@ -852,35 +1107,37 @@ static Image *ExtractIcon(ScreenInfo *scr, unsigned long *prop, int width,
 	Image *image;
 	int i;
 
-	ximage = NULL;
-
 	/** XXX sort of duplicated from util.c:LoadJpegImage() */
-	if(scr->d_depth == 16) {
-		store_data = convert_for_16;
-		buffer_16bpp = malloc(width * height * sizeof(buffer_16bpp[0]));
-		buffer_32bpp = NULL;
-		ximage = XCreateImage(dpy, CopyFromParent, scr->d_depth, ZPixmap, 0,
-		                      (char *) buffer_16bpp, width, height, 16, width * 2);
-	}
-	else if(scr->d_depth == 24 || scr->d_depth == 32) {
-		store_data = convert_for_32;
-		buffer_32bpp = malloc(width * height * sizeof(buffer_32bpp[0]));
-		buffer_16bpp = NULL;
-		ximage = XCreateImage(dpy, CopyFromParent, scr->d_depth, ZPixmap, 0,
-		                      (char *) buffer_32bpp, width, height, 32, width * 4);
-	}
-	else {
+	if(scr->d_depth != 16 && scr->d_depth != 24 && scr->d_depth != 32) {
 #ifdef DEBUG_EWMH
 		fprintf(stderr, "Screen unsupported depth for 32-bit icon: %d\n", scr->d_depth);
 #endif /* DEBUG_EWMH */
-		XFree(prop);
 		return NULL;
 	}
+	ximage = ImageUploadCreate(scr->d_depth, width, height);
 	if(ximage == NULL) {
 #ifdef DEBUG_EWMH
 		fprintf(stderr, "cannot create image for icon\n");
 #endif /* DEBUG_EWMH */
-		XFree(prop);
+		return NULL;
+	}
+	buffer_16bpp = NULL;
+	buffer_32bpp = NULL;
+	if(ximage->bits_per_pixel == 16) {
+		store_data = convert_for_16;
+		buffer_16bpp = (uint16_t *) ximage->data;
+		stride = ximage->bytes_per_line / 2;
+	}
+	else if(ximage->bits_per_pixel == 32) {
+		store_data = convert_for_32;
+		buffer_32bpp = (uint32_t *) ximage->data;
+		stride = ximage->bytes_per_line / 4;
+	}
+	else {
+#ifdef DEBUG_EWMH
+		fprintf(stderr, "Screen unsupported depth for 32-bit icon: %d\n", scr->d_depth);
+#endif /* DEBUG_EWMH */
+		ImageUploadDestroy(ximage);
 		return NULL;
 	}
 
@@ -897,7 +1154,7 @@ static Image *ExtractIcon(ScreenInfo *scr, unsigned long *prop, int width,
 	for(y = 0; y < height; y++) {
 		for(x = 0; x < width; x++) {
 			unsigned long argb = prop[i++];
-			store_data(width, x, y, argb);
+			store_data(stride, x, y, argb);
 			int opaque = ((argb >> 24) & 0xFF) >= 0x80; /* arbitrary cutoff */
 			if(opaque) {
 				maskbits [rowbytes * y + (x / 8)] |= 0x01 << (x % 8);
@@ -910,9 +1167,8 @@ static Image *ExtractIcon(ScreenInfo *scr, unsigned long *prop, int width,
 
 	gc = DefaultGC(dpy, scr->screen);
 	pixret = XCreatePixmap(dpy, scr->Root, width, height, scr->d_depth);
-	XPutImage(dpy, pixret, gc, ximage, 0, 0, 0, 0, width, height);
-	XDestroyImage(ximage);  /* also frees buffer_{16,32}bpp */
-	ximage = NULL;
+	ImageUploadPut(pixret, gc, ximage, 0, 0, 0, 0, width, height);
+	ImageUploadDestroy(ximage);  /* also frees buffer_{16,32}bpp */
 
 	mask = None;
 	if(transparency) {
@@ -956,12 +1212,21 @@ static void EwmhHandle_NET_WM_ICONNotify(XPropertyEvent *event,
 	}
 
 	Image *image = EwmhGetIcon(Scr, twm_win);
+	if(image == NULL) {
+		/* Nothing usable there (any more); keep what we have */
+		return;
+	}
+	if(image == icon->image) {
+		/* Same pixels as we're already showing */
+		EwmhReleaseIcon(image);
+		return;
+	}
 
 	/* TODO: de-duplicate with handling of XA_WM_HINTS */
 	{
 		Image *old_image = icon->image;
 		icon->image = image;
-		FreeImage(old_image);
+		EwmhReleaseIcon(old_image);
 	}
 
 
@@ -1492,10 +1757,7 @@ void EwmhSet_NET_WM_DESKTOP_ws(TwmWindow *twm_win, WorkSpace *ws)
 		}
 	}
 
-	XChangeProperty(dpy, twm_win->w,
-	                XA__NET_WM_DESKTOP, XA_CARDINAL,
-	                32, PropModeReplace,
-	                (unsigned char *)workspaces, n);
+	PropSet(twm_win->w, XA__NET_WM_DESKTOP, XA_CARDINAL, 32, workspaces, n);
 }
 
 
@@ -1649,7 +1911,7 @@ static void EwmhClientMessage_NET_WM_DESKTOP(XClientMessageEvent *msg)
  */
 void EwmhUnmapNotify(TwmWindow *twm_win)
 {
-	XDeleteProperty(dpy, twm_win->w, XA__NET_WM_DESKTOP);
+	PropDelete(twm_win->w, XA__NET_WM_DESKTOP);
 }
 
 /*
@@ -1775,8 +2037,7 @@ void EwmhSet_NET_CLIENT_LIST_STACKING(void)
 		        i, Scr->ewmh_CLIENT_LIST_used);
 	}
 
-	XChangeProperty(dpy, Scr->Root, XA__NET_CLIENT_LIST_STACKING, XA_WINDOW, 32,
-	                PropModeReplace, (unsigned char *)prop, i);
+	PropSet(Scr->Root, XA__NET_CLIENT_LIST_STACKING, XA_WINDOW, 32, prop, i);
 
 	free(prop);
 }
@@ -1787,8 +2048,7 @@ void EwmhSet_NET_ACTIVE_WINDOW(Window w)
 
 	prop[0] = w;
 
-	XChangeProperty(dpy, Scr->Root, XA__NET_ACTIVE_WINDOW, XA_WINDOW, 32,
-	                PropModeReplace, (unsigned char *)prop, 1);
+	PropSet(Scr->Root, XA__NET_ACTIVE_WINDOW, XA_WINDOW, 32, prop, 1);
 }
 
 /*
@@ -1868,42 +2128,185 @@ bool EwmhOnWindowRing(TwmWindow *twm_win)
 }
 
 /*
- * Recalculate the effective border values from the remembered struts.
- * Interestingly it is not documented how to do that.
- * Usually only one dock is present on each side, so it shouldn't matter
- * too much, but I presume that maximizing the values is the thing to do.
+ * Struts are tracked incrementally.  Border{Left,Right,Top,Bottom} hold
+ * the max reservation on each edge over all the struts; these are
+ * updated from just the strut that changed.  Growing a value can only
+ * raise the max, so that's a simple compare.  An edge only needs
+ * rescanning when the strut that set its max shrinks or goes away.
+ *
+ * Interestingly it is not documented how to combine several struts on
+ * the same edge.  Usually only one dock is present on each side, so it
+ * shouldn't matter too much, but I presume that maximizing the values
+ * is the thing to do.
+ *
+ * The BorderedLayout then gets rebuilt from the per-monitor effects of
+ * all the struts, but only swapped in (and _NET_WORKAREA rewritten)
+ * when the result actually differs, since panels that autohide tend to
+ * toggle their struts back and forth constantly.
  */
-static void EwmhRecalculateStrut(void)
+
+/*
+ * Update one edge's max for a strut going from oldval to newval on it.
+ * Returns true if the max may have come down, and needs rescanning.
+ */
+static bool EwmhStrutEdgeChanged(int *edge_max, int oldval, int newval)
 {
-	int left   = 0;
-	int right  = 0;
-	int top    = 0;
-	int bottom = 0;
-	EwmhStrut *strut = Scr->ewmhStruts;
+	if(newval >= *edge_max) {
+		*edge_max = newval;
+		return false;
+	}
+	return oldval == *edge_max && newval < oldval;
+}
 
-	while(strut != NULL) {
-		left   = max(left,   strut->left);
-		right  = max(right,  strut->right);
-		top    = max(top,    strut->top);
-		bottom = max(bottom, strut->bottom);
+static void EwmhStrutChanged(const EwmhStrut *old, const EwmhStrut *new)
+{
+	bool rescan = false;
+
+	rescan |= EwmhStrutEdgeChanged(&Scr->BorderLeft, old->left, new->left);
+	rescan |= EwmhStrutEdgeChanged(&Scr->BorderRight, old->right, new->right);
+	rescan |= EwmhStrutEdgeChanged(&Scr->BorderTop, old->top, new->top);
+	rescan |= EwmhStrutEdgeChanged(&Scr->BorderBottom, old->bottom,
+	                               new->bottom);
+
+	if(rescan) {
+		int left   = 0;
+		int right  = 0;
+		int top    = 0;
+		int bottom = 0;
+
+		for(EwmhStrut *strut = Scr->ewmhStruts; strut != NULL;
+		                strut = strut->next) {
+			left   = max(left,   strut->left);
+			right  = max(right,  strut->right);
+			top    = max(top,    strut->top);
+			bottom = max(bottom, strut->bottom);
+		}
 
-		strut  = strut->next;
+		Scr->BorderLeft   = left;
+		Scr->BorderRight  = right;
+		Scr->BorderTop    = top;
+		Scr->BorderBottom = bottom;
 	}
 
-	Scr->BorderLeft   = left;
-	Scr->BorderRight  = right;
-	Scr->BorderTop    = top;
-	Scr->BorderBottom = bottom;
+	EwmhRecalculateWorkArea();
+}
+
+
+/*
+ * Mark a strut as covering the full length of each of its edges.  Used
+ * for plain _NET_WM_STRUT and for the user config Border* values.
+ */
+static void EwmhStrutSetFullEdges(EwmhStrut *strut)
+{
+	strut->left_start_y   = strut->right_start_y  = 0;
+	strut->top_start_x    = strut->bottom_start_x = 0;
+	strut->left_end_y     = strut->right_end_y    = Scr->rooth - 1;
+	strut->top_end_x      = strut->bottom_end_x   = Scr->rootw - 1;
+}
+
 
-	// Bordered layout may have changed
-	Scr->BorderedLayout = RLayoutCopyCropped(Scr->Layout,
-	                      left, right, top, bottom);
-	if(Scr->BorderedLayout == NULL) {
-		Scr->BorderedLayout = Scr->Layout;        // nothing to crop
+/*
+ * Trim one monitor by what a strut reserves.  Each edge's reservation
+ * is a band along that side of the root, limited to its start/end
+ * range; the monitor is only trimmed on a side where the band overlaps
+ * it.  Returns false if there's nothing left of it.
+ */
+static bool EwmhStrutCropMonitor(RArea *mon, const EwmhStrut *strut,
+                                 const RArea *big)
+{
+	int x1 = mon->x, y1 = mon->y;
+	int x2 = RAreaX2(mon), y2 = RAreaY2(mon);
+
+	if(strut->left > 0 && x1 < big->x + strut->left
+	                && y1 <= strut->left_end_y && y2 >= strut->left_start_y) {
+		x1 = big->x + strut->left;
+	}
+	if(strut->right > 0 && x2 > RAreaX2(big) - strut->right
+	                && y1 <= strut->right_end_y && y2 >= strut->right_start_y) {
+		x2 = RAreaX2(big) - strut->right;
 	}
+	if(strut->top > 0 && y1 < big->y + strut->top
+	                && x1 <= strut->top_end_x && x2 >= strut->top_start_x) {
+		y1 = big->y + strut->top;
+	}
+	if(strut->bottom > 0 && y2 > RAreaY2(big) - strut->bottom
+	                && x1 <= strut->bottom_end_x && x2 >= strut->bottom_start_x) {
+		y2 = RAreaY2(big) - strut->bottom;
+	}
+
+	if(x2 < x1 || y2 < y1) {
+		return false;
+	}
+	*mon = RAreaNew(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+	return true;
+}
+
+
+/*
+ * Figure the work area left by the current struts, and swap it in as
+ * the BorderedLayout if it's any different from what we have.
+ */
+static void EwmhRecalculateWorkArea(void)
+{
+	const RAreaList *mons = Scr->Layout->monitors;
+	const RArea big = RLayoutBigArea(Scr->Layout);
+	RAreaList *cropped;
+	bool changed;
+
+	cropped = RAreaListNew(RAreaListLen(mons), NULL);
+	for(int i = 0 ; i < RAreaListLen(mons) ; i++) {
+		RArea mon = mons->areas[i];
+		bool keep = true;
+
+		// Monitors the struts cover completely aren't part of it
+		for(EwmhStrut *strut = Scr->ewmhStruts; keep && strut != NULL;
+		                strut = strut->next) {
+			keep = EwmhStrutCropMonitor(&mon, strut, &big);
+		}
+		if(keep) {
+			RAreaListAdd(cropped, &mon);
+		}
+	}
+
+	changed = RAreaListLen(cropped) != RAreaListLen(Scr->BorderedLayout->monitors)
+	          || memcmp(cropped->areas, Scr->BorderedLayout->monitors->areas,
+	                    RAreaListLen(cropped) * sizeof(RArea)) != 0;
+	if(!changed) {
+		RAreaListFree(cropped);
+		return;
+	}
+
+	// Nobody holds onto the BorderedLayout past the function they
+	// looked it up in, so the old one can go now.
+	if(Scr->BorderedLayout != Scr->Layout) {
+		RLayoutFree(Scr->BorderedLayout);
+	}
+	Scr->BorderedLayout = RLayoutNew(cropped);
 
 	EwmhSet_NET_WORKAREA(Scr);
 }
+
+
+/*
+ * Do two struts reserve the same thing?
+ */
+static bool EwmhStrutSame(const EwmhStrut *a, const EwmhStrut *b)
+{
+	return a->left == b->left
+	       && a->right == b->right
+	       && a->top == b->top
+	       && a->bottom == b->bottom
+	       && a->left_start_y == b->left_start_y
+	       && a->left_end_y == b->left_end_y
+	       && a->right_start_y == b->right_start_y
+	       && a->right_end_y == b->right_end_y
+	       && a->top_start_x == b->top_start_x
+	       && a->top_end_x == b->top_end_x
+	       && a->bottom_start_x == b->bottom_start_x
+	       && a->bottom_end_x == b->bottom_end_x;
+}
+
+
 /*
  * Check _NET_WM_STRUT_PARTIAL or _NET_WM_STRUT.
  * These are basically automatic settings for Border{Left,Right,Top,Bottom}.
@@ -1919,7 +2322,7 @@ static void EwmhGetStrut(TwmWindow *twm_win, bool update)
 {
 	unsigned long nitems;
 	unsigned long *prop;
-	EwmhStrut *strut;
+	EwmhStrut *strut, old;
 
 	prop = EwmhGetWindowProperties(twm_win->w,
 	                               XA__NET_WM_STRUT_PARTIAL, XA_CARDINAL,
@@ -1969,6 +2372,7 @@ static void EwmhGetStrut(TwmWindow *twm_win, bool update)
 		strut->right  = Scr->BorderRight;
 		strut->top    = Scr->BorderTop;
 		strut->bottom = Scr->BorderBottom;
+		EwmhStrutSetFullEdges(strut);
 
 		Scr->ewmhStruts = strut;
 	}
@@ -2006,12 +2410,28 @@ static void EwmhGetStrut(TwmWindow *twm_win, bool update)
 		Scr->ewmhStruts = strut;
 	}
 
+	old = *strut;
+
 	strut->win    = twm_win;
 	strut->left   = prop[0];
 	strut->right  = prop[1];
 	strut->top    = prop[2];
 	strut->bottom = prop[3];
 
+	if(nitems >= 12) {
+		strut->left_start_y   = prop[4];
+		strut->left_end_y     = prop[5];
+		strut->right_start_y  = prop[6];
+		strut->right_end_y    = prop[7];
+		strut->top_start_x    = prop[8];
+		strut->top_end_x      = prop[9];
+		strut->bottom_start_x = prop[10];
+		strut->bottom_end_x   = prop[11];
+	}
+	else {
+		EwmhStrutSetFullEdges(strut);
+	}
+
 	XFree(prop);
 
 	/*
@@ -2020,7 +2440,14 @@ static void EwmhGetStrut(TwmWindow *twm_win, bool update)
 	 */
 	twm_win->ewmhFlags |= EWMH_HAS_STRUT;
 
-	EwmhRecalculateStrut();
+	/*
+	 * Clients often rewrite the same values; nothing to do then.
+	 */
+	if(EwmhStrutSame(&old, strut)) {
+		return;
+	}
+
+	EwmhStrutChanged(&old, strut);
 }
 
 /*
@@ -2034,13 +2461,14 @@ static void EwmhRemoveStrut(TwmWindow *twm_win)
 
 	while(strut != NULL) {
 		if(strut->win == twm_win) {
+			EwmhStrut none = { 0 };
+
 			twm_win->ewmhFlags &= ~EWMH_HAS_STRUT;
 
 			*prev = strut->next;
+			EwmhStrutChanged(strut, &none);
 			free(strut);
 
-			EwmhRecalculateStrut();
-
 			break;
 		}
 		prev = &strut->next;
@@ -2067,10 +2495,7 @@ void EwmhSet_NET_FRAME_EXTENTS(TwmWindow *twm_win)
 	data[2] = twm_win->title_height + w; // top
 	data[3] = w; // bottom
 
-	XChangeProperty(dpy, twm_win->w,
-	                XA__NET_FRAME_EXTENTS, XA_CARDINAL,
-	                32, PropModeReplace,
-	                (unsigned char *)data, 4);
+	PropSet(twm_win->w, XA__NET_FRAME_EXTENTS, XA_CARDINAL, 32, data, 4);
 }
 
 
@@ -2080,9 +2505,8 @@ void EwmhSet_NET_SHOWING_DESKTOP(int state)
 
 	prop[0] = state;
 
-	XChangeProperty(dpy, Scr->XineramaRoot, XA__NET_SHOWING_DESKTOP, XA_CARDINAL,
-	                32,
-	                PropModeReplace, (unsigned char *)prop, 1);
+	PropSet(Scr->XineramaRoot, XA__NET_SHOWING_DESKTOP, XA_CARDINAL, 32,
+	        prop, 1);
 }
 
 /*
@@ -2186,8 +2610,7 @@ void EwmhSet_NET_WM_STATE(TwmWindow *twm_win, int changes)
 		prop[i++] = XA__NET_WM_STATE_BELOW;
 	}
 
-	XChangeProperty(dpy, twm_win->w, XA__NET_WM_STATE, XA_ATOM, 32,
-	                PropModeReplace, (unsigned char *)prop, i);
+	PropSet(twm_win->w, XA__NET_WM_STATE, XA_ATOM, 32, prop, i);
 }
 
 /*
@@ -2227,6 +2650,5 @@ static void EwmhSet_NET_WORKAREA(ScreenInfo *scr)
 	/* w */ prop[2] = scr->rootw - scr->BorderLeft - scr->BorderRight;
 	/* h */ prop[3] = scr->rooth - scr->BorderTop - scr->BorderBottom;
 
-	XChangeProperty(dpy, Scr->XineramaRoot, XA__NET_WORKAREA, XA_CARDINAL, 32,
-	                PropModeReplace, (unsigned char *)prop, 4);
+	PropSet(Scr->XineramaRoot, XA__NET_WORKAREA, XA_CARDINAL, 32, prop, 4);
 }
@@ -21,6 +21,10 @@ typedef enum EwmhWindowType {
 
 /*
  * The window is to reserve space at the edge of the screen.
+ *
+ * The start/end ranges come from _NET_WM_STRUT_PARTIAL, and limit
+ * which part of the edge (and so which monitors) the reservation
+ * applies to.  Struts without them cover the whole edge.
  */
 typedef struct EwmhStrut {
 	struct EwmhStrut *next;
@@ -30,6 +34,11 @@ typedef struct EwmhStrut {
 	int right;
 	int top;
 	int bottom;
+
+	int left_start_y, left_end_y;
+	int right_start_y, right_end_y;
+	int top_start_x, top_end_x;
+	int bottom_start_x, bottom_end_x;
 } EwmhStrut;
 
 #define EWMH_HAS_STRUT                  0x0001
@@ -63,6 +72,7 @@ void EwmhTerminate(void);
 void EwmhSelectionClear(XSelectionClearEvent *sev);
 bool EwmhClientMessage(XClientMessageEvent *msg);
 Image *EwmhGetIcon(ScreenInfo *scr, TwmWindow *twm_win);
+void EwmhReleaseIcon(Image *image);
 int EwmhHandlePropertyNotify(XPropertyEvent *event, TwmWindow *twm_win);
 void EwmhSet_NET_WM_DESKTOP(TwmWindow *twm_win);
 void EwmhSet_NET_WM_DESKTOP_ws(TwmWindow *twm_win, WorkSpace *ws);
@@ -0,0 +1,249 @@
+/*
+ * Shared font sets
+ *
+ * XCreateFontSet() is one of the slowest things we do at startup; it
+ * has to go find and open a font for every charset of the locale.  And
+ * we do it for every MyFont on every screen, though most configs only
+ * use two or three different fonts between them all.  Font sets belong
+ * to the display rather than to any screen, so identical ones can be
+ * shared everywhere.
+ *
+ * So we keep each font set we create, keyed by the font list it was
+ * made from and the locale it was made in, along with the metrics we
+ * derive from it, and hand out references.  The metrics are worked out
+ * once when the font set is created, and just copied after that.
+ *
+ * "xft:" fonts are Xft fonts rather than font sets, if we're built with
+ * Xft.  Those are tied to a screen, so that's part of their key.
+ */
+
+#include "ctwm.h"
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef XFT
+#include <X11/Xft/Xft.h>
+#endif
+
+#include "font_cache.h"
+#include "screen.h"
+
+
+typedef struct FontCacheEntry {
+	struct FontCacheEntry *next;
+	char *fontlist;
+	char *locale;
+	int scrnum;                 ///< Only meaningful for Xft fonts
+	XFontSet font_set;
+	struct _XftFont *xft;
+	int refcount;
+
+	int ascent;
+	int descent;
+	int height;
+} FontCacheEntry;
+
+static FontCacheEntry *fontCache;
+static FontCacheStats stats;
+
+
+/*
+ * Fill in the metrics for an entry from its font set.  This is done as
+ * the entry's created rather than left for later: it's all worked out
+ * from what Xlib got back with the font set, without asking the server
+ * anything, and every entry is handed out right away anyway.
+ */
+static void
+loadMetrics(FontCacheEntry *e)
+{
+	XFontSetExtents *font_extents;
+	XFontStruct **xfonts;
+	char **font_names;
+	int i, fnum;
+
+#ifdef XFT
+	if(e->xft != NULL) {
+		e->ascent = e->xft->ascent;
+		e->descent = e->xft->descent;
+		e->height = e->ascent + e->descent;
+		return;
+	}
+#endif
+
+	font_extents = XExtentsOfFontSet(e->font_set);
+	fnum = XFontsOfFontSet(e->font_set, &xfonts, &font_names);
+	e->ascent = e->descent = 0;
+	for(i = 0; i < fnum; i++) {
+		e->ascent = MaxSize(e->ascent, xfonts[i]->ascent);
+		e->descent = MaxSize(e->descent, xfonts[i]->descent);
+	}
+	e->height = font_extents->max_logical_extent.height;
+}
+
+
+/*
+ * Open what a font list names: an Xft font for "xft:" names, otherwise
+ * a font set.  Returns false if we can't.
+ */
+static bool
+openFont(FontCacheEntry *e, const char *fontlist)
+{
+	if(FontIsXft(fontlist)) {
+#ifdef XFT
+		e->xft = XftFontOpenName(dpy, Scr->screen,
+		                         fontlist + strlen(FONT_XFT_PREFIX));
+		return e->xft != NULL;
+#else
+		fprintf(stderr, "%s: can't use \"%s\", built without Xft support\n",
+		        ProgramName, fontlist);
+		return false;
+#endif
+	}
+	else {
+		char **missing_charset_list;
+		int missing_charset_count;
+		char *def_string;
+
+		e->font_set = XCreateFontSet(dpy, fontlist, &missing_charset_list,
+		                             &missing_charset_count, &def_string);
+		if(missing_charset_list != NULL) {
+			XFreeStringList(missing_charset_list);
+		}
+		return e->font_set != NULL;
+	}
+}
+
+
+/**
+ * Set up font with a font set (or Xft font) for fontlist, in the current
+ * locale, sharing one we already have if we can.  Fills in font_set or
+ * xft, and the metrics.  Returns false (leaving font alone) if the
+ * server can't give us anything for fontlist.  Drop the reference with
+ * FontCacheRelease() rather than freeing it.
+ */
+bool
+FontCacheGet(MyFont *font, const char *fontlist)
+{
+	struct timeval start, end;
+	const char *locale = setlocale(LC_CTYPE, NULL);
+	const bool isxft = FontIsXft(fontlist);
+	FontCacheEntry *e;
+
+	gettimeofday(&start, NULL);
+
+	if(locale == NULL) {
+		locale = "C";
+	}
+	for(e = fontCache; e != NULL; e = e->next) {
+		if(strcmp(e->fontlist, fontlist) == 0
+		                && strcmp(e->locale, locale) == 0
+		                && (!isxft || e->scrnum == Scr->screen)) {
+			break;
+		}
+	}
+
+	if(e != NULL) {
+		stats.hits++;
+	}
+	else {
+		stats.misses++;
+		e = calloc(1, sizeof(*e));
+		if(e == NULL || (e->fontlist = strdup(fontlist)) == NULL
+		                || (e->locale = strdup(locale)) == NULL) {
+			// Should never happen
+			if(e != NULL) {
+				free(e->fontlist);
+				free(e);
+				e = NULL;
+			}
+			stats.failed++;
+			goto out;
+		}
+		e->scrnum = Scr->screen;
+		if(!openFont(e, fontlist)) {
+			free(e->fontlist);
+			free(e->locale);
+			free(e);
+			e = NULL;
+			stats.failed++;
+			goto out;
+		}
+		loadMetrics(e);
+		e->next = fontCache;
+		fontCache = e;
+		stats.entries++;
+	}
+
+	e->refcount++;
+
+	font->font_set = e->font_set;
+	font->xft = e->xft;
+	font->height = e->height;
+	font->y = e->ascent;
+	font->ascent = e->ascent;
+	font->descent = e->descent;
+
+out:
+	gettimeofday(&end, NULL);
+	stats.total_ms += (end.tv_sec - start.tv_sec) * 1000.0
+	                  + (end.tv_usec - start.tv_usec) / 1000.0;
+	return e != NULL;
+}
+
+
+/**
+ * Let go of whatever font has from FontCacheGet().  It's freed once
+ * nobody's using it.
+ */
+void
+FontCacheRelease(MyFont *font)
+{
+	FontCacheEntry **pp, *e;
+
+	if(font->font_set == NULL && font->xft == NULL) {
+		return;
+	}
+
+	for(pp = &fontCache; (e = *pp) != NULL; pp = &e->next) {
+		if(e->font_set == font->font_set && e->xft == font->xft) {
+			break;
+		}
+	}
+	font->font_set = NULL;
+	font->xft = NULL;
+	if(e == NULL) {
+		// Not ours
+		return;
+	}
+	if(--e->refcount > 0) {
+		return;
+	}
+
+	*pp = e->next;
+	if(e->font_set != NULL) {
+		XFreeFontSet(dpy, e->font_set);
+	}
+#ifdef XFT
+	if(e->xft != NULL) {
+		XftFontClose(dpy, e->xft);
+	}
+#endif
+	free(e->fontlist);
+	free(e->locale);
+	free(e);
+	stats.entries--;
+}
+
+
+/**
+ * Current cache counters.
+ */
+const FontCacheStats *
+FontCacheGetStats(void)
+{
+	return &stats;
+}
@@ -0,0 +1,34 @@
+/*
+ * Shared font sets
+ */
+
+#ifndef _CTWM_FONT_CACHE_H
+#define _CTWM_FONT_CACHE_H
+
+#include <string.h>
+
+
+/// Counts and timings of font set setup, for diagnostics
+typedef struct FontCacheStats {
+	unsigned long hits;     ///< Fonts that reused an existing font set
+	unsigned long misses;   ///< Font sets we had to create
+	unsigned long failed;   ///< ... of which the server couldn't give us
+	unsigned int entries;   ///< Font sets currently held
+	double total_ms;        ///< Total time spent getting font sets
+} FontCacheStats;
+
+/// Font names starting with this are Xft fonts
+#define FONT_XFT_PREFIX "xft:"
+
+static inline bool
+FontIsXft(const char *name)
+{
+	return strncmp(name, FONT_XFT_PREFIX, sizeof(FONT_XFT_PREFIX) - 1) == 0;
+}
+
+bool FontCacheGet(MyFont *font, const char *fontlist);
+void FontCacheRelease(MyFont *font);
+const FontCacheStats *FontCacheGetStats(void);
+
+
+#endif /* _CTWM_FONT_CACHE_H */
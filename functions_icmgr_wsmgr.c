@@ -114,6 +114,7 @@ DFHANDLER(showiconmgr)
 			i->twm_win->mapped = true;
 			i->twm_win->isicon = false;
 		}
+		InvalidateWindowListMenus();
 	}
 }
 
@@ -158,6 +159,7 @@ HideIconManager(void)
 			i->twm_win->mapped = false;
 			i->twm_win->isicon = true;
 		}
+		InvalidateWindowListMenus();
 	}
 }
 
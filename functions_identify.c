@@ -206,8 +206,8 @@ info_dismiss:
 	height = n * (Scr->DefaultFont.height + 2);
 	width = 1;
 	for(i = 0; i < n; i++) {
-		XmbTextExtents(Scr->DefaultFont.font_set, Info[i],
-		               strlen(Info[i]), &inc_rect, &logical_rect);
+		FontTextExtents(&Scr->DefaultFont, Info[i],
+		                strlen(Info[i]), &inc_rect, &logical_rect);
 
 		twidth = logical_rect.width;
 		if(twidth > width) {
@@ -281,9 +281,9 @@ draw_info_window(void)
 	FB(Scr->DefaultC.fore, Scr->DefaultC.back);
 
 	for(i = 0; i < Scr->InfoWindow.lines ; i++) {
-		XmbDrawString(dpy, Scr->InfoWindow.win, Scr->DefaultFont.font_set,
-		              Scr->NormalGC, 5,
-		              (i * height) + Scr->DefaultFont.y + 5,
-		              Info[i], strlen(Info[i]));
+		FontDrawString(Scr->InfoWindow.win, &Scr->DefaultFont,
+		               Scr->NormalGC, 5,
+		               (i * height) + Scr->DefaultFont.y + 5,
+		               Info[i], strlen(Info[i]));
 	}
 }
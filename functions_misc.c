@@ -9,6 +9,7 @@
 #include "ctwm.h"
 
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "animate.h"
 #include "ctwm_shutdown.h"
@@ -16,6 +17,7 @@
 #include "functions_defs.h"
 #include "functions_internal.h"
 #include "icons.h"
+#include "launcher.h"
 #include "otp.h"
 #include "screen.h"
 #ifdef SOUNDS
@@ -342,7 +344,6 @@ DFHANDLER(exec)
 	PopDownMenu();
 	if(!Scr->NoGrabServer) {
 		XUngrabServer(dpy);
-		XSync(dpy, 0);
 	}
 	XUngrabPointer(dpy, CurrentTime);
 	XSync(dpy, 0);
@@ -350,29 +351,34 @@ DFHANDLER(exec)
 }
 
 
-static void
-Execute(const char *_s)
+/*
+ * Per-screen bits of Execute()'s setup that don't change once we're
+ * running, so we only figure them once.
+ */
+typedef struct ExecScreenInfo {
+	bool  inited;
+	char *display_env;  ///< "DISPLAY=..." for this screen, or NULL
+	char *redirect;     ///< Replacement for $redirect
+} ExecScreenInfo;
+
+static ExecScreenInfo *exec_screens;
+
+static ExecScreenInfo *
+ExecGetScreenInfo(void)
 {
-	char *s;
-	char *_ds;
-	char *orig_display;
-	int restorevar = 0;
-	char *subs;
+	ExecScreenInfo *esi;
 
-	/* Seatbelt */
-	if(!_s) {
-		return;
+	if(exec_screens == NULL) {
+		exec_screens = calloc(NumScreens, sizeof(ExecScreenInfo));
+		if(exec_screens == NULL) {
+			return NULL;
+		}
 	}
-
-	/* Work on a local copy since we're mutating it */
-	s = strdup(_s);
-	if(!s) {
-		return;
+	esi = &exec_screens[Scr->screen];
+	if(esi->inited) {
+		return esi;
 	}
 
-	/* Stash up current $DISPLAY value for resetting */
-	orig_display = getenv("DISPLAY");
-
 
 	/*
 	 * Build a display string using the current screen number, so that
@@ -386,49 +392,99 @@ Execute(const char *_s)
 	 * We strdup() because DisplayString() is a macro returning into the
 	 * dpy structure, and we're going to mutate the value we get from it.
 	 */
-	_ds = DisplayString(dpy);
-	if(_ds) {
-		char *ds;
-		char *colon;
-
-		ds = strdup(_ds);
-		if(!ds) {
-			goto end_execute;
-		}
+	{
+		char *_ds = DisplayString(dpy);
+		char *ds = _ds ? strdup(_ds) : NULL;
 
 		/* If it's not host:dpy, we don't have anything to do here */
-		colon = strrchr(ds, ':');
+		char *colon = ds ? strrchr(ds, ':') : NULL;
 		if(colon) {
-			char *dot, *new_display;
-
 			/* Find the . in display.screen and chop it off */
-			dot = strchr(colon, '.');
+			char *dot = strchr(colon, '.');
 			if(dot) {
 				*dot = '\0';
 			}
 
 			/* Build a new string with our correct screen info */
-			asprintf(&new_display, "%s.%d", ds, Scr->screen);
-			if(!new_display) {
-				free(ds);
-				goto end_execute;
-			}
-
-			/* And set */
-			setenv("DISPLAY", new_display, 1);
-			free(new_display);
-			restorevar = 1;
+			asprintf(&esi->display_env, "DISPLAY=%s.%d", ds, Scr->screen);
 		}
 		free(ds);
 	}
 
 
+	/* $redirect is only meaningful for captive ctwms */
+	if(CLarg.is_captive) {
+		asprintf(&esi->redirect, "-xrm 'ctwm.redirect:%s'", Scr->captivename);
+	}
+	else {
+		esi->redirect = strdup("");
+	}
+
+	esi->inited = true;
+	return esi;
+}
+
+
+/*
+ * Our environment, with $DISPLAY swapped for the one for the current
+ * screen.  Only the pointer array is allocated; free() it when done.
+ */
+static char **
+ExecEnvironment(char *display_env)
+{
+	char **env;
+	int n, i, j;
+
+	for(n = 0; environ[n] != NULL; n++) {
+		/* count */;
+	}
+	env = malloc((n + 2) * sizeof(char *));
+	if(env == NULL) {
+		return NULL;
+	}
+
+	for(i = j = 0; i < n; i++) {
+		if(strncmp(environ[i], "DISPLAY=", 8) == 0) {
+			continue;
+		}
+		env[j++] = environ[i];
+	}
+	env[j++] = display_env;
+	env[j] = NULL;
+
+	return env;
+}
+
+
+static void
+Execute(const char *_s)
+{
+	char *s;
+	char **env = NULL;
+	ExecScreenInfo *esi;
+
+	/* Seatbelt */
+	if(!_s) {
+		return;
+	}
+
+	/* Work on a local copy since we're mutating it */
+	s = strdup(_s);
+	if(!s) {
+		return;
+	}
+
+	esi = ExecGetScreenInfo();
+	if(esi == NULL) {
+		goto end_execute;
+	}
+
+
 	/*
 	 * We replace a couple placeholders in the string.  $currentworkspace
 	 * is documented in the manual; $redirect is not.
 	 */
-	subs = strstr(s, "$currentworkspace");
-	if(subs) {
+	if(strstr(s, "$currentworkspace")) {
 		char *tmp;
 		char *wsname;
 
@@ -445,54 +501,30 @@ Execute(const char *_s)
 		s = tmp;
 	}
 
-	subs = strstr(s, "$redirect");
-	if(subs) {
+	if(esi->redirect && strstr(s, "$redirect")) {
 		char *tmp;
-		char *redir;
 
-		if(CLarg.is_captive) {
-			asprintf(&redir, "-xrm 'ctwm.redirect:%s'", Scr->captivename);
-			if(!redir) {
-				goto end_execute;
-			}
-		}
-		else {
-			redir = malloc(1);
-			*redir = '\0';
+		tmp = replace_substr(s, "$redirect", esi->redirect);
+		if(!tmp) {
+			goto end_execute;
 		}
-
-		tmp = replace_substr(s, "$redirect", redir);
 		free(s);
 		s = tmp;
-
-		free(redir);
 	}
 
 
 	/*
-	 * Call it.  Return value doesn't really matter, since whatever
-	 * happened we're done.  Maybe someday if we develop a "show user
+	 * Start it up.  The child gets its $DISPLAY via its own environment,
+	 * so ours is left alone.  We don't wait for it; the launcher reaps
+	 * it when it exits.  Maybe someday if we develop a "show user
 	 * message" generalized func, we can tell the user if executing
 	 * failed somehow.
 	 */
-	system(s);
-
-
-	/*
-	 * Restore $DISPLAY if we changed it.  It's probably only necessary
-	 * in edge cases (it might be used by ctwm restarting itself, for
-	 * instance) and it's not quite clear whether the DisplayString()
-	 * result would even be wrong for that, but what the heck, setenv()
-	 * is cheap.
-	 */
-	if(restorevar) {
-		if(orig_display) {
-			setenv("DISPLAY", orig_display, 1);
-		}
-		else {
-			unsetenv("DISPLAY");
-		}
+	if(esi->display_env) {
+		env = ExecEnvironment(esi->display_env);
 	}
+	LauncherRun(s, env, Scr->DirectExec);
+	free(env);
 
 
 	/* Clean up */
@@ -95,6 +95,7 @@ int yylex(void);
 %token <num> MONITOR_LAYOUT
 %token <num> RPLAY_SOUNDS
 %token <num> FORCE_FOCUS
+%token <num> AUTO_RAISE_DELAY AUTO_LOWER_DELAY
 %token <ptr> STRING
 
 %type <ptr> string
@@ -343,6 +344,10 @@ stmt		: error
 		| AUTO_LOWER		{ curplist = &Scr->AutoLower; }
 		  win_list
 		| AUTO_LOWER		{ Scr->AutoLowerDefault = true; }
+		| AUTO_RAISE_DELAY	{ curplist = &Scr->AutoRaiseDelay; }
+		  delay_list
+		| AUTO_LOWER_DELAY	{ curplist = &Scr->AutoLowerDelay; }
+		  delay_list
 		| MENU string LP string COLON string RP	{
 					root = GetRoot($2, $4, $6); }
 		  menu			{ root->real_menu = true;}
@@ -760,6 +765,17 @@ wingeom_entries	: /* Empty */
 wingeom_entry	: string string	{ AddToList (&Scr->WindowGeometries, $1, $2); }
 		;
 
+delay_list	: LB delay_entries RB {}
+		;
+
+delay_entries	: /* Empty */
+		| delay_entries string number	{
+				if (Scr->FirstTime) {
+				   do_delay_entry (curplist, $2, $3);
+				}
+			}
+		;
+
 vscreen_geom_list	: LB vscreen_geom_entries RB {}
 		;
 
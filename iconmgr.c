@@ -218,6 +218,7 @@ void CreateIconManagers(void)
 			else {
 				p->twm_win->isicon = true;
 			}
+			InvalidateWindowListMenus();
 		}
 		if(ws != NULL) {
 			ws = ws->next;
@@ -1249,7 +1250,7 @@ DrawIconManagerIconName(TwmWindow *tmp_win)
 	WList *iconmanagerlist = tmp_win->iconmanagerlist;
 	XRectangle ink_rect, logical_rect;
 
-	XmbTextExtents(Scr->IconManagerFont.font_set,
+	FontTextExtents(&Scr->IconManagerFont,
 	               tmp_win->icon_name, strlen(tmp_win->icon_name),
 	               &ink_rect, &logical_rect);
 
@@ -1262,10 +1263,9 @@ DrawIconManagerIconName(TwmWindow *tmp_win)
 
 	/* XXX This is a completely absurd way of writing this */
 	((Scr->use3Diconmanagers && (Scr->Monochrome != COLOR)) ?
-	 XmbDrawImageString : XmbDrawString)
-	(dpy,
-	 iconmanagerlist->w,
-	 Scr->IconManagerFont.font_set,
+	 FontDrawImageString : FontDrawString)
+	(iconmanagerlist->w,
+	 &Scr->IconManagerFont,
 	 Scr->NormalGC,
 	 iconmgr_textx,
 	 (Scr->IconManagerFont.avg_height - logical_rect.height) / 2
@@ -1276,7 +1276,7 @@ DrawIconManagerIconName(TwmWindow *tmp_win)
 	 strlen(tmp_win->icon_name));
 
 	// Draw the border around it.  Our "border" isn't an X border, it's
-	// just our own drawing inside the X window.  Since XmbDrawString()
+	// just our own drawing inside the X window.  Since FontDrawString()
 	// believes it has all the space in the window to fill, it might
 	// scribble into the space where we're drawing the border, so draw
 	// the border after the text to cover it up.
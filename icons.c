@@ -43,10 +43,16 @@
 
 static void splitIconRegionEntry(IconEntry *ie, RegGravity grav1,
                                  RegGravity grav2, int w, int h);
+static int sizeBucket(int v);
+static void freeIndexAdd(IconRegion *ir, IconEntry *ie);
+static void freeIndexRemove(IconRegion *ir, IconEntry *ie);
+static void freeListInsertAfter(IconRegion *ir, IconEntry *after,
+                                IconEntry *ie);
+static void freeListUnlink(IconRegion *ir, IconEntry *ie);
+static IconEntry *findFreeEntry(IconRegion *ir, int w, int h);
+static IconRegion *findClaimingRegion(TwmWindow *tmp_win, IconRegion *start);
 static void PlaceIcon(TwmWindow *tmp_win, int def_x, int def_y,
                       int *final_x, int *final_y);
-static IconEntry *FindIconEntry(TwmWindow *tmp_win, IconRegion **irp);
-static IconEntry *prevIconEntry(IconEntry *ie, IconRegion *ir);
 static void mergeEntries(IconEntry *old, IconEntry *ie);
 static void ReshapeIcon(Icon *icon);
 static int roundUp(int v, int multiple);
@@ -88,7 +94,12 @@ splitIconRegionEntry(IconEntry *ie, RegGravity grav1, RegGravity grav2,
 			if(h != ie->h) {
 				IconEntry *new = calloc(1, sizeof(IconEntry));
 				new->next = ie->next;
+				new->prev = ie;
+				if(ie->next) {
+					ie->next->prev = new;
+				}
 				ie->next = new;
+				new->ir = ie->ir;
 				new->x = ie->x;
 				new->h = (ie->h - h);
 				new->w = ie->w;
@@ -110,7 +121,12 @@ splitIconRegionEntry(IconEntry *ie, RegGravity grav1, RegGravity grav2,
 			if(w != ie->w) {
 				IconEntry *new = calloc(1, sizeof(IconEntry));
 				new->next = ie->next;
+				new->prev = ie;
+				if(ie->next) {
+					ie->next->prev = new;
+				}
 				ie->next = new;
+				new->ir = ie->ir;
 				new->y = ie->y;
 				new->w = (ie->w - w);
 				new->h = ie->h;
@@ -128,6 +144,205 @@ splitIconRegionEntry(IconEntry *ie, RegGravity grav1, RegGravity grav2,
 }
 
 
+/*
+ * The free-slot index.  Unused IconEntry's are chained on the region's
+ * freelist in entry order, so first-fit picks the same slot as walking
+ * the whole entries list would, without stepping over every placed
+ * icon.  On top of that, the free entries are counted by power-of-2
+ * size class, so a region with nothing big enough can be skipped
+ * without looking at any of them.
+ */
+static int
+sizeBucket(int v)
+{
+	int b = 0;
+
+	while(v > 1 && b < IR_SIZE_BUCKETS - 1) {
+		v >>= 1;
+		b++;
+	}
+	return b;
+}
+
+static void
+freeIndexAdd(IconRegion *ir, IconEntry *ie)
+{
+	const int bw = sizeBucket(ie->w), bh = sizeBucket(ie->h);
+
+	ir->freecount[bw][bh]++;
+	ir->freemask[bw] |= 1u << bh;
+}
+
+static void
+freeIndexRemove(IconRegion *ir, IconEntry *ie)
+{
+	const int bw = sizeBucket(ie->w), bh = sizeBucket(ie->h);
+
+	if(--ir->freecount[bw][bh] == 0) {
+		ir->freemask[bw] &= ~(1u << bh);
+	}
+}
+
+
+/*
+ * Put an entry on the freelist after another (or at the head, if after
+ * is NULL).
+ */
+static void
+freeListInsertAfter(IconRegion *ir, IconEntry *after, IconEntry *ie)
+{
+	ie->fprev = after;
+	if(after) {
+		ie->fnext = after->fnext;
+		after->fnext = ie;
+	}
+	else {
+		ie->fnext = ir->freelist;
+		ir->freelist = ie;
+	}
+	if(ie->fnext) {
+		ie->fnext->fprev = ie;
+	}
+	freeIndexAdd(ir, ie);
+}
+
+static void
+freeListUnlink(IconRegion *ir, IconEntry *ie)
+{
+	if(ie->fprev) {
+		ie->fprev->fnext = ie->fnext;
+	}
+	else {
+		ir->freelist = ie->fnext;
+	}
+	if(ie->fnext) {
+		ie->fnext->fprev = ie->fprev;
+	}
+	ie->fnext = ie->fprev = NULL;
+	freeIndexRemove(ir, ie);
+}
+
+
+/*
+ * Find the first unused entry in a region at least w x h.
+ */
+static IconEntry *
+findFreeEntry(IconRegion *ir, int w, int h)
+{
+	const int bw = sizeBucket(w), bh = sizeBucket(h);
+	IconEntry *ie;
+	int i;
+
+	// Anything fitting has to be in a size class at least as big
+	for(i = bw; i < IR_SIZE_BUCKETS; i++) {
+		if(ir->freemask[i] >> bh) {
+			break;
+		}
+	}
+	if(i == IR_SIZE_BUCKETS) {
+		return NULL;
+	}
+
+	for(ie = ir->freelist; ie; ie = ie->fnext) {
+		if(ie->w >= w && ie->h >= h) {
+			return ie;
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ * Claim a w x h slot in an IconRegion, splitting up the first free
+ * entry that's big enough.  Returns the entry (now marked used), or
+ * NULL if there's no room.
+ */
+IconEntry *
+IconRegionTakeEntry(IconRegion *ir, int w, int h)
+{
+	IconEntry *ie, *fprev, *next, *p;
+
+	ie = findFreeEntry(ir, w, h);
+	if(ie == NULL) {
+		return NULL;
+	}
+
+	// The leftover bits splitIconRegionEntry() makes wind up between ie
+	// and its old next, and take its place on the freelist.
+	fprev = ie->fprev;
+	next = ie->next;
+	freeListUnlink(ir, ie);
+
+	/* XXX whatever sIRE() does */
+	splitIconRegionEntry(ie, ir->grav1, ir->grav2, w, h);
+	ie->used = true;
+
+	for(p = ie->next; p != next; p = p->next) {
+		freeListInsertAfter(ir, fprev, p);
+		fprev = p;
+	}
+
+	return ie;
+}
+
+
+/*
+ * Give back a slot in an IconRegion, merging it with any free
+ * neighbors.
+ */
+void
+IconRegionReleaseEntry(IconEntry *ie)
+{
+	IconRegion *ir = ie->ir;
+	IconEntry *ip, *in;
+
+	ie->twm_win = NULL;
+	ie->used = false;
+
+	// Back onto the freelist, in entry order
+	for(ip = ie->prev; ip && ip->used; ip = ip->prev)
+		;
+	freeListInsertAfter(ir, ip, ie);
+
+	ip = ie->prev;
+	in = ie->next;
+	for(;;) {
+		if(ip && ip->used == false &&
+		                ((ip->x == ie->x && ip->w == ie->w) ||
+		                 (ip->y == ie->y && ip->h == ie->h))) {
+			ip->next = ie->next;
+			if(ie->next) {
+				ie->next->prev = ip;
+			}
+			freeListUnlink(ir, ie);
+			freeIndexRemove(ir, ip);
+			mergeEntries(ie, ip);
+			freeIndexAdd(ir, ip);
+			free(ie);
+			ie = ip;
+			ip = ip->prev;
+		}
+		else if(in && in->used == false &&
+		                ((in->x == ie->x && in->w == ie->w) ||
+		                 (in->y == ie->y && in->h == ie->h))) {
+			ie->next = in->next;
+			if(in->next) {
+				in->next->prev = ie;
+			}
+			freeListUnlink(ir, in);
+			freeIndexRemove(ir, ie);
+			mergeEntries(in, ie);
+			freeIndexAdd(ir, ie);
+			free(in);
+			in = ie->next;
+		}
+		else {
+			break;
+		}
+	}
+}
+
+
 /*
  * Backend for parsing IconRegion config
  */
@@ -139,7 +354,7 @@ AddIconRegion(const char *geom, RegGravity grav1, RegGravity grav2,
 	IconRegion *ir;
 	int mask, tmp;
 
-	ir = malloc(sizeof(IconRegion));
+	ir = calloc(1, sizeof(IconRegion));
 	ir->next = NULL;
 
 	if(Scr->LastRegion) {
@@ -175,10 +390,12 @@ AddIconRegion(const char *geom, RegGravity grav1, RegGravity grav2,
 	}
 
 	ir->entries = calloc(1, sizeof(IconEntry));
+	ir->entries->ir = ir;
 	ir->entries->x = ir->x;
 	ir->entries->y = ir->y;
 	ir->entries->w = ir->w;
 	ir->entries->h = ir->h;
+	freeListInsertAfter(ir, NULL, ir->entries);
 
 	if((tmp = ParseTitleJustification(ijust)) < 0) {
 		twmrc_error_prefix();
@@ -226,36 +443,35 @@ PlaceIcon(TwmWindow *tmp_win, int def_x, int def_y,
 	const int iconHeight = tmp_win->icon->border_width * 2
 	                       + tmp_win->icon->w_height;
 
+	/*
+	 * If we're somehow already sitting in a slot, give it up first.
+	 */
+	if(tmp_win->iconEntry) {
+		IconRegionReleaseEntry(tmp_win->iconEntry);
+		tmp_win->iconEntry = NULL;
+	}
+
 	/*
 	 * First, check to see if the window is in a region's client list
 	 * (i.e., the win-list on an IconRegion specifier in the config).
+	 * Which one claims it is looked up once and remembered; only if
+	 * it's full do we go looking for further regions that claim it.
 	 */
 	ie = NULL;
-	for(ir = Scr->FirstRegion; ir; ir = ir->next) {
-		if(LookInList(ir->clientlist, tmp_win->name, &tmp_win->class)) {
-			/*
-			 * Found one that claims it.  Figure the necessary local
-			 * size, based on the icon's side itself and the grid for
-			 * this IR.
-			 */
-			w = roundUp(iconWidth, ir->stepx);
-			h = roundUp(iconHeight, ir->stepy);
-
-			/* Find a currently-unused region that's big enough */
-			for(ie = ir->entries; ie; ie = ie->next) {
-				if(ie->used) {
-					continue;
-				}
-				if(ie->w >= w && ie->h >= h) {
-					/* Bingo */
-					break;
-				}
-			}
-
-			/* If we found one, we're done here */
-			if(ie) {
-				break;
-			}
+	if(!tmp_win->iconRegionKnown) {
+		tmp_win->iconRegion = findClaimingRegion(tmp_win, Scr->FirstRegion);
+		tmp_win->iconRegionKnown = true;
+	}
+	for(ir = tmp_win->iconRegion; ir; ir = findClaimingRegion(tmp_win, ir->next)) {
+		/*
+		 * Figure the necessary local size, based on the icon's side
+		 * itself and the grid for this IR, and find a currently-unused
+		 * region that's big enough.
+		 */
+		w = roundUp(iconWidth, ir->stepx);
+		h = roundUp(iconHeight, ir->stepy);
+		if((ie = IconRegionTakeEntry(ir, w, h)) != NULL) {
+			break;
 		}
 	}
 
@@ -268,16 +484,7 @@ PlaceIcon(TwmWindow *tmp_win, int def_x, int def_y,
 		for(ir = Scr->FirstRegion; ir; ir = ir->next) {
 			w = roundUp(iconWidth, ir->stepx);
 			h = roundUp(iconHeight, ir->stepy);
-			for(ie = ir->entries; ie; ie = ie->next) {
-				if(ie->used) {
-					continue;
-				}
-				if(ie->w >= w && ie->h >= h) {
-					/* Bingo */
-					break;
-				}
-			}
-			if(ie) {
+			if((ie = IconRegionTakeEntry(ir, w, h)) != NULL) {
 				break;
 			}
 		}
@@ -292,9 +499,6 @@ PlaceIcon(TwmWindow *tmp_win, int def_x, int def_y,
 	 * basis.
 	 */
 	if(ie) {
-		/* XXX whatever sIRE() does */
-		splitIconRegionEntry(ie, ir->grav1, ir->grav2, w, h);
-
 		/* Adjust horizontal positioning based on IconRegionJustification */
 		switch(ir->Justification) {
 			case IRJ_LEFT:
@@ -341,7 +545,7 @@ PlaceIcon(TwmWindow *tmp_win, int def_x, int def_y,
 
 		/* Tell the win/icon what region it's in, and the entry what's in it */
 		tmp_win->icon->ir = ir;
-		ie->used = true;
+		tmp_win->iconEntry = ie;
 		ie->twm_win = tmp_win;
 	}
 	else {
@@ -366,46 +570,23 @@ PlaceIcon(TwmWindow *tmp_win, int def_x, int def_y,
 
 
 /*
- * Look up an IconEntry holding the icon for a given window, and
- * optionally stash its IconRegion in irp.  Used internally in
- * IconDown().
+ * Find the first IconRegion from start on whose client list matches a
+ * window.
  */
-static IconEntry *
-FindIconEntry(TwmWindow *tmp_win, IconRegion **irp)
+static IconRegion *
+findClaimingRegion(TwmWindow *tmp_win, IconRegion *start)
 {
-	IconRegion  *ir;
-	IconEntry   *ie;
+	IconRegion *ir;
 
-	for(ir = Scr->FirstRegion; ir; ir = ir->next) {
-		for(ie = ir->entries; ie; ie = ie->next)
-			if(ie->twm_win == tmp_win) {
-				if(irp) {
-					*irp = ir;
-				}
-				return ie;
-			}
+	for(ir = start; ir; ir = ir->next) {
+		if(LookInList(ir->clientlist, tmp_win->name, &tmp_win->class)) {
+			return ir;
+		}
 	}
 	return NULL;
 }
 
 
-/*
- * Find prior IE in list.  Used internally in IconDown().
- */
-static IconEntry *
-prevIconEntry(IconEntry *ie, IconRegion *ir)
-{
-	IconEntry   *ip;
-
-	if(ie == ir->entries) {
-		return NULL;
-	}
-	for(ip = ir->entries; ip->next != ie; ip = ip->next)
-		;
-	return ip;
-}
-
-
 /*
  * Merge two adjacent IconEntry's.  old is being freed; and is adjacent
  * to ie.  Merge regions together.
@@ -593,9 +774,9 @@ CreateIconWindow(TwmWindow *tmp_win, int def_x, int def_y)
 		XRectangle inc_rect;
 		XRectangle logical_rect;
 
-		XmbTextExtents(Scr->IconFont.font_set,
-		               tmp_win->icon_name, strlen(tmp_win->icon_name),
-		               &inc_rect, &logical_rect);
+		FontTextExtents(&Scr->IconFont,
+		                tmp_win->icon_name, strlen(tmp_win->icon_name),
+		                &inc_rect, &logical_rect);
 		icon->w_width = logical_rect.width;
 
 		icon->w_width += 2 * (Scr->IconManagerShadowDepth + ICON_MGR_IBORDER);
@@ -769,7 +950,7 @@ CreateIconWindow(TwmWindow *tmp_win, int def_x, int def_y)
 	XSaveContext(dpy, icon->w, TwmContext, (XPointer)tmp_win);
 	XSaveContext(dpy, icon->w, ScreenContext, (XPointer)Scr);
 	XDefineCursor(dpy, icon->w, Scr->IconCursor);
-	MaybeAnimate = true;
+	AnimationAddWindow(tmp_win);
 }
 
 
@@ -830,10 +1011,15 @@ DeleteIcon(Icon *icon)
 void
 ReleaseIconImage(Icon *icon)
 {
-	if(icon->match == match_icon_pixmap_hint ||
-	                icon->match == match_net_wm_icon) {
+	if(icon->match == match_icon_pixmap_hint) {
 		FreeImage(icon->image);
 	}
+#ifdef EWMH
+	else if(icon->match == match_net_wm_icon) {
+		/* Possibly shared with other windows via the icon cache */
+		EwmhReleaseIcon(icon->image);
+	}
+#endif
 }
 
 
@@ -902,7 +1088,7 @@ IconUp(TwmWindow *tmp_win)
 		tmp_win->icon->w_y = y;
 		tmp_win->icon_moved = false;    /* since we've restored it */
 	}
-	MaybeAnimate = true;
+	AnimationAddWindow(tmp_win);
 	return;
 }
 
@@ -914,37 +1100,9 @@ IconUp(TwmWindow *tmp_win)
 void
 IconDown(TwmWindow *tmp_win)
 {
-	IconEntry   *ie, *ip, *in;
-	IconRegion  *ir;
-
-	ie = FindIconEntry(tmp_win, &ir);
-	if(ie) {
-		ie->twm_win = NULL;
-		ie->used = false;
-		ip = prevIconEntry(ie, ir);
-		in = ie->next;
-		for(;;) {
-			if(ip && ip->used == false &&
-			                ((ip->x == ie->x && ip->w == ie->w) ||
-			                 (ip->y == ie->y && ip->h == ie->h))) {
-				ip->next = ie->next;
-				mergeEntries(ie, ip);
-				free(ie);
-				ie = ip;
-				ip = prevIconEntry(ip, ir);
-			}
-			else if(in && in->used == false &&
-			                ((in->x == ie->x && in->w == ie->w) ||
-			                 (in->y == ie->y && in->h == ie->h))) {
-				ie->next = in->next;
-				mergeEntries(in, ie);
-				free(in);
-				in = ie->next;
-			}
-			else {
-				break;
-			}
-		}
+	if(tmp_win->iconEntry) {
+		IconRegionReleaseEntry(tmp_win->iconEntry);
+		tmp_win->iconEntry = NULL;
 	}
 }
 
@@ -986,9 +1144,9 @@ PaintIcon(TwmWindow *tmp_win)
 		width = icon->width;
 	}
 	len    = strlen(tmp_win->icon_name);
-	XmbTextExtents(Scr->IconFont.font_set,
-	               tmp_win->icon_name, len,
-	               &ink_rect, &logical_rect);
+	FontTextExtents(&Scr->IconFont,
+	                tmp_win->icon_name, len,
+	                &ink_rect, &logical_rect);
 	twidth = logical_rect.width;
 	mwidth = width - 2 * (Scr->IconManagerShadowDepth + ICON_MGR_IBORDER);
 	if(Scr->use3Diconmanagers) {
@@ -999,16 +1157,16 @@ PaintIcon(TwmWindow *tmp_win)
 	}
 	while((len > 0) && (twidth > mwidth)) {
 		len--;
-		XmbTextExtents(Scr->IconFont.font_set,
-		               tmp_win->icon_name, len,
-		               &ink_rect, &logical_rect);
+		FontTextExtents(&Scr->IconFont,
+		                tmp_win->icon_name, len,
+		                &ink_rect, &logical_rect);
 		twidth = logical_rect.width;
 	}
 	FB(icon->iconc.fore, icon->iconc.back);
-	XmbDrawString(dpy, icon->w, Scr->IconFont.font_set, Scr->NormalGC,
-	              x + ((mwidth - twidth) / 2) +
-	              Scr->IconManagerShadowDepth + ICON_MGR_IBORDER,
-	              icon->y, tmp_win->icon_name, len);
+	FontDrawString(icon->w, &Scr->IconFont, Scr->NormalGC,
+	               x + ((mwidth - twidth) / 2) +
+	               Scr->IconManagerShadowDepth + ICON_MGR_IBORDER,
+	               icon->y, tmp_win->icon_name, len);
 }
 
 
@@ -1272,9 +1430,9 @@ RedoIconName(TwmWindow *win)
 		return;
 	}
 
-	XmbTextExtents(Scr->IconFont.font_set,
-	               win->icon_name, strlen(win->icon_name),
-	               &ink_rect, &logical_rect);
+	FontTextExtents(&Scr->IconFont,
+	                win->icon_name, strlen(win->icon_name),
+	                &ink_rect, &logical_rect);
 	win->icon->w_width = logical_rect.width;
 	win->icon->w_width += 2 * (Scr->IconManagerShadowDepth + ICON_MGR_IBORDER);
 	if(win->icon->w_width > Scr->MaxIconTitleWidth) {
@@ -45,6 +45,9 @@ struct Icon {
 	bool        w_not_ours;     /* Icon.w comes from IconWindowHint */
 };
 
+/* Number of power-of-2 size classes in the IconRegion free-slot index */
+#define IR_SIZE_BUCKETS 16
+
 struct IconRegion {
 	struct IconRegion   *next;
 	int                 x, y, w, h;
@@ -55,10 +58,23 @@ struct IconRegion {
 	IRAlignement        Alignement;
 	name_list           *clientlist;
 	struct IconEntry    *entries;
+
+	/*
+	 * Index of the unused entries.  freelist chains them in the same
+	 * order they appear in entries.  freecount[i][j] counts those that
+	 * are roughly 2^i wide by 2^j tall, and freemask[i] has bit j set
+	 * when that count is nonzero, so we can tell at a glance when
+	 * nothing in the region is big enough.
+	 */
+	struct IconEntry    *freelist;
+	unsigned int        freecount[IR_SIZE_BUCKETS][IR_SIZE_BUCKETS];
+	unsigned int        freemask[IR_SIZE_BUCKETS];
 };
 
 struct IconEntry {
-	struct IconEntry    *next;
+	struct IconEntry    *next, *prev;
+	struct IconEntry    *fnext, *fprev;     /* freelist, when !used */
+	struct IconRegion   *ir;                /* region we're carved from */
 	int                 x, y, w, h;
 	TwmWindow           *twm_win;
 	bool                used;
@@ -69,6 +85,8 @@ struct IconEntry {
 name_list **AddIconRegion(const char *geom, RegGravity grav1, RegGravity grav2,
                           int stepx, int stepy, const char *ijust,
                           const char *just, const char *align);
+IconEntry *IconRegionTakeEntry(IconRegion *ir, int w, int h);
+void IconRegionReleaseEntry(IconEntry *ie);
 
 /* Icon [window] creation/destruction */
 void CreateIconWindow(TwmWindow *tmp_win, int def_x, int def_y);
@@ -151,6 +151,33 @@ GetImage(const char *name, ColorPair cp)
 }
 
 
+/*
+ * Load an image shrunk down to how it would look on a boxw x boxh
+ * stand-in for the root window, like a workspace map.  Only JPEGs can be
+ * decoded straight to a smaller size; for anything else (or if it
+ * wouldn't be any smaller), this returns NULL, and the full-size
+ * GetImage() one will have to do.  These aren't cached; the caller
+ * FreeImage()'s it when done.
+ */
+Image *
+GetImageScaled(const char *name, ColorPair cp, int boxw, int boxh)
+{
+	if(name == NULL || dpy == NULL) {
+		return NULL;
+	}
+	if(boxw <= 0 || boxh <= 0 || (boxw >= Scr->rootw && boxh >= Scr->rooth)) {
+		return NULL;
+	}
+
+#ifdef JPEG
+	if(strncmp(name, "jpeg:", 5) == 0) {
+		return GetJpegImageScaled(&name [5], boxw, boxh);
+	}
+#endif
+	return NULL;
+}
+
+
 /*
  * Creation/cleanup of Image structs
  */
@@ -16,6 +16,7 @@ struct Image {
 
 
 Image *GetImage(const char *name, ColorPair cp);
+Image *GetImageScaled(const char *name, ColorPair cp, int boxw, int boxh);
 Image *AllocImage(void);
 void FreeImage(Image *image);
 
@@ -12,6 +12,8 @@
 #include "screen.h"
 #include "image.h"
 #include "image_jpeg.h"
+#include "image_upload.h"
+#include "util.h"
 
 /* Bits needed for libjpeg and interaction */
 #include <setjmp.h>
@@ -24,6 +26,7 @@
 /* Various internal bits */
 static Image *LoadJpegImage(const char *name);
 static Image *LoadJpegImageCp(const char *name, ColorPair cp);
+static Image *LoadJpegImageSized(const char *name, int boxw, int boxh);
 static void convert_for_16(int w, int x, int y, int r, int g, int b);
 static void convert_for_32(int w, int x, int y, int r, int g, int b);
 static void jpeg_error_exit(j_common_ptr cinfo);
@@ -38,6 +41,9 @@ typedef struct jpeg_error *jerr_ptr;
 static uint16_t *buffer_16bpp;
 static uint32_t *buffer_32bpp;
 
+/* How many scanlines to ask libjpeg for at a time */
+#define JPEG_BATCH_ROWS 16
+
 
 /*
  * External entry point
@@ -57,6 +63,20 @@ GetJpegImage(const char *name)
 }
 
 
+/*
+ * Shrunk to how it would look on a boxw x boxh stand-in for the root.
+ * Not for animations.
+ */
+Image *
+GetJpegImageScaled(const char *name, int boxw, int boxh)
+{
+	if(strchr(name, '%')) {
+		return NULL;
+	}
+	return LoadJpegImageSized(name, boxw, boxh);
+}
+
+
 /*
  * Internal backend func
  */
@@ -68,12 +88,25 @@ LoadJpegImageCp(const char *name, ColorPair cp)
 	return LoadJpegImage(name);
 }
 
-/* The actual loader */
+/* Full size, for the root */
 static Image *
 LoadJpegImage(const char *name)
+{
+	return LoadJpegImageSized(name, Scr->rootw, Scr->rooth);
+}
+
+/*
+ * The actual loader.  The result is laid out the way it would be for
+ * the root (centered on a root-sized pixmap if it's big, left alone to
+ * be tiled if not), but for a boxw x boxh stand-in for the root; i.e.,
+ * shrunk by boxw/rootw and boxh/rooth.  For the root itself, that's no
+ * shrinking at all.
+ */
+static Image *
+LoadJpegImageSized(const char *name, int boxw, int boxh)
 {
 	char   *fullname;
-	XImage *ximage;
+	XImage *volatile ximage = NULL;
 	FILE   *infile;
 	Image  *image;
 	Pixmap pixret;
@@ -82,9 +115,12 @@ LoadJpegImage(const char *name)
 	struct jpeg_error jerr;
 	JSAMPARRAY buffer;
 	int width, height;
+	int stride;
 	int row_stride;
-	int g, i, a;
-	int bpix;
+	int denom;
+	int *xmap;
+	int x, dy;
+	int bpix, c1, c2;
 	GC  gc;
 
 	fullname = ExpandPixmapPath(name);
@@ -113,6 +149,7 @@ LoadJpegImage(const char *name)
 
 	if(sigsetjmp(jerr.setjmp_buffer, 1)) {
 		jpeg_destroy_decompress(&cinfo);
+		ImageUploadDestroy(ximage);
 		free(image);
 		fclose(infile);
 		return NULL;
@@ -120,76 +157,125 @@ LoadJpegImage(const char *name)
 	jpeg_create_decompress(&cinfo);
 	jpeg_stdio_src(&cinfo, infile);
 	jpeg_read_header(&cinfo, FALSE);
+
+	/* How big we're making it */
+	width  = MAX(1, (int)(((long long) cinfo.image_width  * boxw) / Scr->rootw));
+	height = MAX(1, (int)(((long long) cinfo.image_height * boxh) / Scr->rooth));
+
+	/*
+	 * Have libjpeg do as much of any shrinking as it can, in the IDCT.
+	 * It can do 1/2, 1/4, or 1/8; we take the smallest of those that's
+	 * still at least as big as we need, and do the rest as we copy rows
+	 * out.
+	 */
+	for(denom = 8; denom > 1; denom /= 2) {
+		if((int)((cinfo.image_width  + denom - 1) / denom) >= width
+		                && (int)((cinfo.image_height + denom - 1) / denom) >= height) {
+			break;
+		}
+	}
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = denom;
 	cinfo.do_fancy_upsampling = FALSE;
 	cinfo.do_block_smoothing = FALSE;
 	jpeg_start_decompress(&cinfo);
-	width  = cinfo.output_width;
-	height = cinfo.output_height;
+	width  = MIN(width,  (int) cinfo.output_width);
+	height = MIN(height, (int) cinfo.output_height);
 
-	if(Scr->d_depth == 16) {
-		store_data = &convert_for_16;
-		buffer_16bpp = malloc((width) * (height) * 2);
-		ximage = XCreateImage(dpy, CopyFromParent, Scr->d_depth, ZPixmap, 0,
-		                      (char *) buffer_16bpp, width, height, 16, width * 2);
-	}
-	else if(Scr->d_depth == 24 || Scr->d_depth == 32) {
-		store_data = &convert_for_32;
-		buffer_32bpp = malloc(width * height * 4);
-		ximage = XCreateImage(dpy, CopyFromParent, Scr->d_depth, ZPixmap, 0,
-		                      (char *) buffer_32bpp, width, height, 32, width * 4);
-	}
-	else {
+	if(Scr->d_depth != 16 && Scr->d_depth != 24 && Scr->d_depth != 32) {
 		fprintf(stderr, "Image %s unsupported depth : %d\n", name, Scr->d_depth);
+		jpeg_destroy_decompress(&cinfo);
 		free(image);
 		fclose(infile);
 		return NULL;
 	}
+
+	/* Decode straight into what we'll send to the server */
+	ximage = ImageUploadCreate(Scr->d_depth, width, height);
 	if(ximage == NULL) {
 		fprintf(stderr, "cannot create image for %s\n", name);
+		jpeg_destroy_decompress(&cinfo);
+		free(image);
+		fclose(infile);
+		return NULL;
+	}
+	if(ximage->bits_per_pixel == 16) {
+		store_data = &convert_for_16;
+		buffer_16bpp = (uint16_t *) ximage->data;
+		stride = ximage->bytes_per_line / 2;
+	}
+	else if(ximage->bits_per_pixel == 32) {
+		store_data = &convert_for_32;
+		buffer_32bpp = (uint32_t *) ximage->data;
+		stride = ximage->bytes_per_line / 4;
+	}
+	else {
+		fprintf(stderr, "Image %s unsupported depth : %d\n", name, Scr->d_depth);
+		ImageUploadDestroy(ximage);
+		jpeg_destroy_decompress(&cinfo);
 		free(image);
 		fclose(infile);
 		return NULL;
 	}
-	g = 0;
-	row_stride = cinfo.output_width * cinfo.output_components;
-	buffer = (*cinfo.mem->alloc_sarray)
-	         ((j_common_ptr) & cinfo, JPOOL_IMAGE, row_stride, 1);
 
+	/* Which source pixel each of ours comes from; grayscale has just 1 */
 	bpix = cinfo.output_components;
-	while(cinfo.output_scanline < cinfo.output_height) {
-		jpeg_read_scanlines(&cinfo, buffer, 1);
-		a = 0;
-		for(i = 0; i < bpix * cinfo.output_width; i += bpix) {
-			(*store_data)(width, a, g, buffer[0][i],  buffer[0][i + 1], buffer[0][i + 2]);
-			a++;
+	c1 = (bpix >= 3) ? 1 : 0;
+	c2 = (bpix >= 3) ? 2 : 0;
+	xmap = (*cinfo.mem->alloc_small)((j_common_ptr) & cinfo, JPOOL_IMAGE,
+	                                 width * sizeof(int));
+	for(x = 0; x < width; x++) {
+		xmap[x] = (int)(((long long) x * cinfo.output_width) / width) * bpix;
+	}
+
+	row_stride = cinfo.output_width * bpix;
+	buffer = (*cinfo.mem->alloc_sarray)
+	         ((j_common_ptr) & cinfo, JPOOL_IMAGE, row_stride, JPEG_BATCH_ROWS);
+
+	/*
+	 * Pull out rows a batch at a time, and fill in each of our rows from
+	 * whichever source row is nearest.
+	 */
+	dy = 0;
+	while(cinfo.output_scanline < cinfo.output_height && dy < height) {
+		const int first = cinfo.output_scanline;
+		const int n = jpeg_read_scanlines(&cinfo, buffer, JPEG_BATCH_ROWS);
+
+		for(; dy < height; dy++) {
+			const int sy = (int)(((long long) dy * cinfo.output_height) / height);
+			JSAMPROW row;
+
+			if(sy >= first + n) {
+				break;
+			}
+			row = buffer[sy - first];
+			for(x = 0; x < width; x++) {
+				const JSAMPLE *p = row + xmap[x];
+				(*store_data)(stride, x, dy, p[0], p[c1], p[c2]);
+			}
 		}
-		g++;
 	}
-	jpeg_finish_decompress(&cinfo);
 	jpeg_destroy_decompress(&cinfo);
 	fclose(infile);
 
 	gc = DefaultGC(dpy, Scr->screen);
-	if((width > (Scr->rootw / 2)) || (height > (Scr->rooth / 2))) {
-		int x, y;
-
-		pixret = XCreatePixmap(dpy, Scr->Root, Scr->rootw, Scr->rooth, Scr->d_depth);
-		x = (Scr->rootw  -  width) / 2;
-		y = (Scr->rooth  - height) / 2;
-		XFillRectangle(dpy, pixret, gc, 0, 0, Scr->rootw, Scr->rooth);
-		XPutImage(dpy, pixret, gc, ximage, 0, 0, x, y, width, height);
-		image->width  = Scr->rootw;
-		image->height = Scr->rooth;
+	if((width > (boxw / 2)) || (height > (boxh / 2))) {
+		const int px = (boxw  -  width) / 2;
+		const int py = (boxh  - height) / 2;
+
+		pixret = XCreatePixmap(dpy, Scr->Root, boxw, boxh, Scr->d_depth);
+		XFillRectangle(dpy, pixret, gc, 0, 0, boxw, boxh);
+		ImageUploadPut(pixret, gc, ximage, 0, 0, px, py, width, height);
+		image->width  = boxw;
+		image->height = boxh;
 	}
 	else {
 		pixret = XCreatePixmap(dpy, Scr->Root, width, height, Scr->d_depth);
-		XPutImage(dpy, pixret, gc, ximage, 0, 0, 0, 0, width, height);
+		ImageUploadPut(pixret, gc, ximage, 0, 0, 0, 0, width, height);
 		image->width  = width;
 		image->height = height;
 	}
-	if(ximage) {
-		XDestroyImage(ximage);
-	}
+	ImageUploadDestroy(ximage);
 	image->pixmap = pixret;
 
 	return image;
@@ -5,5 +5,6 @@
 #define _CTWM_IMAGE_JPEG_H
 
 Image *GetJpegImage(const char *name);
+Image *GetJpegImageScaled(const char *name, int boxw, int boxh);
 
 #endif /* _CTWM_IMAGE_JPEG_H */
@@ -0,0 +1,369 @@
+/*
+ * Getting client-side images over to the server
+ *
+ * The JPEG and XWD loaders, XPM, and EWMH icons all end up with an
+ * XImage in our memory that needs putting into a Pixmap.  XPutImage()
+ * pushes every byte of that through the X connection, which adds up for
+ * full-screen backgrounds and the welcome splash.  When the server's on
+ * the same machine and has the MIT-SHM extension, we instead build the
+ * image in a shared memory segment and have the server read it straight
+ * from there.
+ *
+ * There's one segment, kept around after an image is done with it so
+ * the next load (e.g., the rest of the workspace backgrounds at startup)
+ * can use it without setting up another.  It's let go of after sitting
+ * idle for a while.
+ *
+ * Big images are put in strips rather than one huge request, so the
+ * server can get to other clients' requests in between.
+ */
+
+#include "ctwm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
+
+#include "image_upload.h"
+#include "screen.h"
+#include "timers.h"
+#include "util.h"
+
+
+/* Roughly how much image data goes in each put request */
+#define UPLOAD_TILE_BYTES (256 * 1024)
+
+/* Smaller than this, shared memory isn't worth the trouble */
+#define UPLOAD_SHM_MIN (16 * 1024)
+
+/* How long to hang onto an unused segment */
+#define UPLOAD_SHM_IDLE_MS 10000
+
+static ImageUploadStats stats;
+
+
+#ifdef XSHM
+/*
+ * Our shared memory segment, if any.  XShmCreateImage() images using it
+ * point their obdata at seg_info, which is how we tell them apart.
+ */
+static XShmSegmentInfo seg_info;
+static size_t seg_size;         ///< 0 if we don't have one
+static bool seg_busy;           ///< An image is using it
+static Timer seg_timer;         ///< Idle expiry
+
+static enum { SHM_UNKNOWN, SHM_OK, SHM_NO } shm_state = SHM_UNKNOWN;
+static bool attach_failed;
+
+static void SegmentExpire(void *arg);
+
+
+/*
+ * Can we use it at all?  It has to be there, and the server has to be
+ * on this machine; a remote server would happily attach to whatever
+ * segment of its own has our ID.
+ */
+static bool
+ShmAvailable(void)
+{
+	if(shm_state == SHM_UNKNOWN) {
+		const char *ds = DisplayString(dpy);
+
+		shm_state = SHM_NO;
+		if(ds != NULL && (ds[0] == ':' || ds[0] == '/'
+		                  || strncmp(ds, "unix:", 5) == 0)
+		                && XShmQueryExtension(dpy)) {
+			shm_state = SHM_OK;
+		}
+		TimerInit(&seg_timer, SegmentExpire, NULL);
+	}
+	return shm_state == SHM_OK;
+}
+
+
+static int
+CatchAttachError(Display *display, XErrorEvent *event)
+{
+	attach_failed = true;
+	return 0;
+}
+
+
+static void
+SegmentRelease(void)
+{
+	if(seg_size == 0) {
+		return;
+	}
+	TimerCancel(&seg_timer);
+	XShmDetach(dpy, &seg_info);
+	shmdt(seg_info.shmaddr);
+	memset(&seg_info, 0, sizeof(seg_info));
+	seg_size = 0;
+}
+
+
+/* Timer callback: nobody's needed it in a while */
+static void
+SegmentExpire(void *arg)
+{
+	if(!seg_busy) {
+		SegmentRelease();
+	}
+}
+
+
+/*
+ * Get the segment, at least size bytes of it, for an image to use.
+ * NULL if we can't; it's already in use, or setting up a new one
+ * failed.
+ */
+static char *
+SegmentGet(size_t size)
+{
+	XErrorHandler oldHandler;
+	int shmid;
+	char *addr;
+	Status ok;
+
+	if(!ShmAvailable() || seg_busy) {
+		return NULL;
+	}
+
+	if(seg_size >= size) {
+		TimerCancel(&seg_timer);
+		seg_busy = true;
+		stats.reused++;
+		return seg_info.shmaddr;
+	}
+	SegmentRelease();
+
+	shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+	if(shmid < 0) {
+		return NULL;
+	}
+	addr = shmat(shmid, NULL, 0);
+	if(addr == (char *) - 1) {
+		shmctl(shmid, IPC_RMID, NULL);
+		return NULL;
+	}
+	seg_info.shmid = shmid;
+	seg_info.shmaddr = addr;
+	seg_info.readOnly = True;
+
+	/*
+	 * If the server can't get at it after all, it tells us with an
+	 * error, not a return.
+	 */
+	XSync(dpy, False);
+	attach_failed = false;
+	oldHandler = XSetErrorHandler(CatchAttachError);
+	ok = XShmAttach(dpy, &seg_info);
+	XSync(dpy, False);
+	XSetErrorHandler(oldHandler);
+
+	/* Either way, it goes away once we're both done with it */
+	shmctl(shmid, IPC_RMID, NULL);
+
+	if(!ok || attach_failed) {
+		shmdt(addr);
+		memset(&seg_info, 0, sizeof(seg_info));
+		shm_state = SHM_NO;
+		return NULL;
+	}
+
+	seg_size = size;
+	seg_busy = true;
+	stats.segments++;
+	return addr;
+}
+
+
+static bool
+IsShmImage(const XImage *img)
+{
+	return img->obdata == (char *) &seg_info;
+}
+#endif /* XSHM */
+
+
+/**
+ * Make a ZPixmap XImage for building a width x height image of the
+ * given depth in, to be sent with ImageUploadPut().  The data is
+ * allocated, but rows may be padded, so index it by bytes_per_line.
+ * Returns NULL if we can't.
+ */
+XImage *
+ImageUploadCreate(int depth, int width, int height)
+{
+	XImage *img;
+
+	if(width <= 0 || height <= 0) {
+		return NULL;
+	}
+
+#ifdef XSHM
+	if(ShmAvailable()) {
+		img = XShmCreateImage(dpy, Scr->d_visual, depth, ZPixmap, NULL,
+		                      &seg_info, width, height);
+		if(img != NULL) {
+			size_t size = (size_t) img->bytes_per_line * height;
+
+			if(size >= UPLOAD_SHM_MIN
+			                && (img->data = SegmentGet(size)) != NULL) {
+				return img;
+			}
+			XDestroyImage(img);
+		}
+	}
+#endif
+
+	img = XCreateImage(dpy, Scr->d_visual, depth, ZPixmap, 0, NULL,
+	                   width, height, 32, 0);
+	if(img == NULL) {
+		return NULL;
+	}
+	img->data = malloc((size_t) img->bytes_per_line * height);
+	if(img->data == NULL) {
+		XDestroyImage(img);
+		return NULL;
+	}
+	return img;
+}
+
+
+/*
+ * Send part of an image down the connection, a strip at a time.
+ */
+static void
+PutTiled(Drawable d, GC gc, XImage *img, int sx, int sy,
+         int dx, int dy, unsigned int w, unsigned int h, bool shm)
+{
+	int rows = UPLOAD_TILE_BYTES / MAX(img->bytes_per_line, 1);
+
+	if(rows < 1) {
+		rows = 1;
+	}
+	for(unsigned int y = 0; y < h; y += rows) {
+		unsigned int n = MIN((unsigned int) rows, h - y);
+
+#ifdef XSHM
+		if(shm) {
+			XShmPutImage(dpy, d, gc, img, sx, sy + y, dx, dy + y, w, n, False);
+		}
+		else
+#endif
+			XPutImage(dpy, d, gc, img, sx, sy + y, dx, dy + y, w, n);
+		stats.tiles++;
+	}
+}
+
+
+/**
+ * XPutImage(), but through shared memory when we can.  img can be from
+ * ImageUploadCreate(), or any other ZPixmap image; big ones get copied
+ * into shared memory to send.
+ */
+void
+ImageUploadPut(Drawable d, GC gc, XImage *img, int sx, int sy,
+               int dx, int dy, unsigned int w, unsigned int h)
+{
+	const unsigned long long bytes = (unsigned long long) img->bytes_per_line * h;
+
+	if(w == 0 || h == 0) {
+		return;
+	}
+
+#ifdef XSHM
+	if(IsShmImage(img)) {
+		PutTiled(d, gc, img, sx, sy, dx, dy, w, h, true);
+
+		/* Make sure the server's done reading before it's reused */
+		XSync(dpy, False);
+		stats.shm_puts++;
+		stats.shm_bytes += bytes;
+		return;
+	}
+
+	if(img->format == ZPixmap && bytes >= UPLOAD_SHM_MIN) {
+		XImage *staged = ImageUploadCreate(img->depth, img->width, img->height);
+
+		if(staged != NULL && IsShmImage(staged)
+		                && staged->bits_per_pixel == img->bits_per_pixel
+		                && staged->byte_order == img->byte_order) {
+			const int len = MIN(staged->bytes_per_line, img->bytes_per_line);
+
+			for(int y = sy; y < sy + (int) h; y++) {
+				memcpy(staged->data + y * staged->bytes_per_line,
+				       img->data + y * img->bytes_per_line, len);
+			}
+			stats.staged++;
+			ImageUploadPut(d, gc, staged, sx, sy, dx, dy, w, h);
+			ImageUploadDestroy(staged);
+			return;
+		}
+		if(staged != NULL) {
+			ImageUploadDestroy(staged);
+		}
+	}
+#endif
+
+	PutTiled(d, gc, img, sx, sy, dx, dy, w, h, false);
+	stats.puts++;
+	stats.wire_bytes += bytes;
+}
+
+
+/**
+ * Free up an image from ImageUploadCreate().  Plain XImages can come
+ * through here too.
+ */
+void
+ImageUploadDestroy(XImage *img)
+{
+	if(img == NULL) {
+		return;
+	}
+
+#ifdef XSHM
+	if(IsShmImage(img)) {
+		/* The segment stays around for next time, for a while */
+		img->data = NULL;
+		seg_busy = false;
+		TimerSet(&seg_timer, UPLOAD_SHM_IDLE_MS);
+	}
+#endif
+
+	XDestroyImage(img);
+}
+
+
+/**
+ * Current counters.
+ */
+const ImageUploadStats *
+ImageUploadGetStats(void)
+{
+	return &stats;
+}
+
+
+/**
+ * Say how image data got to the server.
+ */
+void
+ImageUploadReport(FILE *out)
+{
+	fprintf(out, "Image uploads: %lu shared memory (%lu copied in, "
+	        "%llu KB), %lu on the wire (%llu KB), %lu requests\n",
+	        stats.shm_puts, stats.staged, stats.shm_bytes / 1024,
+	        stats.puts, stats.wire_bytes / 1024, stats.tiles);
+	fprintf(out, "  %lu segments set up, %lu reused\n",
+	        stats.segments, stats.reused);
+}
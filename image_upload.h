@@ -0,0 +1,29 @@
+/*
+ * Getting client-side images over to the server
+ */
+#ifndef _CTWM_IMAGE_UPLOAD_H
+#define _CTWM_IMAGE_UPLOAD_H
+
+#include <stdio.h>  // For FILE
+
+
+/// Counts of image uploads, for diagnostics
+typedef struct ImageUploadStats {
+	unsigned long shm_puts;     ///< Images put through shared memory
+	unsigned long staged;       ///< ... of which had to be copied in first
+	unsigned long puts;         ///< Images sent down the connection
+	unsigned long tiles;        ///< Put requests they were split into
+	unsigned long segments;     ///< Shared memory segments set up
+	unsigned long reused;       ///< ... and times one got reused
+	unsigned long long shm_bytes;   ///< Image data passed by shared memory
+	unsigned long long wire_bytes;  ///< ... and sent on the connection
+} ImageUploadStats;
+
+XImage *ImageUploadCreate(int depth, int width, int height);
+void ImageUploadPut(Drawable d, GC gc, XImage *img, int sx, int sy,
+                    int dx, int dy, unsigned int w, unsigned int h);
+void ImageUploadDestroy(XImage *img);
+const ImageUploadStats *ImageUploadGetStats(void);
+void ImageUploadReport(FILE *out);
+
+#endif /* _CTWM_IMAGE_UPLOAD_H */
@@ -13,6 +13,7 @@
 #include "screen.h"
 
 #include "image.h"
+#include "image_upload.h"
 #include "image_xpm.h"
 
 static Image *LoadXpmImage(const char  *name, ColorPair cp);
@@ -47,6 +48,8 @@ LoadXpmImage(const char *name, ColorPair cp)
 	char        *fullname;
 	Image       *image;
 	int         status;
+	XImage      *ximage, *shapeimage;
+	GC          gc;
 	Colormap    stdcmap = Scr->RootColormaps.cwins[0]->colormap->c;
 	XpmAttributes attributes;
 	static XpmColorSymbol overrides[] = {
@@ -88,10 +91,22 @@ LoadXpmImage(const char *name, ColorPair cp)
 	attributes.depth     = Scr->d_depth;
 	attributes.visual    = Scr->d_visual;
 	attributes.closeness = 65535; /* Never fail */
-	status = XpmReadFileToPixmap(dpy, Scr->Root, fullname,
-	                             &(image->pixmap), &(image->mask), &attributes);
+
+	/*
+	 * Read it into client-side images, and put them into pixmaps
+	 * ourselves, so big ones can go through shared memory.
+	 */
+	ximage = shapeimage = NULL;
+	status = XpmReadFileToImage(dpy, fullname, &ximage, &shapeimage,
+	                            &attributes);
 	if(status != XpmSuccess) {
 		xpmErrorMessage(status, name, fullname);
+		if(ximage) {
+			XDestroyImage(ximage);
+		}
+		if(shapeimage) {
+			XDestroyImage(shapeimage);
+		}
 		free(fullname);
 		free(image);
 		return NULL;
@@ -99,6 +114,25 @@ LoadXpmImage(const char *name, ColorPair cp)
 	free(fullname);
 	image->width  = attributes.width;
 	image->height = attributes.height;
+
+	image->pixmap = XCreatePixmap(dpy, Scr->Root, image->width,
+	                              image->height, ximage->depth);
+	gc = XCreateGC(dpy, image->pixmap, 0, NULL);
+	ImageUploadPut(image->pixmap, gc, ximage,
+	               0, 0, 0, 0, image->width, image->height);
+	XFreeGC(dpy, gc);
+	XDestroyImage(ximage);
+
+	image->mask = None;
+	if(shapeimage) {
+		image->mask = XCreatePixmap(dpy, Scr->Root, image->width,
+		                            image->height, 1);
+		gc = XCreateGC(dpy, image->mask, 0, NULL);
+		ImageUploadPut(image->mask, gc, shapeimage,
+		               0, 0, 0, 0, image->width, image->height);
+		XFreeGC(dpy, gc);
+		XDestroyImage(shapeimage);
+	}
 	return image;
 }
 
@@ -13,6 +13,7 @@
 #include "animate.h"
 
 #include "image.h"
+#include "image_upload.h"
 #include "image_xwd.h"
 
 
@@ -213,13 +214,13 @@ file_opened:
 		x = (Scr->rootw  - w) / 2;
 		y = (Scr->rooth - h) / 2;
 		XFillRectangle(dpy, pixret, gc, 0, 0, Scr->rootw, Scr->rooth);
-		XPutImage(dpy, pixret, gc, image, 0, 0, x, y, w, h);
+		ImageUploadPut(pixret, gc, image, 0, 0, x, y, w, h);
 		ret->width  = Scr->rootw;
 		ret->height = Scr->rooth;
 	}
 	else {
 		pixret = XCreatePixmap(dpy, Scr->Root, w, h, depth);
-		XPutImage(dpy, pixret, gc, image, 0, 0, 0, 0, w, h);
+		ImageUploadPut(pixret, gc, image, 0, 0, 0, 0, w, h);
 		ret->width  = w;
 		ret->height = h;
 	}
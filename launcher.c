@@ -0,0 +1,432 @@
+/*
+ * Starting external programs
+ *
+ * f.exec and friends used to system() their command, which leaves us
+ * blocked until /bin/sh returns; forever, if the command doesn't end
+ * in a '&'.  Instead we posix_spawn() the process and go right back to
+ * the event loop.  Simple commands (just words, no shell syntax) can
+ * optionally be run directly, without a shell in between.
+ *
+ * Children are reaped from the main loop: the SIGCHLD handler just
+ * pokes a self-pipe, which CtwmNextEvent() watches alongside the X
+ * connection, and LauncherReap() does the actual waitpid()'ing.
+ */
+
+#include "ctwm.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "launcher.h"
+
+
+static int child_pipe[2] = { -1, -1 };
+static LauncherStats stats;
+
+/* PIDs we started and haven't reaped yet */
+static pid_t *running_pids;
+static int running_size;
+
+
+/*
+ * SIGCHLD handler.  All the real work happens in LauncherReap().
+ */
+static void
+sh_child(int signum)
+{
+	int save_errno = errno;
+	const char c = 0;
+
+	// If the pipe is full there's already a wakeup pending
+	write(child_pipe[1], &c, 1);
+	errno = save_errno;
+}
+
+
+/**
+ * Setup the self-pipe and SIGCHLD handler.  Called during startup.
+ */
+void
+LauncherInit(void)
+{
+	struct sigaction sa;
+	int i;
+
+	if(child_pipe[0] != -1) {
+		return;
+	}
+
+	if(pipe(child_pipe) != 0) {
+		perror("launcher pipe");
+		// Fallback to the old way; nothing to wait() for then.
+		signal(SIGCHLD, SIG_IGN);
+		return;
+	}
+	for(i = 0; i < 2; i++) {
+		fcntl(child_pipe[i], F_SETFD, FD_CLOEXEC);
+		fcntl(child_pipe[i], F_SETFL, fcntl(child_pipe[i], F_GETFL) | O_NONBLOCK);
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = sh_child;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sigaction(SIGCHLD, &sa, NULL);
+}
+
+
+/**
+ * File descriptor that becomes readable when there are children to
+ * reap.  -1 if we're not setup.
+ */
+int
+LauncherFd(void)
+{
+	return child_pipe[0];
+}
+
+
+/*
+ * Track our running children.
+ */
+static void
+trackPid(pid_t pid)
+{
+	int i;
+
+	for(i = 0; i < running_size; i++) {
+		if(running_pids[i] == 0) {
+			running_pids[i] = pid;
+			return;
+		}
+	}
+
+	int nsize = running_size ? running_size * 2 : 16;
+	pid_t *n = realloc(running_pids, nsize * sizeof(pid_t));
+	if(n == NULL) {
+		return;
+	}
+	memset(n + running_size, 0, (nsize - running_size) * sizeof(pid_t));
+	n[running_size] = pid;
+	running_pids = n;
+	running_size = nsize;
+}
+
+static bool
+untrackPid(pid_t pid)
+{
+	int i;
+
+	for(i = 0; i < running_size; i++) {
+		if(running_pids[i] == pid) {
+			running_pids[i] = 0;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/**
+ * Collect any exited children.  We take anyone, not just what we
+ * started, since things like the m4 child from config parsing are never
+ * waited for otherwise.
+ */
+void
+LauncherReap(void)
+{
+	char buf[64];
+	pid_t pid;
+	int status;
+
+	if(child_pipe[0] == -1) {
+		return;
+	}
+
+	// Drain the wakeups first, so a SIGCHLD arriving during the
+	// waitpid() loop leaves a fresh one for next time.
+	while(read(child_pipe[0], buf, sizeof(buf)) > 0) {
+		/* nada */;
+	}
+
+	while((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		if(untrackPid(pid)) {
+			stats.reaped++;
+			stats.running--;
+			if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+				stats.badexit++;
+			}
+		}
+	}
+}
+
+
+/**
+ * Split a "simple" command into an argv[], so it can be run without a
+ * shell.  Simple means words made of a conservative set of characters,
+ * separated by blanks, optionally with a trailing '&' (which is
+ * meaningless to us, as we never wait anyway).  Anything else (quotes,
+ * variables, redirections, globs, VAR=val prefixes...) returns NULL,
+ * and should be left to /bin/sh.
+ */
+char **
+LauncherSplitArgv(const char *cmd)
+{
+	char **argv;
+	const char *p;
+	int nwords = 0, len, i;
+	bool inword = false;
+
+	/* Check it's simple, and count words */
+	len = strlen(cmd);
+	while(len > 0 && (cmd[len - 1] == ' ' || cmd[len - 1] == '\t')) {
+		len--;
+	}
+	if(len > 0 && cmd[len - 1] == '&') {
+		len--;
+		if(len > 0 && cmd[len - 1] == '&') {
+			return NULL;
+		}
+	}
+	for(p = cmd; p < cmd + len; p++) {
+		if(*p == ' ' || *p == '\t') {
+			inword = false;
+			continue;
+		}
+		if(!inword) {
+			nwords++;
+			inword = true;
+		}
+		if(!(isalnum((unsigned char)*p) || strchr("-_./,:+@%=^", *p))) {
+			return NULL;
+		}
+		if(*p == '=' && nwords == 1) {
+			// VAR=value prefix
+			return NULL;
+		}
+	}
+	if(nwords == 0) {
+		return NULL;
+	}
+
+	/* Build it */
+	argv = calloc(nwords + 1, sizeof(char *));
+	if(argv == NULL) {
+		return NULL;
+	}
+	for(i = 0, p = cmd; i < nwords; i++) {
+		const char *start;
+
+		while(*p == ' ' || *p == '\t') {
+			p++;
+		}
+		start = p;
+		while(p < cmd + len && *p != ' ' && *p != '\t') {
+			p++;
+		}
+		argv[i] = strndup(start, p - start);
+		if(argv[i] == NULL) {
+			LauncherFreeArgv(argv);
+			return NULL;
+		}
+	}
+
+	return argv;
+}
+
+
+/**
+ * Free an argv[] from LauncherSplitArgv().
+ */
+void
+LauncherFreeArgv(char **argv)
+{
+	char **a;
+
+	if(argv == NULL) {
+		return;
+	}
+	for(a = argv; *a != NULL; a++) {
+		free(*a);
+	}
+	free(argv);
+}
+
+
+/*
+ * Find the program we'd run for name, like execvp() would: name itself
+ * if it has a '/' in it, otherwise the first match in the $PATH of
+ * envp.  Returns a malloc'd path, or NULL if there's nothing we can run.
+ *
+ * We do this ourselves rather than leave it to posix_spawnp(), since
+ * not every libc tells us when the exec fails; some just have the child
+ * exit 127, which would leave a command that's really a shell builtin
+ * silently doing nothing.
+ */
+static char *
+findProgram(const char *name, char *const envp[])
+{
+	const char *path = NULL;
+	struct stat sb;
+
+	if(strchr(name, '/') != NULL) {
+		if(stat(name, &sb) == 0 && S_ISREG(sb.st_mode)
+		                && access(name, X_OK) == 0) {
+			return strdup(name);
+		}
+		return NULL;
+	}
+
+	for(char *const *e = envp; *e != NULL; e++) {
+		if(strncmp(*e, "PATH=", 5) == 0) {
+			path = *e + 5;
+			break;
+		}
+	}
+	if(path == NULL) {
+		path = "/usr/bin:/bin";
+	}
+
+	while(1) {
+		const size_t dlen = strcspn(path, ":");
+		char *full;
+
+		// An empty element is the current directory
+		if(asprintf(&full, "%.*s%s%s", (int)dlen, path, dlen ? "/" : "",
+		                name) == -1) {
+			return NULL;
+		}
+		if(stat(full, &sb) == 0 && S_ISREG(sb.st_mode)
+		                && access(full, X_OK) == 0) {
+			return full;
+		}
+		free(full);
+
+		if(path[dlen] == '\0') {
+			return NULL;
+		}
+		path += dlen + 1;
+	}
+}
+
+
+/**
+ * Start a command in the background, with the given environment (NULL
+ * for our own).  If direct is set and the command is simple enough, it's
+ * run without a shell.  Returns the child PID, or -1 on failure.
+ */
+pid_t
+LauncherRun(const char *cmd, char *const envp[], bool direct)
+{
+	struct timeval start, end;
+	posix_spawnattr_t attr;
+	sigset_t none;
+	char **argv = NULL;
+	char *prog = NULL;
+	pid_t pid;
+	int ret;
+
+	gettimeofday(&start, NULL);
+
+	if(envp == NULL) {
+		envp = environ;
+	}
+
+	/* Whatever we've got blocked, the child shouldn't inherit */
+	posix_spawnattr_init(&attr);
+	sigemptyset(&none);
+	posix_spawnattr_setsigmask(&attr, &none);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+	if(direct) {
+		argv = LauncherSplitArgv(cmd);
+		if(argv != NULL) {
+			prog = findProgram(argv[0], envp);
+		}
+	}
+	if(prog != NULL) {
+		ret = posix_spawn(&pid, prog, NULL, &attr, argv, envp);
+		if(ret == 0) {
+			stats.direct++;
+		}
+		free(prog);
+	}
+	else {
+		/*
+		 * Not simple, or not a program we can find (maybe a shell
+		 * builtin like "exit", or the shell can tell the user about it
+		 * better than we can); hand it to sh.
+		 */
+		char *shcmd = strdup(cmd);
+		char *sh_argv[] = { "sh", "-c", shcmd, NULL };
+
+		if(shcmd == NULL) {
+			ret = ENOMEM;
+		}
+		else {
+			ret = posix_spawn(&pid, "/bin/sh", NULL, &attr, sh_argv, envp);
+			free(shcmd);
+		}
+	}
+	LauncherFreeArgv(argv);
+	posix_spawnattr_destroy(&attr);
+
+	if(ret != 0) {
+		fprintf(stderr, "%s: can't run '%s': %s\n", ProgramName, cmd,
+		        strerror(ret));
+		stats.failed++;
+		pid = -1;
+	}
+	else {
+		trackPid(pid);
+		stats.launched++;
+		stats.running++;
+	}
+
+	gettimeofday(&end, NULL);
+	{
+		double ms = (end.tv_sec - start.tv_sec) * 1000.0
+		            + (end.tv_usec - start.tv_usec) / 1000.0;
+		stats.total_ms += ms;
+		if(ms > stats.max_ms) {
+			stats.max_ms = ms;
+		}
+	}
+
+	return pid;
+}
+
+
+/**
+ * Current launcher counters.
+ */
+const LauncherStats *
+LauncherGetStats(void)
+{
+	return &stats;
+}
+
+
+/**
+ * Say how many programs we started, and how long it took.
+ */
+void
+LauncherReport(FILE *out)
+{
+	fprintf(out, "Launcher: %lu started (%lu without sh), %lu failed, "
+	        "%lu reaped (%lu unsuccessful), %lu still running\n",
+	        stats.launched, stats.direct, stats.failed, stats.reaped,
+	        stats.badexit, stats.running);
+	fprintf(out, "  %.1f ms total, %.1f ms longest\n", stats.total_ms,
+	        stats.max_ms);
+}
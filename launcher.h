@@ -0,0 +1,33 @@
+/*
+ * Starting external programs
+ */
+
+#ifndef _CTWM_LAUNCHER_H
+#define _CTWM_LAUNCHER_H
+
+#include <stdio.h>  // For FILE
+#include <sys/types.h>
+
+
+/// Counts and timings for programs started via LauncherRun()
+typedef struct LauncherStats {
+	unsigned long launched;  ///< Processes started
+	unsigned long direct;    ///< ... of which without going through sh
+	unsigned long failed;    ///< Spawn attempts that failed
+	unsigned long reaped;    ///< Our children collected by the reaper
+	unsigned long badexit;   ///< ... of which didn't exit 0
+	unsigned long running;   ///< Started and not reaped yet
+	double total_ms;         ///< Total time spent in LauncherRun()
+	double max_ms;           ///< Longest single LauncherRun()
+} LauncherStats;
+
+void LauncherInit(void);
+int LauncherFd(void);
+void LauncherReap(void);
+pid_t LauncherRun(const char *cmd, char *const envp[], bool direct);
+char **LauncherSplitArgv(const char *cmd);
+void LauncherFreeArgv(char **argv);
+const LauncherStats *LauncherGetStats(void);
+void LauncherReport(FILE *out);
+
+#endif /* _CTWM_LAUNCHER_H */
@@ -66,16 +66,30 @@ bool AlternateContext;
 
 int MenuDepth = 0;              /* number of menus up */
 static struct {
-	int x;
+	int x;                      ///< Relative to Scr->Root
 	int y;
+	int root_x;                 ///< Same, relative to the real root
+	int root_y;
 } MenuOrigins[MAXMENUDEPTH];
 static bool addingdefaults = false;
 
+/*
+ * Bumped whenever something the window-list menus (TwmWindows, TwmIcons,
+ * etc) show may have changed; they're only rebuilt when it has.  0 is
+ * never used, so a MenuRoot that was never built is never current.
+ */
+static unsigned int WindowListGeneration = 1;
+
 
 
-static void Paint3DEntry(MenuRoot *mr, MenuItem *mi, bool exposure);
-static void PaintNormalEntry(MenuRoot *mr, MenuItem *mi, bool exposure);
+static void Paint3DEntry(MenuRoot *mr, Drawable d, MenuItem *mi,
+                         bool exposure);
+static void PaintNormalEntry(MenuRoot *mr, Drawable d, MenuItem *mi,
+                             bool exposure);
+static bool MenuRender(MenuRoot *mr);
+static void MenuFreeRender(MenuRoot *mr);
 static void DestroyMenu(MenuRoot *menu);
+static void SetMenuOrigin(int depth, int x, int y);
 
 
 #define SHADOWWIDTH 5                   /* in pixels */
@@ -123,8 +137,12 @@ AddFuncKey(char *name, int cont, int nmods, int func,
 		return false;
 	}
 
-	/* see if there already is a key defined for this context */
-	for(tmp = Scr->FuncKeyRoot.next; tmp != NULL; tmp = tmp->next) {
+	/*
+	 * See if there already is a key defined for this context.  The same
+	 * keysym always gives the same keycode, so it'd be in this bucket.
+	 */
+	FuncKey **bucket = &Scr->FuncKeyHash[FUNCKEY_HASH(keycode, nmods)];
+	for(tmp = *bucket; tmp != NULL; tmp = tmp->hnext) {
 		if(tmp->keysym == keysym &&
 		                tmp->cont == cont &&
 		                tmp->mods == nmods) {
@@ -136,8 +154,13 @@ AddFuncKey(char *name, int cont, int nmods, int func,
 		tmp = malloc(sizeof(FuncKey));
 		tmp->next = Scr->FuncKeyRoot.next;
 		Scr->FuncKeyRoot.next = tmp;
+		tmp->hnext = *bucket;
+		*bucket = tmp;
 	}
 
+	/* Any precalculated grabs are out of date now */
+	InvalidateWindowGrabs();
+
 	tmp->name = name;
 	tmp->keysym = keysym;
 	tmp->keycode = keycode;
@@ -204,10 +227,28 @@ AddFuncButton(int num, int cont, int nmods, int func,
 	tmp->menu = menu;
 	tmp->item = item;
 
+	/* Any precalculated grabs are out of date now */
+	InvalidateWindowGrabs();
+
 	return;
 }
 
 
+/**
+ * Note that the set of windows, or their names, icon states or
+ * occupations have changed, so the window-list menus need to be rebuilt
+ * next time they're popped up.
+ */
+void
+InvalidateWindowListMenus(void)
+{
+	WindowListGeneration++;
+	if(WindowListGeneration == 0) {
+		WindowListGeneration = 1;
+	}
+}
+
+
 /*
  * AddDefaultFuncButtons - attach default bindings so that naive users
  * don't get messed up if they provide a minimal twmrc.
@@ -241,11 +282,22 @@ AddDefaultFuncButtons(void)
 void
 PaintEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 {
-	if(Scr->use3Dmenus) {
-		Paint3DEntry(mr, mi, exposure);
+	if(MenuRender(mr)) {
+		/* Just copy in the row from the appropriate rendering */
+		const Pixmap src = mi->state ? mr->hilitePm : mr->normalPm;
+		int y = mi->item_num * Scr->EntryHeight;
+
+		if(Scr->use3Dmenus) {
+			y += Scr->MenuShadowDepth;
+		}
+		XCopyArea(dpy, src, mr->w, Scr->NormalGC, 0, y,
+		          mr->width, Scr->EntryHeight, 0, y);
+	}
+	else if(Scr->use3Dmenus) {
+		Paint3DEntry(mr, mr->w, mi, exposure);
 	}
 	else {
-		PaintNormalEntry(mr, mi, exposure);
+		PaintNormalEntry(mr, mr->w, mi, exposure);
 	}
 	if(mi->state) {
 		mr->lastactive = mi;
@@ -253,14 +305,12 @@ PaintEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 }
 
 static void
-Paint3DEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
+Paint3DEntry(MenuRoot *mr, Drawable d, MenuItem *mi, bool exposure)
 {
 	int y_offset;
 	int text_y;
 	GC gc;
-	XRectangle ink_rect, logical_rect;
-	XmbTextExtents(Scr->MenuFont.font_set, mi->item, mi->strlen,
-	               &ink_rect, &logical_rect);
+	const XRectangle logical_rect = mi->extents;
 
 	y_offset = mi->item_num * Scr->EntryHeight + Scr->MenuShadowDepth;
 	text_y = y_offset + (Scr->EntryHeight - logical_rect.height) / 2
@@ -271,17 +321,17 @@ Paint3DEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 
 		gc = Scr->NormalGC;
 		if(mi->state) {
-			Draw3DBorder(mr->w, Scr->MenuShadowDepth, y_offset,
+			Draw3DBorder(d, Scr->MenuShadowDepth, y_offset,
 			             mr->width - 2 * Scr->MenuShadowDepth, Scr->EntryHeight, 1,
 			             mi->highlight, off, true, false);
 			FB(mi->highlight.fore, mi->highlight.back);
-			XmbDrawImageString(dpy, mr->w, Scr->MenuFont.font_set, gc,
-			                   mi->x + Scr->MenuShadowDepth, text_y, mi->item, mi->strlen);
+			FontDrawImageString(d, &Scr->MenuFont, gc,
+			                    mi->x + Scr->MenuShadowDepth, text_y, mi->item, mi->strlen);
 		}
 		else {
 			if(mi->user_colors || !exposure) {
 				XSetForeground(dpy, gc, mi->normal.back);
-				XFillRectangle(dpy, mr->w, gc,
+				XFillRectangle(dpy, d, gc,
 				               Scr->MenuShadowDepth, y_offset,
 				               mr->width - 2 * Scr->MenuShadowDepth, Scr->EntryHeight);
 				FB(mi->normal.fore, mi->normal.back);
@@ -289,18 +339,18 @@ Paint3DEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 			else {
 				gc = Scr->MenuGC;
 			}
-			XmbDrawImageString(dpy, mr->w, Scr->MenuFont.font_set, gc,
-			                   mi->x + Scr->MenuShadowDepth, text_y,
-			                   mi->item, mi->strlen);
+			FontDrawImageString(d, &Scr->MenuFont, gc,
+			                    mi->x + Scr->MenuShadowDepth, text_y,
+			                    mi->item, mi->strlen);
 			if(mi->separated) {
 				FB(Scr->MenuC.shadd, Scr->MenuC.shadc);
-				XDrawLine(dpy, mr->w, Scr->NormalGC,
+				XDrawLine(dpy, d, Scr->NormalGC,
 				          Scr->MenuShadowDepth,
 				          y_offset + Scr->EntryHeight - 2,
 				          mr->width - Scr->MenuShadowDepth,
 				          y_offset + Scr->EntryHeight - 2);
 				FB(Scr->MenuC.shadc, Scr->MenuC.shadd);
-				XDrawLine(dpy, mr->w, Scr->NormalGC,
+				XDrawLine(dpy, d, Scr->NormalGC,
 				          Scr->MenuShadowDepth,
 				          y_offset + Scr->EntryHeight - 1,
 				          mr->width - Scr->MenuShadowDepth,
@@ -316,29 +366,27 @@ Paint3DEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 			}
 			x = mr->width - Scr->pullW - Scr->MenuShadowDepth - 2;
 			y = y_offset + ((Scr->EntryHeight - ENTRY_SPACING - Scr->pullH) / 2) + 2;
-			XCopyArea(dpy, Scr->pullPm, mr->w, gc, 0, 0, Scr->pullW, Scr->pullH, x, y);
+			XCopyArea(dpy, Scr->pullPm, d, gc, 0, 0, Scr->pullW, Scr->pullH, x, y);
 		}
 	}
 	else {
-		Draw3DBorder(mr->w, Scr->MenuShadowDepth, y_offset,
+		Draw3DBorder(d, Scr->MenuShadowDepth, y_offset,
 		             mr->width - 2 * Scr->MenuShadowDepth, Scr->EntryHeight, 1,
 		             mi->normal, off, true, false);
 		FB(mi->normal.fore, mi->normal.back);
-		XmbDrawImageString(dpy, mr->w, Scr->MenuFont.font_set, Scr->NormalGC,
-		                   mi->x + 2, text_y, mi->item, mi->strlen);
+		FontDrawImageString(d, &Scr->MenuFont, Scr->NormalGC,
+		                    mi->x + 2, text_y, mi->item, mi->strlen);
 	}
 }
 
 
 static void
-PaintNormalEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
+PaintNormalEntry(MenuRoot *mr, Drawable d, MenuItem *mi, bool exposure)
 {
 	int y_offset;
 	int text_y;
 	GC gc;
-	XRectangle ink_rect, logical_rect;
-	XmbTextExtents(Scr->MenuFont.font_set, mi->item, mi->strlen,
-	               &ink_rect, &logical_rect);
+	const XRectangle logical_rect = mi->extents;
 
 	y_offset = mi->item_num * Scr->EntryHeight;
 	text_y = y_offset + (Scr->EntryHeight - logical_rect.height) / 2
@@ -350,11 +398,11 @@ PaintNormalEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 		if(mi->state) {
 			XSetForeground(dpy, Scr->NormalGC, mi->highlight.back);
 
-			XFillRectangle(dpy, mr->w, Scr->NormalGC, 0, y_offset,
+			XFillRectangle(dpy, d, Scr->NormalGC, 0, y_offset,
 			               mr->width, Scr->EntryHeight);
 			FB(mi->highlight.fore, mi->highlight.back);
-			XmbDrawString(dpy, mr->w, Scr->MenuFont.font_set, Scr->NormalGC,
-			              mi->x, text_y, mi->item, mi->strlen);
+			FontDrawString(d, &Scr->MenuFont, Scr->NormalGC,
+			               mi->x, text_y, mi->item, mi->strlen);
 
 			gc = Scr->NormalGC;
 		}
@@ -362,7 +410,7 @@ PaintNormalEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 			if(mi->user_colors || !exposure) {
 				XSetForeground(dpy, Scr->NormalGC, mi->normal.back);
 
-				XFillRectangle(dpy, mr->w, Scr->NormalGC, 0, y_offset,
+				XFillRectangle(dpy, d, Scr->NormalGC, 0, y_offset,
 				               mr->width, Scr->EntryHeight);
 
 				FB(mi->normal.fore, mi->normal.back);
@@ -371,10 +419,10 @@ PaintNormalEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 			else {
 				gc = Scr->MenuGC;
 			}
-			XmbDrawString(dpy, mr->w, Scr->MenuFont.font_set, gc, mi->x,
-			              text_y, mi->item, mi->strlen);
+			FontDrawString(d, &Scr->MenuFont, gc, mi->x,
+			               text_y, mi->item, mi->strlen);
 			if(mi->separated)
-				XDrawLine(dpy, mr->w, gc, 0, y_offset + Scr->EntryHeight - 1,
+				XDrawLine(dpy, d, gc, 0, y_offset + Scr->EntryHeight - 1,
 				          mr->width, y_offset + Scr->EntryHeight - 1);
 		}
 
@@ -386,7 +434,7 @@ PaintNormalEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 			}
 			x = mr->width - Scr->pullW - 5;
 			y = y_offset + ((Scr->MenuFont.height - Scr->pullH) / 2);
-			XCopyPlane(dpy, Scr->pullPm, mr->w, gc, 0, 0,
+			XCopyPlane(dpy, Scr->pullPm, d, gc, 0, 0,
 			           Scr->pullW, Scr->pullH, x, y, 1);
 		}
 	}
@@ -396,23 +444,23 @@ PaintNormalEntry(MenuRoot *mr, MenuItem *mi, bool exposure)
 		XSetForeground(dpy, Scr->NormalGC, mi->normal.back);
 
 		/* fill the rectangle with the title background color */
-		XFillRectangle(dpy, mr->w, Scr->NormalGC, 0, y_offset,
+		XFillRectangle(dpy, d, Scr->NormalGC, 0, y_offset,
 		               mr->width, Scr->EntryHeight);
 
 		{
 			XSetForeground(dpy, Scr->NormalGC, mi->normal.fore);
 			/* now draw the dividing lines */
 			if(y_offset)
-				XDrawLine(dpy, mr->w, Scr->NormalGC, 0, y_offset,
+				XDrawLine(dpy, d, Scr->NormalGC, 0, y_offset,
 				          mr->width, y_offset);
 			y = ((mi->item_num + 1) * Scr->EntryHeight) - 1;
-			XDrawLine(dpy, mr->w, Scr->NormalGC, 0, y, mr->width, y);
+			XDrawLine(dpy, d, Scr->NormalGC, 0, y, mr->width, y);
 		}
 
 		FB(mi->normal.fore, mi->normal.back);
 		/* finally render the title */
-		XmbDrawString(dpy, mr->w, Scr->MenuFont.font_set, Scr->NormalGC, mi->x,
-		              text_y, mi->item, mi->strlen);
+		FontDrawString(d, &Scr->MenuFont, Scr->NormalGC, mi->x,
+		               text_y, mi->item, mi->strlen);
 	}
 }
 
@@ -420,6 +468,19 @@ void PaintMenu(MenuRoot *mr, XEvent *e)
 {
 	MenuItem *mi;
 
+	if(MenuRender(mr)) {
+		XCopyArea(dpy, mr->normalPm, mr->w, Scr->NormalGC,
+		          e->xexpose.x, e->xexpose.y,
+		          e->xexpose.width, e->xexpose.height,
+		          e->xexpose.x, e->xexpose.y);
+		for(mi = mr->first; mi != NULL; mi = mi->next) {
+			if(mi->state) {
+				PaintEntry(mr, mi, true);
+			}
+		}
+		return;
+	}
+
 	if(Scr->use3Dmenus) {
 		Draw3DBorder(mr->w, 0, 0, mr->width, mr->height,
 		             Scr->MenuShadowDepth, Scr->MenuC, off, false, false);
@@ -439,6 +500,95 @@ void PaintMenu(MenuRoot *mr, XEvent *e)
 }
 
 
+/*
+ * Menus are pre-rendered into a pair of pixmaps the first time they're
+ * painted: one with every item drawn normally, the other with every
+ * (non-title) item highlighted.  Exposes and highlight changes are then
+ * just copying rows out of them, rather than redrawing text, 3D borders
+ * and pull-right arrows each time.  Really big menus aren't worth the
+ * server memory, and are drawn directly as before.
+ */
+#define MENU_RENDER_MAX_AREA (1024 * 1024)
+
+static bool
+MenuRender(MenuRoot *mr)
+{
+	MenuItem *mi;
+
+	if(mr->normalPm != None) {
+		return true;
+	}
+	if(mr->w == None || mr->width <= 0 || mr->height <= 0
+	                || (long)mr->width * mr->height > MENU_RENDER_MAX_AREA) {
+		return false;
+	}
+
+	mr->normalPm = XCreatePixmap(dpy, mr->w, mr->width, mr->height,
+	                             Scr->d_depth);
+	mr->hilitePm = XCreatePixmap(dpy, mr->w, mr->width, mr->height,
+	                             Scr->d_depth);
+
+	/* Background, frame, and everything in its normal state */
+	XSetForeground(dpy, Scr->NormalGC, Scr->MenuC.back);
+	XFillRectangle(dpy, mr->normalPm, Scr->NormalGC, 0, 0,
+	               mr->width, mr->height);
+	if(Scr->use3Dmenus) {
+		Draw3DBorder(mr->normalPm, 0, 0, mr->width, mr->height,
+		             Scr->MenuShadowDepth, Scr->MenuC, off, false, false);
+	}
+	for(mi = mr->first; mi != NULL; mi = mi->next) {
+		const bool save = mi->state;
+
+		mi->state = false;
+		if(Scr->use3Dmenus) {
+			Paint3DEntry(mr, mr->normalPm, mi, false);
+		}
+		else {
+			PaintNormalEntry(mr, mr->normalPm, mi, false);
+		}
+		mi->state = save;
+	}
+
+	/* And the same with everything selectable lit up */
+	XCopyArea(dpy, mr->normalPm, mr->hilitePm, Scr->NormalGC, 0, 0,
+	          mr->width, mr->height, 0, 0);
+	for(mi = mr->first; mi != NULL; mi = mi->next) {
+		const bool save = mi->state;
+
+		if(mi->func == F_TITLE) {
+			continue;
+		}
+		mi->state = true;
+		if(Scr->use3Dmenus) {
+			Paint3DEntry(mr, mr->hilitePm, mi, false);
+		}
+		else {
+			PaintNormalEntry(mr, mr->hilitePm, mi, false);
+		}
+		mi->state = save;
+	}
+
+	return true;
+}
+
+
+/*
+ * Throw away the pre-rendering, when the menu is changing.
+ */
+static void
+MenuFreeRender(MenuRoot *mr)
+{
+	if(mr->normalPm != None) {
+		XFreePixmap(dpy, mr->normalPm);
+		mr->normalPm = None;
+	}
+	if(mr->hilitePm != None) {
+		XFreePixmap(dpy, mr->hilitePm);
+		mr->hilitePm = None;
+	}
+}
+
+
 void MakeWorkspacesMenu(void)
 {
 	static char **actions = NULL;
@@ -487,7 +637,7 @@ cur_fromMenu()
 void UpdateMenu(void)
 {
 	MenuItem *mi;
-	int i, x, y, x_root, y_root, entry;
+	int i, x, y, entry;
 	bool done;
 	MenuItem *badItem = NULL;
 
@@ -527,16 +677,41 @@ void UpdateMenu(void)
 		}
 
 		done = false;
-		XQueryPointer(dpy, ActiveMenu->w, &JunkRoot, &JunkChild,
-		              &x_root, &y_root, &x, &y, &JunkMask);
+
+		XFindContext(dpy, ActiveMenu->w, ScreenContext, (XPointer *)&Scr);
+
+		/*
+		 * Where the pointer is relative to the menu.  Pinned menus get
+		 * motion on their own window; otherwise it mostly comes to the
+		 * root we grabbed, and we work it out from where we put the
+		 * menu.  Motion over our other windows has only x_root/y_root
+		 * to go on, which are on the real root, not Scr->Root if we're
+		 * captive.
+		 */
+		if(Event.xmotion.window == ActiveMenu->w) {
+			x = Event.xmotion.x;
+			y = Event.xmotion.y;
+		}
+		else {
+			const int bw = Scr->use3Dmenus ? 0 : 1;
+
+			if(Event.xmotion.window == Scr->Root) {
+				x = Event.xmotion.x - MenuOrigins[MenuDepth - 1].x - bw;
+				y = Event.xmotion.y - MenuOrigins[MenuDepth - 1].y - bw;
+			}
+			else {
+				x = Event.xmotion.x_root - MenuOrigins[MenuDepth - 1].root_x
+				    - bw;
+				y = Event.xmotion.y_root - MenuOrigins[MenuDepth - 1].root_y
+				    - bw;
+			}
+		}
 
 		/* if we haven't received the enter notify yet, wait */
 		if(!ActiveMenu->entered) {
 			continue;
 		}
 
-		XFindContext(dpy, ActiveMenu->w, ScreenContext, (XPointer *)&Scr);
-
 		if(x < 0 || y < 0 ||
 		                x >= ActiveMenu->width || y >= ActiveMenu->height) {
 			if(ActiveItem && ActiveItem->func != F_TITLE) {
@@ -655,6 +830,9 @@ MenuRoot *NewMenuRoot(char *name)
 	tmp->w = None;
 	tmp->shadow = None;
 	tmp->real_menu = false;
+	tmp->wl_gen = 0;
+	tmp->normalPm = None;
+	tmp->hilitePm = None;
 
 	if(Scr->MenuList == NULL) {
 		Scr->MenuList = tmp;
@@ -792,15 +970,20 @@ MenuItem *AddToMenu(MenuRoot *menu, char *item, char *action,
 	}
 
 	if(dpy) {
-		XmbTextExtents(Scr->MenuFont.font_set,
-		               itemname, tmp->strlen,
-		               &ink_rect, &logical_rect);
+		FontTextExtents(&Scr->MenuFont,
+		                itemname, tmp->strlen,
+		                &ink_rect, &logical_rect);
 		width = logical_rect.width;
 	}
 	else {
 		// Fake for non-dpy cases
+		logical_rect.x = logical_rect.y = 0;
+		logical_rect.width = 25;
+		logical_rect.height = Scr->MenuFont.height;
 		width = 25;
 	}
+	// Painting and sizing the menu use these, and they don't change.
+	tmp->extents = logical_rect;
 
 	if(width <= 0) {
 		width = 1;
@@ -861,8 +1044,6 @@ void MakeMenu(MenuRoot *mr)
 	unsigned long valuemask;
 	XSetWindowAttributes attributes;
 	Colormap cmap = Scr->RootColormaps.cwins[0]->colormap->c;
-	XRectangle ink_rect;
-	XRectangle logical_rect;
 
 	Scr->EntryHeight = Scr->MenuFont.height + 4;
 
@@ -870,20 +1051,24 @@ void MakeMenu(MenuRoot *mr)
 	if(mr->mapped == MRM_NEVER) {
 		int max_entry_height = 0;
 
+		/*
+		 * A new window.  Any rendering we've got isn't ours; f.pin makes
+		 * a copy of the MenuRoot and then brings us here.
+		 */
+		mr->normalPm = mr->hilitePm = None;
+
 		if(mr->pull == true) {
 			mr->width += 16 + 10;
 		}
 		width = mr->width + 10;
 		for(cur = mr->first; cur != NULL; cur = cur->next) {
-			XmbTextExtents(Scr->MenuFont.font_set, cur->item, cur->strlen,
-			               &ink_rect, &logical_rect);
-			max_entry_height = MAX(max_entry_height, logical_rect.height);
+			max_entry_height = MAX(max_entry_height, cur->extents.height);
 
 			if(cur->func != F_TITLE) {
 				cur->x = 5;
 			}
 			else {
-				cur->x = width - logical_rect.width;
+				cur->x = width - cur->extents.width;
 				cur->x /= 2;
 			}
 		}
@@ -953,6 +1138,10 @@ void MakeMenu(MenuRoot *mr)
 
 		mr->mapped = MRM_UNMAPPED;
 	}
+	else {
+		/* Colors may be changing, so it needs redrawing */
+		MenuFreeRender(mr);
+	}
 
 	if(Scr->use3Dmenus && (Scr->Monochrome == COLOR)
 	                && (mr->highlight.back == UNUSED_PIXEL)) {
@@ -1153,6 +1342,37 @@ PopUpMenu(MenuRoot *menu, int x, int y, bool center)
 		icons = (menu == Scr->Icons);
 		visible_ = (menu == Scr->Visible);    /* Added by dl */
 		allicons = (menu == Scr->AllIcons);
+
+		ws = NULL;
+
+		if(!(all || allicons)
+		                && CurrentSelectedWorkspace && Scr->workSpaceManagerActive) {
+			for(ws = Scr->workSpaceMgr.workSpaceList; ws != NULL; ws = ws->next) {
+				if(strcmp(ws->name, CurrentSelectedWorkspace) == 0) {
+					break;
+				}
+			}
+		}
+		if(!Scr->currentvs) {
+			return false;
+		}
+		if(!ws) {
+			ws = Scr->currentvs->wsw->currentwspc;
+		}
+
+		func = (all || allicons || CurrentSelectedWorkspace) ? F_WINWARP :
+		       F_POPUP;
+
+		/*
+		 * If nothing it shows has changed since we last built it, what
+		 * we've already got will do fine.
+		 */
+		if(menu->w != None && menu->wl_gen == WindowListGeneration
+		                && menu->wl_ws == ws && menu->wl_vs == Scr->currentvs
+		                && menu->wl_func == func) {
+			goto build_done;
+		}
+
 		DestroyMenu(menu);
 
 		menu->first = NULL;
@@ -1178,23 +1398,6 @@ PopUpMenu(MenuRoot *menu, int x, int y, bool center)
 			AddToMenu(menu, "TWM All Windows", NULL, NULL, F_TITLE, NULL, NULL);
 		}
 
-		ws = NULL;
-
-		if(!(all || allicons)
-		                && CurrentSelectedWorkspace && Scr->workSpaceManagerActive) {
-			for(ws = Scr->workSpaceMgr.workSpaceList; ws != NULL; ws = ws->next) {
-				if(strcmp(ws->name, CurrentSelectedWorkspace) == 0) {
-					break;
-				}
-			}
-		}
-		if(!Scr->currentvs) {
-			return false;
-		}
-		if(!ws) {
-			ws = Scr->currentvs->wsw->currentwspc;
-		}
-
 		for(tmp_win = Scr->FirstWindow, WindowNameCount = 0;
 		                tmp_win != NULL;
 		                tmp_win = tmp_win->next) {
@@ -1273,8 +1476,6 @@ PopUpMenu(MenuRoot *menu, int x, int y, bool center)
 			WindowNames[WindowNameCount] = tmp_win2;
 			WindowNameCount++;
 		}
-		func = (all || allicons || CurrentSelectedWorkspace) ? F_WINWARP :
-		       F_POPUP;
 		for(i = 0; i < WindowNameCount; i++) {
 			char *tmpname;
 			tmpname = WindowNames[i]->name;
@@ -1285,7 +1486,13 @@ PopUpMenu(MenuRoot *menu, int x, int y, bool center)
 
 		menu->pinned = false;
 		MakeMenu(menu);
+
+		menu->wl_gen = WindowListGeneration;
+		menu->wl_ws = ws;
+		menu->wl_vs = Scr->currentvs;
+		menu->wl_func = func;
 	}
+build_done:
 
 	/* Keys added by dl */
 
@@ -1347,17 +1554,20 @@ PopUpMenu(MenuRoot *menu, int x, int y, bool center)
 		ActiveMenu    = menu;
 		menu->mapped  = MRM_MAPPED;
 		menu->entered = true;
-		MenuOrigins [MenuDepth].x = menu->x;
-		MenuOrigins [MenuDepth].y = menu->y;
+		SetMenuOrigin(MenuDepth, menu->x, menu->y);
 		MenuDepth++;
 
 		XRaiseWindow(dpy, menu->w);
 		return true;
 	}
 
+	/*
+	 * No PointerMotionHintMask; UpdateMenu() takes the position from
+	 * each motion event rather than asking for it.
+	 */
 	XGrabPointer(dpy, Scr->Root, True,
 	             ButtonPressMask | ButtonReleaseMask | PointerMotionMask |
-	             ButtonMotionMask | PointerMotionHintMask,
+	             ButtonMotionMask,
 	             GrabModeAsync, GrabModeAsync,
 	             Scr->Root,
 	             Scr->MenuCursor, CurrentTime);
@@ -1377,8 +1587,7 @@ PopUpMenu(MenuRoot *menu, int x, int y, bool center)
 	* clip to screen
 	*/
 	clipped = ConstrainByLayout(Scr->Layout, -1, &x, menu->width, &y, menu->height);
-	MenuOrigins[MenuDepth].x = x;
-	MenuOrigins[MenuDepth].y = y;
+	SetMenuOrigin(MenuDepth, x, y);
 	MenuDepth++;
 
 
@@ -1512,6 +1721,7 @@ static void DestroyMenu(MenuRoot *menu)
 		}
 		XDestroyWindow(dpy, menu->w);
 	}
+	MenuFreeRender(menu);
 
 	for(item = menu->first; item;) {
 		MenuItem *tmp = item;
@@ -1602,13 +1812,35 @@ void MoveMenu(XEvent *eventp)
 	XMoveWindow(dpy, ActiveMenu->w, newX, newY);
 	ActiveMenu->x = newX;
 	ActiveMenu->y = newY;
-	MenuOrigins [MenuDepth - 1].x = newX;
-	MenuOrigins [MenuDepth - 1].y = newY;
+	SetMenuOrigin(MenuDepth - 1, newX, newY);
 
 	return;
 }
 
 
+/*
+ * Note where a menu at the given depth is, in Scr->Root coordinates.
+ * We also keep where that is on the real root, for UpdateMenu(); when
+ * we're captive that's worked out now, since our window may have moved
+ * since we started.
+ */
+static void
+SetMenuOrigin(int depth, int x, int y)
+{
+	Window junk;
+
+	MenuOrigins[depth].x = x;
+	MenuOrigins[depth].y = y;
+	MenuOrigins[depth].root_x = x;
+	MenuOrigins[depth].root_y = y;
+	if(Scr->Root != Scr->RealRoot) {
+		XTranslateCoordinates(dpy, Scr->Root, Scr->RealRoot, x, y,
+		                      &MenuOrigins[depth].root_x,
+		                      &MenuOrigins[depth].root_y, &junk);
+	}
+}
+
+
 void WarpCursorToDefaultEntry(MenuRoot *menu)
 {
 	MenuItem    *item;
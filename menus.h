@@ -59,6 +59,7 @@ struct MenuItem {
 	short func;                 /* twm built in function */
 	bool  state;                /* in reversed video state (i.e., active) */
 	short strlen;               /* strlen(item) */
+	XRectangle extents;         /* logical XmbTextExtents() of item */
 	bool  user_colors;          /* colors were specified */
 	bool  separated;            /* separated from the next item */
 };
@@ -84,6 +85,12 @@ struct MenuRoot {
 	short x, y;                 /* position (for pinned menus) */
 	bool  pinned;               /* is this a pinned menu*/
 	struct MenuRoot *pmenu;     /* the associated pinned menu */
+	unsigned int wl_gen;        /* window list generation it shows */
+	WorkSpace *wl_ws;           /* ... for which workspace */
+	VirtualScreen *wl_vs;       /* ... on which vscreen */
+	int wl_func;                /* ... with what function on items */
+	Pixmap normalPm;            /* pre-rendered items, normal */
+	Pixmap hilitePm;            /* ... and all highlighted */
 };
 
 
@@ -106,6 +113,7 @@ struct FuncButton {
 
 struct FuncKey {
 	struct FuncKey *next;       /* next in the list of function keys */
+	struct FuncKey *hnext;      /* next in its ScreenInfo.FuncKeyHash chain */
 	char *name;                 /* key name */
 	KeySym keysym;              /* X keysym */
 	KeyCode keycode;            /* X keycode */
@@ -117,6 +125,16 @@ struct FuncKey {
 	MenuRoot *menu;             /* menu if func is F_MENU */
 };
 
+/*
+ * Key bindings are also hashed on (keycode, modifiers), so a key press
+ * only has to look at the bindings for that key.  Each chain keeps the
+ * same relative order as the FuncKeyRoot list.
+ */
+#define FUNCKEY_HASH_SIZE 256
+#define FUNCKEY_HASH(keycode, mods) \
+        (((unsigned int)(keycode) * 31u + (unsigned int)(mods)) \
+         & (FUNCKEY_HASH_SIZE - 1))
+
 extern MenuRoot *ActiveMenu;
 extern MenuItem *ActiveItem;
 
@@ -147,6 +165,7 @@ bool AddFuncKey(char *name, int cont, int mods, int func,
 void AddFuncButton(int num, int cont, int mods, int func,
                    MenuRoot *menu, MenuItem *item);
 void AddDefaultFuncButtons(void);
+void InvalidateWindowListMenus(void);
 void PopDownMenu(void);
 void HideMenu(MenuRoot *menu);
 void PaintEntry(MenuRoot *mr, MenuItem *mi, bool exposure);
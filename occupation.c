@@ -643,17 +643,17 @@ CreateOccupyWindow(void)
 		int bb_width, ws_width;
 
 		/* Buttons gotta be as wide as the biggest of the three strings */
-		XmbTextExtents(font.font_set, ok_string, strlen(ok_string),
-		               &inc_rect, &logical_rect);
+		FontTextExtents(&font, ok_string, strlen(ok_string),
+		                &inc_rect, &logical_rect);
 		bbwidth = logical_rect.width;
 
-		XmbTextExtents(font.font_set, cancel_string, strlen(cancel_string),
-		               &inc_rect, &logical_rect);
+		FontTextExtents(&font, cancel_string, strlen(cancel_string),
+		                &inc_rect, &logical_rect);
 		bbwidth = MAX(bbwidth, logical_rect.width);
 
-		XmbTextExtents(font.font_set, everywhere_string,
-		               strlen(everywhere_string),
-		               &inc_rect, &logical_rect);
+		FontTextExtents(&font, everywhere_string,
+		                strlen(everywhere_string),
+		                &inc_rect, &logical_rect);
 		bbwidth = MAX(bbwidth, logical_rect.width);
 
 		/* Plus the padding width */
@@ -816,16 +816,14 @@ CreateOccupyWindow(void)
 	{
 		unsigned long attrmask;
 		XSetWindowAttributes attr;
-		XWindowAttributes wattr;
 
 		attr.cursor = Scr->ButtonCursor;
 		attrmask = CWCursor;
 		XChangeWindowAttributes(dpy, w, attrmask, &attr);
 
-		XGetWindowAttributes(dpy, w, &wattr);
-		attrmask = wattr.your_event_mask | KeyPressMask | KeyReleaseMask
+		attrmask = get_event_mask(w) | KeyPressMask | KeyReleaseMask
 		           | ExposureMask;
-		XSelectInput(dpy, w, attrmask);
+		select_input(w, attrmask);
 	}
 
 
@@ -1189,6 +1187,13 @@ ChangeOccupation(TwmWindow *tmp_win, int newoccupation)
 	 */
 	oldoccupation = tmp_win->occupation;
 
+	/*
+	 * Vanishing/showing the window and setting the property below (and
+	 * the same for any transients) each mask out events on it; just
+	 * restore them once at the end.
+	 */
+	mask_batch_begin();
+
 	/*
 	 * Add it to IconManager in the new WS[en], remove from old.  We have
 	 * to do the rather odd dance because AddIconManager() loops through
@@ -1202,6 +1207,7 @@ ChangeOccupation(TwmWindow *tmp_win, int newoccupation)
 	AddIconManager(tmp_win);
 	tmp_win->occupation = newoccupation;
 	RemoveIconManager(tmp_win);
+	InvalidateWindowListMenus();
 
 	/* If it shouldn't be "here", vanish it */
 	if(tmp_win->vs && !OCCUPY(tmp_win, tmp_win->vs->wsw->currentwspc)) {
@@ -1331,6 +1337,7 @@ ChangeOccupation(TwmWindow *tmp_win, int newoccupation)
 	}
 
 	/* All done */
+	mask_batch_end();
 	return;
 }
 
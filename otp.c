@@ -16,6 +16,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <sys/time.h>
 #include <X11/Xatom.h>
 
 #include "otp.h"
@@ -36,12 +37,6 @@
 #define DPRINTF(x)
 #endif
 
-#if defined(NDEBUG)
-# define CHECK_OTP      0
-#else
-# define CHECK_OTP      1
-#endif
-
 /* number of priorities known to ctwm: [0..ONTOP_MAX] */
 #define OTP_ZERO 8
 #define OTP_MAX (OTP_ZERO * 2)
@@ -185,6 +180,55 @@ static Window WindowOfOwl(OtpWinList *owl)
 	       ? owl->twm_win->icon->w : owl->twm_win->frame;
 }
 
+/*
+ * Checking the OTP list against the X server.
+ *
+ * Verifying our idea of the stacking order against the server's takes an
+ * XQueryTree() round trip and a walk over every window, which is a lot
+ * to do on every raise/lower/workspace switch just for safety's sake.
+ * So (unless DEBUG_OTP is on, in which case it's done right away)
+ * OtpCheckConsistency() just notes that the stacking has changed, and
+ * OtpIdleCheck() gets around to checking it from the event loop when
+ * there's nothing else to do.  That's at most once per
+ * OTP_CHECK_INTERVAL ms, and only on screens with CheckStackingOrder
+ * set.  Anything found is counted and reported, rather than abort()'ing.
+ */
+#define OTP_CHECK_INTERVAL 2000
+
+/* Don't flood stderr if something's persistently wrong */
+#define OTP_CHECK_MAX_REPORTS 20
+
+static bool check_pending = false;
+static struct timeval last_check;
+static OtpCheckStats check_stats;
+
+static void
+OtpReportDivergence(const char *what, const TwmWindow *twm_win)
+{
+	check_stats.divergences++;
+	if(check_stats.divergences > OTP_CHECK_MAX_REPORTS) {
+		return;
+	}
+
+	if(twm_win != NULL) {
+		fprintf(stderr, "%s: stacking check: %s ('%s')\n", ProgramName,
+		        what, twm_win->name);
+	}
+	else {
+		fprintf(stderr, "%s: stacking check: %s\n", ProgramName, what);
+	}
+	if(check_stats.divergences == OTP_CHECK_MAX_REPORTS) {
+		fprintf(stderr, "%s: stacking check: not reporting any more\n",
+		        ProgramName);
+	}
+}
+
+
+/**
+ * Note that the stacking order has changed, so it can be checked.  With
+ * DEBUG_OTP this checks immediately; otherwise it's left for
+ * OtpIdleCheck().
+ */
 bool OtpCheckConsistency(void)
 {
 #if DEBUG_OTP
@@ -198,13 +242,86 @@ bool OtpCheckConsistency(void)
 	}
 	return result;
 #else
-	return OtpCheckConsistencyVS(Scr->currentvs, Scr->Root);
+	check_pending = true;
+	return true;
 #endif
 }
 
+
+/**
+ * Check the stacking order, if it's changed and we haven't done so
+ * recently.  Called from the main loop when the event queue is empty.
+ */
+void
+OtpIdleCheck(void)
+{
+	ScreenInfo *savedScr = Scr;
+	struct timeval now, done;
+	int scrnum;
+
+	if(!check_pending) {
+		return;
+	}
+
+	gettimeofday(&now, NULL);
+	if((now.tv_sec - last_check.tv_sec) * 1000
+	                + (now.tv_usec - last_check.tv_usec) / 1000
+	                < OTP_CHECK_INTERVAL) {
+		return;
+	}
+	check_pending = false;
+	last_check = now;
+
+	for(scrnum = 0; scrnum < NumScreens; scrnum++) {
+		if((Scr = ScreenList[scrnum]) == NULL || !Scr->CheckStackingOrder
+		                || Scr->currentvs == NULL) {
+			continue;
+		}
+		check_stats.checks++;
+		if(!OtpCheckConsistencyVS(Scr->currentvs, Scr->Root)) {
+			check_stats.failed++;
+		}
+	}
+	Scr = savedScr;
+
+	gettimeofday(&done, NULL);
+	{
+		double ms = (done.tv_sec - now.tv_sec) * 1000.0
+		            + (done.tv_usec - now.tv_usec) / 1000.0;
+		check_stats.total_ms += ms;
+		if(ms > check_stats.max_ms) {
+			check_stats.max_ms = ms;
+		}
+	}
+}
+
+
+/**
+ * Counts from the stacking checks.
+ */
+const OtpCheckStats *
+OtpGetCheckStats(void)
+{
+	return &check_stats;
+}
+
+
+/**
+ * Say how the stacking checks went, and what they cost.
+ */
+void
+OtpReport(FILE *out)
+{
+	fprintf(out, "Stacking checks: %lu screens checked, %lu didn't match "
+	        "(%lu problems)\n", check_stats.checks, check_stats.failed,
+	        check_stats.divergences);
+	fprintf(out, "  %.1f ms total, %.1f ms longest\n", check_stats.total_ms,
+	        check_stats.max_ms);
+}
+
+
 static bool OtpCheckConsistencyVS(VirtualScreen *currentvs, Window vroot)
 {
-#if CHECK_OTP
 	OtpWinList *owl;
 	TwmWindow *twm_win;
 	Window root, parent, *children;
@@ -212,8 +329,11 @@ static bool OtpCheckConsistencyVS(VirtualScreen *currentvs, Window vroot)
 	int priority = 0;
 	int stack = -1;
 	int nwins = 0;
+	bool ok = true;
 
-	XQueryTree(dpy, vroot, &root, &parent, &children, &nchildren);
+	if(!XQueryTree(dpy, vroot, &root, &parent, &children, &nchildren)) {
+		return true;
+	}
 
 #if DEBUG_OTP
 	{
@@ -231,15 +351,20 @@ static bool OtpCheckConsistencyVS(VirtualScreen *currentvs, Window vroot)
 		twm_win = owl->twm_win;
 
 		/* check the back arrows are correct */
-		assert(((owl->type == IconWin) && (owl == twm_win->icon->otp))
-		       || ((owl->type == WinWin) && (owl == twm_win->otp)));
+		if(!(((owl->type == IconWin) && twm_win->icon
+		                && (owl == twm_win->icon->otp))
+		                || ((owl->type == WinWin) && (owl == twm_win->otp)))) {
+			OtpReportDivergence("OTP entry doesn't match its window", twm_win);
+			ok = false;
+			break;
+		}
 
 		/* check the doubly linked list's consistency */
-		if(owl->below == NULL) {
-			assert(owl == Scr->bottomOwl);
-		}
-		else {
-			assert(owl->below->above == owl);
+		if(owl->below == NULL ? (owl != Scr->bottomOwl)
+		                : (owl->below->above != owl)) {
+			OtpReportDivergence("OTP list links broken", twm_win);
+			ok = false;
+			break;
 		}
 
 		/* Code already ensures this */
@@ -249,13 +374,17 @@ static bool OtpCheckConsistencyVS(VirtualScreen *currentvs, Window vroot)
 		{
 			const int nextpri = PRI(owl);
 			if(nextpri < priority) {
-				fprintf(stderr, "%s(): Priority went backward "
-				        "(%d:'%s' -> %d:'%s')\n",
-				        __func__,
-				        priority, owl->below->twm_win->name,
-				        nextpri, owl->twm_win->name);
-				OwlPrettyPrint(Scr->bottomOwl);
-				abort();
+				if(check_stats.divergences < OTP_CHECK_MAX_REPORTS) {
+					fprintf(stderr, "%s(): Priority went backward "
+					        "(%d:'%s' -> %d:'%s')\n",
+					        __func__,
+					        priority, owl->below->twm_win->name,
+					        nextpri, owl->twm_win->name);
+					OwlPrettyPrint(Scr->bottomOwl);
+				}
+				OtpReportDivergence("priority went backward", twm_win);
+				ok = false;
+				break;
 			}
 			priority = nextpri;
 		}
@@ -332,23 +461,33 @@ static bool OtpCheckConsistencyVS(VirtualScreen *currentvs, Window vroot)
 				stack++;
 				DPRINTF((stderr, "stack++: children[%d] = %x\n", stack,
 				         (unsigned int)children[stack]));
-				assert(stack < nchildren);
 			}
-			while(windowOfOwl != children[stack]);
+			while(stack < (int)nchildren && windowOfOwl != children[stack]);
+			if(stack >= (int)nchildren) {
+				OtpReportDivergence("window out of place in server stack",
+				                    twm_win);
+				ok = false;
+				break;
+			}
 #endif /* DEBUG_OTP */
 		}
 	}
 
 	XFree(children);
 
-	/* by decrementing nwins, check that all the wins are in our list */
-	for(twm_win = Scr->FirstWindow; twm_win != NULL; twm_win = twm_win->next) {
-		nwins--;
+	if(ok) {
+		/* by decrementing nwins, check that all the wins are in our list */
+		for(twm_win = Scr->FirstWindow; twm_win != NULL; twm_win = twm_win->next) {
+			nwins--;
+		}
+		/* if we just removed a win, it might still be somewhere, hence the -1 */
+		if(!((nwins <= 0) && (nwins >= -1))) {
+			OtpReportDivergence("OTP list and window list differ in size", NULL);
+			ok = false;
+		}
 	}
-	/* if we just removed a win, it might still be somewhere, hence the -1 */
-	assert((nwins <= 0) && (nwins >= -1));
-#endif
-	return true;
+
+	return ok;
 }
 
 
@@ -838,15 +977,15 @@ void OtpTinyLower(TwmWindow *twm_win, WinType wintype)
 void OtpCirculateSubwindows(VirtualScreen *vs, int direction)
 {
 	Window w = vs->window;
-	XWindowAttributes winattrs;
+	long eventMask;
 	Bool circulated;
 
 	DPRINTF((stderr, "OtpCirculateSubwindows %d\n", direction));
 
-	XGetWindowAttributes(dpy, w, &winattrs);
-	XSelectInput(dpy, w, winattrs.your_event_mask | SubstructureNotifyMask);
+	eventMask = get_event_mask(w);
+	select_input(w, eventMask | SubstructureNotifyMask);
 	XCirculateSubwindows(dpy, w, direction);
-	XSelectInput(dpy, w, winattrs.your_event_mask);
+	select_input(w, eventMask);
 	/*
 	 * Now we should get the CirculateNotify event.
 	 * It usually seems to arrive soon enough, but just to be sure, look
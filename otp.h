@@ -10,6 +10,8 @@
 #ifndef _CTWM_OTP_H
 #define _CTWM_OTP_H
 
+#include <stdio.h>  // For FILE
+
 /* kind of window */
 typedef enum WinType { WinWin, IconWin } WinType;
 
@@ -87,6 +89,19 @@ int OtpEffectivePriority(TwmWindow *twm_win);
 bool OtpIsFocusDependent(TwmWindow *twm_win);
 
 /* Other debugging functions */
+
+/// Counts from the idle-time stacking order checks
+typedef struct OtpCheckStats {
+	unsigned long checks;       ///< Screens checked against the server
+	unsigned long failed;       ///< ... and found not to match
+	unsigned long divergences;  ///< Problems reported
+	double total_ms;            ///< Total time spent in OtpIdleCheck()
+	double max_ms;              ///< Longest single OtpIdleCheck()
+} OtpCheckStats;
+
 bool OtpCheckConsistency(void);
+void OtpIdleCheck(void);
+const OtpCheckStats *OtpGetCheckStats(void);
+void OtpReport(FILE *out);
 
 #endif /* _CTWM_OTP_H */
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/time.h>
 #ifdef USEM4
 # include <sys/types.h>
 # include <sys/wait.h>
@@ -92,12 +93,16 @@ static int overflowlen;
 int ConstrainedMoveTime = 400;          /* milliseconds, event times */
 bool ParseError;                        /* error parsing the .twmrc file */
 int RaiseDelay = 0;                     /* msec, for AutoRaise */
+int LowerDelay = 0;                     /* msec, for AutoLower */
 int (*twmInputFunc)(void);              /* used in lexer */
 
 static int twmrc_lineno;
 
+static TwmrcLoadInfo loadinfo;
+
 
 /* Actual file loader */
+static bool TryTwmrcs(const char *filename);
 static int ParseTwmrc(const char *filename);
 
 /* lex plumbing funcs */
@@ -118,11 +123,8 @@ int yydebug = 1;
 
 /**
  * Principal entry point from top-level code to parse the config file.
- * This tries the various permutations of config files we could load.
- * For most possible names, we try loading `$NAME.$SCREENNUM` before
- * trying `$NAME`.  If a `-f filename` is given on the command line, it's
- * passed in here, and the normal `~/.[c]twmrc*` attempts are skipped if
- * it's not found.
+ * See TryTwmrcs() for where we look.  How long it took and such are
+ * available after from LoadTwmrcInfo().
  *
  * \param filename A filename given in the -f command-line argument (or
  * NULL)
@@ -131,6 +133,40 @@ int yydebug = 1;
  */
 bool
 LoadTwmrc(const char *filename)
+{
+	struct timeval start, end;
+	bool ok;
+
+	loadinfo.m4cache = NULL;
+	gettimeofday(&start, NULL);
+	ok = TryTwmrcs(filename);
+	gettimeofday(&end, NULL);
+	loadinfo.ms = (end.tv_sec - start.tv_sec) * 1000.0
+	              + (end.tv_usec - start.tv_usec) / 1000.0;
+
+	return ok;
+}
+
+
+/**
+ * Details of the last LoadTwmrc().
+ */
+const TwmrcLoadInfo *
+LoadTwmrcInfo(void)
+{
+	return &loadinfo;
+}
+
+
+/**
+ * This tries the various permutations of config files we could load.
+ * For most possible names, we try loading `$NAME.$SCREENNUM` before
+ * trying `$NAME`.  If a `-f filename` is given on the command line, it's
+ * passed in here, and the normal `~/.[c]twmrc*` attempts are skipped if
+ * it's not found.
+ */
+static bool
+TryTwmrcs(const char *filename)
 {
 	int ret = -1;
 	char *tryname = NULL;
@@ -263,12 +299,20 @@ ParseTwmrc(const char *filename)
 		 * swap twmrc over to the output from m4
 		 */
 		raw = twmrc;
-		twmrc = start_m4(raw);
+		twmrc = start_m4(raw, filename);
+		loadinfo.m4cache = m4_cache_result();
+		if(twmrc == NULL) {
+			fprintf(stderr, "%s:  unable to read m4 output for %s\n",
+			        ProgramName, filename);
+			fclose(raw);
+			return false;
+		}
 	}
 	status = doparse(m4twmFileInput, "file", filename);
 	fclose(twmrc);
 	if(raw) {
 		fclose(raw);
+		m4_cache_done(status);
 	}
 #else
 	status = doparse(twmFileInput, "file", filename);
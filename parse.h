@@ -20,12 +20,20 @@
 extern unsigned int mods_used;
 extern int ConstrainedMoveTime;
 extern int RaiseDelay;
+extern int LowerDelay;
 extern bool ParseError;    /* error parsing the .twmrc file */
 
 /* Needed in the lexer */
 extern int (*twmInputFunc)(void);
 
+/// How the last LoadTwmrc() went, for --cfgchk to report
+typedef struct TwmrcLoadInfo {
+	double ms;               ///< Time spent finding, m4'ing, and parsing
+	const char *m4cache;     ///< What the m4 output cache did, or NULL
+} TwmrcLoadInfo;
+
 bool LoadTwmrc(const char *filename);
+const TwmrcLoadInfo *LoadTwmrcInfo(void);
 void twmrc_error_prefix(void);
 
 /*
@@ -131,6 +131,9 @@ typedef struct _TwmKeyword {
 #define kw0_GrabServer                  76
 #define kw0_DontNameDecorations         77
 #define kw0_StrictWinNameEncoding       78
+#define kw0_ScaleEWMHIcons              79
+#define kw0_DirectExec                  80
+#define kw0_CheckStackingOrder          81
 
 #define kws_UsePPosition                1
 #define kws_IconFont                    2
@@ -194,6 +197,8 @@ typedef struct _TwmKeyword {
 #define kwn_BorderLeft                  35
 #define kwn_BorderRight                 36
 
+#define kwn_LowerDelay                  37
+
 #define kwcl_BorderColor                1
 #define kwcl_IconManagerHighlight       2
 #define kwcl_BorderTileForeground       3
@@ -232,10 +237,12 @@ static const TwmKeyword keytable[] = {
 	{ "animationspeed",         NKEYWORD, kwn_AnimationSpeed },
 	{ "autofocustotransients",  KEYWORD, kw0_AutoFocusToTransients }, /* kai */
 	{ "autolower",              AUTO_LOWER, 0 },
+	{ "autolowerdelay",         AUTO_LOWER_DELAY, 0 },
 	{ "autooccupy",             KEYWORD, kw0_AutoOccupy },
 	{ "autopopup",              AUTO_POPUP, 0 },
 	{ "autopriority",           KEYWORD, kw0_AutoPriority },
 	{ "autoraise",              AUTO_RAISE, 0 },
+	{ "autoraisedelay",         AUTO_RAISE_DELAY, 0 },
 	{ "autoraiseicons",         KEYWORD, kw0_AutoRaiseIcons },
 	{ "autorelativeresize",     KEYWORD, kw0_AutoRelativeResize },
 	{ "autosqueeze",            AUTOSQUEEZE, 0 },
@@ -257,6 +264,7 @@ static const TwmKeyword keytable[] = {
 	{ "center",                 SIJENUM, SIJ_CENTER },
 	{ "centerfeedbackwindow",   KEYWORD, kw0_CenterFeedbackWindow },
 	{ "changeworkspacefunction", CHANGE_WORKSPACE_FUNCTION, 0 },
+	{ "checkstackingorder",     KEYWORD, kw0_CheckStackingOrder },
 	{ "clearshadowcontrast",    NKEYWORD, kwn_ClearShadowContrast },
 	{ "clicktofocus",           KEYWORD, kw0_ClickToFocus },
 	{ "clientborderwidth",      KEYWORD, kw0_ClientBorderWidth },
@@ -271,6 +279,7 @@ static const TwmKeyword keytable[] = {
 	{ "defaultfunction",        DEFAULT_FUNCTION, 0 },
 	{ "deiconifyfunction",      DEICONIFY_FUNCTION, 0 },
 	{ "destroy",                KILL, 0 },
+	{ "directexec",             KEYWORD, kw0_DirectExec },
 	{ "donticonifybyunmapping", DONT_ICONIFY_BY_UNMAPPING, 0 },
 	{ "dontmoveoff",            KEYWORD, kw0_DontMoveOff },
 	{ "dontnamedecorations",    KEYWORD, kw0_DontNameDecorations },
@@ -327,6 +336,7 @@ static const TwmKeyword keytable[] = {
 	{ "left",                   SIJENUM, SIJ_LEFT },
 	{ "lefttitlebutton",        LEFT_TITLEBUTTON, 0 },
 	{ "lock",                   LOCK, 0 },
+	{ "lowerdelay",             NKEYWORD, kwn_LowerDelay },
 	{ "m",                      META, 0 },
 	{ "maketitle",              MAKE_TITLE, 0 },
 	{ "mapwindowbackground",    CLKEYWORD, kwcl_MapWindowBackground },
@@ -413,6 +423,7 @@ static const TwmKeyword keytable[] = {
 	{ "s",                      SHIFT, 0 },
 	{ "savecolor",              SAVECOLOR, 0},
 	{ "saveworkspacefocus",     KEYWORD, kw0_SaveWorkspaceFocus },
+	{ "scaleewmhicons",         KEYWORD, kw0_ScaleEWMHIcons },
 	{ "schrinkicontitles",      KEYWORD, kw0_ShrinkIconTitles },
 	{ "select",                 SELECT, 0 },
 	{ "shift",                  SHIFT, 0 },
@@ -885,6 +896,20 @@ do_single_keyword(int keyword)
 			Scr->StrictWinNameEncoding = true;
 			return true;
 
+		case kw0_ScaleEWMHIcons:
+#ifdef EWMH
+			Scr->ScaleEWMHIcons = true;
+#endif
+			return true;
+
+		case kw0_DirectExec:
+			Scr->DirectExec = true;
+			return true;
+
+		case kw0_CheckStackingOrder:
+			Scr->CheckStackingOrder = true;
+			return true;
+
 	}
 	return false;
 }
@@ -1254,6 +1279,10 @@ do_number_keyword(int keyword, int num)
 			RaiseDelay = num;
 			return true;
 
+		case kwn_LowerDelay:
+			LowerDelay = num;
+			return true;
+
 		case kwn_TransientOnTop:
 			if(Scr->FirstTime) {
 				Scr->TransientOnTop = num;
@@ -1934,6 +1963,34 @@ do_squeeze_entry(name_list **slist, // squeeze or dont-squeeze list
 }
 
 
+/*
+ * An entry in AutoRaiseDelay { } or AutoLowerDelay { }
+ */
+void
+do_delay_entry(name_list **dlist, const char *name, int ms)
+{
+	int *delay;
+
+	if(ms < 0) {
+		twmrc_error_prefix();
+		fprintf(stderr, "negative delay %d for \"%s\"\n", ms, name);
+		ParseError = true;
+		return;
+	}
+
+	delay = malloc(sizeof(int));
+	if(!delay) {
+		twmrc_error_prefix();
+		fprintf(stderr, "unable to allocate %lu bytes for delay\n",
+		        (unsigned long) sizeof(int));
+		ParseError = true;
+		return;
+	}
+	*delay = ms;
+	AddToList(dlist, name, delay);
+}
+
+
 /*
  * Parsing for EWMHIgnore { } lists
  */
@@ -21,6 +21,7 @@ void do_squeeze_entry(name_list **list,  /* squeeze or dont-squeeze list */
                       int num,           /* signed num */
                       int denom          /* 0 or indicates fraction denom */
                      );
+void do_delay_entry(name_list **list, const char *name, int ms);
 void proc_ewmh_ignore(void);
 void add_ewmh_ignore(char *s);
 void proc_mwm_ignore(void);
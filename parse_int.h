@@ -6,7 +6,9 @@
 
 /* Stuff in parse_m4.c, if enabled */
 #ifdef USEM4
-FILE *start_m4(FILE *fraw);
+FILE *start_m4(FILE *fraw, const char *filename);
+void m4_cache_done(bool ok);
+const char *m4_cache_result(void);
 #endif
 
 #endif /* _CTWM_PARSE_INT_H */
@@ -6,8 +6,12 @@
 #include "ctwm.h"
 
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <netdb.h>
 #include <pwd.h>
@@ -18,21 +22,87 @@
 #include "version.h"
 
 
-static char *m4_defs(Display *display, const char *host);
+static char *m4_defs(Display *display, const char *host, uint64_t *hash);
+static FILE *cache_lookup(FILE *fraw, const char *filename, uint64_t key);
+static FILE *cache_fill(FILE *m4out, FILE *cached);
+
+
+/*
+ * Caching of m4's output.
+ *
+ * Running the config through m4 means a fork/exec and m4 chewing through
+ * the whole thing on every startup and f.restart, though the result
+ * hardly ever changes.  So we keep the output in $XDG_CACHE_HOME/ctwm
+ * (or ~/.cache/ctwm), keyed on a hash of the config file, the
+ * definitions we hand m4 (which cover the host, user, ctwm version, and
+ * X server and screen particulars), and the m4 we'd run.  If they all
+ * match next time, we parse the saved output and skip m4 entirely.
+ *
+ * m4 can also read other files or run commands, which we can't see
+ * into, so configs that look like they might do that are never cached.
+ * --cfgchk never uses or updates the cache, but does check whether
+ * what's there matches what m4 gives now.
+ */
+#define CACHE_MAGIC "ctwm-m4-cache"
+
+/* m4 builtins that bring in things we can't hash */
+static const char *uncacheable_words[] = {
+	"include", "syscmd", "maketemp", "mkstemp", "undivert", NULL
+};
+
+static struct {
+	char *path;             ///< Where this config's cache file lives
+	char *tmppath;          ///< New one being written, if any
+	uint64_t key;           ///< Hash of everything that went into it
+	const char *result;     ///< What happened, for reporting
+} m4cache;
+
+
+static uint64_t
+hash_bytes(uint64_t h, const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+
+	while(len--) {
+		h ^= *p++;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+#define HASH_INIT 0xcbf29ce484222325ULL
 
 
 /*
  * Primary entry point to do m4 parsing of a startup file
  */
 FILE *
-start_m4(FILE *fraw)
+start_m4(FILE *fraw, const char *filename)
 {
 	int fids[2];
 	int fres;
 	char *defs_file;
+	uint64_t key;
+	FILE *cached = NULL;
 
 	/* Write our our standard definitions into a temp file */
-	defs_file = m4_defs(dpy, CLarg.display_name);
+	defs_file = m4_defs(dpy, CLarg.display_name, &key);
+
+	/* Maybe we've seen this all before */
+	free(m4cache.path);
+	m4cache.path = NULL;
+	m4cache.result = "off";
+	if(CLarg.UseM4Cache) {
+		cached = cache_lookup(fraw, filename, key);
+		if(cached && !CLarg.cfgchk) {
+			/* m4 won't be reading it, so won't be deleting it either */
+			if(!CLarg.KeepTmpFile) {
+				unlink(defs_file);
+			}
+			free(defs_file);
+			m4cache.result = "hit";
+			return cached;
+		}
+	}
 
 	/* We'll read back m4's output over a pipe */
 	pipe(fids);
@@ -72,11 +142,271 @@ start_m4(FILE *fraw)
 	}
 
 	/*
-	 * Else we're the parent; hand back our reading end of the pipe.
+	 * Else we're the parent; hand back our reading end of the pipe, or
+	 * a copy of what comes out of it if we're caching.
 	 */
 	close(fids[1]);
 	free(defs_file);
-	return (fdopen(fids[0], "r"));
+	if(m4cache.path == NULL) {
+		return (fdopen(fids[0], "r"));
+	}
+	return cache_fill(fdopen(fids[0], "r"), cached);
+}
+
+
+/**
+ * Finish up caching after parsing a config from start_m4().  If it
+ * parsed OK, the output we saved becomes the cache for next time.
+ */
+void
+m4_cache_done(bool ok)
+{
+	if(m4cache.tmppath == NULL) {
+		return;
+	}
+	if(!ok || rename(m4cache.tmppath, m4cache.path) != 0) {
+		unlink(m4cache.tmppath);
+	}
+	free(m4cache.tmppath);
+	m4cache.tmppath = NULL;
+}
+
+
+/**
+ * What the m4 cache did for the last start_m4(): "hit", "miss", "off",
+ * "uncacheable", or with --cfgchk "valid" or "stale" for whether the
+ * cache matched m4's current output.
+ */
+const char *
+m4_cache_result(void)
+{
+	return m4cache.result;
+}
+
+
+/*
+ * Where cache files go, creating it if necessary.  NULL if there's
+ * nowhere usable.
+ */
+static char *
+cache_dir(void)
+{
+	const char *base = getenv("XDG_CACHE_HOME");
+	char *dir = NULL;
+
+	if(base != NULL && *base == '/') {
+		asprintf(&dir, "%s/ctwm", base);
+	}
+	else if(Home != NULL && *Home == '/') {
+		char *dotcache = NULL;
+
+		asprintf(&dotcache, "%s/.cache", Home);
+		if(dotcache == NULL) {
+			return NULL;
+		}
+		if(mkdir(dotcache, 0700) != 0 && errno != EEXIST) {
+			free(dotcache);
+			return NULL;
+		}
+		asprintf(&dir, "%s/ctwm", dotcache);
+		free(dotcache);
+	}
+	if(dir == NULL) {
+		return NULL;
+	}
+	if(mkdir(dir, 0700) != 0 && errno != EEXIST) {
+		free(dir);
+		return NULL;
+	}
+	return dir;
+}
+
+
+/*
+ * Finish the cache key with the config file's contents, figure where
+ * its cache file is, and open it if it's there and current.  If the
+ * config can be cached at all, m4cache.path is set.  Leaves fraw
+ * rewound for m4 to read.
+ */
+static FILE *
+cache_lookup(FILE *fraw, const char *filename, uint64_t key)
+{
+	char *buf = NULL, *dir;
+	size_t len = 0, size = 0;
+	uint64_t slot;
+	FILE *cf;
+	char hdr[64], want[64];
+	int i;
+
+	/* Slurp the whole config */
+	while(!feof(fraw) && !ferror(fraw)) {
+		if(size - len < 4096) {
+			char *nbuf = realloc(buf, size + 65536);
+			if(nbuf == NULL) {
+				free(buf);
+				rewind(fraw);
+				return NULL;
+			}
+			buf = nbuf;
+			size += 65536;
+		}
+		len += fread(buf + len, 1, size - len - 1, fraw);
+	}
+	rewind(fraw);
+	if(buf == NULL) {
+		return NULL;
+	}
+	buf[len] = '\0';
+
+	for(i = 0; uncacheable_words[i] != NULL; i++) {
+		if(strstr(buf, uncacheable_words[i]) != NULL) {
+			free(buf);
+			m4cache.result = "uncacheable";
+			return NULL;
+		}
+	}
+	key = hash_bytes(key, buf, len);
+	key = hash_bytes(key, M4CMD, strlen(M4CMD));
+	free(buf);
+
+	/* Each config file (per screen) gets one cache file */
+	dir = cache_dir();
+	if(dir == NULL) {
+		return NULL;
+	}
+	slot = hash_bytes(HASH_INIT, filename, strlen(filename));
+	slot = hash_bytes(slot, &Scr->screen, sizeof(Scr->screen));
+	asprintf(&m4cache.path, "%s/m4-%016llx", dir, (unsigned long long)slot);
+	free(dir);
+	if(m4cache.path == NULL) {
+		return NULL;
+	}
+	m4cache.key = key;
+	m4cache.result = "miss";
+
+	/* See if what's there is for this exact input */
+	snprintf(want, sizeof(want), "%s %016llx\n", CACHE_MAGIC,
+	         (unsigned long long)key);
+	cf = fopen(m4cache.path, "r");
+	if(cf == NULL) {
+		return NULL;
+	}
+	if(fgets(hdr, sizeof(hdr), cf) == NULL || strcmp(hdr, want) != 0) {
+		fclose(cf);
+		return NULL;
+	}
+	return cf;
+}
+
+
+/*
+ * Copy m4's output into a new cache file, and hand that back to be
+ * parsed.  If we had a matching cache file (only in --cfgchk mode), see
+ * whether it's still right, and don't write anything.
+ */
+static FILE *
+cache_fill(FILE *m4out, FILE *cached)
+{
+	char buf[8192];
+	char *line = NULL;
+	size_t n, linesize = 0;
+	ssize_t ll;
+	FILE *tmp;
+	long start;
+	int fd;
+
+	if(m4out == NULL) {
+		if(cached) {
+			fclose(cached);
+		}
+		return NULL;
+	}
+	if(CLarg.cfgchk && cached == NULL) {
+		/* Nothing to check against, and we don't write */
+		return m4out;
+	}
+
+	/*
+	 * Where the new output goes.  For --cfgchk that's just a scratch
+	 * file, otherwise it's the next cache file.
+	 */
+	free(m4cache.tmppath);
+	m4cache.tmppath = NULL;
+	if(CLarg.cfgchk) {
+		tmp = tmpfile();
+	}
+	else {
+		asprintf(&m4cache.tmppath, "%s.XXXXXX", m4cache.path);
+		if(m4cache.tmppath == NULL) {
+			return m4out;
+		}
+		fd = mkstemp(m4cache.tmppath);
+		tmp = (fd >= 0) ? fdopen(fd, "w+") : NULL;
+	}
+	if(tmp == NULL) {
+		free(m4cache.tmppath);
+		m4cache.tmppath = NULL;
+		if(cached) {
+			fclose(cached);
+		}
+		return m4out;
+	}
+
+	/* Header, then everything m4 says */
+	fprintf(tmp, "%s %016llx\n", CACHE_MAGIC, (unsigned long long)m4cache.key);
+	start = ftell(tmp);
+	while((ll = getline(&line, &linesize, m4out)) > 0) {
+		int lineno;
+
+		/*
+		 * m4's sync lines name the (randomly named) defs file; only
+		 * the line number matters to us, so drop the rest.
+		 */
+		if(sscanf(line, "#line %d", &lineno) == 1) {
+			fprintf(tmp, "#line %d\n", lineno);
+		}
+		else {
+			fwrite(line, 1, ll, tmp);
+		}
+	}
+	free(line);
+	fclose(m4out);
+	fflush(tmp);
+
+	/* --cfgchk: does the cache have it right? */
+	if(cached) {
+		char buf2[sizeof(buf)];
+		size_t n2;
+		bool same = true;
+
+		fseek(tmp, start, SEEK_SET);
+		do {
+			n = fread(buf, 1, sizeof(buf), tmp);
+			n2 = fread(buf2, 1, sizeof(buf2), cached);
+			if(n != n2 || memcmp(buf, buf2, n) != 0) {
+				same = false;
+				break;
+			}
+		}
+		while(n > 0);
+		fclose(cached);
+		m4cache.result = same ? "valid" : "stale";
+	}
+
+	if(ferror(tmp)) {
+		/*
+		 * Out of disk or some such; don't keep a truncated copy.  We
+		 * can only parse what we've got though.  (There's no copy
+		 * being written in --cfgchk mode.)
+		 */
+		if(m4cache.tmppath) {
+			unlink(m4cache.tmppath);
+			free(m4cache.tmppath);
+			m4cache.tmppath = NULL;
+		}
+	}
+	fseek(tmp, start, SEEK_SET);
+	return tmp;
 }
 
 
@@ -85,10 +415,11 @@ start_m4(FILE *fraw)
 
 /*
  * Writes out a temp file of all the m4 defs appropriate for this run,
- * and returns the file name
+ * and returns the file name.  *hash gets a hash of the defs, for the
+ * m4 output cache.
  */
 static char *
-m4_defs(Display *display, const char *host)
+m4_defs(Display *display, const char *host, uint64_t *hash)
 {
 	char client[MAXHOSTNAME];
 	char *vc, *color;
@@ -297,6 +628,9 @@ m4_defs(Display *display, const char *host)
 #endif
 #ifdef XRANDR
 	WR_DEF("XRANDR", "Yes");
+#endif
+#ifdef XFT
+	WR_DEF("XFT", "Yes");
 #endif
 	/* Since this is no longer an option, it should be removed in the future */
 	WR_DEF("I18N", "Yes");
@@ -304,6 +638,20 @@ m4_defs(Display *display, const char *host)
 #undef WR_NUM
 #undef WR_DEF
 
+	/* Hash it all, for the cache key */
+	{
+		char buf[4096];
+		size_t n;
+
+		*hash = HASH_INIT;
+		fflush(tmpf);
+		rewind(tmpf);
+		while((n = fread(buf, 1, sizeof(buf), tmpf)) > 0) {
+			*hash = hash_bytes(*hash, buf, n);
+		}
+		fseek(tmpf, 0, SEEK_END);
+	}
+
 
 	/*
 	 * We might be keeping it, in which case tell the user where it is;
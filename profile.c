@@ -0,0 +1,313 @@
+/*
+ * Startup phase profiling
+ *
+ * With --profile-startup, ctwm_main() marks off the phases of startup
+ * (opening the display, reading the config, making menus and icon
+ * managers, adopting the windows already on the screen, ...) and we
+ * record how much wall time and how many X requests and round trips
+ * each took, plus the same for every window adopted.  The report goes
+ * to stderr once startup is done, or at exit if we never get that far.
+ *
+ * Xlib doesn't count round trips for us, so we install an "after
+ * function", which Xlib calls after each call that sends a request.  If
+ * at that point the server has already processed the last request we
+ * sent, we must have waited for its reply; that's a round trip.
+ */
+
+#include "ctwm.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "profile.h"
+
+
+/* How many of the slowest windows to list */
+#define PROFILE_SLOWEST 10
+
+typedef struct ProfileCounts {
+	double ms;
+	unsigned long requests;
+	unsigned long roundtrips;
+} ProfileCounts;
+
+typedef struct ProfilePhaseInfo {
+	const char *name;
+	int calls;          ///< Times we went through it (once per screen...)
+	ProfileCounts c;
+} ProfilePhaseInfo;
+
+typedef struct ProfileWindowInfo {
+	Window w;
+	ProfileCounts c;
+} ProfileWindowInfo;
+
+static bool enabled = false;
+static bool reported = false;
+static int (*prevAfter)(Display *);
+static bool hooked = false;
+
+static unsigned long roundtrips;
+static unsigned long lastProcessed;
+
+static struct timeval startTime;
+
+static ProfilePhaseInfo *phases;
+static int nphases, phasesSize;
+static ProfilePhaseInfo *curPhase;
+static ProfileCounts phaseStart;
+
+static ProfileWindowInfo *windows;
+static int nwindows, windowsSize;
+static ProfileCounts windowStart;
+
+
+/*
+ * Xlib after function: note round trips.
+ */
+static int
+afterHook(Display *d)
+{
+	unsigned long processed = LastKnownRequestProcessed(d);
+
+	if(processed != lastProcessed && processed == NextRequest(d) - 1) {
+		roundtrips++;
+	}
+	lastProcessed = processed;
+
+	if(prevAfter != NULL) {
+		return prevAfter(d);
+	}
+	return 0;
+}
+
+
+/*
+ * Where the counters are at now.
+ */
+static void
+snapshot(ProfileCounts *pc)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	pc->ms = (now.tv_sec - startTime.tv_sec) * 1000.0
+	         + (now.tv_usec - startTime.tv_usec) / 1000.0;
+	pc->requests = dpy ? NextRequest(dpy) : 0;
+	pc->roundtrips = roundtrips;
+}
+
+static void
+addSince(ProfileCounts *total, const ProfileCounts *since)
+{
+	ProfileCounts now;
+
+	snapshot(&now);
+	total->ms += now.ms - since->ms;
+	total->requests += now.requests - since->requests;
+	total->roundtrips += now.roundtrips - since->roundtrips;
+}
+
+
+static void
+atexitReport(void)
+{
+	if(enabled && !reported) {
+		ProfilePhase(NULL);
+		ProfileReport(stderr);
+	}
+}
+
+
+/**
+ * Turn on profiling.  Does nothing unless --profile-startup was given.
+ */
+void
+ProfileStart(void)
+{
+	if(!CLarg.ProfileStartup || enabled) {
+		return;
+	}
+	enabled = true;
+	gettimeofday(&startTime, NULL);
+	atexit(atexitReport);
+}
+
+
+/**
+ * End the current phase (if any) and start counting toward a new one.
+ * Phases with the same name (e.g., for each screen) are added together.
+ * NULL just ends the current one.
+ */
+void
+ProfilePhase(const char *name)
+{
+	if(!enabled) {
+		return;
+	}
+
+	// Hook into Xlib as soon as there's a connection to hook
+	if(dpy && !hooked) {
+		prevAfter = XSetAfterFunction(dpy, afterHook);
+		lastProcessed = LastKnownRequestProcessed(dpy);
+		hooked = true;
+		// The connection was made during the current phase, so
+		// requests are counted from here.
+		phaseStart.requests = NextRequest(dpy);
+	}
+
+	if(curPhase != NULL) {
+		curPhase->calls++;
+		addSince(&curPhase->c, &phaseStart);
+		curPhase = NULL;
+	}
+	if(name == NULL) {
+		return;
+	}
+
+	for(int i = 0; i < nphases; i++) {
+		if(strcmp(phases[i].name, name) == 0) {
+			curPhase = &phases[i];
+			break;
+		}
+	}
+	if(curPhase == NULL) {
+		if(nphases == phasesSize) {
+			int nsize = phasesSize ? phasesSize * 2 : 32;
+			ProfilePhaseInfo *n = realloc(phases, nsize * sizeof(*n));
+			if(n == NULL) {
+				return;
+			}
+			phases = n;
+			phasesSize = nsize;
+		}
+		curPhase = &phases[nphases++];
+		memset(curPhase, 0, sizeof(*curPhase));
+		curPhase->name = name;
+	}
+	snapshot(&phaseStart);
+}
+
+
+/**
+ * Start timing the adoption of a window.
+ */
+void
+ProfileWindowStart(void)
+{
+	if(!enabled) {
+		return;
+	}
+	snapshot(&windowStart);
+}
+
+
+/**
+ * Done adopting window w.
+ */
+void
+ProfileWindowEnd(Window w)
+{
+	ProfileWindowInfo *wi;
+
+	if(!enabled) {
+		return;
+	}
+
+	if(nwindows == windowsSize) {
+		int nsize = windowsSize ? windowsSize * 2 : 256;
+		ProfileWindowInfo *n = realloc(windows, nsize * sizeof(*n));
+		if(n == NULL) {
+			return;
+		}
+		windows = n;
+		windowsSize = nsize;
+	}
+	wi = &windows[nwindows++];
+	memset(wi, 0, sizeof(*wi));
+	wi->w = w;
+	addSince(&wi->c, &windowStart);
+}
+
+
+/**
+ * Startup's done; stop counting, unhook from Xlib, and print the report.
+ */
+void
+ProfileStop(void)
+{
+	if(!enabled) {
+		return;
+	}
+
+	ProfilePhase(NULL);
+	if(hooked) {
+		XSetAfterFunction(dpy, prevAfter);
+		hooked = false;
+	}
+	ProfileReport(stderr);
+}
+
+
+static int
+cmpWindowMs(const void *a, const void *b)
+{
+	const ProfileWindowInfo *wa = a, *wb = b;
+
+	return (wa->c.ms < wb->c.ms) - (wa->c.ms > wb->c.ms);
+}
+
+
+/**
+ * Print what we've got.
+ */
+void
+ProfileReport(FILE *out)
+{
+	ProfileCounts total = { 0 }, wtotal = { 0 };
+
+	if(!enabled) {
+		return;
+	}
+	reported = true;
+
+	fprintf(out, "Startup profile:\n");
+	fprintf(out, "  %-24s %5s %10s %9s %10s\n", "phase", "calls", "ms",
+	        "requests", "roundtrips");
+	for(int i = 0; i < nphases; i++) {
+		const ProfilePhaseInfo *p = &phases[i];
+
+		fprintf(out, "  %-24s %5d %10.1f %9lu %10lu\n", p->name, p->calls,
+		        p->c.ms, p->c.requests, p->c.roundtrips);
+		total.ms += p->c.ms;
+		total.requests += p->c.requests;
+		total.roundtrips += p->c.roundtrips;
+	}
+	fprintf(out, "  %-24s %5s %10.1f %9lu %10lu\n", "total", "",
+	        total.ms, total.requests, total.roundtrips);
+
+	if(nwindows == 0) {
+		return;
+	}
+
+	for(int i = 0; i < nwindows; i++) {
+		wtotal.ms += windows[i].c.ms;
+		wtotal.requests += windows[i].c.requests;
+		wtotal.roundtrips += windows[i].c.roundtrips;
+	}
+	fprintf(out, "Adopted %d windows: %.1f ms, %lu requests, %lu roundtrips"
+	        " (%.2f ms, %.1f roundtrips each)\n", nwindows, wtotal.ms,
+	        wtotal.requests, wtotal.roundtrips, wtotal.ms / nwindows,
+	        (double)wtotal.roundtrips / nwindows);
+
+	qsort(windows, nwindows, sizeof(*windows), cmpWindowMs);
+	fprintf(out, "  %-12s %10s %9s %10s\n", "slowest", "ms", "requests",
+	        "roundtrips");
+	for(int i = 0; i < nwindows && i < PROFILE_SLOWEST; i++) {
+		const ProfileWindowInfo *wi = &windows[i];
+
+		fprintf(out, "  0x%-10lx %10.2f %9lu %10lu\n", (unsigned long)wi->w,
+		        wi->c.ms, wi->c.requests, wi->c.roundtrips);
+	}
+}
@@ -0,0 +1,18 @@
+/*
+ * Startup phase profiling
+ */
+
+#ifndef _CTWM_PROFILE_H
+#define _CTWM_PROFILE_H
+
+#include <stdio.h>
+
+
+void ProfileStart(void);
+void ProfilePhase(const char *name);
+void ProfileWindowStart(void);
+void ProfileWindowEnd(Window w);
+void ProfileStop(void);
+void ProfileReport(FILE *out);
+
+#endif /* _CTWM_PROFILE_H */
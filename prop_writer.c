@@ -0,0 +1,335 @@
+/*
+ * Batched, change-suppressing property writes
+ *
+ * We set a bunch of properties over and over, on the root and on client
+ * windows: WM_STATE, the EWMH _NET_WM_STATE/_NET_WM_DESKTOP/etc, the
+ * current workspace.  Most of the time the value's the same as what's
+ * already there, but every XChangeProperty() makes a PropertyNotify for
+ * every pager and panel watching, whether it changed anything or not.
+ *
+ * So those go through here instead.  We remember the last value set for
+ * each window/property, drop sets that wouldn't change it, and hold on
+ * to the rest until PropFlush(), which the main loop calls before
+ * going back for more events.  Several changes to the same property in
+ * between turn into one write of the last.
+ *
+ * This only works for properties we own; if somebody else can change
+ * them behind our back, they need a PropInvalidate() when we see them
+ * do it.  And anything reading back a property that's set through here
+ * should PropFlush() first.
+ */
+
+#include "ctwm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "prop_writer.h"
+
+
+/* Must be a power of 2 */
+#define PROP_BUCKETS 256
+
+typedef struct PropEntry {
+	struct PropEntry *next;    ///< Hash chain
+	struct PropEntry *dnext;   ///< Dirty list
+	Window w;
+	Atom prop;
+	Atom type;
+	int format;
+	int nelem;
+	size_t len;                ///< Bytes in data
+	size_t size;               ///< Bytes allocated for data
+	unsigned char *data;
+	bool present;              ///< false if it's being deleted
+	bool known;                ///< We know what's (about to be) there
+	bool dirty;                ///< Not sent yet
+} PropEntry;
+
+static PropEntry *buckets[PROP_BUCKETS];
+static PropEntry *dirty_head, **dirty_tail = &dirty_head;
+
+static PropStats stats;
+
+
+static unsigned int
+prop_hash(Window w, Atom prop)
+{
+	return (unsigned int)(w * 31 + prop) & (PROP_BUCKETS - 1);
+}
+
+
+/*
+ * How many bytes nelem items take up in client memory; Xlib wants
+ * format 32 data as longs, whatever size those are.
+ */
+static size_t
+prop_len(int format, int nelem)
+{
+	switch(format) {
+		case 8:
+			return nelem;
+		case 16:
+			return nelem * sizeof(short);
+		case 32:
+			return nelem * sizeof(long);
+	}
+	return 0;
+}
+
+
+static PropEntry *
+prop_find(Window w, Atom prop)
+{
+	for(PropEntry *pe = buckets[prop_hash(w, prop)]; pe != NULL;
+	                pe = pe->next) {
+		if(pe->w == w && pe->prop == prop) {
+			return pe;
+		}
+	}
+	return NULL;
+}
+
+
+static PropEntry *
+prop_add(Window w, Atom prop)
+{
+	const unsigned int h = prop_hash(w, prop);
+	PropEntry *pe = calloc(1, sizeof(PropEntry));
+
+	if(pe == NULL) {
+		return NULL;
+	}
+	pe->w = w;
+	pe->prop = prop;
+	pe->next = buckets[h];
+	buckets[h] = pe;
+	return pe;
+}
+
+
+static void
+prop_mark_dirty(PropEntry *pe)
+{
+	if(pe->dirty) {
+		stats.coalesced++;
+		return;
+	}
+	pe->dirty = true;
+	pe->dnext = NULL;
+	*dirty_tail = pe;
+	dirty_tail = &pe->dnext;
+}
+
+
+/**
+ * XChangeProperty(..., PropModeReplace, ...), held until the next
+ * PropFlush(), and skipped entirely if it's what we last set.
+ */
+void
+PropSet(Window w, Atom prop, Atom type, int format,
+        const void *data, int nelem)
+{
+	const size_t len = prop_len(format, nelem);
+	PropEntry *pe = prop_find(w, prop);
+
+	stats.sets++;
+	if(pe != NULL && pe->known && pe->present && pe->type == type
+	                && pe->format == format && pe->nelem == nelem
+	                && (len == 0 || memcmp(pe->data, data, len) == 0)) {
+		stats.suppressed++;
+		return;
+	}
+
+	if(pe == NULL) {
+		pe = prop_add(w, prop);
+	}
+	if(pe != NULL && len > pe->size) {
+		unsigned char *nd = realloc(pe->data, len);
+
+		if(nd == NULL) {
+			pe->known = false;
+			pe = NULL;
+		}
+		else {
+			pe->data = nd;
+			pe->size = len;
+		}
+	}
+	if(pe == NULL) {
+		/* Out of memory; just send it, after anything already waiting */
+		PropFlush();
+		if(dpy != NULL) {
+			XChangeProperty(dpy, w, prop, type, format, PropModeReplace,
+			                data, nelem);
+		}
+		stats.writes++;
+		return;
+	}
+
+	if(len > 0) {
+		memcpy(pe->data, data, len);
+	}
+	pe->len = len;
+	pe->type = type;
+	pe->format = format;
+	pe->nelem = nelem;
+	pe->present = true;
+	pe->known = true;
+	prop_mark_dirty(pe);
+}
+
+
+/**
+ * XDeleteProperty(), held and skipped like PropSet().
+ */
+void
+PropDelete(Window w, Atom prop)
+{
+	PropEntry *pe = prop_find(w, prop);
+
+	stats.sets++;
+	if(pe != NULL && pe->known && !pe->present) {
+		stats.suppressed++;
+		return;
+	}
+
+	if(pe == NULL) {
+		pe = prop_add(w, prop);
+	}
+	if(pe == NULL) {
+		PropFlush();
+		if(dpy != NULL) {
+			XDeleteProperty(dpy, w, prop);
+		}
+		stats.deletes++;
+		return;
+	}
+
+	pe->len = 0;
+	pe->nelem = 0;
+	pe->present = false;
+	pe->known = true;
+	prop_mark_dirty(pe);
+}
+
+
+/**
+ * Send everything that's been set since last time.  Without a display,
+ * nothing's sent, but it's counted like it was.
+ */
+void
+PropFlush(void)
+{
+	PropEntry *pe;
+
+	if(dirty_head == NULL) {
+		return;
+	}
+	stats.flushes++;
+
+	while((pe = dirty_head) != NULL) {
+		dirty_head = pe->dnext;
+		pe->dnext = NULL;
+		pe->dirty = false;
+
+		if(pe->present) {
+			if(dpy != NULL) {
+				XChangeProperty(dpy, pe->w, pe->prop, pe->type, pe->format,
+				                PropModeReplace, pe->data, pe->nelem);
+			}
+			stats.writes++;
+		}
+		else {
+			if(dpy != NULL) {
+				XDeleteProperty(dpy, pe->w, pe->prop);
+			}
+			stats.deletes++;
+		}
+	}
+	dirty_tail = &dirty_head;
+}
+
+
+/**
+ * Somebody else changed a property, so don't assume we know what's in
+ * it any more.  If we've got a write pending it'll land after theirs,
+ * so that still holds.
+ */
+void
+PropInvalidate(Window w, Atom prop)
+{
+	PropEntry *pe = prop_find(w, prop);
+
+	if(pe != NULL && !pe->dirty) {
+		pe->known = false;
+	}
+}
+
+
+/**
+ * We're done with a window: it's been destroyed, or we've stopped
+ * managing it (after which its client can do what it likes with its
+ * properties).  Anything still pending for it is thrown away, since
+ * there may be nothing left to write it to; when withdrawing a window
+ * that's still around, PropFlush() first.
+ */
+void
+PropForget(Window w)
+{
+	PropEntry **dp = &dirty_head;
+
+	while(*dp != NULL) {
+		PropEntry *pe = *dp;
+
+		if(pe->w == w) {
+			*dp = pe->dnext;
+			pe->dnext = NULL;
+			pe->dirty = false;
+			stats.dropped++;
+			continue;
+		}
+		dp = &pe->dnext;
+	}
+	dirty_tail = dp;
+
+	for(int i = 0; i < PROP_BUCKETS; i++) {
+		PropEntry **pp = &buckets[i];
+
+		while(*pp != NULL) {
+			PropEntry *pe = *pp;
+
+			if(pe->w == w) {
+				*pp = pe->next;
+				free(pe->data);
+				free(pe);
+			}
+			else {
+				pp = &pe->next;
+			}
+		}
+	}
+}
+
+
+/**
+ * Current counters.
+ */
+const PropStats *
+PropGetStats(void)
+{
+	return &stats;
+}
+
+
+/**
+ * Say how many property writes we managed to skip.
+ */
+void
+PropReport(FILE *out)
+{
+	fprintf(out, "Property writes: %lu asked for, %lu unchanged, "
+	        "%lu merged\n", stats.sets, stats.suppressed, stats.coalesced);
+	fprintf(out, "  %lu set and %lu deleted in %lu flushes, %lu dropped\n",
+	        stats.writes, stats.deletes, stats.flushes, stats.dropped);
+}
@@ -0,0 +1,30 @@
+/*
+ * Batched, change-suppressing property writes
+ */
+#ifndef _CTWM_PROP_WRITER_H
+#define _CTWM_PROP_WRITER_H
+
+#include <stdio.h>  // For FILE
+
+
+/// Counts of property writes, for diagnostics
+typedef struct PropStats {
+	unsigned long sets;         ///< PropSet()/PropDelete() calls
+	unsigned long suppressed;   ///< ... that didn't change anything
+	unsigned long coalesced;    ///< ... that replaced a pending write
+	unsigned long writes;       ///< XChangeProperty()'s sent
+	unsigned long deletes;      ///< XDeleteProperty()'s sent
+	unsigned long flushes;      ///< PropFlush()'s that sent anything
+	unsigned long dropped;      ///< Pending writes for windows forgotten
+} PropStats;
+
+void PropSet(Window w, Atom prop, Atom type, int format,
+             const void *data, int nelem);
+void PropDelete(Window w, Atom prop);
+void PropFlush(void);
+void PropInvalidate(Window w, Atom prop);
+void PropForget(Window w);
+const PropStats *PropGetStats(void);
+void PropReport(FILE *out);
+
+#endif /* _CTWM_PROP_WRITER_H */
@@ -16,6 +16,9 @@
 /*
  * Prototype internal funcs
  */
+static void *RAreaArenaAlloc(RAreaArena *self, size_t size);
+static RAreaList *RAreaListNewIn(RAreaArena *arena, int cap);
+static void RAreaListGrow(RAreaList *self, int cap);
 static RAreaList *RAreaListCopy(const RAreaList *self);
 static void RAreaListDelete(RAreaList *self, int index);
 static void RAreaListAddList(RAreaList *self, const RAreaList *other);
@@ -29,6 +32,134 @@ static int _cmpY(const void *av, const void *bv);
 static void RAreaListSortY(const RAreaList *self);
 
 
+/* Running count of where our storage has come from */
+static RAreaListStats alloc_stats;
+
+
+
+/**
+ * Setup an RAreaArena for use.  These are generally on the stack of a
+ * function doing some layout query that needs a handful of temporary
+ * RAreaList's.
+ */
+void
+RAreaArenaInit(RAreaArena *self)
+{
+	self->used = 0;
+	self->overflow = NULL;
+}
+
+
+/**
+ * Release everything handed out from an RAreaArena.  Any RAreaList's
+ * created in it are invalid afterward.  The arena can be reused.
+ */
+void
+RAreaArenaReset(RAreaArena *self)
+{
+	void **chunk = self->overflow;
+
+	while(chunk != NULL) {
+		void **next = chunk[0];
+		free(chunk);
+		chunk = next;
+	}
+
+	self->used = 0;
+	self->overflow = NULL;
+}
+
+
+/**
+ * Carve a block of memory out of an RAreaArena.  We only need
+ * pointer-alignment for anything we store, so just round up to that.
+ */
+static void *
+RAreaArenaAlloc(RAreaArena *self, size_t size)
+{
+	void **chunk;
+
+	size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+	alloc_stats.arena++;
+
+	if(self->used + size <= sizeof(self->buf)) {
+		void *ret = (char *)self->buf + self->used;
+		self->used += size;
+		return ret;
+	}
+
+	// Out of scratch space; chain on a heap chunk for this one.  The
+	// first slot links to the previous chunk for RAreaArenaReset().
+	chunk = malloc(sizeof(void *) + size);
+	if(chunk == NULL) {
+		abort();
+	}
+	chunk[0] = self->overflow;
+	self->overflow = chunk;
+	alloc_stats.arena_overflow++;
+
+	return &chunk[1];
+}
+
+
+/**
+ * Get the counts of how RAreaList storage has been allocated so far.
+ * Used to check how much the arena and inline storage save us.
+ */
+const RAreaListStats *
+RAreaListGetStats(void)
+{
+	return &alloc_stats;
+}
+
+
+/**
+ * Say where RAreaList storage came from.
+ */
+void
+RAreaListReport(FILE *out)
+{
+	fprintf(out, "Area lists: %lu inline, %lu from arenas (%lu overflowed), "
+	        "%lu heap allocations\n", alloc_stats.inline_lists,
+	        alloc_stats.arena, alloc_stats.arena_overflow, alloc_stats.heap);
+}
+
+
+/**
+ * Create an empty RAreaList with space for cap RArea's, either on the
+ * heap or in an arena.
+ */
+static RAreaList *
+RAreaListNewIn(RAreaArena *arena, int cap)
+{
+	RAreaList *list;
+
+	if(arena != NULL) {
+		list = RAreaArenaAlloc(arena, sizeof(RAreaList));
+	}
+	else {
+		list = malloc(sizeof(RAreaList));
+		if(list == NULL) {
+			abort();
+		}
+		alloc_stats.heap++;
+	}
+	list->len = 0;
+	list->arena = arena;
+
+	// Small lists don't need anything more
+	list->cap = RAREALIST_INLINE;
+	list->areas = list->inline_areas;
+	if(cap <= RAREALIST_INLINE) {
+		alloc_stats.inline_lists++;
+	}
+	else {
+		RAreaListGrow(list, cap);
+	}
+
+	return list;
+}
+
 
 /**
  * Create an RAreaList from a set of RArea's.
@@ -43,20 +174,7 @@ RAreaListNew(int cap, ...)
 	RAreaList *list;
 	RArea *area;
 
-	list = malloc(sizeof(RAreaList));
-	if(list == NULL) {
-		abort();
-	}
-	list->len = 0;
-
-	if(cap <= 0) {
-		cap = 1;
-	}
-	list->cap = cap;
-	list->areas = malloc(cap * sizeof(RArea));
-	if(list->areas == NULL) {
-		abort();
-	}
+	list = RAreaListNewIn(NULL, cap);
 
 	va_start(ap, cap);
 
@@ -70,13 +188,52 @@ RAreaListNew(int cap, ...)
 }
 
 
+/**
+ * Make sure an RAreaList has room for at least cap RArea's.
+ */
+static void
+RAreaListGrow(RAreaList *self, int cap)
+{
+	RArea *new_list;
+
+	if(cap <= self->cap) {
+		return;
+	}
+
+	if(self->arena != NULL) {
+		// Arena space is never given back individually, so just take a
+		// new block and leave the old one to the reset.
+		new_list = RAreaArenaAlloc(self->arena, cap * sizeof(RArea));
+		memcpy(new_list, self->areas, self->len * sizeof(RArea));
+	}
+	else if(self->areas == self->inline_areas) {
+		new_list = malloc(cap * sizeof(RArea));
+		if(new_list == NULL) {
+			abort();
+		}
+		memcpy(new_list, self->areas, self->len * sizeof(RArea));
+		alloc_stats.heap++;
+	}
+	else {
+		new_list = realloc(self->areas, cap * sizeof(RArea));
+		if(new_list == NULL) {
+			abort();
+		}
+		alloc_stats.heap++;
+	}
+
+	self->cap = cap;
+	self->areas = new_list;
+}
+
+
 /**
  * Create a copy of a given RAreaList.
  */
 static RAreaList *
 RAreaListCopy(const RAreaList *self)
 {
-	RAreaList *new = RAreaListNew(self->cap, NULL);
+	RAreaList *new = RAreaListNewIn(NULL, self->len);
 
 	RAreaListAddList(new, self);
 
@@ -135,15 +292,18 @@ RAreaListCopyCropped(const RAreaList *self, int left_margin,
 
 
 /**
- * Clean up and free an RAreaList.
+ * Clean up and free an RAreaList.  Lists living in an RAreaArena are
+ * left for RAreaArenaReset() to deal with.
  */
 void
 RAreaListFree(RAreaList *self)
 {
-	if(self == NULL) {
+	if(self == NULL || self->arena != NULL) {
 		return;
 	}
-	free(self->areas);
+	if(self->areas != self->inline_areas) {
+		free(self->areas);
+	}
 	free(self);
 }
 
@@ -164,8 +324,8 @@ RAreaListDelete(RAreaList *self, int index)
 		return;
 	}
 
-	memcpy(&self->areas[index], &self->areas[index + 1],
-	       (self->len - index) * sizeof(RArea));
+	memmove(&self->areas[index], &self->areas[index + 1],
+	        (self->len - index) * sizeof(RArea));
 }
 
 
@@ -176,13 +336,7 @@ void
 RAreaListAdd(RAreaList *self, const RArea *area)
 {
 	if(self->cap == self->len) {
-		RArea *new_list = realloc(self->areas, (self->cap + 1) * sizeof(RArea));
-		if(new_list == NULL) {
-			abort();
-		}
-
-		self->cap++;
-		self->areas = new_list;
+		RAreaListGrow(self, self->cap * 2);
 	}
 
 	self->areas[self->len++] = *area;
@@ -195,16 +349,7 @@ RAreaListAdd(RAreaList *self, const RArea *area)
 static void
 RAreaListAddList(RAreaList *self, const RAreaList *other)
 {
-	if(self->cap - self->len < other->len) {
-		RArea *new_list = realloc(self->areas,
-		                          (self->len + other->len) * sizeof(RArea));
-		if(new_list == NULL) {
-			abort();
-		}
-
-		self->cap = self->len + other->len;
-		self->areas = new_list;
-	}
+	RAreaListGrow(self, self->len + other->len);
 
 	memcpy(&self->areas[self->len], other->areas, other->len * sizeof(RArea));
 
@@ -358,7 +503,20 @@ refine:
 RAreaList *
 RAreaListIntersect(const RAreaList *self, const RArea *area)
 {
-	RAreaList *new = RAreaListNew(self->len, NULL);
+	return RAreaListIntersectArena(self, area, NULL);
+}
+
+
+/**
+ * Create an RAreaList of all the areas in an RAreaList that a given
+ * RArea intersects with, as a temporary in an RAreaArena.  With a NULL
+ * arena, this is just RAreaListIntersect().
+ */
+RAreaList *
+RAreaListIntersectArena(const RAreaList *self, const RArea *area,
+                        RAreaArena *arena)
+{
+	RAreaList *new = RAreaListNewIn(arena, self->len);
 
 	for(int i = 0; i < self->len; i++) {
 		if(RAreaIsIntersect(&self->areas[i], area)) {
@@ -395,7 +553,7 @@ RAreaListForeach(const RAreaList *self,
 static RAreaList *
 RAreaListIntersectCrop(const RAreaList *self, const RArea *area)
 {
-	RAreaList *new = RAreaListNew(self->len, NULL);
+	RAreaList *new = RAreaListNewIn(NULL, self->len);
 
 	for(int i = 0; i < self->len; i++) {
 		RArea it = RAreaIntersect(&self->areas[i], area);
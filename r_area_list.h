@@ -5,9 +5,25 @@
 #ifndef _CTWM_R_AREA_LIST_H
 #define _CTWM_R_AREA_LIST_H
 
+#include <stdio.h>  // For FILE
+
 #include "r_structs.h"
 
 
+/// Counts of how RAreaList storage has been obtained
+typedef struct RAreaListStats {
+	unsigned long heap;  ///< malloc()/realloc() calls made
+	unsigned long inline_lists;   ///< Lists that fit in inline storage
+	unsigned long arena; ///< Allocations served by an RAreaArena
+	unsigned long arena_overflow; ///< ... that had to go to the heap
+} RAreaListStats;
+
+
+void RAreaArenaInit(RAreaArena *self);
+void RAreaArenaReset(RAreaArena *self);
+const RAreaListStats *RAreaListGetStats(void);
+void RAreaListReport(FILE *out);
+
 RAreaList *RAreaListNew(int cap, ...);
 
 void RAreaListFree(RAreaList *self);
@@ -22,6 +38,8 @@ RAreaList *RAreaListHorizontalUnion(const RAreaList *self);
 RAreaList *RAreaListVerticalUnion(const RAreaList *self);
 
 RAreaList *RAreaListIntersect(const RAreaList *self, const RArea *area);
+RAreaList *RAreaListIntersectArena(const RAreaList *self, const RArea *area,
+                                   RAreaArena *arena);
 void RAreaListForeach(const RAreaList *self,
                       bool (*func)(const RArea *area, void *data),
                       void *data);
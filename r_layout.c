@@ -19,13 +19,13 @@
  */
 static void _RLayoutFreeNames(RLayout *self);
 static RAreaList *_RLayoutRecenterVertically(const RLayout *self,
-                const RArea *far_area);
+                const RArea *far_area, RAreaArena *arena);
 static RAreaList *_RLayoutRecenterHorizontally(const RLayout *self,
-                const RArea *far_area);
+                const RArea *far_area, RAreaArena *arena);
 static RAreaList *_RLayoutVerticalIntersect(const RLayout *self,
-                const RArea *area);
+                const RArea *area, RAreaArena *arena);
 static RAreaList *_RLayoutHorizontalIntersect(const RLayout *self,
-                const RArea *area);
+                const RArea *area, RAreaArena *arena);
 
 /* Foreach() callbacks used in various lookups */
 static bool _findMonitorByXY(const RArea *cur, void *vdata);
@@ -144,6 +144,11 @@ RLayoutSetMonitorsNames(RLayout *self, char **names)
  * RLayout, but we want to find the nearest way to move them inside, then
  * return a list of which RArea's they'd be intersecting with.
  *
+ * These and the intersection wrappers below only build temporaries for
+ * the query funcs further down, so they take the RAreaArena the caller
+ * set up for the query and build their lists in it.  The caller resets
+ * the arena when it's done, so nothing here frees its results.
+ *
  ************************/
 
 
@@ -173,9 +178,11 @@ RLayoutSetMonitorsNames(RLayout *self, char **names)
  *
  * \param self     Our current monitor layout
  * \param far_area The area to act on
+ * \param arena    Where to build the result
  */
 static RAreaList *
-_RLayoutRecenterVertically(const RLayout *self, const RArea *far_area)
+_RLayoutRecenterVertically(const RLayout *self, const RArea *far_area,
+                           RAreaArena *arena)
 {
 	RArea big = RAreaListBigArea(self->monitors), tmp;
 
@@ -222,7 +229,7 @@ _RLayoutRecenterVertically(const RLayout *self, const RArea *far_area)
 	// ->vert of our layout.  If it were off the top of bottom, though,
 	// it'll yield some slice of 1 (or more) of our ->vert's, as wide as
 	// the window itself was.
-	return RAreaListIntersect(self->vert, &tmp);
+	return RAreaListIntersectArena(self->vert, &tmp, arena);
 
 	// n.b.; _RLayoutRecenterHorizontally() is the counterpart to this
 	// with horizontal slices.  The comments in the two have been written
@@ -258,9 +265,11 @@ _RLayoutRecenterVertically(const RLayout *self, const RArea *far_area)
  *
  * \param self     Our current monitor layout
  * \param far_area The area to act on
+ * \param arena    Where to build the result
  */
 static RAreaList *
-_RLayoutRecenterHorizontally(const RLayout *self, const RArea *far_area)
+_RLayoutRecenterHorizontally(const RLayout *self, const RArea *far_area,
+                             RAreaArena *arena)
 {
 	RArea big = RAreaListBigArea(self->monitors), tmp;
 
@@ -301,7 +310,7 @@ _RLayoutRecenterHorizontally(const RLayout *self, const RArea *far_area)
 	// 1 pixel at the top of the top-most, or 1..(far_area->height)
 	// overlap somewhere.  In that last case (far_area was in H), the
 	// intersection may yield multiple areas.
-	return RAreaListIntersect(self->horiz, &tmp);
+	return RAreaListIntersectArena(self->horiz, &tmp, arena);
 
 	// n.b.; _RLayoutRecenterVertically() is the counterpart to this with
 	// vertical slices.  The comments in the two have been written
@@ -331,15 +340,15 @@ _RLayoutRecenterHorizontally(const RLayout *self, const RArea *far_area)
  * This function is used only by RLayoutFindTopBottomEdges()
  */
 static RAreaList *
-_RLayoutVerticalIntersect(const RLayout *self, const RArea *area)
+_RLayoutVerticalIntersect(const RLayout *self, const RArea *area,
+                          RAreaArena *arena)
 {
-	RAreaList *mit = RAreaListIntersect(self->vert, area);
+	RAreaList *mit = RAreaListIntersectArena(self->vert, area, arena);
 
 	if(mit->len == 0) {
 		// Not on screen.  Move it to just over the nearest edge so it
 		// is, and give the slices it's in then.
-		RAreaListFree(mit);
-		mit = _RLayoutRecenterVertically(self, area);
+		mit = _RLayoutRecenterVertically(self, area, arena);
 	}
 	return mit;
 }
@@ -354,15 +363,15 @@ _RLayoutVerticalIntersect(const RLayout *self, const RArea *area)
  * This function is used only by RLayoutFindLeftRightEdges()
  */
 static RAreaList *
-_RLayoutHorizontalIntersect(const RLayout *self, const RArea *area)
+_RLayoutHorizontalIntersect(const RLayout *self, const RArea *area,
+                            RAreaArena *arena)
 {
-	RAreaList *mit = RAreaListIntersect(self->horiz, area);
+	RAreaList *mit = RAreaListIntersectArena(self->horiz, area, arena);
 
 	if(mit->len == 0) {
 		// Not on screen.  Move it to just over the nearest edge so it
 		// is, and give the slices it's in then.
-		RAreaListFree(mit);
-		mit = _RLayoutRecenterHorizontally(self, area);
+		mit = _RLayoutRecenterHorizontally(self, area, arena);
 	}
 
 	return mit;
@@ -401,7 +410,11 @@ void
 RLayoutFindTopBottomEdges(const RLayout *self, const RArea *area, int *top,
                           int *bottom)
 {
-	RAreaList *mit = _RLayoutVerticalIntersect(self, area);
+	RAreaArena arena;
+	RAreaList *mit;
+
+	RAreaArenaInit(&arena);
+	mit = _RLayoutVerticalIntersect(self, area, &arena);
 
 	if(top != NULL) {
 		*top = RAreaListMaxY(mit);
@@ -411,7 +424,7 @@ RLayoutFindTopBottomEdges(const RLayout *self, const RArea *area, int *top,
 		*bottom = RAreaListMinY2(mit);
 	}
 
-	RAreaListFree(mit);
+	RAreaArenaReset(&arena);
 }
 
 
@@ -466,7 +479,11 @@ void
 RLayoutFindLeftRightEdges(const RLayout *self, const RArea *area, int *left,
                           int *right)
 {
-	RAreaList *mit = _RLayoutHorizontalIntersect(self, area);
+	RAreaArena arena;
+	RAreaList *mit;
+
+	RAreaArenaInit(&arena);
+	mit = _RLayoutHorizontalIntersect(self, area, &arena);
 
 	if(left != NULL) {
 		*left = RAreaListMaxX(mit);
@@ -476,7 +493,7 @@ RLayoutFindLeftRightEdges(const RLayout *self, const RArea *area, int *left,
 		*right = RAreaListMinX2(mit);
 	}
 
-	RAreaListFree(mit);
+	RAreaArenaReset(&arena);
 }
 
 
@@ -973,20 +990,23 @@ RArea
 RLayoutFull1(const RLayout *self, const RArea *area)
 {
 	RArea target;
-	RAreaList *mit = RAreaListIntersect(self->monitors, area);
+	RAreaArena arena;
+	RAreaList *mit;
+
 	// Start with a list of all the monitors the window is on now.
+	RAreaArenaInit(&arena);
+	mit = RAreaListIntersectArena(self->monitors, area, &arena);
 
 	if(mit->len == 0) {
 		// Not on any screens.  Find the "nearest" place it would wind
 		// up.
-		RAreaListFree(mit);
-		mit = _RLayoutRecenterHorizontally(self, area);
+		mit = _RLayoutRecenterHorizontally(self, area, &arena);
 	}
 
 	// Of the monitors it's on, find the one that it's "most" on, and
 	// return the RArea of it.
 	target = RAreaListBestTarget(mit, area);
-	RAreaListFree(mit);
+	RAreaArenaReset(&arena);
 	return target;
 }
 
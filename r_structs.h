@@ -21,16 +21,44 @@ struct RArea {
 };
 
 
+/// How many RArea's an RAreaList can hold without allocating storage
+#define RAREALIST_INLINE 4
+
 /**
  * A set of RArea's.
  *
  * This is generally used to define a contiguous region formed of various
  * stitched-together subareas.
+ *
+ * Small lists keep their members in inline_areas, so they need no
+ * separate allocation.  Lists built as temporaries during layout queries
+ * may be carved out of an RAreaArena instead of the heap; those are
+ * released all at once when the arena is reset.
  */
 struct RAreaList {
 	int len; ///< How many we're using
 	int cap; ///< How many we have space for
 	RArea *areas; ///< Array of RArea members of this list
+	RAreaArena *arena; ///< Arena we live in, or NULL if on the heap
+	RArea inline_areas[RAREALIST_INLINE]; ///< Storage for small lists
+};
+
+
+/// Size of the built-in scratch buffer in an RAreaArena
+#define RAREAARENA_SIZE 2048
+
+/**
+ * A bump allocator for temporary RAreaList's.
+ *
+ * These are set up on the stack for the duration of a single layout
+ * query, so the intermediate lists it builds don't each go through
+ * malloc()/free().  If the built-in buffer fills up, further space is
+ * taken from the heap in chunks, which get freed by RAreaArenaReset().
+ */
+struct RAreaArena {
+	size_t used; ///< How much of buf is handed out
+	void *overflow; ///< Chain of heap chunks allocated when buf ran out
+	void *buf[RAREAARENA_SIZE / sizeof(void *)]; ///< Scratch space
 };
 
 
@@ -0,0 +1,322 @@
+/*
+ * Main loop file descriptor watching
+ *
+ * Everything the main loop waits on goes through here: the X
+ * connection, the session manager's ICE connection, the launcher's
+ * child-exit pipe, and whatever else registers a descriptor with
+ * ReactorAddFd().  ReactorWait() sleeps until one of them is readable or
+ * the next timer (see timers.c) is due, and calls the owner's callback.
+ *
+ * We use epoll(7) where it's available, and poll(2) otherwise (or if
+ * epoll_create() fails for some reason).  Signal handlers poke a
+ * self-pipe via ReactorWakeup(), so a signal that lands just before we
+ * go to sleep still wakes us up, rather than waiting for the next event.
+ */
+
+#include "ctwm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef HAS_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#include "reactor.h"
+#include "timers.h"
+
+
+typedef struct ReactorFd {
+	int fd;
+	const char *name;
+	ReactorFunc func;
+	void *arg;
+	unsigned long wakes;   ///< Times it woke us
+} ReactorFd;
+
+static ReactorFd *fds;
+static int nfds, fds_size;
+
+static int wake_pipe[2] = { -1, -1 };
+static bool initted = false;
+#ifdef HAS_EPOLL
+static int epfd = -1;
+#endif
+
+static ReactorStats stats;
+
+
+static ReactorFd *
+findFd(int fd)
+{
+	for(int i = 0; i < nfds; i++) {
+		if(fds[i].fd == fd) {
+			return &fds[i];
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ * Signal wakeups just need draining; whoever poked us set a flag the
+ * main loop will look at.
+ */
+static void
+wakeInput(int fd, void *arg)
+{
+	char buf[64];
+
+	while(read(fd, buf, sizeof(buf)) > 0) {
+		/* nada */;
+	}
+	stats.signals++;
+}
+
+
+/**
+ * Setup.  Called during startup, but anything using us will do it
+ * on first use if needed.
+ */
+void
+ReactorInit(void)
+{
+	if(initted) {
+		return;
+	}
+	initted = true;
+	stats.started = TimerNow();
+	stats.backend = "poll";
+
+#ifdef HAS_EPOLL
+	epfd = epoll_create(8);
+	if(epfd >= 0) {
+		fcntl(epfd, F_SETFD, FD_CLOEXEC);
+		stats.backend = "epoll";
+	}
+#endif
+
+	if(pipe(wake_pipe) != 0) {
+		perror("reactor pipe");
+		wake_pipe[0] = wake_pipe[1] = -1;
+		return;
+	}
+	for(int i = 0; i < 2; i++) {
+		fcntl(wake_pipe[i], F_SETFD, FD_CLOEXEC);
+		fcntl(wake_pipe[i], F_SETFL, fcntl(wake_pipe[i], F_GETFL) | O_NONBLOCK);
+	}
+	ReactorAddFd(wake_pipe[0], "signals", wakeInput, NULL);
+}
+
+
+/**
+ * Watch a file descriptor for input, calling func(fd, arg) when it's
+ * readable.  name is just for the stats.  Returns false if it can't be
+ * watched.
+ */
+bool
+ReactorAddFd(int fd, const char *name, ReactorFunc func, void *arg)
+{
+	ReactorFd *rf;
+
+	ReactorInit();
+	if(fd < 0) {
+		return false;
+	}
+
+	rf = findFd(fd);
+	if(rf == NULL) {
+		if(nfds == fds_size) {
+			int nsize = fds_size ? fds_size * 2 : 8;
+			ReactorFd *n = realloc(fds, nsize * sizeof(ReactorFd));
+			if(n == NULL) {
+				return false;
+			}
+			fds = n;
+			fds_size = nsize;
+		}
+
+#ifdef HAS_EPOLL
+		if(epfd >= 0) {
+			struct epoll_event ev;
+
+			memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.fd = fd;
+			if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+				perror("epoll_ctl");
+				return false;
+			}
+		}
+#endif
+		rf = &fds[nfds++];
+		rf->fd = fd;
+		rf->wakes = 0;
+	}
+	rf->name = name;
+	rf->func = func;
+	rf->arg = arg;
+
+	return true;
+}
+
+
+/**
+ * Stop watching a file descriptor.  Do this before closing it.
+ */
+void
+ReactorRemoveFd(int fd)
+{
+	ReactorFd *rf = findFd(fd);
+
+	if(rf == NULL) {
+		return;
+	}
+#ifdef HAS_EPOLL
+	if(epfd >= 0) {
+		epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+	}
+#endif
+	*rf = fds[--nfds];
+}
+
+
+/**
+ * Make ReactorWait() return.  Safe to call from signal handlers.
+ */
+void
+ReactorWakeup(void)
+{
+	int save_errno = errno;
+	const char c = 0;
+
+	if(wake_pipe[1] >= 0) {
+		// If the pipe is full there's already a wakeup pending
+		write(wake_pipe[1], &c, 1);
+	}
+	errno = save_errno;
+}
+
+
+/*
+ * Run the callback for a ready fd, if it's still one of ours (an
+ * earlier callback in the same batch might have removed it).
+ */
+static void
+dispatch(int fd)
+{
+	ReactorFd *rf = findFd(fd);
+
+	if(rf == NULL) {
+		return;
+	}
+	rf->wakes++;
+	rf->func(fd, rf->arg);
+}
+
+
+/**
+ * Sleep until something's readable, or timeout ms have passed (-1 to
+ * wait forever), and run the callbacks for whatever's ready.  Returns
+ * the number of fds handled, 0 on timeout, or -1 if interrupted.
+ */
+int
+ReactorWait(int timeout)
+{
+	int n;
+
+	ReactorInit();
+	stats.waits++;
+
+#ifdef HAS_EPOLL
+	if(epfd >= 0) {
+		struct epoll_event evs[16];
+
+		n = epoll_wait(epfd, evs, 16, timeout);
+		if(n < 0) {
+			if(errno != EINTR) {
+				perror("epoll_wait");
+			}
+			return -1;
+		}
+		if(n == 0) {
+			stats.timeouts++;
+			return 0;
+		}
+		stats.fd_wakes++;
+		for(int i = 0; i < n; i++) {
+			dispatch(evs[i].data.fd);
+		}
+		return n;
+	}
+#endif
+
+	{
+		struct pollfd pfds[nfds > 0 ? nfds : 1];
+		const int count = nfds;
+		int handled = 0;
+
+		for(int i = 0; i < count; i++) {
+			pfds[i].fd = fds[i].fd;
+			pfds[i].events = POLLIN;
+			pfds[i].revents = 0;
+		}
+		n = poll(pfds, count, timeout);
+		if(n < 0) {
+			if(errno != EINTR) {
+				perror("poll");
+			}
+			return -1;
+		}
+		if(n == 0) {
+			stats.timeouts++;
+			return 0;
+		}
+		stats.fd_wakes++;
+		for(int i = 0; i < count; i++) {
+			if(pfds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+				dispatch(pfds[i].fd);
+				handled++;
+			}
+		}
+		return handled;
+	}
+}
+
+
+/**
+ * Current counters.
+ */
+const ReactorStats *
+ReactorGetStats(void)
+{
+	return &stats;
+}
+
+
+/**
+ * Say how often we've been waking up, and why.
+ */
+void
+ReactorReport(FILE *out)
+{
+	double secs = (TimerNow() - stats.started) / 1000.0;
+
+	if(secs <= 0) {
+		secs = 0.001;
+	}
+	fprintf(out, "Main loop (%s): %lu wakeups in %.1f s, %.2f/s\n",
+	        stats.backend ? stats.backend : "unused", stats.waits, secs,
+	        stats.waits / secs);
+	fprintf(out, "  %lu for fds, %lu of which were signals\n",
+	        stats.fd_wakes, stats.signals);
+	fprintf(out, "  %-12s %8lu  %8.2f/s\n", "timers", stats.timeouts,
+	        stats.timeouts / secs);
+	for(int i = 0; i < nfds; i++) {
+		fprintf(out, "  %-12s %8lu  %8.2f/s\n", fds[i].name, fds[i].wakes,
+		        fds[i].wakes / secs);
+	}
+}
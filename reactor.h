@@ -0,0 +1,32 @@
+/*
+ * Main loop file descriptor watching
+ */
+
+#ifndef _CTWM_REACTOR_H
+#define _CTWM_REACTOR_H
+
+#include <stdio.h>  // For FILE
+#include <stdint.h>
+
+
+typedef void (*ReactorFunc)(int fd, void *arg);
+
+/// Counts of main loop wakeups, for diagnostics
+typedef struct ReactorStats {
+	unsigned long waits;      ///< Times we went to sleep
+	unsigned long timeouts;   ///< ... and woke because a timer was due
+	unsigned long fd_wakes;   ///< ... or a watched fd was readable
+	unsigned long signals;    ///< ... or a signal poked us
+	uint64_t started;         ///< TimerNow() when we started
+	const char *backend;      ///< "epoll" or "poll"
+} ReactorStats;
+
+void ReactorInit(void);
+bool ReactorAddFd(int fd, const char *name, ReactorFunc func, void *arg);
+void ReactorRemoveFd(int fd);
+void ReactorWakeup(void);
+int ReactorWait(int timeout);
+const ReactorStats *ReactorGetStats(void);
+void ReactorReport(FILE *out);
+
+#endif /* _CTWM_REACTOR_H */
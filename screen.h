@@ -206,7 +206,9 @@ struct ScreenInfo {
 	/// Layout of our roow window and monitor(s).
 	RLayout *Layout;
 	/// Layout taking into account Border{Top,Left,Right,Bottom} config
-	/// params.
+	/// params, and any EWMH struts.  This gets replaced (and the old one
+	/// freed) when the struts change the work area, so don't hang onto
+	/// it.
 	RLayout *BorderedLayout;
 
 	/**
@@ -310,6 +312,9 @@ struct ScreenInfo {
 		int root_pushes;
 		/// saved colormaps to install when pushes drops to zero
 		Colormaps *pushed_cmaps;
+		/// ColormapsChanged() generation when we last picked what to
+		/// install from cmaps; 0 if we haven't since it was set
+		unsigned long picked_gen;
 	} cmapInfo; ///< \copydoc ScreenInfo::_cmapInfo
 	///< \todo Somebody needs to understand and document this better.
 	// x-ref trailing comment on InfoWindow above
@@ -473,6 +478,9 @@ struct ScreenInfo {
 #ifdef EWMH
 	int PreferredIconWidth;     ///< Width from IconSize config var
 	int PreferredIconHeight;    ///< Height from IconSize config var
+	/// Shrink _NET_WM_ICON icons bigger than the IconSize to fit it.
+	/// From ScaleEWMHIcons config var.
+	bool ScaleEWMHIcons;
 #endif
 	/// @}
 
@@ -589,6 +597,10 @@ struct ScreenInfo {
 	/// \sa ScreenInfo.AutoRaiseDefault \sa ScreenInfo.RaiseDelay
 	name_list *AutoRaise;
 
+	/// AutoRaiseDelay config var.  Per-window overrides of RaiseDelay
+	/// (the list data is an int, in ms).
+	name_list *AutoRaiseDelay;
+
 	/// WarpOnDeIconify config var.  Windows to occupy over to current
 	/// workspace on deiconification.  \note Minor nomenclature issue;
 	/// 'Warp' in name suggests we move to the win, but it actually means
@@ -599,6 +611,10 @@ struct ScreenInfo {
 	/// pointed away from.  \sa ScreenInfo.AutoLowerDefault
 	name_list *AutoLower;
 
+	/// AutoLowerDelay config var.  Per-window overrides of LowerDelay
+	/// (the list data is an int, in ms).
+	name_list *AutoLowerDelay;
+
 	/// Icons config var.  Manually specified icons for particular
 	/// windows.
 	name_list *IconNames;
@@ -938,6 +954,14 @@ struct ScreenInfo {
 	/// config var.
 	bool StrictWinNameEncoding;
 
+	/// Run simple f.exec commands without going through /bin/sh.  From
+	/// DirectExec config var.
+	bool DirectExec;
+
+	/// Periodically check our stacking order against the server's when
+	/// idle.  From CheckStackingOrder config var.
+	bool CheckStackingOrder;
+
 	/// ForceFocus config var.  Forcing focus-setting on windows.
 	/// \sa ScreenInfo.ForceFocusL
 	bool      ForceFocus;
@@ -945,6 +969,11 @@ struct ScreenInfo {
 	name_list *ForceFocusL;
 
 	FuncKey FuncKeyRoot;       ///< Key bindings
+	/// Key bindings hashed by keycode/modifiers; see FUNCKEY_HASH()
+	FuncKey *FuncKeyHash[FUNCKEY_HASH_SIZE];
+	/// Key/button grabs for client windows, worked out from the bindings
+	/// on first use.  \sa GrabKeys() \sa GrabButtons()
+	struct WindowGrabs *WindowGrabs;
 	FuncButton FuncButtonRoot; ///< Mouse click bindings
 
 #ifdef EWMH
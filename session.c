@@ -70,11 +70,12 @@
 #include "ctwm_shutdown.h"
 #include "icons.h"
 #include "list.h"
+#include "reactor.h"
 #include "screen.h"
 #include "session.h"
 
 SmcConn smcConn = NULL;
-static XtInputId iceInputId;
+static int iceFd = -1;
 static char *twm_clientId;
 static TWMWinConfigEntry *winConfigHead = NULL;
 static bool sent_save_done = false;
@@ -1065,8 +1066,8 @@ void DieCB(SmcConn smcCon, SmPointer clientData)
  * application shut istelf down
  */
 {
+	ReactorRemoveFd(iceFd);
 	SmcCloseConnection(smcCon, 0, NULL);
-	XtRemoveInput(iceInputId);
 	DoShutdown();
 }
 
@@ -1093,7 +1094,7 @@ void ShutdownCancelledCB(SmcConn smcCon, SmPointer clientData)
 
 /*===[ Process ICE Message ]=================================================*/
 
-void ProcessIceMsgProc(XtPointer client_data, int *source, XtInputId *id)
+void ProcessIceMsgProc(int fd, void *client_data)
 
 {
 	IceConn     ice_conn = (IceConn) client_data;
@@ -1150,10 +1151,6 @@ void ConnectToSessionManager(char *previous_id)
 
 	iceConn = SmcGetIceConnection(smcConn);
 
-	iceInputId = XtAppAddInput(
-	                     appContext,
-	                     IceConnectionNumber(iceConn),
-	                     (XtPointer) XtInputReadMask,
-	                     ProcessIceMsgProc,
-	                     (XtPointer) iceConn);
+	iceFd = IceConnectionNumber(iceConn);
+	ReactorAddFd(iceFd, "ICE", ProcessIceMsgProc, iceConn);
 }
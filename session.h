@@ -61,7 +61,7 @@ void SaveYourselfPhase2CB(SmcConn smcCon, SmPointer clientData);
 void DieCB(SmcConn smcCon, SmPointer clientData);
 void SaveCompleteCB(SmcConn smcCon, SmPointer clientData);
 void ShutdownCancelledCB(SmcConn smcCon, SmPointer clientData);
-void ProcessIceMsgProc(XtPointer client_data, int *source, XtInputId *id);
+void ProcessIceMsgProc(int fd, void *client_data);
 void ConnectToSessionManager(char *previous_id);
 
 #endif /* _CTWM_SESSION_H */
@@ -10,6 +10,8 @@
 #include <unistd.h>
 
 #include "ctwm_shutdown.h"
+#include "launcher.h"
+#include "reactor.h"
 #include "signals.h"
 
 
@@ -33,6 +35,9 @@ bool SignalFlag = false;
 void
 setup_signal_handlers(void)
 {
+	// Handlers poke the main loop awake through the reactor
+	ReactorInit();
+
 	// INT/QUIT/TERM: shutdown
 	// XXX Wildly unsafe handler; to be reworked
 	signal(SIGINT,  sh_shutdown);
@@ -46,9 +51,9 @@ setup_signal_handlers(void)
 	// die...
 	signal(SIGALRM, SIG_IGN);
 
-	// This should be set by default, but just in case; explicitly don't
-	// leave zombies.
-	signal(SIGCHLD, SIG_IGN);
+	// SIGCHLD: the launcher reaps children from the main loop, so we
+	// don't leave zombies.
+	LauncherInit();
 
 	return;
 }
@@ -107,6 +112,7 @@ sh_restart(int signum)
 	write(2, srf, sizeof(srf));
 
 	SignalFlag = sig_restart = true;
+	ReactorWakeup();
 }
 
 /**
@@ -121,5 +127,6 @@ sh_shutdown(int signum)
 	write(2, srf, sizeof(srf));
 
 	SignalFlag = sig_shutdown = true;
+	ReactorWakeup();
 }
 
@@ -0,0 +1,134 @@
+/*
+ * Benchmark text drawing: how many window titles a second we can measure
+ * and paint, the way PaintTitle() does, with a core font set and (if
+ * we're built with it) an Xft font.
+ *
+ *   bench_text [-n count] [-c corefont] [-x xftfont] [title]
+ *
+ * Needs a display; compare runs on a local server and over a forwarded
+ * connection to see what round trips cost.
+ */
+
+#include "ctwm.h"
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "drawing.h"
+#include "font_cache.h"
+#include "screen.h"
+
+
+static Pixmap pm;
+static GC gc;
+
+
+static void
+bench(const char *what, MyFont *font, const char *title, int count)
+{
+	struct timeval start, end;
+	XRectangle ink, logical;
+	int len = strlen(title);
+	double ms;
+
+	XSync(dpy, False);
+	gettimeofday(&start, NULL);
+	for(int i = 0; i < count; i++) {
+		FontTextExtents(font, title, len, &ink, &logical);
+		FontDrawImageString(pm, font, gc, 4, font->y, title, len);
+	}
+	XSync(dpy, False);
+	gettimeofday(&end, NULL);
+
+	ms = (end.tv_sec - start.tv_sec) * 1000.0
+	     + (end.tv_usec - start.tv_usec) / 1000.0;
+	printf("%-5s %d titles in %.1f ms: %.0f titles/s\n", what, count, ms,
+	       ms > 0 ? count * 1000.0 / ms : 0.0);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	const char *corename = "variable";
+	const char *xftname = "xft:sans-10";
+	const char *title = "user@host: ~/src/ctwm/win_decorations.c - VIM";
+	TwmColormap tcmap = { 0 };
+	ColormapWindow cwin = { 0 }, *cwinp = &cwin;
+	MyFont core = { 0 };
+	char *corelist;
+	int count = 10000;
+	int ch;
+
+	while((ch = getopt(argc, argv, "n:c:x:")) != -1) {
+		switch(ch) {
+			case 'n':
+				count = atoi(optarg);
+				break;
+			case 'c':
+				corename = optarg;
+				break;
+			case 'x':
+				xftname = optarg;
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-n count] [-c corefont] "
+				        "[-x xftfont] [title]\n", argv[0]);
+				return 1;
+		}
+	}
+	if(optind < argc) {
+		title = argv[optind];
+	}
+
+	setlocale(LC_ALL, "");
+	dpy = XOpenDisplay(NULL);
+	if(dpy == NULL) {
+		fprintf(stderr, "Can't open display\n");
+		return 1;
+	}
+
+	/* Just enough of a screen for the font and drawing code */
+	Scr = calloc(1, sizeof(ScreenInfo));
+	Scr->screen = DefaultScreen(dpy);
+	Scr->Root = RootWindow(dpy, Scr->screen);
+	Scr->d_visual = DefaultVisual(dpy, Scr->screen);
+	tcmap.c = DefaultColormap(dpy, Scr->screen);
+	cwin.colormap = &tcmap;
+	Scr->RootColormaps.cwins = &cwinp;
+	Scr->RootColormaps.number_cwins = 1;
+
+	pm = XCreatePixmap(dpy, Scr->Root, 1000, 50,
+	                   DefaultDepth(dpy, Scr->screen));
+	gc = XCreateGC(dpy, pm, 0, NULL);
+	XSetForeground(dpy, gc, BlackPixel(dpy, Scr->screen));
+	XSetBackground(dpy, gc, WhitePixel(dpy, Scr->screen));
+
+	asprintf(&corelist, "%s,*", corename);
+	if(!FontCacheGet(&core, corelist)) {
+		fprintf(stderr, "Can't load core font %s\n", corename);
+		return 1;
+	}
+	bench("core", &core, title, count);
+
+#ifdef XFT
+	{
+		MyFont xft = { 0 };
+
+		if(!FontCacheGet(&xft, xftname)) {
+			fprintf(stderr, "Can't load Xft font %s\n", xftname);
+			return 1;
+		}
+		bench("xft", &xft, title, count);
+	}
+#else
+	(void)xftname;
+	printf("xft   not built in\n");
+#endif
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * Test the color name cache and TrueColor pixel computation
+ */
+
+#include "ctwm.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "color_cache.h"
+
+
+static int
+check_pixel(const Visual *vis, unsigned short r, unsigned short g,
+            unsigned short b, unsigned long expect)
+{
+	XColor col = { .red = r, .green = g, .blue = b };
+	XColor back;
+
+	if(!ColorTrueColorPixel(vis, &col)) {
+		fprintf(stderr, "TrueColor visual not handled\n");
+		return 1;
+	}
+	if(col.pixel != expect) {
+		fprintf(stderr, "#%04x%04x%04x: got pixel 0x%lx, expected 0x%lx\n",
+		        r, g, b, col.pixel, expect);
+		return 1;
+	}
+
+	/* Decoding it again has to give the same adjusted RGB */
+	back.pixel = col.pixel;
+	if(!ColorCacheQuery(None, vis, &back)
+	                || back.red != col.red || back.green != col.green
+	                || back.blue != col.blue) {
+		fprintf(stderr, "pixel 0x%lx doesn't decode consistently\n", col.pixel);
+		return 1;
+	}
+	return 0;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	Visual v24 = { .class = TrueColor, .red_mask = 0xff0000,
+	               .green_mask = 0x00ff00, .blue_mask = 0x0000ff
+	             };
+	Visual v16 = { .class = TrueColor, .red_mask = 0xf800,
+	               .green_mask = 0x07e0, .blue_mask = 0x001f
+	             };
+	Visual pseudo = { .class = PseudoColor };
+	XColor col, q;
+	const ColorCacheStats *st;
+	int ret = 0;
+
+	/* 24-bit */
+	ret += check_pixel(&v24, 0xffff, 0, 0, 0xff0000);
+	ret += check_pixel(&v24, 0, 0xffff, 0xffff, 0x00ffff);
+	ret += check_pixel(&v24, 0x8080, 0x4040, 0x0101, 0x804001);
+	ret += check_pixel(&v24, 0x807f, 0, 0, 0x800000);
+	// Where the server's rounding differs from the nearest step
+	ret += check_pixel(&v24, 0x8101, 0, 0, 0x800000);
+
+	/* 16-bit 565 */
+	ret += check_pixel(&v16, 0xffff, 0xffff, 0xffff, 0xffff);
+	ret += check_pixel(&v16, 0xffff, 0, 0, 0xf800);
+	ret += check_pixel(&v16, 0, 0x8000, 0, 0x0400);
+	ret += check_pixel(&v16, 0x8842, 0x32cb, 0, 0x8180);
+
+	/* Not TrueColor: we can't help */
+	col.red = 0xffff;
+	if(ColorTrueColorPixel(&pseudo, &col)) {
+		fprintf(stderr, "PseudoColor visual shouldn't be computed\n");
+		ret++;
+	}
+
+	/* Name cache, case-insensitive and per-colormap */
+	col = (XColor) {
+		.pixel = 17, .red = 0x1111, .green = 0x2222, .blue = 0x3333
+	};
+	ColorCacheAdd(1, "SteelBlue", &col);
+	if(!ColorCacheLookup(1, "steelblue", &q) || q.pixel != 17
+	                || q.blue != 0x3333) {
+		fprintf(stderr, "Cached name not found\n");
+		ret++;
+	}
+	if(ColorCacheLookup(2, "SteelBlue", &q)) {
+		fprintf(stderr, "Name found in the wrong colormap\n");
+		ret++;
+	}
+	if(ColorCacheLookup(1, "SteelBlue1", &q)) {
+		fprintf(stderr, "Found a name we never added\n");
+		ret++;
+	}
+
+	/* Pixel -> RGB from what we've cached */
+	q.pixel = 17;
+	if(!ColorCacheQuery(1, &pseudo, &q) || q.red != 0x1111
+	                || q.green != 0x2222) {
+		fprintf(stderr, "Cached pixel not found\n");
+		ret++;
+	}
+	q.pixel = 18;
+	if(ColorCacheQuery(1, NULL, &q)) {
+		fprintf(stderr, "Found a pixel we never added\n");
+		ret++;
+	}
+
+	st = ColorCacheGetStats();
+	if(st->hits != 1 || st->misses != 2 || st->entries != 1) {
+		fprintf(stderr, "Stats off: %lu hits, %lu misses, %u entries\n",
+		        st->hits, st->misses, st->entries);
+		ret++;
+	}
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Test colormap install picking and its caching
+ */
+
+#include "ctwm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "colormaps.h"
+#include "screen.h"
+
+
+static int
+check_wanted(const char *what, ColormapWindow **cwins, int n,
+             const char *expect)
+{
+	for(int i = 0; i < n; i++) {
+		bool wanted = (cwins[i]->colormap->state & CM_WANTED) != 0;
+
+		if(wanted != (expect[i] == 'y')) {
+			fprintf(stderr, "%s: window %d %s, expected otherwise\n", what, i,
+			        wanted ? "picked" : "not picked");
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	ScreenInfo scr;
+	TwmWindow tw;
+	ColormapWindow *a, *b, *c;
+	const ColormapStats *st = ColormapGetStats();
+	int ret = 0;
+
+	memset(&scr, 0, sizeof(scr));
+	Scr = &scr;
+	Scr->cmapInfo.maxCmaps = 1;
+
+	/* Without a display, these just make up a colormap each */
+	a = CreateColormapWindow(1, false, false);
+	b = CreateColormapWindow(2, false, false);
+	c = CreateColormapWindow(3, false, false);
+	memset(&tw, 0, sizeof(tw));
+	tw.cmaps.number_cwins = 3;
+	tw.cmaps.cwins = malloc(3 * sizeof(ColormapWindow *));
+	tw.cmaps.cwins[0] = a;
+	tw.cmaps.cwins[1] = b;
+	tw.cmaps.cwins[2] = c;
+	tw.cmaps.scoreboard = calloc(1, ColormapsScoreboardLength(&tw.cmaps));
+
+	/* Room for one: the first */
+	InstallColormaps(EnterNotify, &tw.cmaps);
+	ret += check_wanted("one slot", tw.cmaps.cwins, 3, "ynn");
+	if(st->passes != 1) {
+		fprintf(stderr, "expected 1 pass, got %lu\n", st->passes);
+		ret++;
+	}
+
+	/* Not installed yet, so it has to go again */
+	InstallColormaps(EnterNotify, &tw.cmaps);
+	if(st->passes != 2 || st->cached != 0) {
+		fprintf(stderr, "uninstalled map shouldn't be cached (%lu/%lu)\n",
+		        st->passes, st->cached);
+		ret++;
+	}
+
+	/* Once the server says it is, re-entering is free */
+	a->colormap->state |= CM_INSTALLED;
+	InstallColormaps(EnterNotify, &tw.cmaps);
+	InstallColormaps(VisibilityNotify, NULL);
+	if(st->passes != 2 || st->cached != 2 || st->avoided != 2) {
+		fprintf(stderr, "expected 2 passes, 2 cached, 2 avoided; "
+		        "got %lu/%lu/%lu\n", st->passes, st->cached, st->avoided);
+		ret++;
+	}
+
+	/* Room for two, but the first two conflict */
+	Scr->cmapInfo.maxCmaps = 2;
+	tw.cmaps.scoreboard[0] = 1;
+	ColormapsChanged();
+	InstallColormaps(PropertyNotify, NULL);
+	ret += check_wanted("conflict", tw.cmaps.cwins, 3, "yny");
+
+	/* Hide the first, and the second gets a look in */
+	a->visibility = VisibilityFullyObscured;
+	ColormapsChanged();
+	InstallColormaps(VisibilityNotify, NULL);
+	ret += check_wanted("obscured", tw.cmaps.cwins, 3, "nyy");
+	a->visibility = VisibilityUnobscured;
+
+	/* Rotating the list keeps the a/b conflict, now at (b, a) */
+	BumpWindowColormap(&tw, 1);
+	if(tw.cmaps.cwins[0] != b || tw.cmaps.cwins[2] != a) {
+		fprintf(stderr, "rotation went wrong\n");
+		ret++;
+	}
+	else if(tw.cmaps.scoreboard[0] || !tw.cmaps.scoreboard[1]
+	                || tw.cmaps.scoreboard[2] || st->kept != 1) {
+		fprintf(stderr, "conflict not carried over rotation: %d%d%d, kept %lu\n",
+		        tw.cmaps.scoreboard[0], tw.cmaps.scoreboard[1],
+		        tw.cmaps.scoreboard[2], st->kept);
+		ret++;
+	}
+	ret += check_wanted("rotated", tw.cmaps.cwins, 3, "yyn");
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * Test (and time) IconRegion slot allocation, by iconifying and
+ * deiconifying large batches of icons.
+ */
+
+#include "ctwm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ctwm_main.h"
+#include "ctwm_test.h"
+#include "icons.h"
+#include "screen.h"
+
+
+#define NICONS  400
+#define ROUNDS  50
+
+
+/**
+ * Make sure a region is back to a single free entry covering all of it,
+ * and that the free-slot index agrees.
+ */
+static int
+check_region_empty(IconRegion *ir)
+{
+	IconEntry *ie = ir->entries;
+	int nfree = 0;
+
+	if(ie == NULL || ie->next != NULL || ie->used) {
+		fprintf(stderr, "Region didn't merge back to one free entry\n");
+		return 1;
+	}
+	if(ie->x != ir->x || ie->y != ir->y || ie->w != ir->w || ie->h != ir->h) {
+		fprintf(stderr, "Merged entry %dx%d+%d+%d doesn't cover region\n",
+		        ie->w, ie->h, ie->x, ie->y);
+		return 1;
+	}
+	if(ir->freelist != ie || ie->fnext != NULL) {
+		fprintf(stderr, "Freelist doesn't match entries\n");
+		return 1;
+	}
+	for(int i = 0 ; i < IR_SIZE_BUCKETS ; i++) {
+		for(int j = 0 ; j < IR_SIZE_BUCKETS ; j++) {
+			nfree += ir->freecount[i][j];
+		}
+	}
+	if(nfree != 1) {
+		fprintf(stderr, "Free index counts %d entries, not 1\n", nfree);
+		return 1;
+	}
+	return 0;
+}
+
+
+/**
+ * Fill a region up with assorted icon sizes, checking nothing
+ * overlaps, then empty it in the given order.
+ */
+static int
+fill_and_empty(IconRegion *ir, IconEntry **slots, bool reverse, int *placed)
+{
+	int n;
+
+	for(n = 0 ; n < NICONS ; n++) {
+		const int w = 32 + (n % 3) * 16, h = 32 + (n % 2) * 16;
+
+		slots[n] = IconRegionTakeEntry(ir, w, h);
+		if(slots[n] == NULL) {
+			break;
+		}
+		if(slots[n]->w < w || slots[n]->h < h) {
+			fprintf(stderr, "Got %dx%d slot for %dx%d icon\n",
+			        slots[n]->w, slots[n]->h, w, h);
+			return 1;
+		}
+	}
+	*placed = n;
+
+	// Nothing we handed out may overlap
+	for(int i = 0 ; i < n ; i++) {
+		for(int j = i + 1 ; j < n ; j++) {
+			const IconEntry *a = slots[i], *b = slots[j];
+			if(a->x < b->x + b->w && b->x < a->x + a->w
+			                && a->y < b->y + b->h && b->y < a->y + a->h) {
+				fprintf(stderr, "Slots %d and %d overlap\n", i, j);
+				return 1;
+			}
+		}
+	}
+
+	for(int i = 0 ; i < n ; i++) {
+		IconRegionReleaseEntry(slots[reverse ? n - 1 - i : i]);
+	}
+
+	return check_region_empty(ir);
+}
+
+
+/**
+ * Callback: after the config file gets parsed, work over the
+ * IconRegion's it set up.
+ */
+static int
+test_icon_region(void)
+{
+	IconEntry *slots[NICONS];
+	struct timespec start, end;
+	int placed = 0, total = 0;
+
+	if(Scr == NULL || Scr->FirstRegion == NULL) {
+		fprintf(stderr, "BUG: no IconRegion's from config\n");
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int round = 0 ; round < ROUNDS ; round++) {
+		for(IconRegion *ir = Scr->FirstRegion; ir; ir = ir->next) {
+			if(fill_and_empty(ir, slots, round & 1, &placed)) {
+				return 1;
+			}
+			if(placed == 0) {
+				fprintf(stderr, "Couldn't place anything in region\n");
+				return 1;
+			}
+			total += placed;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	fprintf(stdout, "Placed and removed %d icons in %.3f ms\n", total,
+	        (end.tv_sec - start.tv_sec) * 1e3
+	        + (end.tv_nsec - start.tv_nsec) / 1e6);
+	fprintf(stdout, "OK\n");
+	return 0;
+}
+
+
+/*
+ * Connect up our callback and kick off ctwm.
+ */
+int
+main(int argc, char *argv[])
+{
+	TEST_POSTPARSE(test_icon_region);
+
+	return ctwm_main(argc, argv);
+}
@@ -0,0 +1,128 @@
+/*
+ * Test the f.exec process launcher
+ */
+
+#include "ctwm.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/select.h>
+
+#include "launcher.h"
+
+
+static int
+check_split(const char *cmd, const char *expect)
+{
+	char **argv = LauncherSplitArgv(cmd);
+	char buf[256] = "";
+
+	if(argv != NULL) {
+		for(char **a = argv; *a != NULL; a++) {
+			if(a != argv) {
+				strcat(buf, "|");
+			}
+			strcat(buf, *a);
+		}
+	}
+	LauncherFreeArgv(argv);
+
+	if(expect == NULL ? argv != NULL : strcmp(buf, expect) != 0) {
+		fprintf(stderr, "Split '%s': got '%s', expected '%s'\n",
+		        cmd, argv ? buf : "(shell)", expect ? expect : "(shell)");
+		return 1;
+	}
+	return 0;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	const LauncherStats *st;
+	int ret = 0;
+
+	/* Simple stuff gets split */
+	ret += check_split("xterm", "xterm");
+	ret += check_split("  xterm  -geometry 80x24+0+0\t-e top ", "xterm|-geometry|80x24+0+0|-e|top");
+	ret += check_split("xclock &", "xclock");
+	ret += check_split("emacs --name=foo &  ", "emacs|--name=foo");
+	ret += check_split("/usr/bin/xlock -mode blank", "/usr/bin/xlock|-mode|blank");
+
+	/* Anything shell-y doesn't */
+	ret += check_split("", NULL);
+	ret += check_split("   &", NULL);
+	ret += check_split("xterm -title 'a b'", NULL);
+	ret += check_split("xterm -title $USER", NULL);
+	ret += check_split("ls > /tmp/foo", NULL);
+	ret += check_split("a && b", NULL);
+	ret += check_split("a; b", NULL);
+	ret += check_split("FOO=bar xterm", NULL);
+	ret += check_split("xterm *", NULL);
+	ret += check_split("~/bin/thing", NULL);
+	ret += check_split("xterm & xclock", NULL);
+
+	if(ret != 0) {
+		exit(1);
+	}
+
+
+	/* Start a few things, and make sure they all get reaped */
+	LauncherInit();
+	if(LauncherFd() < 0) {
+		fprintf(stderr, "No launcher fd\n");
+		exit(1);
+	}
+
+	for(int i = 0; i < 10; i++) {
+		if(LauncherRun("true", NULL, true) < 0
+		                || LauncherRun("exit 3", NULL, false) < 0
+		                || LauncherRun("sleep 0 &", NULL, false) < 0) {
+			fprintf(stderr, "Launch failed\n");
+			exit(1);
+		}
+	}
+
+	/*
+	 * Simple, but not something we can find: it has to go to sh, which
+	 * will fail it (and not us silently running nothing).
+	 */
+	if(LauncherRun("ctwm-test-no-such-program -x", NULL, true) < 0) {
+		fprintf(stderr, "Launch via sh failed\n");
+		exit(1);
+	}
+
+	st = LauncherGetStats();
+	if(st->launched != 31 || st->direct != 10) {
+		fprintf(stderr, "Expected 31 launched, 10 direct; got %lu, %lu\n",
+		        st->launched, st->direct);
+		exit(1);
+	}
+
+	for(int tries = 0; st->running > 0 && tries < 100; tries++) {
+		fd_set mask;
+		struct timeval tv = { 0, 100000 };
+
+		FD_ZERO(&mask);
+		FD_SET(LauncherFd(), &mask);
+		select(LauncherFd() + 1, &mask, NULL, NULL, &tv);
+		LauncherReap();
+	}
+	if(st->running != 0 || st->reaped != 31) {
+		fprintf(stderr, "Expected all 31 reaped; %lu running, %lu reaped\n",
+		        st->running, st->reaped);
+		exit(1);
+	}
+
+	/* The exit 3's, and sh not finding the missing program */
+	if(st->badexit != 11) {
+		fprintf(stderr, "Expected 11 unsuccessful; got %lu\n", st->badexit);
+		exit(1);
+	}
+
+	printf("%lu launches, avg %.3f ms, max %.3f ms to return\n",
+	       st->launched, st->total_ms / st->launched, st->max_ms);
+
+	exit(0);
+}
@@ -498,6 +498,7 @@ int
 main(int argc, char **argv)
 {
 	int i, error;
+	const RAreaListStats *stats;
 
 	if(argc < 2) {
 		fprintf(stderr, "usage: %s TEST_FILE ...\n", argv[0]);
@@ -510,5 +511,13 @@ main(int argc, char **argv)
 		error = read_test_from_file(argv[i]) || error;
 	}
 
+	// The layout queries' temporaries should all have fit their arenas
+	stats = RAreaListGetStats();
+	if(stats->arena == 0 || stats->arena_overflow != 0) {
+		fprintf(stderr, "RAreaList arenas: %lu used, %lu overflowed to heap\n",
+		        stats->arena, stats->arena_overflow);
+		error = 1;
+	}
+
 	return error;
 }
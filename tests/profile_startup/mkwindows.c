@@ -0,0 +1,83 @@
+/*
+ * Put up a bunch of ordinary top-level windows, as a synthetic session
+ * for ctwm to adopt at startup.
+ *
+ *   mkwindows [count]
+ *
+ * Once they're all mapped it forks; the parent prints the child's PID
+ * and exits, and the child keeps the windows up until it's killed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+
+int
+main(int argc, char *argv[])
+{
+	Display *dpy;
+	int count = 200;
+	int scr;
+	pid_t pid;
+
+	if(argc > 1) {
+		count = atoi(argv[1]);
+	}
+
+	dpy = XOpenDisplay(NULL);
+	if(dpy == NULL) {
+		fprintf(stderr, "Can't open display\n");
+		return 1;
+	}
+	scr = DefaultScreen(dpy);
+
+	for(int i = 0; i < count; i++) {
+		char name[64];
+		char *namep = name;
+		XTextProperty tp;
+		XClassHint ch = { "mkwindows", "MkWindows" };
+		XWMHints wmh = { .flags = InputHint | StateHint,
+		                 .input = True, .initial_state = NormalState
+		               };
+		XSizeHints sh = { .flags = USPosition | PSize | PMinSize };
+		Window w;
+
+		sh.x = (i * 37) % (DisplayWidth(dpy, scr) - 300);
+		sh.y = (i * 23) % (DisplayHeight(dpy, scr) - 200);
+		sh.width = 200 + (i % 5) * 20;
+		sh.height = 100 + (i % 3) * 20;
+		sh.min_width = sh.min_height = 50;
+
+		w = XCreateSimpleWindow(dpy, RootWindow(dpy, scr), sh.x, sh.y,
+		                        sh.width, sh.height, 1,
+		                        BlackPixel(dpy, scr), WhitePixel(dpy, scr));
+
+		snprintf(name, sizeof(name), "synthetic window %d", i);
+		XStringListToTextProperty(&namep, 1, &tp);
+		XSetWMProperties(dpy, w, &tp, &tp, argv, argc, &sh, &wmh, &ch);
+		XFree(tp.value);
+
+		XMapWindow(dpy, w);
+	}
+	XSync(dpy, False);
+
+	pid = fork();
+	if(pid < 0) {
+		perror("fork");
+		return 1;
+	}
+	if(pid > 0) {
+		printf("%d\n", (int)pid);
+		return 0;
+	}
+
+	// Keep the connection (and so the windows) around
+	for(;;) {
+		XEvent ev;
+		XNextEvent(dpy, &ev);
+	}
+}
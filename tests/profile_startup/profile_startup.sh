@@ -0,0 +1,69 @@
+#!/bin/sh
+#
+# Start an Xvfb, put up a synthetic session, and profile ctwm's startup
+# on it.
+#
+# profile_startup.sh Xvfb mkwindows ctwm config nwindows
+
+XVFB=$1
+MKWINDOWS=$2
+CTWM=$3
+CONFIG=$4
+NWINDOWS=${5:-200}
+
+# Find a free display
+n=90
+while [ -e /tmp/.X${n}-lock ]; do
+	n=$((n + 1))
+done
+DISPLAY=:${n}
+export DISPLAY
+
+LOG=$(mktemp "${TMPDIR:-/tmp}/ctwm-profile.XXXXXX")
+xvfb=
+mkwin=
+ctwm=
+cleanup() {
+	for p in $ctwm $mkwin $xvfb; do
+		kill $p 2>/dev/null
+	done
+	rm -f "$LOG"
+}
+trap cleanup EXIT INT TERM
+
+"$XVFB" "$DISPLAY" -screen 0 1600x1200x24 -nolisten tcp >/dev/null 2>&1 &
+xvfb=$!
+
+# Wait for it to come up
+i=0
+while [ ! -e /tmp/.X11-unix/X${n} ]; do
+	i=$((i + 1))
+	if [ $i -gt 100 ]; then
+		echo "Xvfb didn't start" >&2
+		exit 1
+	fi
+	sleep 0.1
+done
+
+mkwin=$("$MKWINDOWS" "$NWINDOWS") || exit 1
+
+"$CTWM" --profile-startup -W -f "$CONFIG" 2>"$LOG" &
+ctwm=$!
+
+# The report is printed once startup's done.  The phase table's total
+# line is always there, even if no windows got adopted; the per-window
+# part, if any, follows right after it.
+i=0
+while ! grep -q '^  total ' "$LOG"; do
+	i=$((i + 1))
+	if [ $i -gt 600 ] || ! kill -0 $ctwm 2>/dev/null; then
+		echo "ctwm didn't finish starting up" >&2
+		cat "$LOG" >&2
+		exit 1
+	fi
+	sleep 0.1
+done
+sleep 0.5
+
+cat "$LOG"
+exit 0
@@ -0,0 +1,121 @@
+/*
+ * Test property write suppression and batching
+ */
+
+#include "ctwm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/Xatom.h>
+
+#include "prop_writer.h"
+
+
+static int
+check(const char *what, unsigned long got, unsigned long expect)
+{
+	if(got != expect) {
+		fprintf(stderr, "%s: got %lu, expected %lu\n", what, got, expect);
+		return 1;
+	}
+	return 0;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	/* Without a display, writes are only counted */
+	const PropStats *st = PropGetStats();
+	const Window w1 = 0x200001, w2 = 0x400001;
+	const Atom state = 100, desk = 101;
+	unsigned long v[2] = { 1, 0 };
+	int ret = 0;
+
+	/* First one always goes out */
+	PropSet(w1, state, state, 32, v, 2);
+	ret += check("nothing sent before flush", st->writes, 0);
+	PropFlush();
+	ret += check("first write", st->writes, 1);
+	ret += check("first flush", st->flushes, 1);
+
+	/* Same again is dropped, and there's nothing to flush */
+	PropSet(w1, state, state, 32, v, 2);
+	PropFlush();
+	ret += check("same value suppressed", st->suppressed, 1);
+	ret += check("no write for same value", st->writes, 1);
+	ret += check("empty flush", st->flushes, 1);
+
+	/* Same property on another window is separate */
+	PropSet(w2, state, state, 32, v, 2);
+	ret += check("other window not suppressed", st->suppressed, 1);
+
+	/* Several changes in between flushes make one write */
+	v[0] = 3;
+	PropSet(w1, state, state, 32, v, 2);
+	v[0] = 1;
+	PropSet(w1, state, state, 32, v, 2);
+	ret += check("merged", st->coalesced, 1);
+	PropFlush();
+	ret += check("one write each", st->writes, 3);
+
+	/* Different length isn't the same value */
+	PropSet(w1, state, state, 32, v, 1);
+	PropFlush();
+	ret += check("shorter value written", st->writes, 4);
+
+	/* Strings */
+	PropSet(w1, desk, XA_STRING, 8, "one", 3);
+	PropSet(w1, desk, XA_STRING, 8, "two", 3);
+	PropFlush();
+	PropSet(w1, desk, XA_STRING, 8, "two", 3);
+	ret += check("string unchanged", st->suppressed, 2);
+	ret += check("string written", st->writes, 5);
+
+	/* Once somebody else has set it, we can't skip it */
+	PropInvalidate(w1, desk);
+	PropSet(w1, desk, XA_STRING, 8, "two", 3);
+	PropFlush();
+	ret += check("invalidated write", st->writes, 6);
+
+	/* Deletes */
+	PropDelete(w1, desk);
+	PropDelete(w1, desk);
+	PropFlush();
+	ret += check("one delete", st->deletes, 1);
+	ret += check("second delete suppressed", st->suppressed, 3);
+	PropSet(w1, desk, XA_STRING, 8, "two", 3);
+	PropFlush();
+	ret += check("set after delete", st->writes, 7);
+
+	/* Forgetting drops what's pending, and then starts over */
+	v[0] = 5;
+	PropDelete(w2, desk);
+	PropSet(w1, state, state, 32, v, 1);
+	PropSet(w2, state, state, 32, v, 2);
+	PropForget(w2);
+	ret += check("pending dropped on forget", st->dropped, 2);
+	PropFlush();
+	ret += check("no delete after forget", st->deletes, 1);
+	ret += check("other window's pending kept", st->writes, 8);
+	v[0] = 1;
+	PropSet(w2, state, state, 32, v, 2);
+	PropFlush();
+	ret += check("forgotten window written", st->writes, 9);
+
+	/* The dirty list still works after dropping from it */
+	PropSet(w2, desk, XA_STRING, 8, "three", 5);
+	PropFlush();
+	ret += check("written after drop", st->writes, 10);
+
+	/* And w1's still remembered */
+	PropSet(w1, desk, XA_STRING, 8, "two", 3);
+	ret += check("other window still cached", st->suppressed, 4);
+
+	if(ret == 0) {
+		PropReport(stdout);
+	}
+	return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/*
+ * Test the main loop reactor
+ */
+
+#include "ctwm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "reactor.h"
+#include "timers.h"
+
+
+static int calls;
+static int lastfd = -1;
+
+static void
+readable(int fd, void *arg)
+{
+	char buf[16];
+
+	read(fd, buf, sizeof(buf));
+	calls++;
+	lastfd = fd;
+	if(arg != NULL) {
+		/* Removing ourselves from inside the callback */
+		ReactorRemoveFd(fd);
+	}
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	int p1[2], p2[2];
+	const ReactorStats *st;
+	uint64_t start;
+	int ret;
+
+	if(pipe(p1) != 0 || pipe(p2) != 0) {
+		perror("pipe");
+		exit(1);
+	}
+	if(!ReactorAddFd(p1[0], "one", readable, NULL)
+	                || !ReactorAddFd(p2[0], "two", readable, (void *)1)) {
+		fprintf(stderr, "Can't add fds\n");
+		exit(1);
+	}
+	st = ReactorGetStats();
+
+	/* Nothing ready: should time out, and not too early */
+	start = TimerNow();
+	ret = ReactorWait(50);
+	if(ret != 0 || TimerNow() - start < 45 || st->timeouts != 1) {
+		fprintf(stderr, "Expected a timeout, got %d after %llu ms\n", ret,
+		        (unsigned long long)(TimerNow() - start));
+		exit(1);
+	}
+
+	/* Readable fds get their callbacks */
+	write(p1[1], "x", 1);
+	ret = ReactorWait(1000);
+	if(ret != 1 || calls != 1 || lastfd != p1[0]) {
+		fprintf(stderr, "Expected a call for fd %d, got %d calls (%d)\n",
+		        p1[0], calls, lastfd);
+		exit(1);
+	}
+
+	/* One that removes itself doesn't get called again */
+	write(p2[1], "x", 1);
+	ReactorWait(1000);
+	write(p2[1], "x", 1);
+	ret = ReactorWait(50);
+	if(calls != 2 || ret != 0) {
+		fprintf(stderr, "Removed fd still watched: %d calls\n", calls);
+		exit(1);
+	}
+
+	/* Wakeups (from signal handlers) interrupt the wait */
+	ReactorWakeup();
+	start = TimerNow();
+	ret = ReactorWait(5000);
+	if(ret != 1 || st->signals != 1 || TimerNow() - start > 1000) {
+		fprintf(stderr, "Wakeup didn't wake us: %d, %lu\n", ret, st->signals);
+		exit(1);
+	}
+
+	ReactorReport(stdout);
+	exit(0);
+}
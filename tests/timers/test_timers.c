@@ -0,0 +1,166 @@
+/*
+ * Test the timer wheel
+ */
+
+#include "ctwm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "timers.h"
+
+
+/* Pretend clock; the wheel's driven by TimerRunUntil() in here */
+#define T0 UINT64_C(1000000)
+
+static uint64_t clock_now;
+static uint64_t fired_at[64];
+static int nfired;
+
+
+static void
+record(void *arg)
+{
+	int i = (int)(intptr_t)arg;
+
+	fired_at[i] = clock_now;
+	nfired++;
+}
+
+
+/* A timer that keeps re-arming itself every 50ms, a few times */
+static Timer repeater;
+static int repeats;
+
+static void
+repeat(void *arg)
+{
+	repeats++;
+	if(repeats < 5) {
+		TimerSetAt(&repeater, clock_now + 50);
+	}
+}
+
+
+/*
+ * Step the pretend clock along 1ms at a time, so we can see exactly when
+ * things fire.
+ */
+static void
+run_to(uint64_t when)
+{
+	while(clock_now < when) {
+		clock_now++;
+		TimerRunUntil(clock_now);
+	}
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	/* Spread across all the wheel levels */
+	static const uint64_t delays[] = {
+		0, 1, 5, 63, 64, 65, 200, 4095, 4096, 4097, 70000, 262143, 262144,
+		300000, 5000000,
+	};
+	const int ndelays = sizeof(delays) / sizeof(delays[0]);
+	Timer timers[sizeof(delays) / sizeof(delays[0])];
+	Timer cancelled;
+	const TimerStats *st;
+	uint64_t next;
+
+	clock_now = T0;
+	TimerRunUntil(clock_now);
+
+	for(int i = 0; i < ndelays; i++) {
+		TimerInit(&timers[i], record, (void *)(intptr_t)i);
+		TimerSetAt(&timers[i], T0 + delays[i]);
+	}
+	TimerInit(&cancelled, record, (void *)(intptr_t)63);
+	TimerSetAt(&cancelled, T0 + 100);
+
+	if(!TimerNextExpiry(&next) || next != T0 + 1) {
+		// 0 delay is already due, so it fires next run at T0+1
+		fprintf(stderr, "Next expiry %llu, expected %llu\n",
+		        (unsigned long long)next, (unsigned long long)(T0 + 1));
+		exit(1);
+	}
+
+	/* Moving a timer and cancelling one */
+	TimerSetAt(&timers[6], T0 + 250);
+	TimerCancel(&cancelled);
+	TimerCancel(&cancelled);
+	if(TimerPending(&cancelled) || !TimerPending(&timers[6])) {
+		fprintf(stderr, "Bad pending state after cancel/move\n");
+		exit(1);
+	}
+
+	/* Step through the first stretch exactly */
+	run_to(T0 + 5000);
+	for(int i = 0; i < ndelays; i++) {
+		uint64_t want = T0 + (i == 6 ? 250 : delays[i]);
+
+		if(delays[i] > 5000) {
+			continue;
+		}
+		if(want <= T0) {
+			want = T0 + 1;
+		}
+		if(fired_at[i] != want) {
+			fprintf(stderr, "Timer %d (+%llu) fired at +%lld\n", i,
+			        (unsigned long long)delays[i],
+			        (long long)(fired_at[i] - T0));
+			exit(1);
+		}
+	}
+
+	/* Then leap ahead in bigger jumps, like after a long sleep */
+	for(int i = 0; i < ndelays; i++) {
+		if(delays[i] <= 5000) {
+			continue;
+		}
+		if(!TimerNextExpiry(&next) || next != T0 + delays[i]) {
+			fprintf(stderr, "Next expiry +%lld, expected +%llu\n",
+			        (long long)(next - T0), (unsigned long long)delays[i]);
+			exit(1);
+		}
+		clock_now = next - 1;
+		TimerRunUntil(clock_now);
+		if(fired_at[i] != 0) {
+			fprintf(stderr, "Timer %d fired early\n", i);
+			exit(1);
+		}
+		clock_now = next;
+		TimerRunUntil(clock_now);
+		if(fired_at[i] != T0 + delays[i]) {
+			fprintf(stderr, "Timer %d (+%llu) fired at +%lld\n", i,
+			        (unsigned long long)delays[i],
+			        (long long)(fired_at[i] - T0));
+			exit(1);
+		}
+	}
+	if(nfired != ndelays || TimerNextExpiry(&next)) {
+		fprintf(stderr, "%d fired, expected %d\n", nfired, ndelays);
+		exit(1);
+	}
+
+	/* Re-arming from inside the callback */
+	TimerInit(&repeater, repeat, NULL);
+	TimerSetAt(&repeater, clock_now + 50);
+	run_to(clock_now + 1000);
+	if(repeats != 5 || TimerPending(&repeater)) {
+		fprintf(stderr, "Repeater ran %d times, expected 5\n", repeats);
+		exit(1);
+	}
+
+	st = TimerGetStats();
+	if(st->pending != 0 || st->cancelled != 1) {
+		fprintf(stderr, "Stats: %u pending, %lu cancelled\n", st->pending,
+		        st->cancelled);
+		exit(1);
+	}
+	printf("%lu fired, %lu cascaded\n", st->fired, st->cascaded);
+
+	exit(0);
+}
@@ -0,0 +1,358 @@
+/*
+ * Timers for the main loop
+ *
+ * Things that need to happen later (animation frames, and so on) arm a
+ * Timer, and CtwmNextEvent() sleeps until the earliest one is due rather
+ * than waking on a fixed tick and going looking for work.
+ *
+ * Pending timers live on a hierarchical timing wheel, with a 1ms
+ * resolution: TW_LEVELS levels of TW_SLOTS slots each, every level
+ * TW_SLOTS times coarser than the one below.  Arming and cancelling are
+ * O(1); timers on the coarser levels get moved down ("cascaded") as
+ * their time comes closer.  Anything further out than the wheel spans
+ * (about 4.6 hours) sits in the top level and gets re-placed whenever it
+ * comes around.
+ */
+
+#include "ctwm.h"
+
+#include <limits.h>
+#include <time.h>
+
+#include "timers.h"
+
+
+#define TW_BITS   6
+#define TW_SLOTS  (1 << TW_BITS)
+#define TW_MASK   (TW_SLOTS - 1)
+#define TW_LEVELS 4
+#define TW_SPAN   (UINT64_C(1) << (TW_BITS * TW_LEVELS))
+
+static Timer *wheel[TW_LEVELS][TW_SLOTS];
+static unsigned int levelCount[TW_LEVELS];
+
+/* The next ms to be processed; everything before it has been run */
+static uint64_t base;
+
+static TimerStats stats;
+
+
+/**
+ * Current time in ms, on a clock that doesn't jump around.
+ */
+uint64_t
+TimerNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/*
+ * Put a timer in the right slot for its expiry, relative to where the
+ * wheel currently is.
+ */
+static void
+place(Timer *t)
+{
+	uint64_t e = t->expires;
+	uint64_t idx;
+	int level;
+	Timer **slot;
+
+	if(e < base) {
+		e = base;
+	}
+	idx = e - base;
+	if(idx >= TW_SPAN) {
+		idx = TW_SPAN - 1;
+		e = base + idx;
+	}
+	for(level = 0; level < TW_LEVELS - 1; level++) {
+		if(idx < (UINT64_C(1) << (TW_BITS * (level + 1)))) {
+			break;
+		}
+	}
+
+	slot = &wheel[level][(e >> (TW_BITS * level)) & TW_MASK];
+	t->next = *slot;
+	if(t->next) {
+		t->next->pprev = &t->next;
+	}
+	t->pprev = slot;
+	*slot = t;
+	t->level = level;
+	levelCount[level]++;
+}
+
+static void
+detach(Timer *t)
+{
+	*t->pprev = t->next;
+	if(t->next) {
+		t->next->pprev = t->pprev;
+	}
+	levelCount[t->level]--;
+	t->next = NULL;
+	t->pprev = NULL;
+	t->level = -1;
+}
+
+
+/**
+ * Setup a Timer before first use.
+ */
+void
+TimerInit(Timer *t, TimerFunc func, void *arg)
+{
+	t->next = NULL;
+	t->pprev = NULL;
+	t->expires = 0;
+	t->func = func;
+	t->arg = arg;
+	t->level = -1;
+}
+
+
+/**
+ * Arm a timer to fire at a given TimerNow() time.  If it's already
+ * pending, it's moved.  Times in the past fire on the next TimerRun().
+ */
+void
+TimerSetAt(Timer *t, uint64_t when)
+{
+	if(t->level >= 0) {
+		detach(t);
+	}
+	else {
+		stats.pending++;
+	}
+	t->expires = when;
+	place(t);
+	stats.added++;
+}
+
+
+/**
+ * Arm a timer to fire ms milliseconds from now.
+ */
+void
+TimerSet(Timer *t, unsigned int ms)
+{
+	TimerSetAt(t, TimerNow() + ms);
+}
+
+
+/**
+ * Disarm a timer.  It's fine to cancel one that isn't pending.
+ */
+void
+TimerCancel(Timer *t)
+{
+	if(t->level < 0) {
+		return;
+	}
+	detach(t);
+	stats.pending--;
+	stats.cancelled++;
+}
+
+
+/**
+ * Is the timer armed?
+ */
+bool
+TimerPending(const Timer *t)
+{
+	return t->level >= 0;
+}
+
+
+/*
+ * Move everything in a slot down to where it belongs now.  Returns the
+ * slot index, so the caller knows whether the next level up is due too.
+ */
+static int
+cascade(int level)
+{
+	int idx = (base >> (TW_BITS * level)) & TW_MASK;
+	Timer *t, *next;
+
+	t = wheel[level][idx];
+	wheel[level][idx] = NULL;
+	for(; t != NULL; t = next) {
+		next = t->next;
+		levelCount[level]--;
+		place(t);
+		stats.cascaded++;
+	}
+	return idx;
+}
+
+
+/**
+ * Run everything that's due by the given time.
+ */
+void
+TimerRunUntil(uint64_t now)
+{
+	while(base <= now) {
+		Timer *t;
+		int level;
+
+		if(stats.pending == 0) {
+			base = now + 1;
+			break;
+		}
+
+		/* Crossing into a new span of a coarser level? */
+		if((base & TW_MASK) == 0) {
+			for(level = 1; level < TW_LEVELS; level++) {
+				if(cascade(level) != 0) {
+					break;
+				}
+			}
+		}
+
+		/*
+		 * Take the whole slot before running any of it; callbacks
+		 * re-arming themselves go into the fresh list for a later ms.
+		 */
+		t = wheel[0][base & TW_MASK];
+		wheel[0][base & TW_MASK] = NULL;
+		if(t) {
+			t->pprev = &t;
+		}
+		base++;
+		while(t != NULL) {
+			Timer *cur = t;
+
+			detach(cur);
+			stats.pending--;
+			stats.fired++;
+			cur->func(cur->arg);
+		}
+
+		/*
+		 * Nothing due at the finest level; skip ahead to the next
+		 * boundary where something might cascade down.
+		 */
+		if(levelCount[0] == 0 && base <= now) {
+			uint64_t step;
+
+			for(level = 1; level < TW_LEVELS; level++) {
+				if(levelCount[level] != 0) {
+					break;
+				}
+			}
+			if(level == TW_LEVELS) {
+				base = now + 1;
+				break;
+			}
+			step = UINT64_C(1) << (TW_BITS * level);
+			base = (base + step - 1) & ~(step - 1);
+			if(base > now + 1) {
+				base = now + 1;
+			}
+		}
+	}
+}
+
+
+/**
+ * Run everything that's due.
+ */
+void
+TimerRun(void)
+{
+	TimerRunUntil(TimerNow());
+}
+
+
+/**
+ * When the next timer is due.  Returns false if there's none pending.
+ */
+bool
+TimerNextExpiry(uint64_t *when)
+{
+	uint64_t best = UINT64_MAX;
+
+	if(stats.pending == 0) {
+		return false;
+	}
+
+	/* The finest level is exact; the first occupied slot is it */
+	if(levelCount[0] != 0) {
+		for(int k = 0; k < TW_SLOTS; k++) {
+			if(wheel[0][(base + k) & TW_MASK] != NULL) {
+				best = base + k;
+				break;
+			}
+		}
+	}
+
+	/* Coarser ones aren't; look at what's actually in them */
+	for(int level = 1; level < TW_LEVELS; level++) {
+		if(levelCount[level] == 0) {
+			continue;
+		}
+		for(int i = 0; i < TW_SLOTS; i++) {
+			for(Timer *t = wheel[level][i]; t != NULL; t = t->next) {
+				uint64_t e = t->expires < base ? base : t->expires;
+				if(e < best) {
+					best = e;
+				}
+			}
+		}
+	}
+
+	*when = best;
+	return true;
+}
+
+
+/**
+ * How long until the next timer is due, in ms, for a poll()-ish
+ * timeout.  -1 if nothing's pending.
+ */
+int
+TimerTimeout(void)
+{
+	uint64_t when, now;
+
+	if(!TimerNextExpiry(&when)) {
+		return -1;
+	}
+	now = TimerNow();
+	if(when <= now) {
+		return 0;
+	}
+	if(when - now > INT_MAX) {
+		return INT_MAX;
+	}
+	return when - now;
+}
+
+
+/**
+ * Current timer counters.
+ */
+const TimerStats *
+TimerGetStats(void)
+{
+	return &stats;
+}
+
+
+/**
+ * Say how much the timers got used.
+ */
+void
+TimerReport(FILE *out)
+{
+	fprintf(out, "Timers: %lu armed, %lu fired, %lu cancelled, "
+	        "%lu cascaded; %u pending\n", stats.added, stats.fired,
+	        stats.cancelled, stats.cascaded, stats.pending);
+}
@@ -0,0 +1,50 @@
+/*
+ * Timers for the main loop
+ */
+
+#ifndef _CTWM_TIMERS_H
+#define _CTWM_TIMERS_H
+
+#include <stdio.h>  // For FILE
+#include <stdint.h>
+
+
+typedef void (*TimerFunc)(void *arg);
+
+/**
+ * A pending (or not) callback.  These are allocated by the caller,
+ * usually inside whatever the timer is about, and set up with
+ * TimerInit().  Everything but func and arg is private to timers.c.
+ */
+typedef struct Timer {
+	struct Timer *next;      ///< Wheel slot list
+	struct Timer **pprev;
+	uint64_t expires;        ///< When to fire, on the TimerNow() clock
+	TimerFunc func;          ///< Called when it fires
+	void *arg;               ///< ... with this
+	int level;               ///< Wheel level it's on, -1 if not pending
+} Timer;
+
+/// Counts of timer activity, for diagnostics
+typedef struct TimerStats {
+	unsigned long added;      ///< Timers (re)armed
+	unsigned long fired;      ///< Callbacks run
+	unsigned long cancelled;  ///< Cancelled while pending
+	unsigned long cascaded;   ///< Moves down from a coarser wheel level
+	unsigned int pending;     ///< Currently armed
+} TimerStats;
+
+void TimerInit(Timer *t, TimerFunc func, void *arg);
+void TimerSet(Timer *t, unsigned int ms);
+void TimerSetAt(Timer *t, uint64_t when);
+void TimerCancel(Timer *t);
+bool TimerPending(const Timer *t);
+bool TimerNextExpiry(uint64_t *when);
+int TimerTimeout(void);
+void TimerRun(void);
+void TimerRunUntil(uint64_t now);
+uint64_t TimerNow(void);
+const TimerStats *TimerGetStats(void);
+void TimerReport(FILE *out);
+
+#endif /* _CTWM_TIMERS_H */
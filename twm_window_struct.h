@@ -75,6 +75,14 @@ struct TwmWindow {
 	struct Icon *icon;     ///< The current icon.  \sa CreateIconWindow()
 	name_list *iconslist;  ///< The current list of potential icons
 
+	/// The IconRegion slot our icon is placed in, if any.
+	struct IconEntry *iconEntry;
+	/// The first IconRegion whose client list matches us.  Only valid
+	/// when TwmWindow.iconRegionKnown is set; looked up once by
+	/// PlaceIcon() and forgotten when the window name changes.
+	struct IconRegion *iconRegion;
+	bool iconRegionKnown;  ///< Has TwmWindow.iconRegion been looked up?
+
 	/// \addtogroup win_frame Window frame bits
 	/// @{
 	int frame_x;                ///< X position on screen of frame
@@ -192,6 +200,9 @@ struct TwmWindow {
 
 	bool titlehighlight;      ///< Should I highlight the title bar?
 
+	int raise_delay;  ///< ms in the window before auto-raising it
+	int lower_delay;  ///< ms out of the window before auto-lowering it
+
 	/// Pointer to the icon manager structure, for windows that are icon
 	/// managers.  Currently also set for some other window types to
 	/// various things, but is only ever used for icon manager windows
@@ -69,6 +69,7 @@ typedef struct OtpPreferences OtpPreferences;
 /* From r_structs.h */
 typedef struct RArea RArea;
 typedef struct RAreaList RAreaList;
+typedef struct RAreaArena RAreaArena;
 typedef struct RLayout RLayout;
 
 #endif /* _CTWM_TYPES_H */
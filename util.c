@@ -42,8 +42,10 @@
 
 #include "animate.h"
 #include "add_window.h"
+#include "color_cache.h"
 #include "cursor.h"
 #include "drawing.h"
+#include "font_cache.h"
 #include "gram.tab.h"
 #include "iconmgr.h"
 #include "icons.h"
@@ -147,8 +149,23 @@ ExpandFilename(const char *name)
 /*
  * Some color utils
  */
+/*
+ * The visual of cmap, if it's one we can work out pixel values for
+ * ourselves; NULL if we need to go through the server.
+ */
+static const Visual *
+directVisual(Colormap cmap)
+{
+	if(cmap != DefaultColormap(dpy, Scr->screen)) {
+		return NULL;
+	}
+	return Scr->d_visual;
+}
+
+
 /**
- * Get info from the server about a given color.
+ * Get info from the server about a given color.  Results are cached for
+ * the whole run, so each name only costs us the server's time once.
  */
 void
 GetColor(int kind, Pixel *what, const char *name)
@@ -173,11 +190,22 @@ GetColor(int kind, Pixel *what, const char *name)
 		return;
 	}
 
+	if(ColorCacheLookup(cmap, name, &color)) {
+		*what = color.pixel;
+		return;
+	}
+
 	if(! XParseColor(dpy, cmap, name, &color)) {
 		fprintf(stderr, "%s:  invalid color name \"%s\"\n", ProgramName, name);
 		return;
 	}
-	if(! XAllocColor(dpy, cmap, &color)) {
+	if(ColorTrueColorPixel(directVisual(cmap), &color)) {
+		ColorCacheAdd(cmap, name, &color);
+	}
+	else if(XAllocColor(dpy, cmap, &color)) {
+		ColorCacheAdd(cmap, name, &color);
+	}
+	else {
 		/* if we could not allocate the color, let's see if this is a
 		 * standard colormap
 		 */
@@ -262,7 +290,9 @@ GetShadeColors(ColorPair *cp)
 	clearfactor = (float) Scr->ClearShadowContrast / 100.0;
 	darkfactor  = (100.0 - (float) Scr->DarkShadowContrast)  / 100.0;
 	xcol.pixel = cp->back;
-	XQueryColor(dpy, cmap, &xcol);
+	if(!ColorCacheQuery(cmap, directVisual(cmap), &xcol)) {
+		XQueryColor(dpy, cmap, &xcol);
+	}
 
 	sprintf(clearcol, "#%04x%04x%04x",
 	        xcol.red   + (unsigned short)((65535 -   xcol.red) * clearfactor),
@@ -309,21 +339,12 @@ UpdateFont(MyFont *font, int height)
 
 /**
  * Load up fontsets from the X server.  Only used by CreateFonts() below.
+ * Identical fonts share their font set, via the font cache.
  */
 static void
 GetFont(MyFont *font)
 {
 	char *deffontname = "fixed,*";
-	char **missing_charset_list_return;
-	int missing_charset_count_return;
-	char *def_string_return;
-	XFontSetExtents *font_extents;
-	XFontStruct **xfonts;
-	char **font_names;
-	int i;
-	int ascent;
-	int descent;
-	int fnum;
 	char *basename2;
 
 	// In special cases where we have no dpy, I don't think we're going
@@ -334,42 +355,27 @@ GetFont(MyFont *font)
 		return;
 	}
 
-	if(font->font_set != NULL) {
-		XFreeFontSet(dpy, font->font_set);
-	}
+	FontCacheRelease(font);
 
-	asprintf(&basename2, "%s,*", font->basename);
-	if((font->font_set = XCreateFontSet(dpy, basename2,
-	                                    &missing_charset_list_return,
-	                                    &missing_charset_count_return,
-	                                    &def_string_return)) == NULL) {
+	if(FontIsXft(font->basename)) {
+		basename2 = strdup(font->basename);
+	}
+	else {
+		asprintf(&basename2, "%s,*", font->basename);
+	}
+	if(!FontCacheGet(font, basename2)) {
 		fprintf(stderr, "Failed to get fontset %s\n", basename2);
 		if(Scr->DefaultFont.basename) {
 			deffontname = Scr->DefaultFont.basename;
 		}
-		if((font->font_set = XCreateFontSet(dpy, deffontname,
-		                                    &missing_charset_list_return,
-		                                    &missing_charset_count_return,
-		                                    &def_string_return)) == NULL) {
+		if(!FontCacheGet(font, deffontname)) {
 			fprintf(stderr, "%s:  unable to open fonts \"%s\" or \"%s\"\n",
 			        ProgramName, font->basename, deffontname);
 			exit(1);
 		}
 	}
 	free(basename2);
-	font_extents = XExtentsOfFontSet(font->font_set);
-
-	fnum = XFontsOfFontSet(font->font_set, &xfonts, &font_names);
-	for(i = 0, ascent = 0, descent = 0; i < fnum; i++) {
-		ascent = MaxSize(ascent, (*xfonts)->ascent);
-		descent = MaxSize(descent, (*xfonts)->descent);
-		xfonts++;
-	}
 
-	font->height = font_extents->max_logical_extent.height;
-	font->y = ascent;
-	font->ascent = ascent;
-	font->descent = descent;
 	font->avg_height = 0;
 	font->avg_fheight = 0.0;
 	font->avg_count = 0;
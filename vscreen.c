@@ -9,11 +9,13 @@
 
 #include <X11/Xatom.h>
 
+#include "animate.h"
 #include "ctwm_atoms.h"
 #include "cursor.h"
 #include "icons.h"
 #include "list.h"
 #include "otp.h"
+#include "prop_writer.h"
 #include "screen.h"
 #include "vscreen.h"
 #include "win_utils.h"
@@ -89,6 +91,7 @@ void InitVirtualScreens(ScreenInfo *scr)
 		vs->window = XCreateWindow(dpy, Scr->Root, x, y, w, h,
 		                           0, CopyFromParent, CopyFromParent,
 		                           CopyFromParent, valuemask, &attributes);
+		note_event_mask(vs->window, attrmask);
 		vs->wsw = 0;
 
 		XSync(dpy, 0);
@@ -212,8 +215,7 @@ CtwmSetVScreenMap(Display *display, Window rootw,
 		return false;
 	}
 
-	XChangeProperty(display, rootw, XA_WM_CTWM_VSCREENMAP, XA_STRING, 8,
-	                PropModeReplace, (unsigned char *)buf, strlen(buf));
+	PropSet(rootw, XA_WM_CTWM_VSCREENMAP, XA_STRING, 8, buf, strlen(buf));
 	return true;
 }
 
@@ -227,6 +229,7 @@ DisplayWin(VirtualScreen *vs, TwmWindow *tmp_win)
 	OtpCheckConsistency();
 	DisplayWinUnchecked(vs, tmp_win);
 	OtpCheckConsistency();
+	AnimationAddWindow(tmp_win);
 }
 
 static void
@@ -23,6 +23,7 @@
 #include "workspace_manager.h"
 
 #include "win_decorations.h"
+#include "win_decorations_atlas.h"
 
 
 /* Internal bits */
@@ -32,8 +33,10 @@ static void CreateHighlightWindows(TwmWindow *tmp_win);
 static void CreateLowlightWindows(TwmWindow *tmp_win);
 
 typedef enum { TopLeft, TopRight, BottomRight, BottomLeft } CornerType;
-static void Draw3DCorner(Window w, int x, int y, int width, int height,
+static void Draw3DCorner(Drawable w, int x, int y, int width, int height,
                          int thick, int bw, ColorPair cp, CornerType type);
+static void PaintCorner(Window w, int x, int y, int len,
+                        int thick, int bw, ColorPair cp, CornerType type);
 
 
 
@@ -1001,8 +1004,7 @@ CreateHighlightWindows(TwmWindow *tmp_win)
 			which = "gray";
 		}
 
-		pm = mk_blackgray_pixmap(which, tmp_win->title_w,
-		                         tmp_win->title.fore, tmp_win->title.back);
+		pm = DecorAtlasBlackGray(which, tmp_win->title.fore, tmp_win->title.back);
 
 		tmp_win->HiliteImage = AllocImage();
 		tmp_win->HiliteImage->pixmap = pm;
@@ -1075,7 +1077,8 @@ DeleteHighlightWindows(TwmWindow *tmp_win)
 			 */
 		}
 		else {
-			XFreePixmap(dpy, tmp_win->HiliteImage->pixmap);
+			/* Our own Image struct, around a shared atlas Pixmap */
+			DecorAtlasRelease(tmp_win->HiliteImage->pixmap);
 			free(tmp_win->HiliteImage);
 		}
 		tmp_win->HiliteImage = NULL;
@@ -1221,18 +1224,18 @@ PaintTitle(TwmWindow *tmp_win)
 		 * visible in the case of a long enough title.
 		 */
 		len    = strlen(tmp_win->name);
-		XmbTextExtents(Scr->TitleBarFont.font_set,
-		               tmp_win->name, len,
-		               &ink_rect, &logical_rect);
+		FontTextExtents(&Scr->TitleBarFont,
+		                tmp_win->name, len,
+		                &ink_rect, &logical_rect);
 		width  = logical_rect.width;
 		mwidth = tmp_win->title_width  - Scr->TBInfo.titlex -
 		         Scr->TBInfo.rightoff  - Scr->TitlePadding  -
 		         Scr->TitleShadowDepth - 4;
 		while((len > 0) && (width > mwidth)) {
 			len--;
-			XmbTextExtents(Scr->TitleBarFont.font_set,
-			               tmp_win->name, len,
-			               &ink_rect, &logical_rect);
+			FontTextExtents(&Scr->TitleBarFont,
+			                tmp_win->name, len,
+			                &ink_rect, &logical_rect);
 			width = logical_rect.width;
 		}
 
@@ -1241,8 +1244,8 @@ PaintTitle(TwmWindow *tmp_win)
 		 * !3Dtitles case due to the potential bordering around it.  It's
 		 * not quite clear whether it should be.
 		 */
-		((Scr->Monochrome != COLOR) ? XmbDrawImageString : XmbDrawString)
-		(dpy, tmp_win->title_w, Scr->TitleBarFont.font_set,
+		((Scr->Monochrome != COLOR) ? FontDrawImageString : FontDrawString)
+		(tmp_win->title_w, &Scr->TitleBarFont,
 		 Scr->NormalGC,
 		 tmp_win->name_x,
 		 (Scr->TitleHeight - logical_rect.height) / 2 + (- logical_rect.y),
@@ -1258,10 +1261,10 @@ PaintTitle(TwmWindow *tmp_win)
 		 * titlebar is painted.  This requires investigation, and either
 		 * fixing the wrong or documentation of why it's right.
 		 */
-		XmbDrawString(dpy, tmp_win->title_w, Scr->TitleBarFont.font_set,
-		              Scr->NormalGC,
-		              tmp_win->name_x, Scr->TitleBarFont.y,
-		              tmp_win->name, strlen(tmp_win->name));
+		FontDrawString(tmp_win->title_w, &Scr->TitleBarFont,
+		               Scr->NormalGC,
+		               tmp_win->name_x, Scr->TitleBarFont.y,
+		               tmp_win->name, strlen(tmp_win->name));
 	}
 }
 
@@ -1310,7 +1313,7 @@ PaintTitleButton(TwmWindow *tmp_win, TBWindow *tbw)
  * drawing.
  */
 static void
-Draw3DCorner(Window w, int x, int y, int width, int height,
+Draw3DCorner(Drawable w, int x, int y, int width, int height,
              int thick, int bw, ColorPair cp, CornerType type)
 {
 	XRectangle rects [2];
@@ -1370,6 +1373,87 @@ Draw3DCorner(Window w, int x, int y, int width, int height,
 }
 
 
+/*
+ * Corners look the same on every window with the same border colors and
+ * widths, so they're rendered once into the decoration atlas and copied
+ * from there.  The bottom corners are only drawn as the L-shape along
+ * the frame edges (Draw3DCorner() clips to that), so only those bits are
+ * copied.
+ */
+static Pixmap
+RenderCorner(const DecorAtlasKey *key)
+{
+	ColorPair cp;
+	Pixmap pm;
+
+	cp.fore  = key->fore;
+	cp.back  = key->back;
+	cp.shadc = key->shadc;
+	cp.shadd = key->shadd;
+
+	pm = XCreatePixmap(dpy, Scr->Root, key->width, key->height, Scr->d_depth);
+	Draw3DCorner(pm, 0, 0, key->width, key->height, key->thick, key->bw,
+	             cp, key->variant);
+	return pm;
+}
+
+static void
+PaintCorner(Window w, int x, int y, int len,
+            int thick, int bw, ColorPair cp, CornerType type)
+{
+	DecorAtlasKey key = { 0 };
+	Pixmap pm;
+
+	/*
+	 * The monochrome stipple's alignment depends on where it's drawn,
+	 * so a copy wouldn't come out the same.
+	 */
+	if(Scr->Monochrome != COLOR) {
+		Draw3DCorner(w, x, y, len, len, thick, bw, cp, type);
+		return;
+	}
+
+	key.elem    = DA_CORNER;
+	key.variant = type;
+	key.fore    = cp.fore;
+	key.back    = cp.back;
+	key.shadc   = cp.shadc;
+	key.shadd   = cp.shadd;
+	key.width   = len;
+	key.height  = len;
+	key.thick   = thick;
+	key.bw      = bw;
+
+	pm = DecorAtlasGet(&key, RenderCorner);
+	if(pm == None) {
+		Draw3DCorner(w, x, y, len, len, thick, bw, cp, type);
+		return;
+	}
+
+	switch(type) {
+		case TopLeft:
+		case TopRight:
+			XCopyArea(dpy, pm, w, Scr->NormalGC, 0, 0, len, len, x, y);
+			break;
+		case BottomRight:
+			XCopyArea(dpy, pm, w, Scr->NormalGC,
+			          len - thick, 0, thick, len, x + len - thick, y);
+			XCopyArea(dpy, pm, w, Scr->NormalGC,
+			          0, len - thick, len - thick, thick, x, y + len - thick);
+			break;
+		case BottomLeft:
+			XCopyArea(dpy, pm, w, Scr->NormalGC,
+			          0, 0, thick, len, x, y);
+			XCopyArea(dpy, pm, w, Scr->NormalGC,
+			          thick, len - thick, len - thick, thick,
+			          x + thick, y + len - thick);
+			break;
+	}
+
+	DecorAtlasRelease(pm);
+}
+
+
 /*
  * Draw the borders onto the frame for a window
  */
@@ -1412,26 +1496,26 @@ PaintBorders(TwmWindow *tmp_win, bool focus)
 	/* How far the corners extend along the sides */
 #define CORNERLEN (Scr->TitleHeight + tmp_win->frame_bw3D)
 
-	Draw3DCorner(tmp_win->frame,
-	             tmp_win->title_x - tmp_win->frame_bw3D,
-	             0,
-	             CORNERLEN, CORNERLEN,
-	             tmp_win->frame_bw3D, Scr->BorderShadowDepth, cp, TopLeft);
-	Draw3DCorner(tmp_win->frame,
-	             tmp_win->title_x + tmp_win->title_width - Scr->TitleHeight,
-	             0,
-	             CORNERLEN, CORNERLEN,
-	             tmp_win->frame_bw3D, Scr->BorderShadowDepth, cp, TopRight);
-	Draw3DCorner(tmp_win->frame,
-	             tmp_win->frame_width  - CORNERLEN,
-	             tmp_win->frame_height - CORNERLEN,
-	             CORNERLEN, CORNERLEN,
-	             tmp_win->frame_bw3D, Scr->BorderShadowDepth, cp, BottomRight);
-	Draw3DCorner(tmp_win->frame,
-	             0,
-	             tmp_win->frame_height - CORNERLEN,
-	             CORNERLEN, CORNERLEN,
-	             tmp_win->frame_bw3D, Scr->BorderShadowDepth, cp, BottomLeft);
+	PaintCorner(tmp_win->frame,
+	            tmp_win->title_x - tmp_win->frame_bw3D,
+	            0,
+	            CORNERLEN,
+	            tmp_win->frame_bw3D, Scr->BorderShadowDepth, cp, TopLeft);
+	PaintCorner(tmp_win->frame,
+	            tmp_win->title_x + tmp_win->title_width - Scr->TitleHeight,
+	            0,
+	            CORNERLEN,
+	            tmp_win->frame_bw3D, Scr->BorderShadowDepth, cp, TopRight);
+	PaintCorner(tmp_win->frame,
+	            tmp_win->frame_width  - CORNERLEN,
+	            tmp_win->frame_height - CORNERLEN,
+	            CORNERLEN,
+	            tmp_win->frame_bw3D, Scr->BorderShadowDepth, cp, BottomRight);
+	PaintCorner(tmp_win->frame,
+	            0,
+	            tmp_win->frame_height - CORNERLEN,
+	            CORNERLEN,
+	            tmp_win->frame_bw3D, Scr->BorderShadowDepth, cp, BottomLeft);
 
 
 	/*
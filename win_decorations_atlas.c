@@ -0,0 +1,296 @@
+/*
+ * Shared pre-rendered decoration pixmaps
+ *
+ * A lot of what we draw on window decorations comes out pixel-for-pixel
+ * the same across windows: every window with the same border colors has
+ * identical 3D corners, the same highlight stipple tile, etc.  Rather
+ * than have each window create and draw its own, we keep them here,
+ * keyed by what they depict (element, colors, size, state), and hand out
+ * shared server-side Pixmaps to be XCopyArea()'d or set as a window
+ * background.
+ *
+ * Pixmaps are reference counted.  Ones nobody holds a reference to any
+ * more are kept on an LRU list, so things that get painted and let go
+ * of each time (like corners) stay around, and are only freed once
+ * there are more than DA_MAX_IDLE of them.
+ */
+
+#include "ctwm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image.h"
+#include "screen.h"
+
+#include "win_decorations_atlas.h"
+
+
+/* How many unreferenced pixmaps to keep around */
+#define DA_MAX_IDLE 64
+
+/* Hash table sizes; must be powers of 2 */
+#define DA_KEY_BUCKETS 64
+#define DA_PM_BUCKETS  64
+
+typedef struct DecorAtlasEntry {
+	struct DecorAtlasEntry *knext;      ///< Next in key hash chain
+	struct DecorAtlasEntry *pnext;      ///< Next in Pixmap hash chain
+	struct DecorAtlasEntry *lru_prev;   ///< Idle list, most recent first
+	struct DecorAtlasEntry *lru_next;
+	int scrnum;
+	DecorAtlasKey key;
+	unsigned int hash;
+	Pixmap pm;
+	int refcount;
+} DecorAtlasEntry;
+
+static DecorAtlasEntry *keyTable[DA_KEY_BUCKETS];
+static DecorAtlasEntry *pmTable[DA_PM_BUCKETS];
+static DecorAtlasEntry *idleHead, *idleTail;
+static DecorAtlasStats stats;
+
+
+static unsigned int
+hashKey(int scrnum, const DecorAtlasKey *k)
+{
+	unsigned int h = 2166136261u;
+#define MIX(v) h = (h ^ (unsigned int)(v)) * 16777619u
+	MIX(scrnum);
+	MIX(k->elem);
+	MIX(k->variant);
+	MIX(k->fore);
+	MIX(k->back);
+	MIX(k->shadc);
+	MIX(k->shadd);
+	MIX(k->width);
+	MIX(k->height);
+	MIX(k->thick);
+	MIX(k->bw);
+#undef MIX
+	return h;
+}
+
+static bool
+keyEqual(const DecorAtlasKey *a, const DecorAtlasKey *b)
+{
+	return a->elem == b->elem && a->variant == b->variant
+	       && a->fore == b->fore && a->back == b->back
+	       && a->shadc == b->shadc && a->shadd == b->shadd
+	       && a->width == b->width && a->height == b->height
+	       && a->thick == b->thick && a->bw == b->bw;
+}
+
+#define PM_BUCKET(pm) (((pm) ^ ((pm) >> 6)) & (DA_PM_BUCKETS - 1))
+
+
+/*
+ * Idle (refcount 0) list handling
+ */
+static void
+idleUnlink(DecorAtlasEntry *e)
+{
+	if(e->lru_prev) {
+		e->lru_prev->lru_next = e->lru_next;
+	}
+	else {
+		idleHead = e->lru_next;
+	}
+	if(e->lru_next) {
+		e->lru_next->lru_prev = e->lru_prev;
+	}
+	else {
+		idleTail = e->lru_prev;
+	}
+	e->lru_prev = e->lru_next = NULL;
+	stats.idle--;
+}
+
+static void
+idlePush(DecorAtlasEntry *e)
+{
+	e->lru_prev = NULL;
+	e->lru_next = idleHead;
+	if(idleHead) {
+		idleHead->lru_prev = e;
+	}
+	else {
+		idleTail = e;
+	}
+	idleHead = e;
+	stats.idle++;
+}
+
+
+/*
+ * Throw out an (idle) entry entirely.
+ */
+static void
+entryDestroy(DecorAtlasEntry *e)
+{
+	DecorAtlasEntry **pp;
+
+	for(pp = &keyTable[e->hash & (DA_KEY_BUCKETS - 1)]; *pp; pp = &(*pp)->knext) {
+		if(*pp == e) {
+			*pp = e->knext;
+			break;
+		}
+	}
+	for(pp = &pmTable[PM_BUCKET(e->pm)]; *pp; pp = &(*pp)->pnext) {
+		if(*pp == e) {
+			*pp = e->pnext;
+			break;
+		}
+	}
+
+	XFreePixmap(dpy, e->pm);
+	free(e);
+	stats.entries--;
+	stats.evictions++;
+}
+
+
+/**
+ * Get the Pixmap for a given decoration on the current screen, calling
+ * render() to create it if we don't have it yet.  The caller holds a
+ * reference to the result until it calls DecorAtlasRelease(), and must
+ * not draw into it.  Returns None if render() fails.
+ */
+Pixmap
+DecorAtlasGet(const DecorAtlasKey *key, DecorAtlasRender render)
+{
+	DecorAtlasEntry *e;
+	unsigned int hash = hashKey(Scr->screen, key);
+	DecorAtlasEntry **bucket = &keyTable[hash & (DA_KEY_BUCKETS - 1)];
+
+	for(e = *bucket; e != NULL; e = e->knext) {
+		if(e->hash == hash && e->scrnum == Scr->screen
+		                && keyEqual(&e->key, key)) {
+			if(e->refcount++ == 0) {
+				idleUnlink(e);
+			}
+			stats.hits++;
+			return e->pm;
+		}
+	}
+
+	stats.misses++;
+	Pixmap pm = render(key);
+	if(pm == None) {
+		return None;
+	}
+
+	e = calloc(1, sizeof(*e));
+	if(e == NULL) {
+		/* Should never happen, and we'd leak pm; better than crashing */
+		return pm;
+	}
+	e->scrnum = Scr->screen;
+	e->key = *key;
+	e->hash = hash;
+	e->pm = pm;
+	e->refcount = 1;
+
+	e->knext = *bucket;
+	*bucket = e;
+	e->pnext = pmTable[PM_BUCKET(pm)];
+	pmTable[PM_BUCKET(pm)] = e;
+	stats.entries++;
+
+	return pm;
+}
+
+
+/**
+ * Drop a reference to a Pixmap gotten from DecorAtlasGet().
+ */
+void
+DecorAtlasRelease(Pixmap pm)
+{
+	DecorAtlasEntry *e;
+
+	if(pm == None) {
+		return;
+	}
+
+	for(e = pmTable[PM_BUCKET(pm)]; e != NULL; e = e->pnext) {
+		if(e->pm == pm) {
+			break;
+		}
+	}
+	if(e == NULL) {
+		fprintf(stderr, "%s(): Pixmap 0x%lx not in the atlas\n", __func__,
+		        (unsigned long)pm);
+		return;
+	}
+	if(e->refcount <= 0) {
+		fprintf(stderr, "%s(): Pixmap 0x%lx released too often\n", __func__,
+		        (unsigned long)pm);
+		return;
+	}
+
+	if(--e->refcount > 0) {
+		return;
+	}
+	idlePush(e);
+
+	/* Over the limit; evict from the cold end */
+	while(stats.idle > DA_MAX_IDLE) {
+		DecorAtlasEntry *victim = idleTail;
+		idleUnlink(victim);
+		entryDestroy(victim);
+	}
+}
+
+
+/*
+ * The black/gray stipple tiles used for title highlights and unfocused
+ * borders.
+ */
+static Pixmap
+renderBlackGray(const DecorAtlasKey *key)
+{
+	return mk_blackgray_pixmap(key->variant ? "gray" : "black", Scr->Root,
+	                           key->fore, key->back);
+}
+
+/**
+ * Shared equivalent of mk_blackgray_pixmap().  Release with
+ * DecorAtlasRelease() rather than XFreePixmap().
+ */
+Pixmap
+DecorAtlasBlackGray(const char *which, Pixel fg, Pixel bg)
+{
+	DecorAtlasKey key = { 0 };
+
+	key.elem = DA_BLACKGRAY;
+	key.variant = (strcmp(which, "gray") == 0) ? 1 : 0;
+	key.fore = fg;
+	key.back = bg;
+	get_blackgray_size(&key.width, &key.height);
+
+	return DecorAtlasGet(&key, renderBlackGray);
+}
+
+
+/**
+ * Current usage counts.
+ */
+const DecorAtlasStats *
+DecorAtlasGetStats(void)
+{
+	return &stats;
+}
+
+
+/**
+ * Say how much sharing of decoration pixmaps we got.
+ */
+void
+DecorAtlasReport(FILE *out)
+{
+	fprintf(out, "Decoration atlas: %lu hits, %lu misses, %lu evicted; "
+	        "%u held (%u idle)\n", stats.hits, stats.misses, stats.evictions,
+	        stats.entries, stats.idle);
+}
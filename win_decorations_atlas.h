@@ -0,0 +1,49 @@
+/*
+ * Shared pre-rendered decoration pixmaps
+ */
+
+#ifndef _CTWM_WIN_DECORATIONS_ATLAS_H
+#define _CTWM_WIN_DECORATIONS_ATLAS_H
+
+#include <stdio.h>  // For FILE
+
+
+/// The sorts of things kept in the decoration atlas
+typedef enum {
+	DA_BLACKGRAY,   ///< mk_blackgray_pixmap() tile; variant 0 black, 1 gray
+	DA_CORNER,      ///< 3D frame corner; variant is the corner type
+} DecorElement;
+
+/**
+ * What a decoration pixmap is keyed on.  Everything that affects the
+ * rendered pixels has to be in here; fields that don't matter for an
+ * element are left 0.
+ */
+typedef struct DecorAtlasKey {
+	DecorElement elem;
+	int variant;
+	Pixel fore, back, shadc, shadd;
+	int width, height;
+	int thick, bw;
+} DecorAtlasKey;
+
+/// Render the pixmap for a key; called on an atlas miss.
+typedef Pixmap (*DecorAtlasRender)(const DecorAtlasKey *key);
+
+/// Counts of atlas usage, for diagnostics
+typedef struct DecorAtlasStats {
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long evictions;
+	unsigned int entries;   ///< Pixmaps currently held
+	unsigned int idle;      ///< ... of which nobody holds a reference
+} DecorAtlasStats;
+
+Pixmap DecorAtlasGet(const DecorAtlasKey *key, DecorAtlasRender render);
+void DecorAtlasRelease(Pixmap pm);
+Pixmap DecorAtlasBlackGray(const char *which, Pixel fg, Pixel bg);
+const DecorAtlasStats *DecorAtlasGetStats(void);
+void DecorAtlasReport(FILE *out);
+
+
+#endif /* _CTWM_WIN_DECORATIONS_ATLAS_H */
@@ -5,10 +5,10 @@
 #include "ctwm.h"
 
 #include <stdlib.h>
-#include <sys/time.h>
 
 #include <X11/extensions/shape.h>
 
+#include "animate.h"
 #include "events.h"
 #include "functions.h"
 #include "iconmgr.h"
@@ -16,6 +16,7 @@
 #include "list.h"
 #include "otp.h"
 #include "screen.h"
+#include "timers.h"
 #include "util.h"
 #include "vscreen.h"
 #include "win_iconify.h"
@@ -25,16 +26,12 @@
 
 
 /* Animations */
-static void MosaicFade(TwmWindow *tmp_win, Window blanket);
-static void ZoomInWindow(TwmWindow *tmp_win, Window blanket);
-static void ZoomOutWindow(TwmWindow *tmp_win, Window blanket);
-static void FadeWindow(TwmWindow *tmp_win, Window blanket);
-static void SweepWindow(TwmWindow *tmp_win, Window blanket);
+static void TransitionStart(TwmWindow *tmp_win, Window blanket);
+static void TransitionCancel(TwmWindow *tmp_win);
 
 /* De/iconify utils */
 static void Zoom(Window wf, Window wt);
 static void ReMapOne(TwmWindow *t, TwmWindow *leader);
-static void waitamoment(float timeout);
 
 
 
@@ -81,11 +78,14 @@ Iconify(TwmWindow *tmp_win, int def_x, int def_y)
 		}
 	}
 
-	/* Don't mask anything yet, just get the current for various uses */
-	eventMask = mask_out_event(tmp_win->w, 0);
+	/*
+	 * Everything's unmapped with StructureNotify masked out; put the
+	 * masks back all together once it's done.
+	 */
+	mask_batch_begin();
 
 	/* iconify transients and window group first */
-	UnmapTransients(tmp_win, iconify, eventMask);
+	UnmapTransients(tmp_win, iconify);
 
 	if(iconify) {
 		Zoom(tmp_win->frame, tmp_win->icon->w);
@@ -98,46 +98,25 @@ Iconify(TwmWindow *tmp_win, int def_x, int def_y)
 	tmp_win->mapped = false;
 
 	if((Scr->IconifyStyle != ICONIFY_NORMAL) && !Scr->WindowMask) {
-		XWindowAttributes winattrs;
 		XSetWindowAttributes attr;
 
-		XGetWindowAttributes(dpy, tmp_win->frame, &winattrs);
-		blanket = XCreateWindow(dpy, Scr->Root, winattrs.x, winattrs.y,
-		                        winattrs.width, winattrs.height, 0,
+		blanket = XCreateWindow(dpy, Scr->Root, tmp_win->frame_x, tmp_win->frame_y,
+		                        tmp_win->frame_width, tmp_win->frame_height, 0,
 		                        CopyFromParent, CopyFromParent,
 		                        CopyFromParent, None, &attr);
 		XMapWindow(dpy, blanket);
 	}
 
-	mask_out_event_mask(tmp_win->w, StructureNotifyMask, eventMask);
+	eventMask = mask_out_event(tmp_win->w, StructureNotifyMask);
 	XUnmapWindow(dpy, tmp_win->w);
 	XUnmapWindow(dpy, tmp_win->frame);
 	restore_mask(tmp_win->w, eventMask);
+	mask_batch_end();
 
 	SetMapStateProp(tmp_win, IconicState);
 
-	if((Scr->IconifyStyle != ICONIFY_NORMAL) && !Scr->WindowMask) {
-		switch(Scr->IconifyStyle) {
-			case ICONIFY_MOSAIC:
-				MosaicFade(tmp_win, blanket);
-				break;
-			case ICONIFY_ZOOMIN:
-				ZoomInWindow(tmp_win, blanket);
-				break;
-			case ICONIFY_ZOOMOUT:
-				ZoomOutWindow(tmp_win, blanket);
-				break;
-			case ICONIFY_FADE:
-				FadeWindow(tmp_win, blanket);
-				break;
-			case ICONIFY_SWEEP:
-				SweepWindow(tmp_win, blanket);
-				break;
-			case ICONIFY_NORMAL:
-				/* Placate insufficiently smart clang warning */
-				break;
-		}
-		XDestroyWindow(dpy, blanket);
+	if(blanket != (Window) - 1) {
+		TransitionStart(tmp_win, blanket);
 	}
 	if(tmp_win == Scr->Focus) {
 		SetFocus(NULL, EventTime);
@@ -147,7 +126,9 @@ Iconify(TwmWindow *tmp_win, int def_x, int def_y)
 	}
 	tmp_win->isicon = true;
 	tmp_win->icon_on = iconify;
+	InvalidateWindowListMenus();
 	WMapIconify(tmp_win);
+	AnimationAddWindow(tmp_win);
 	if(! Scr->WindowMask && Scr->IconifyFunction.func != 0) {
 		char *action;
 		XEvent event;
@@ -213,209 +194,353 @@ DeIconify(TwmWindow *tmp_win)
 
 /*
  * Animations for popping windows around.
+ *
+ * When a window's iconified with an IconifyStyle, a "blanket" window is
+ * left where its frame was, still showing what was there, and then
+ * eaten away (or swept off the screen) over a few hundred ms.  These
+ * used to run their frames inline, sleeping in between, so nothing else
+ * got done until they finished.  Now each is a Transition, stepped along
+ * by a timer from the main loop: events keep being handled meanwhile,
+ * and any number can be running at once.
+ *
+ * Frames are picked by the clock, not counted, so if we fall behind we
+ * skip ahead rather than drag the effect out.  Iconifying a window again
+ * (or deiconifying it) while its transition's still going cuts the old
+ * one short.
+ *
+ * The shape effects are done with as few requests per frame as we can:
+ * mosaic subtracts its squares straight from the blanket's shape in one
+ * XShapeCombineRectangles(), and the zooms only render the latest frame
+ * into their mask.
+ */
+
+#define TRANSITION_FRAME_MS 20
+
+typedef struct Transition {
+	struct Transition *next;
+	TwmWindow *win;           ///< Only for matching; never dereferenced
+	IcStyle style;
+	Window blanket;
+	int w, h;                 ///< Blanket size
+	int nframes;              ///< Length of the effect, in frames
+	int shown;                ///< Last frame drawn
+	uint64_t start;           ///< TimerNow() at frame 0
+	Timer timer;
+
+	Pixmap mask;              ///< ZOOMIN/ZOOMOUT/FADE shape mask
+	GC gc;                    ///< Draws 1s into mask
+	GC gcclear;               ///< Draws 0s
+	int step;                 ///< ZOOM radius step, MOSAIC square size
+	XRectangle *rects;        ///< MOSAIC squares
+	int nrects;
+	int x, y;                 ///< SWEEP start position
+	int dir;                  ///< SWEEP direction: left, up, right, down
+	float sstep;              ///< SWEEP distance factor
+} Transition;
+
+static Transition *transitions;
+
+static void TransitionStep(void *arg);
+
+
+/*
+ * Draw a given frame.  Frames in between the last one shown and this
+ * one may have been skipped.
  */
 static void
-MosaicFade(TwmWindow *tmp_win, Window blanket)
+TransitionDraw(Transition *tr, int frame)
 {
-	int         srect;
-	int         i, j, nrects;
-	Pixmap      mask;
-	GC          gc;
-	XGCValues   gcv;
-	XRectangle *rectangles;
-	int  width = tmp_win->frame_width;
-	int height = tmp_win->frame_height;
-
-	srect = (width < height) ? (width / 20) : (height / 20);
-	mask  = XCreatePixmap(dpy, blanket, width, height, 1);
-
-	gcv.foreground = 1;
-	gc = XCreateGC(dpy, mask, GCForeground, &gcv);
-	XFillRectangle(dpy, mask, gc, 0, 0, width, height);
-	gcv.function = GXclear;
-	XChangeGC(dpy, gc, GCFunction, &gcv);
-
-	nrects = ((width * height) / (srect * srect)) / 10;
-	rectangles = calloc(nrects, sizeof(XRectangle));
-	for(j = 0; j < nrects; j++) {
-		rectangles [j].width  = srect;
-		rectangles [j].height = srect;
-	}
-	for(i = 0; i < 10; i++) {
-		for(j = 0; j < nrects; j++) {
-			rectangles [j].x = ((lrand48() %  width) / srect) * srect;
-			rectangles [j].y = ((lrand48() % height) / srect) * srect;
+	const int w = tr->w;
+	const int h = tr->h;
+	const int nsteps = tr->nframes;
+
+	switch(tr->style) {
+		case ICONIFY_MOSAIC:
+			/* Knock out a few more squares for each frame */
+			for(int f = tr->shown + 1; f <= frame; f++) {
+				for(int j = 0; j < tr->nrects; j++) {
+					tr->rects[j].x = ((lrand48() % w) / tr->step) * tr->step;
+					tr->rects[j].y = ((lrand48() % h) / tr->step) * tr->step;
+				}
+				XShapeCombineRectangles(dpy, tr->blanket, ShapeBounding, 0, 0,
+				                        tr->rects, tr->nrects, ShapeSubtract,
+				                        Unsorted);
+			}
+			break;
+
+		case ICONIFY_ZOOMIN: {
+			/* A shrinking circle */
+			int r = (nsteps - frame) * tr->step;
+
+			XFillRectangle(dpy, tr->mask, tr->gcclear, 0, 0, w, h);
+			XFillArc(dpy, tr->mask, tr->gc, (w / 2) - r, (h / 2) - r,
+			         2 * r, 2 * r, 0, 360 * 64);
+			XShapeCombineMask(dpy, tr->blanket, ShapeBounding, 0, 0, tr->mask,
+			                  ShapeSet);
+			break;
 		}
-		XFillRectangles(dpy, mask, gc, rectangles, nrects);
-		XShapeCombineMask(dpy, blanket, ShapeBounding, 0, 0, mask, ShapeSet);
-		XFlush(dpy);
-		waitamoment(0.020);
+
+		case ICONIFY_ZOOMOUT: {
+			/* A growing hole; the latest covers all the previous */
+			int r = frame * tr->step;
+
+			XFillArc(dpy, tr->mask, tr->gcclear, (w / 2) - r, (h / 2) - r,
+			         2 * r, 2 * r, 0, 360 * 64);
+			XShapeCombineMask(dpy, tr->blanket, ShapeBounding, 0, 0, tr->mask,
+			                  ShapeSet);
+			break;
+		}
+
+		case ICONIFY_FADE:
+			/* Stippled for a moment, and then gone */
+			if(tr->shown < 0) {
+				XShapeCombineMask(dpy, tr->blanket, ShapeBounding, 0, 0, tr->mask,
+				                  ShapeSet);
+			}
+			break;
+
+		case ICONIFY_SWEEP: {
+			int x = tr->x;
+			int y = tr->y;
+			int d = frame * frame * tr->sstep;
+
+			switch(tr->dir) {
+				case 0:
+					x -= d;
+					break;
+				case 1:
+					y -= d;
+					break;
+				case 2:
+					x += d;
+					break;
+				case 3:
+					y += d;
+					break;
+			}
+			XMoveWindow(dpy, tr->blanket, x, y);
+			break;
+		}
+
+		case ICONIFY_NORMAL:
+			break;
 	}
-	XFreePixmap(dpy, mask);
-	XFreeGC(dpy, gc);
-	free(rectangles);
+
+	tr->shown = frame;
 }
 
 
+/*
+ * All done (or cut short); clean up after it.
+ */
 static void
-ZoomInWindow(TwmWindow *tmp_win, Window blanket)
+TransitionEnd(Transition *tr)
 {
-	Pixmap        mask;
-	GC            gc, gcn;
-	XGCValues     gcv;
-
-	int i, nsteps = 20;
-	int w = tmp_win->frame_width;
-	int h = tmp_win->frame_height;
-	int step = (MAX(w, h)) / (2.0 * nsteps);
-
-	mask = XCreatePixmap(dpy, blanket, w, h, 1);
-	gcv.foreground = 1;
-	gc  = XCreateGC(dpy, mask, GCForeground, &gcv);
-	gcv.function = GXclear;
-	gcn = XCreateGC(dpy, mask, GCForeground | GCFunction, &gcv);
-
-	for(i = 0; i < nsteps; i++) {
-		XFillRectangle(dpy, mask, gcn, 0, 0, w, h);
-		XFillArc(dpy, mask, gc, (w / 2) - ((nsteps - i) * step),
-		         (h / 2) - ((nsteps - i) * step),
-		         2 * (nsteps - i) * step,
-		         2 * (nsteps - i) * step,
-		         0, 360 * 64);
-		XShapeCombineMask(dpy, blanket, ShapeBounding, 0, 0, mask, ShapeSet);
-		XFlush(dpy);
-		waitamoment(0.020);
+	Transition **pp;
+
+	for(pp = &transitions; *pp != NULL; pp = &(*pp)->next) {
+		if(*pp == tr) {
+			*pp = tr->next;
+			break;
+		}
+	}
+
+	TimerCancel(&tr->timer);
+	XDestroyWindow(dpy, tr->blanket);
+	if(tr->mask != None) {
+		XFreePixmap(dpy, tr->mask);
 	}
+	if(tr->gc != None) {
+		XFreeGC(dpy, tr->gc);
+	}
+	if(tr->gcclear != None) {
+		XFreeGC(dpy, tr->gcclear);
+	}
+	free(tr->rects);
+	free(tr);
 }
 
 
+/*
+ * Timer callback: catch up to wherever the clock says we should be.
+ */
 static void
-ZoomOutWindow(TwmWindow *tmp_win, Window blanket)
+TransitionStep(void *arg)
 {
-	Pixmap        mask;
-	GC            gc;
-	XGCValues     gcv;
-
-	int i, nsteps = 20;
-	int w = tmp_win->frame_width;
-	int h = tmp_win->frame_height;
-	int step = (MAX(w, h)) / (2.0 * nsteps);
-
-	mask  = XCreatePixmap(dpy, blanket, w, h, 1);
-	gcv.foreground = 1;
-	gc = XCreateGC(dpy, mask, GCForeground, &gcv);
-	XFillRectangle(dpy, mask, gc, 0, 0, w, h);
-	gcv.function = GXclear;
-	XChangeGC(dpy, gc, GCFunction, &gcv);
-
-	for(i = 0; i < nsteps; i++) {
-		XFillArc(dpy, mask, gc, (w / 2) - (i * step),
-		         (h / 2) - (i * step),
-		         2 * i * step,
-		         2 * i * step,
-		         0, 360 * 64);
-		XShapeCombineMask(dpy, blanket, ShapeBounding, 0, 0, mask, ShapeSet);
+	Transition *tr = arg;
+	int frame = (TimerNow() - tr->start) / TRANSITION_FRAME_MS;
+
+	if(frame >= tr->nframes) {
+		TransitionEnd(tr);
 		XFlush(dpy);
-		waitamoment(0.020);
+		return;
 	}
+	if(frame > tr->shown) {
+		TransitionDraw(tr, frame);
+		XFlush(dpy);
+	}
+	TimerSetAt(&tr->timer, tr->start + (uint64_t)(frame + 1) * TRANSITION_FRAME_MS);
 }
 
 
-void
-FadeWindow(TwmWindow *tmp_win, Window blanket)
-{
-	Pixmap        mask, stipple;
-	GC            gc;
-	XGCValues     gcv;
-	static unsigned char stipple_bits[] = { 0x0F, 0x0F,
-	                                        0xF0, 0xF0,
-	                                        0x0F, 0x0F,
-	                                        0xF0, 0xF0,
-	                                        0x0F, 0x0F,
-	                                        0xF0, 0xF0,
-	                                        0x0F, 0x0F,
-	                                        0xF0, 0xF0,
-	                                      };
-	int w = tmp_win->frame_width;
-	int h = tmp_win->frame_height;
-
-	stipple = XCreateBitmapFromData(dpy, blanket, (char *)stipple_bits, 8, 8);
-	mask    = XCreatePixmap(dpy, blanket, w, h, 1);
-	gcv.background = 0;
-	gcv.foreground = 1;
-	gcv.stipple    = stipple;
-	gcv.fill_style = FillOpaqueStippled;
-	gc = XCreateGC(dpy, mask, GCBackground | GCForeground | GCFillStyle | GCStipple,
-	               &gcv);
-	XFillRectangle(dpy, mask, gc, 0, 0, w, h);
-
-	XShapeCombineMask(dpy, blanket, ShapeBounding, 0, 0, mask, ShapeSet);
-	XFlush(dpy);
-	waitamoment(0.10);
-	XFreePixmap(dpy, stipple);
-	XFlush(dpy);
-}
-
-
+/*
+ * Start the iconify animation for a window on its blanket.  We take
+ * ownership of the blanket, and destroy it when done.
+ */
 static void
-SweepWindow(TwmWindow *tmp_win, Window blanket)
+TransitionStart(TwmWindow *tmp_win, Window blanket)
 {
-	float step = 0.0;
-	int i, nsteps = 20;
-	int dir = 0, dist = tmp_win->frame_x, dist1;
+	Transition *tr;
+	XGCValues gcv;
+	const int w = tmp_win->frame_width;
+	const int h = tmp_win->frame_height;
+	const IcStyle style = Scr->IconifyStyle;
 
-	dist1 = tmp_win->frame_y;
-	if(dist1 < dist) {
-		dir = 1;
-		dist = dist1;
-	}
-	dist1 = tmp_win->vs->w - (tmp_win->frame_x + tmp_win->frame_width);
-	if(dist1 < dist) {
-		dir = 2;
-		dist = dist1;
+	TransitionCancel(tmp_win);
+
+	/* Everything but sweeping is done by shaping the blanket */
+	if((style != ICONIFY_SWEEP && !HasShape) || w <= 0 || h <= 0) {
+		XDestroyWindow(dpy, blanket);
+		return;
 	}
-	dist1 = tmp_win->vs->h - (tmp_win->frame_y + tmp_win->frame_height);
-	if(dist1 < dist) {
-		dir = 3;
-		dist = dist1;
+
+	tr = calloc(1, sizeof(*tr));
+	if(tr == NULL) {
+		XDestroyWindow(dpy, blanket);
+		return;
 	}
+	tr->win = tmp_win;
+	tr->style = style;
+	tr->blanket = blanket;
+	tr->w = w;
+	tr->h = h;
+	tr->nframes = 20;
+	tr->shown = -1;
+
+	switch(style) {
+		case ICONIFY_MOSAIC:
+			tr->nframes = 10;
+			tr->step = MAX(1, MIN(w, h) / 20);
+			tr->nrects = ((w * h) / (tr->step * tr->step)) / 10;
+			tr->rects = calloc(MAX(tr->nrects, 1), sizeof(XRectangle));
+			for(int j = 0; j < tr->nrects; j++) {
+				tr->rects[j].width  = tr->step;
+				tr->rects[j].height = tr->step;
+			}
+			break;
 
-	switch(dir) {
-		case 0:
-			step = tmp_win->frame_x + tmp_win->frame_width;
+		case ICONIFY_ZOOMIN:
+		case ICONIFY_ZOOMOUT:
+			tr->step = MAX(w, h) / (2.0 * tr->nframes);
+			tr->mask = XCreatePixmap(dpy, blanket, w, h, 1);
+			gcv.foreground = 1;
+			tr->gc = XCreateGC(dpy, tr->mask, GCForeground, &gcv);
+			gcv.function = GXclear;
+			tr->gcclear = XCreateGC(dpy, tr->mask, GCForeground | GCFunction, &gcv);
+			if(style == ICONIFY_ZOOMOUT) {
+				XFillRectangle(dpy, tr->mask, tr->gc, 0, 0, w, h);
+			}
 			break;
-		case 1:
-			step = tmp_win->frame_y + tmp_win->frame_height;
+
+		case ICONIFY_FADE: {
+			static unsigned char stipple_bits[] = { 0x0F, 0x0F,
+			                                        0xF0, 0xF0,
+			                                        0x0F, 0x0F,
+			                                        0xF0, 0xF0,
+			                                        0x0F, 0x0F,
+			                                        0xF0, 0xF0,
+			                                        0x0F, 0x0F,
+			                                        0xF0, 0xF0,
+			                                      };
+			Pixmap stipple;
+
+			tr->nframes = 100 / TRANSITION_FRAME_MS;
+			stipple = XCreateBitmapFromData(dpy, blanket, (char *)stipple_bits,
+			                                8, 8);
+			tr->mask = XCreatePixmap(dpy, blanket, w, h, 1);
+			gcv.background = 0;
+			gcv.foreground = 1;
+			gcv.stipple    = stipple;
+			gcv.fill_style = FillOpaqueStippled;
+			tr->gc = XCreateGC(dpy, tr->mask,
+			                   GCBackground | GCForeground | GCFillStyle | GCStipple,
+			                   &gcv);
+			XFillRectangle(dpy, tr->mask, tr->gc, 0, 0, w, h);
+			XFreePixmap(dpy, stipple);
 			break;
-		case 2:
-			step = tmp_win->vs->w - tmp_win->frame_x;
+		}
+
+		case ICONIFY_SWEEP: {
+			/* Off whichever edge is closest */
+			int dist = tmp_win->frame_x, dist1;
+
+			tr->x = tmp_win->frame_x;
+			tr->y = tmp_win->frame_y;
+			dist1 = tmp_win->frame_y;
+			if(dist1 < dist) {
+				tr->dir = 1;
+				dist = dist1;
+			}
+			dist1 = tmp_win->vs->w - (tmp_win->frame_x + w);
+			if(dist1 < dist) {
+				tr->dir = 2;
+				dist = dist1;
+			}
+			dist1 = tmp_win->vs->h - (tmp_win->frame_y + h);
+			if(dist1 < dist) {
+				tr->dir = 3;
+				dist = dist1;
+			}
+
+			switch(tr->dir) {
+				case 0:
+					tr->sstep = tmp_win->frame_x + w;
+					break;
+				case 1:
+					tr->sstep = tmp_win->frame_y + h;
+					break;
+				case 2:
+					tr->sstep = tmp_win->vs->w - tmp_win->frame_x;
+					break;
+				case 3:
+					tr->sstep = tmp_win->vs->h - tmp_win->frame_y;
+					break;
+			}
+			tr->sstep /= (float) tr->nframes;
+			tr->sstep /= (float) tr->nframes;
 			break;
-		case 3:
-			step = tmp_win->vs->h - tmp_win->frame_y;
+		}
+
+		case ICONIFY_NORMAL:
 			break;
 	}
-	step /= (float) nsteps;
-	step /= (float) nsteps;
-	for(i = 0; i < 20; i++) {
-		int x = tmp_win->frame_x;
-		int y = tmp_win->frame_y;
-		switch(dir) {
-			case 0:
-				x -= i * i * step;
-				break;
-			case 1:
-				y -= i * i * step;
-				break;
-			case 2:
-				x += i * i * step;
-				break;
-			case 3:
-				y += i * i * step;
-				break;
+
+	tr->next = transitions;
+	transitions = tr;
+
+	/* First frame right away, along with the unmap */
+	tr->start = TimerNow();
+	TransitionDraw(tr, 0);
+	XFlush(dpy);
+	TimerInit(&tr->timer, TransitionStep, tr);
+	TimerSetAt(&tr->timer, tr->start + TRANSITION_FRAME_MS);
+}
+
+
+/*
+ * Cut short any transition running for a window; it's being iconified
+ * again, or coming back.
+ */
+static void
+TransitionCancel(TwmWindow *tmp_win)
+{
+	Transition *tr, *next;
+
+	for(tr = transitions; tr != NULL; tr = next) {
+		next = tr->next;
+		if(tr->win == tmp_win) {
+			TransitionEnd(tr);
 		}
-		XMoveWindow(dpy, blanket, x, y);
-		XFlush(dpy);
-		waitamoment(0.020);
 	}
 }
 
@@ -442,8 +567,8 @@ Zoom(Window wf, Window wt)
 	int fx, fy, tx, ty;                 /* from, to */
 	unsigned int fw, fh, tw, th;        /* from, to */
 	long dx, dy, dw, dh;
-	long z;
-	int j;
+	long z, i;
+	XRectangle *rects;
 
 	if((Scr->IconifyStyle != ICONIFY_NORMAL) || !Scr->DoZoom
 	                || Scr->ZoomCount < 1) {
@@ -463,27 +588,31 @@ Zoom(Window wf, Window wt)
 	dh = (long) th - (long) fh; /* going from -> to */
 	z = (long)(Scr->ZoomCount + 1);
 
-	for(j = 0; j < 2; j++) {
-		long i;
-
-		XDrawRectangle(dpy, Scr->Root, Scr->DrawGC, fx, fy, fw, fh);
-		for(i = 1; i < z; i++) {
-			int x = fx + (int)((dx * i) / z);
-			int y = fy + (int)((dy * i) / z);
-			unsigned width = (unsigned)(((long) fw) + (dw * i) / z);
-			unsigned height = (unsigned)(((long) fh) + (dh * i) / z);
-
-			XDrawRectangle(dpy, Scr->Root, Scr->DrawGC,
-			               x, y, width, height);
-		}
-		XDrawRectangle(dpy, Scr->Root, Scr->DrawGC, tx, ty, tw, th);
+	/*
+	 * All the outlines from one to the other, drawn in a single request,
+	 * and then the same again to XOR them back off.
+	 */
+	rects = calloc(z + 1, sizeof(XRectangle));
+	if(rects == NULL) {
+		return;
 	}
+	for(i = 0; i <= z; i++) {
+		rects[i].x = fx + (int)((dx * i) / z);
+		rects[i].y = fy + (int)((dy * i) / z);
+		rects[i].width = (unsigned)(((long) fw) + (dw * i) / z);
+		rects[i].height = (unsigned)(((long) fh) + (dh * i) / z);
+	}
+	XDrawRectangles(dpy, Scr->Root, Scr->DrawGC, rects, z + 1);
+	XDrawRectangles(dpy, Scr->Root, Scr->DrawGC, rects, z + 1);
+	free(rects);
 }
 
 
 static void
 ReMapOne(TwmWindow *t, TwmWindow *leader)
 {
+	TransitionCancel(t);
+
 	if(t->icon_on) {
 		Zoom(t->icon->w, t->frame);
 	}
@@ -520,7 +649,9 @@ ReMapOne(TwmWindow *t, TwmWindow *leader)
 	}
 	t->isicon = false;
 	t->icon_on = false;
+	InvalidateWindowListMenus();
 	WMapDeIconify(t);
+	AnimationAddWindow(t);
 }
 
 
@@ -548,7 +679,7 @@ ReMapTransients(TwmWindow *tmp_win)
  * Ditto previous note about squeezing.
  */
 void
-UnmapTransients(TwmWindow *tmp_win, bool iconify, long eventMask)
+UnmapTransients(TwmWindow *tmp_win, bool iconify)
 {
 	TwmWindow *t;
 
@@ -556,6 +687,8 @@ UnmapTransients(TwmWindow *tmp_win, bool iconify, long eventMask)
 		if(t != tmp_win &&
 		                ((t->istransient && t->transientfor == tmp_win->w) ||
 		                 t->group == tmp_win->w)) {
+			long eventMask;
+
 			if(iconify) {
 				if(t->icon_on) {
 					Zoom(t->icon->w, tmp_win->icon->w);
@@ -571,15 +704,7 @@ UnmapTransients(TwmWindow *tmp_win, bool iconify, long eventMask)
 			 */
 			t->mapped = false;
 
-			/*
-			 * Note that here, we're setting masks relative to what we
-			 * were passed, which is that of the window these are
-			 * transient for, rather than relative to these windows'
-			 * current masks.  I believe in practice it's the same thing,
-			 * and it saves getting attributes on each for masking.
-			 * Still, a little odd...
-			 */
-			mask_out_event_mask(t->w, StructureNotifyMask, eventMask);
+			eventMask = mask_out_event(t->w, StructureNotifyMask);
 			XUnmapWindow(dpy, t->w);
 			XUnmapWindow(dpy, t->frame);
 			restore_mask(t->w, eventMask);
@@ -599,18 +724,9 @@ UnmapTransients(TwmWindow *tmp_win, bool iconify, long eventMask)
 			}
 			t->isicon = true;
 			t->icon_on = false;
+			InvalidateWindowListMenus();
 			WMapIconify(t);
 		}
 	}
 }
 
-
-static void
-waitamoment(float timeout)
-{
-	struct timeval timeoutstruct;
-	int usec = timeout * 1000000;
-	timeoutstruct.tv_usec = usec % (unsigned long) 1000000;
-	timeoutstruct.tv_sec  = usec / (unsigned long) 1000000;
-	select(0, NULL, NULL, NULL, &timeoutstruct);
-}
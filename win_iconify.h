@@ -11,7 +11,7 @@ void DeIconify(TwmWindow *tmp_win);
 
 /* Lower-level utils, but the squeeze code uses them too */
 void ReMapTransients(TwmWindow *tmp_win);
-void UnmapTransients(TwmWindow *tmp_win, bool iconify, long eventMask);
+void UnmapTransients(TwmWindow *tmp_win, bool iconify);
 
 
 #endif /* _CTWM_WIN_ICONIFY_H */
@@ -64,8 +64,6 @@ SetFocusVisualAttributes(TwmWindow *tmp_win, bool focus)
 	}
 
 	if(focus) {
-		bool hil = false;
-
 		if(tmp_win->lolite_wl) {
 			XUnmapWindow(dpy, tmp_win->lolite_wl);
 		}
@@ -74,14 +72,9 @@ SetFocusVisualAttributes(TwmWindow *tmp_win, bool focus)
 		}
 		if(tmp_win->hilite_wl) {
 			XMapWindow(dpy, tmp_win->hilite_wl);
-			hil = true;
 		}
 		if(tmp_win->hilite_wr) {
 			XMapWindow(dpy, tmp_win->hilite_wr);
-			hil = true;
-		}
-		if(hil && tmp_win->HiliteImage && tmp_win->HiliteImage->next) {
-			MaybeAnimate = true;
 		}
 		if(tmp_win->iconmanagerlist) {
 			ActiveIconManager(tmp_win->iconmanagerlist);
@@ -115,6 +108,9 @@ SetFocusVisualAttributes(TwmWindow *tmp_win, bool focus)
 		             tmp_win->title, bs, false, false);
 	}
 	tmp_win->hasfocusvisible = focus;
+	if(focus && (tmp_win->hilite_wl || tmp_win->hilite_wr)) {
+		AnimationAddWindow(tmp_win);
+	}
 }
 
 
@@ -293,7 +289,7 @@ Squeeze(TwmWindow *tmp_win)
 	tmp_win->actual_frame_y = savey;
 
 	/* Now make the group members disappear */
-	UnmapTransients(tmp_win, false, eventMask);
+	UnmapTransients(tmp_win, false);
 }
 
 
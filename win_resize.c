@@ -615,9 +615,9 @@ static void DisplaySize(TwmWindow *tmp_win, int width, int height)
 	             2, Scr->DefaultC, off, false, false);
 
 	FB(Scr->DefaultC.fore, Scr->DefaultC.back);
-	XmbDrawImageString(dpy, Scr->SizeWindow, Scr->SizeFont.font_set,
-	                   Scr->NormalGC, Scr->SizeStringOffset,
-	                   Scr->SizeFont.ascent + SIZE_VINDENT, str, 13);
+	FontDrawImageString(Scr->SizeWindow, &Scr->SizeFont,
+	                    Scr->NormalGC, Scr->SizeStringOffset,
+	                    Scr->SizeFont.ascent + SIZE_VINDENT, str, 13);
 }
 
 /***********************************************************************
@@ -21,6 +21,7 @@
 #include "list.h"
 #include "occupation.h"
 #include "otp.h"
+#include "prop_writer.h"
 #include "r_area.h"
 #include "r_area_list.h"
 #include "r_layout.h"
@@ -361,16 +362,162 @@ visible(const TwmWindow *tmp_win)
  * I'm assuming 2s-complement too) is pretty absurd, and there are only
  * 25 defined bits in Xlib, so even on 32-bit systems, it shouldn't fill
  * up long.
+ *
+ * Asking the server what a window's mask is costs a round trip, and
+ * these get done a lot (every window on a workspace switch, for
+ * instance), so we keep track of the masks we've set ourselves.
+ * Anything that selects input on a window we might mask like this
+ * should do it through select_input(), or tell us with
+ * note_event_mask() if it's set some other way (XCreateWindow(), etc).
+ * We only ask the server about windows we don't know.
+ *
+ * Operations that mask and restore a bunch of things, possibly the same
+ * windows several times over, can wrap it all in mask_batch_begin() and
+ * mask_batch_end().  In between, restores are held back and done once
+ * per window at the end, and masking out only goes to the server when it
+ * turns off something that's still selected.
+ */
+typedef struct TrackedMask {
+	long mask;          ///< What it should be
+	long selected;      ///< What we last told the server
+	bool pending;       ///< On the batch's list to restore
+} TrackedMask;
+
+static XContext EventMaskContext = None;
+static int batch_depth;
+static Window *batch_wins;
+static int batch_nwins, batch_size;
+static EventMaskStats emstats;
+
+
+static TrackedMask *
+emask_find(Window w)
+{
+	TrackedMask *em;
+
+	if(EventMaskContext == None) {
+		return NULL;
+	}
+	if(XFindContext(dpy, w, EventMaskContext, (XPointer *)&em) != 0) {
+		return NULL;
+	}
+	return em;
+}
+
+
+/*
+ * Find or start tracking a window, with a given current mask.
+ */
+static TrackedMask *
+emask_set(Window w, long mask)
+{
+	TrackedMask *em = emask_find(w);
+
+	if(em == NULL) {
+		if(EventMaskContext == None) {
+			EventMaskContext = XUniqueContext();
+		}
+		em = calloc(1, sizeof(TrackedMask));
+		if(em == NULL) {
+			return NULL;
+		}
+		if(XSaveContext(dpy, w, EventMaskContext, (XPointer)em) != 0) {
+			free(em);
+			return NULL;
+		}
+	}
+	em->mask = em->selected = mask;
+	return em;
+}
+
+
+/*
+ * Actually tell the server, if it doesn't already have it.
+ */
+static void
+emask_select(Window w, TrackedMask *em, long mask)
+{
+	if(em->selected == mask) {
+		emstats.avoided++;
+		return;
+	}
+	XSelectInput(dpy, w, mask);
+	em->selected = mask;
+	emstats.selects++;
+}
+
+
+/**
+ * XSelectInput(), and remember it.
+ */
+void
+select_input(Window w, long mask)
+{
+	XSelectInput(dpy, w, mask);
+	emstats.selects++;
+	emask_set(w, mask);
+}
+
+
+/**
+ * Remember a mask that got set some other way.
+ */
+void
+note_event_mask(Window w, long mask)
+{
+	emask_set(w, mask);
+}
+
+
+/**
+ * Stop tracking a window; it's going away, or at least out of our hands.
+ */
+void
+forget_event_mask(Window w)
+{
+	TrackedMask *em = emask_find(w);
+
+	if(em == NULL) {
+		return;
+	}
+	XDeleteContext(dpy, w, EventMaskContext);
+	free(em);
+}
+
+
+/**
+ * What a window's mask is (or will be once any batch is done).  -1 if
+ * we don't know, and can't find out.
  */
 long
-mask_out_event(Window w, long ignore_event)
+get_event_mask(Window w)
 {
+	TrackedMask *em = emask_find(w);
 	XWindowAttributes wattr;
 
-	/* Get current mask */
+	if(em != NULL) {
+		emstats.cached++;
+		return em->mask;
+	}
+
+	emstats.queries++;
 	if(XGetWindowAttributes(dpy, w, &wattr) == 0) {
 		return -1;
 	}
+	emask_set(w, wattr.your_event_mask);
+	return wattr.your_event_mask;
+}
+
+
+long
+mask_out_event(Window w, long ignore_event)
+{
+	long curmask;
+
+	/* Get current mask */
+	if((curmask = get_event_mask(w)) < 0) {
+		return -1;
+	}
 
 	/*
 	 * If we're ignoring nothing, nothing to do.  This is probably not
@@ -378,18 +525,36 @@ mask_out_event(Window w, long ignore_event)
 	 * the right thing for us to do if we're asked to do nothing.
 	 */
 	if(ignore_event == 0) {
-		return wattr.your_event_mask;
+		return curmask;
 	}
 
 	/* Delegate */
-	return mask_out_event_mask(w, ignore_event, wattr.your_event_mask);
+	return mask_out_event_mask(w, ignore_event, curmask);
 }
 
 long
 mask_out_event_mask(Window w, long ignore_event, long curmask)
 {
-	/* Set to the current, minus what we're wanting to ignore */
-	XSelectInput(dpy, w, (curmask & ~ignore_event));
+	TrackedMask *em = emask_find(w);
+	const long want = curmask & ~ignore_event;
+
+	if(em == NULL && (em = emask_set(w, curmask)) == NULL) {
+		XSelectInput(dpy, w, want);
+		return curmask;
+	}
+	em->mask = want;
+
+	/*
+	 * Set to the current, minus what we're wanting to ignore.  In a
+	 * batch, something may still be masked out from earlier, waiting to
+	 * be restored at the end; leave it that way.
+	 */
+	if(batch_depth > 0) {
+		emask_select(w, em, em->selected & want);
+	}
+	else {
+		emask_select(w, em, want);
+	}
 
 	/* Return what it was */
 	return curmask;
@@ -398,7 +563,98 @@ mask_out_event_mask(Window w, long ignore_event, long curmask)
 int
 restore_mask(Window w, long restore)
 {
-	return XSelectInput(dpy, w, restore);
+	TrackedMask *em = emask_find(w);
+
+	if(em == NULL) {
+		/* Not one we know; just set it */
+		select_input(w, restore);
+		return 1;
+	}
+	em->mask = restore;
+
+	/*
+	 * In a batch, hold off on turning things back on until the end; if
+	 * this is turning something off, though, do that now.
+	 */
+	if(batch_depth > 0 && (em->selected & ~restore) == 0) {
+		if(em->selected != restore && !em->pending) {
+			if(batch_nwins == batch_size) {
+				int nsize = batch_size ? batch_size * 2 : 16;
+				Window *n = realloc(batch_wins, nsize * sizeof(Window));
+				if(n == NULL) {
+					emask_select(w, em, restore);
+					return 1;
+				}
+				batch_wins = n;
+				batch_size = nsize;
+			}
+			batch_wins[batch_nwins++] = w;
+			em->pending = true;
+			emstats.deferred++;
+		}
+		return 1;
+	}
+
+	emask_select(w, em, restore);
+	return 1;
+}
+
+
+/**
+ * Start holding back mask restores.  These nest; only the outermost
+ * mask_batch_end() does them.
+ */
+void
+mask_batch_begin(void)
+{
+	batch_depth++;
+}
+
+
+/**
+ * Restore everything masked out since the outermost mask_batch_begin().
+ */
+void
+mask_batch_end(void)
+{
+	if(batch_depth == 0 || --batch_depth > 0) {
+		return;
+	}
+
+	for(int i = 0; i < batch_nwins; i++) {
+		TrackedMask *em = emask_find(batch_wins[i]);
+
+		/* Might have been forgotten along the way */
+		if(em == NULL || !em->pending) {
+			continue;
+		}
+		em->pending = false;
+		emask_select(batch_wins[i], em, em->mask);
+	}
+	batch_nwins = 0;
+}
+
+
+/**
+ * Current counters.
+ */
+const EventMaskStats *
+EventMaskGetStats(void)
+{
+	return &emstats;
+}
+
+
+/**
+ * Say how many round trips and requests we've saved.
+ */
+void
+EventMaskReport(FILE *out)
+{
+	fprintf(out, "Event masks: %lu lookups, %lu queried, %lu selects, "
+	        "%lu skipped, %lu restores deferred\n",
+	        emstats.cached + emstats.queries, emstats.queries,
+	        emstats.selects, emstats.avoided, emstats.deferred);
 }
 
 
@@ -420,8 +676,7 @@ SetMapStateProp(TwmWindow *tmp_win, int state)
 	data[1] = (unsigned long)(tmp_win->iconify_by_unmapping ? None :
 	                          (tmp_win->icon ? tmp_win->icon->w : None));
 
-	XChangeProperty(dpy, tmp_win->w, XA_WM_STATE, XA_WM_STATE, 32,
-	                PropModeReplace, (unsigned char *) data, 2);
+	PropSet(tmp_win->w, XA_WM_STATE, XA_WM_STATE, 32, data, 2);
 }
 
 
@@ -434,6 +689,8 @@ GetWMState(Window w, int *statep, Window *iwp)
 	unsigned long *datap = NULL;
 	bool retval = false;
 
+	// We might have set it without it having gone out yet
+	PropFlush();
 	if(XGetWindowProperty(dpy, w, XA_WM_STATE, 0L, 2L, False, XA_WM_STATE,
 	                      &actual_type, &actual_format, &nitems, &bytesafter,
 	                      (unsigned char **) &datap) != Success || !datap) {
@@ -486,9 +743,9 @@ DisplayPosition(const TwmWindow *_unused_tmp_win, int x, int y)
 	             2, Scr->DefaultC, off, false, false);
 
 	FB(Scr->DefaultC.fore, Scr->DefaultC.back);
-	XmbDrawImageString(dpy, Scr->SizeWindow, Scr->SizeFont.font_set,
-	                   Scr->NormalGC, Scr->SizeStringOffset,
-	                   Scr->SizeFont.ascent + SIZE_VINDENT, str, 13);
+	FontDrawImageString(Scr->SizeWindow, &Scr->SizeFont,
+	                    Scr->NormalGC, Scr->SizeStringOffset,
+	                    Scr->SizeFont.ascent + SIZE_VINDENT, str, 13);
 }
 
 void
@@ -1135,6 +1392,12 @@ set_window_name(TwmWindow *win)
 	// Now we know what to call it
 	win->name = newname;
 
+	// Which IconRegion claims us may depend on the name
+	win->iconRegionKnown = false;
+
+	// And it's listed in the window menus under it
+	InvalidateWindowListMenus();
+
 #ifdef EWMH
 	// EWMH says we set an additional property on any windows where what
 	// we consider the name isn't what's in _NET_WM_NAME, so pagers etc
@@ -1186,9 +1449,9 @@ apply_window_name(TwmWindow *win)
 		XRectangle inc_rect;
 		XRectangle logical_rect;
 
-		XmbTextExtents(Scr->TitleBarFont.font_set,
-		               win->name, strlen(win->name),
-		               &inc_rect, &logical_rect);
+		FontTextExtents(&Scr->TitleBarFont,
+		                win->name, strlen(win->name),
+		                &inc_rect, &logical_rect);
 		win->name_width = logical_rect.width;
 	}
 
@@ -4,6 +4,16 @@
 #ifndef _CTWM_WIN_UTILS_H
 #define _CTWM_WIN_UTILS_H
 
+#include <stdio.h>  // For FILE
+
+/// Counts of event mask lookups and changes, for diagnostics
+typedef struct EventMaskStats {
+	unsigned long cached;     ///< Masks we already knew
+	unsigned long queries;    ///< ... and had to ask the server for
+	unsigned long selects;    ///< XSelectInput()s done
+	unsigned long avoided;    ///< ... and skipped as not changing anything
+	unsigned long deferred;   ///< Restores held to the end of a batch
+} EventMaskStats;
 
 void GetWindowSizeHints(TwmWindow *tmp_win);
 void FetchWmProtocols(TwmWindow *tmp);
@@ -12,9 +22,17 @@ TwmWindow *GetTwmWindow(Window w);
 char *GetWMPropertyString(Window w, Atom prop);
 void FreeWMPropertyString(char *prop);
 bool visible(const TwmWindow *tmp_win);
+void select_input(Window w, long mask);
+void note_event_mask(Window w, long mask);
+void forget_event_mask(Window w);
+long get_event_mask(Window w);
 long mask_out_event(Window w, long ignore_event);
 long mask_out_event_mask(Window w, long ignore_event, long curmask);
 int restore_mask(Window w, long restore);
+void mask_batch_begin(void);
+void mask_batch_end(void);
+const EventMaskStats *EventMaskGetStats(void);
+void EventMaskReport(FILE *out);
 void SetMapStateProp(TwmWindow *tmp_win, int state);
 bool GetWMState(Window w, int *statep, Window *iwp);
 void DisplayPosition(const TwmWindow *_unused_tmp_win, int x, int y);
@@ -105,6 +105,7 @@ AddWorkSpace(const char *name, const char *background, const char *foreground,
 	/* Maybe there's an image to stick on the root as well */
 	ws->image = GetImage(backpix, ws->backcp);
 	if(ws->image != NULL) {
+		ws->imagename = strdup(backpix);
 		useBackgroundInfo = true;
 	}
 
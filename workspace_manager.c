@@ -49,6 +49,10 @@ static void WMapRedrawWindow(Window window, int width, int height,
                              ColorPair cp, const char *label);
 
 static void InvertColorPair(ColorPair *cp);
+static void WMapThumbnailTimer(void *arg);
+
+/* How long the map has to hold still before we redo its thumbnails */
+#define WMAP_THUMB_DELAY 300
 
 
 static XContext MapWListContext = None;
@@ -121,6 +125,10 @@ ConfigureWorkSpaceManager(ScreenInfo *scr)
 		 */
 		WorkSpaceWindow *wsw = calloc(1, sizeof(WorkSpaceWindow));
 		wsw->state = scr->workSpaceMgr.initialstate;
+		wsw->thumbtimer.vs = vs;
+		wsw->thumbtimer.scr = scr;
+		TimerInit(&wsw->thumbtimer.timer, WMapThumbnailTimer,
+		          &wsw->thumbtimer);
 
 		// If we have a current ws for this vs, assign it in, and
 		// loop onward to the ws for the next vs.  For any we don't
@@ -302,8 +310,8 @@ CreateWorkSpaceManagerWindow(VirtualScreen *vs)
 			unsigned short wid;
 			const MyFont font = Scr->workSpaceMgr.buttonFont;
 
-			XmbTextExtents(font.font_set, ws->label, strlen(ws->label),
-			               &inc_rect, &logical_rect);
+			FontTextExtents(&font, ws->label, strlen(ws->label),
+			                &inc_rect, &logical_rect);
 			wid = logical_rect.width;
 			if(wid > strWid) {
 				strWid = wid;
@@ -431,22 +439,7 @@ CreateWorkSpaceManagerWindow(VirtualScreen *vs)
 
 			/* Setup background on map-state window */
 			/* XXX X-ref CTAG_BGDRAW in CreateWorkSpaceManager() */
-			if(useBackgroundInfo) {
-				if(ws->image == NULL || Scr->NoImagesInWorkSpaceManager) {
-					XSetWindowBackground(dpy, msw->w, ws->backcp.back);
-				}
-				else {
-					XSetWindowBackgroundPixmap(dpy, msw->w, ws->image->pixmap);
-				}
-			}
-			else {
-				if(Scr->workSpaceMgr.defImage == NULL || Scr->NoImagesInWorkSpaceManager) {
-					XSetWindowBackground(dpy, msw->w, Scr->workSpaceMgr.defColors.back);
-				}
-				else {
-					XSetWindowBackgroundPixmap(dpy, msw->w, Scr->workSpaceMgr.defImage->pixmap);
-				}
-			}
+			WMapSetMapBackground(vs, ws);
 
 			/*
 			 * Clear out button subwin; PaintWorkSpaceManager() fills it
@@ -506,7 +499,6 @@ CreateWorkSpaceManagerWindow(VirtualScreen *vs)
 
 	/* Setup cursor/gravity and listen for events */
 	{
-		XWindowAttributes wattr;
 		XSetWindowAttributes attr;
 		unsigned long attrmask;
 
@@ -515,10 +507,9 @@ CreateWorkSpaceManagerWindow(VirtualScreen *vs)
 		attrmask = CWCursor | CWWinGravity;
 		XChangeWindowAttributes(dpy, vs->wsw->w, attrmask, &attr);
 
-		XGetWindowAttributes(dpy, vs->wsw->w, &wattr);
-		attrmask = wattr.your_event_mask | KeyPressMask | KeyReleaseMask
+		attrmask = get_event_mask(vs->wsw->w) | KeyPressMask | KeyReleaseMask
 		           | ExposureMask;
-		XSelectInput(dpy, vs->wsw->w, attrmask);
+		select_input(vs->wsw->w, attrmask);
 	}
 
 
@@ -657,11 +648,99 @@ ResizeWorkSpaceManager(VirtualScreen *vs, TwmWindow *win)
 	}
 
 
+	/*
+	 * Shrink the workspace images down to the new size.  That's a fresh
+	 * decode of each, so wait until it's stopped changing size for a
+	 * moment; the old ones will do until then.
+	 */
+	if(useBackgroundInfo && !Scr->NoImagesInWorkSpaceManager) {
+		TimerSet(&vs->wsw->thumbtimer.timer, WMAP_THUMB_DELAY);
+	}
+
+
 	/* Draw it */
 	PaintWorkSpaceManager(vs);
 }
 
 
+/*
+ * Set the background of a workspace's subwindow in the map, for when
+ * it's not the current one.
+ *
+ * XXX X-ref CTAG_BGDRAW in CreateWorkSpaceManager()
+ */
+void
+WMapSetMapBackground(VirtualScreen *vs, WorkSpace *ws)
+{
+	MapSubwindow *msw = vs->wsw->mswl[ws->number];
+
+	if(useBackgroundInfo) {
+		if(ws->image == NULL || Scr->NoImagesInWorkSpaceManager) {
+			XSetWindowBackground(dpy, msw->w, ws->backcp.back);
+		}
+		else if(msw->thumb != NULL) {
+			XSetWindowBackgroundPixmap(dpy, msw->w, msw->thumb->pixmap);
+		}
+		else {
+			XSetWindowBackgroundPixmap(dpy, msw->w, ws->image->pixmap);
+		}
+	}
+	else {
+		if(Scr->workSpaceMgr.defImage == NULL || Scr->NoImagesInWorkSpaceManager) {
+			XSetWindowBackground(dpy, msw->w, Scr->workSpaceMgr.defColors.back);
+		}
+		else {
+			XSetWindowBackgroundPixmap(dpy, msw->w, Scr->workSpaceMgr.defImage->pixmap);
+		}
+	}
+}
+
+
+/*
+ * Timer callback: make thumbnails of the workspace images for the map
+ * at its current size.  They're scaled the same as the windows in it,
+ * so they look like the root does.
+ */
+static void
+WMapThumbnailTimer(void *arg)
+{
+	WMapThumbTimer *tt = arg;
+	VirtualScreen *vs = tt->vs;
+	WorkSpaceWindow *wsw = vs->wsw;
+	int boxw, boxh;
+
+	Scr = tt->scr;
+	boxw = (int)(((long long) Scr->rootw * (wsw->wwidth  - 2)) / vs->w);
+	boxh = (int)(((long long) Scr->rooth * (wsw->wheight - 2)) / vs->h);
+
+	for(WorkSpace *ws = Scr->workSpaceMgr.workSpaceList; ws != NULL;
+	                ws = ws->next) {
+		MapSubwindow *msw = wsw->mswl[ws->number];
+		Image *old = msw->thumb;
+
+		if(ws->image == NULL || ws->imagename == NULL) {
+			continue;
+		}
+		msw->thumb = GetImageScaled(ws->imagename, ws->backcp, boxw, boxh);
+		if(msw->thumb == NULL && old == NULL) {
+			/* Not one we can shrink; it stays as it was */
+			continue;
+		}
+
+		/* The current one may be drawn differently; if so leave it be */
+		if(ws != wsw->currentwspc
+		                || (Scr->workSpaceMgr.curImage == NULL
+		                    && !Scr->workSpaceMgr.curPaint)) {
+			WMapSetMapBackground(vs, ws);
+			XClearWindow(dpy, msw->w);
+		}
+		if(old != NULL) {
+			FreeImage(old);
+		}
+	}
+}
+
+
 /*
  * Draw up the button-state pieces of a WSM window.
  *
@@ -783,7 +862,7 @@ WMgrSetMapState(VirtualScreen *vs)
 		XMapWindow(dpy, vs->wsw->mswl [ws->number]->w);
 	}
 	vs->wsw->state = WMS_map;
-	MaybeAnimate = true;
+	AnimationAddRoot(Scr);
 }
 
 void
@@ -2034,8 +2113,8 @@ WMapRedrawWindow(Window window, int width, int height,
 		char **font_names;
 		int fnum;
 
-		XmbTextExtents(font.font_set, label, strlen(label),
-		               &inc_rect, &logical_rect);
+		FontTextExtents(&font, label, strlen(label),
+		                &inc_rect, &logical_rect);
 		strwid = logical_rect.width;
 		strhei = logical_rect.height;
 
@@ -2052,11 +2131,16 @@ WMapRedrawWindow(Window window, int width, int height,
 			x = 1;
 		}
 
-		fnum = XFontsOfFontSet(font.font_set, &xfonts, &font_names);
-		for(i = 0, descent = 0; i < fnum; i++) {
-			/* xf = xfonts[i]; */
-			descent = ((descent < (xfonts[i]->max_bounds.descent)) ?
-			           (xfonts[i]->max_bounds.descent) : descent);
+		if(font.font_set != NULL) {
+			fnum = XFontsOfFontSet(font.font_set, &xfonts, &font_names);
+			for(i = 0, descent = 0; i < fnum; i++) {
+				/* xf = xfonts[i]; */
+				descent = ((descent < (xfonts[i]->max_bounds.descent)) ?
+				           (xfonts[i]->max_bounds.descent) : descent);
+			}
+		}
+		else {
+			descent = font.descent;
 		}
 
 		y = ((height + strhei) / 2) - descent;
@@ -2075,12 +2159,12 @@ WMapRedrawWindow(Window window, int width, int height,
 
 	/* Write in the name */
 	if(Scr->Monochrome != COLOR) {
-		XmbDrawImageString(dpy, window, font.font_set, Scr->NormalGC, x, y,
-		                   label, strlen(label));
+		FontDrawImageString(window, &font, Scr->NormalGC, x, y,
+		                    label, strlen(label));
 	}
 	else {
-		XmbDrawString(dpy, window, font.font_set, Scr->NormalGC, x, y,
-		              label, strlen(label));
+		FontDrawString(window, &font, Scr->NormalGC, x, y,
+		               label, strlen(label));
 	}
 }
 
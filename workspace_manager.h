@@ -42,5 +42,6 @@ void WMapRemoveWindowFromWorkspace(TwmWindow *win, WorkSpace *ws);
 
 /* Util */
 bool WMapWindowMayBeAdded(TwmWindow *win);
+void WMapSetMapBackground(VirtualScreen *vs, WorkSpace *ws);
 
 #endif /* _CTWM_WORKMGR_H */
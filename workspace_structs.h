@@ -5,6 +5,8 @@
 #ifndef _CTWM_WORKSPACE_STRUCTS_H
 #define _CTWM_WORKSPACE_STRUCTS_H
 
+#include "timers.h"
+
 #define MAXWORKSPACE 32
 
 typedef enum {
@@ -66,6 +68,7 @@ struct WorkSpace {
 	char                *name;
 	char                *label;
 	Image               *image;
+	char                *imagename;   /* What image was loaded from */
 	name_list           *clientlist;
 	IconMgr             *iconmgr;
 	ColorPair           cp;
@@ -79,12 +82,24 @@ struct MapSubwindow {
 	Window  w;
 	int     x, y;
 	WinList *wl;
+	Image   *thumb;   /* WS image shrunk to fit, if we could */
 };
 
 struct ButtonSubwindow {
 	Window w;
 };
 
+/*
+ * Pending redo of a map's thumbnails.  The timer fires from the main
+ * loop, where Scr is whoever had the last event, so it keeps track of
+ * whose map it is.
+ */
+typedef struct WMapThumbTimer {
+	Timer          timer;
+	VirtualScreen  *vs;
+	ScreenInfo     *scr;
+} WMapThumbTimer;
+
 struct WorkSpaceWindow {                /* There is one per virtual screen */
 	VirtualScreen   *vs;
 	Window          w;
@@ -98,6 +113,7 @@ struct WorkSpaceWindow {                /* There is one per virtual screen */
 	int           width, height;   // Window dimensions
 	int           bwidth, bheight; // Button dimensions
 	int           wwidth, wheight; // Map dimensions
+	WMapThumbTimer thumbtimer;     // Redo map thumbnails after resizing
 };
 
 #endif /* _CTWM_WORKSPACE_STRUCTS_H */
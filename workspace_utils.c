@@ -18,6 +18,7 @@
 #include "iconmgr.h"
 #include "image.h"
 #include "otp.h"
+#include "prop_writer.h"
 #include "screen.h"
 #include "vscreen.h"
 #include "win_ops.h"
@@ -70,6 +71,12 @@ GotoWorkSpace(VirtualScreen *vs, WorkSpace *ws)
 		return;
 	}
 
+	/*
+	 * Hiding and showing windows masks out events on each of them; hold
+	 * the restores until everything's moved around.
+	 */
+	mask_batch_begin();
+
 	/* XXX X-ref CTAG_BGDRAW in CreateWorkSpaceManager() and below */
 	if(useBackgroundInfo && ! Scr->DontPaintRootWindow) {
 		if(newws->image == NULL) {
@@ -208,22 +215,7 @@ GotoWorkSpace(VirtualScreen *vs, WorkSpace *ws)
 	/* XXX X-ref CTAG_BGDRAW in CreateWorkSpaceManager() and above */
 	oldw = vs->wsw->mswl [oldws->number]->w;
 	neww = vs->wsw->mswl [newws->number]->w;
-	if(useBackgroundInfo) {
-		if(oldws->image == NULL || Scr->NoImagesInWorkSpaceManager) {
-			XSetWindowBackground(dpy, oldw, oldws->backcp.back);
-		}
-		else {
-			XSetWindowBackgroundPixmap(dpy, oldw, oldws->image->pixmap);
-		}
-	}
-	else {
-		if(Scr->workSpaceMgr.defImage == NULL || Scr->NoImagesInWorkSpaceManager) {
-			XSetWindowBackground(dpy, oldw, Scr->workSpaceMgr.defColors.back);
-		}
-		else {
-			XSetWindowBackgroundPixmap(dpy, oldw, Scr->workSpaceMgr.defImage->pixmap);
-		}
-	}
+	WMapSetMapBackground(vs, oldws);
 	attr.border_pixel = Scr->workSpaceMgr.defBorderColor;
 	XChangeWindowAttributes(dpy, oldw, CWBorderPixel, &attr);
 
@@ -243,8 +235,8 @@ GotoWorkSpace(VirtualScreen *vs, WorkSpace *ws)
 
 	eventMask = mask_out_event(Scr->Root, PropertyChangeMask);
 
-	XChangeProperty(dpy, Scr->Root, XA_WM_CURRENTWORKSPACE, XA_STRING, 8,
-	                PropModeReplace, (unsigned char *) newws->name, strlen(newws->name));
+	PropSet(Scr->Root, XA_WM_CURRENTWORKSPACE, XA_STRING, 8,
+	        newws->name, strlen(newws->name));
 #ifdef EWMH
 	{
 		long number = newws->number;
@@ -254,13 +246,18 @@ GotoWorkSpace(VirtualScreen *vs, WorkSpace *ws)
 		 * Also, on the real root it would need values for each of the
 		 * virtual roots, but that doesn't fit in the EWMH ideas.
 		 */
-		XChangeProperty(dpy, Scr->Root, XA__NET_CURRENT_DESKTOP,
-		                XA_CARDINAL, 32,
-		                PropModeReplace, (unsigned char *) &number, 1);
+		PropSet(Scr->Root, XA__NET_CURRENT_DESKTOP, XA_CARDINAL, 32,
+		        &number, 1);
 	}
 #endif /* EWMH */
 
+	/*
+	 * These have to actually go out before we start listening again,
+	 * or we'd hear about our own WM_CURRENTWORKSPACE change.
+	 */
+	PropFlush();
 	restore_mask(Scr->Root, eventMask);
+	mask_batch_end();
 
 	/*    XDestroyWindow (dpy, cachew);*/
 	if(Scr->ChangeWorkspaceFunction.func != 0) {
@@ -292,7 +289,7 @@ GotoWorkSpace(VirtualScreen *vs, WorkSpace *ws)
 	if(Scr->ClickToFocus || Scr->SloppyFocus) {
 		set_last_window(newws);
 	}
-	MaybeAnimate = true;
+	AnimationAddRoot(Scr);
 }
 
 